@@ -0,0 +1,317 @@
+/*! \file       benchmain.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      Benchmark Application File.
+ *
+ *  This file contains the main function of the tdir_bench application.
+ *  It generates synthetic trees & times FileEnumerator::listFiles()
+ *  on them in every listing mode with cold & warm caches. Start up time
+ *  is measured by whole runs of a tdir executable on a tiny tree. Results
+ *  are written as tab separated lines to compare them across commits.
+ */
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QPair>
+#include <QStringList>
+#include <QTextCodec>
+#include <QTextStream>
+#include <QThread>
+
+#include <algorithm>
+
+#include <stdio.h>
+
+#include "benchrunner.h"
+#include "treegenerator.h"
+
+/*!
+ * \brief median
+ * \param[in] results Successful run measurements
+ * \return The measurement with the median time
+ */
+static BenchRunner::Result median(QList<BenchRunner::Result> results)
+{
+    std::sort(results.begin(), results.end(), [](const BenchRunner::Result &left, const BenchRunner::Result &right) {
+        return left.nsecs < right.nsecs;
+    });
+    return results.at(results.count() / 2);
+}
+
+/* Files of the start up tree, few enough for start up to dominate a run */
+static const int startup_file_count = 16;
+
+/*!
+ * \brief makeStartupTree
+ * \param[in] dirPath A directory to create the tree in
+ * \return "false" if the tree can't be created
+ */
+static bool makeStartupTree(const QString &dirPath)
+{
+    if(!QDir().mkpath(dirPath))
+    {
+        return false;
+    }
+
+    for(int fileNum = 0; fileNum < startup_file_count; fileNum++)
+    {
+        QFile file(QDir(dirPath).filePath(QString("file_%1.txt").arg(fileNum)));
+        if(!file.open(QIODevice::WriteOnly) || file.write("tdir\n") != 5)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*!
+ * \brief printResult
+ * \param[in] out A stream to write the line to
+ * \param[in] results Successful run measurements
+ * \param[in] entries Number of listed entries
+ *
+ * Writes the measurement columns of the median run & ends the line.
+ */
+static void printResult(QTextStream &out, const QList<BenchRunner::Result> &results, qint64 entries)
+{
+    if(results.isEmpty())
+    {
+        out << "\t-\t-\t-\t-" << endl;
+        return;
+    }
+
+    BenchRunner::Result result = median(results);
+    double seconds = result.nsecs / 1e9;
+    out << '\t' << QString::number(seconds, 'f', 6) <<
+           '\t' << QString::number(seconds > 0 ? entries / seconds : 0.0, 'f', 0) <<
+           '\t' << (result.syscalls >= 0 && entries > 0 ? QString::number(double(result.syscalls) / entries, 'f', 3) : QString("-")) <<
+           '\t' << (result.peakRssKb >= 0 ? QString::number(result.peakRssKb) : QString("-")) << endl;
+}
+
+/*!
+ * \brief runStartup
+ * \param[in] out A stream to write results to
+ * \param[in] programPath A tdir executable
+ * \param[in] treePath A tiny tree to list
+ * \param[in] repeat Runs per measurement
+ *
+ * Times whole tdir runs listing the tiny tree, recursively & showing help.
+ */
+static void runStartup(QTextStream &out, const QString &programPath, const QString &treePath, int repeat)
+{
+    QStringList listArguments;
+    listArguments << treePath;
+    QStringList recursiveArguments;
+    recursiveArguments << treePath << "-r";
+    QStringList helpArguments;
+    helpArguments << "-h";
+
+    QList<QPair<QString, QStringList> > invocations;
+    invocations.append(qMakePair(QString("list"), listArguments));
+    invocations.append(qMakePair(QString("recursive"), recursiveArguments));
+    invocations.append(qMakePair(QString("help"), helpArguments));
+
+    for(int invocationNum = 0; invocationNum < invocations.count(); invocationNum++)
+    {
+        const QString &name = invocations.at(invocationNum).first;
+        const QStringList &arguments = invocations.at(invocationNum).second;
+
+        /* An untimed run loads the executable & its libraries into the page cache */
+        BenchRunner::runProgram(programPath, arguments);
+
+        QList<BenchRunner::Result> results;
+        for(int runNum = 0; runNum < repeat; runNum++)
+        {
+            BenchRunner::Result result = BenchRunner::runProgram(programPath, arguments);
+            if(result.ok)
+            {
+                results.append(result);
+            }
+        }
+
+        qint64 entries = (name == "help") ? 0 : startup_file_count;
+        out << "startup\t" << name << "\twarm\t" << entries;
+        printResult(out, results, entries);
+    }
+}
+
+/*!
+ * \brief viewHelp
+ * \param[in] out A stream to write help to
+ */
+static void viewHelp(QTextStream &out)
+{
+    out << "Usage:" << endl <<
+           "   tdir_bench [--root dir] [--scale n] [--repeat n] [-j jobs]" << endl <<
+           "\t[--shapes wide,deep,small,mixed] [--modes name,...] [--no-cold]" << endl <<
+           "   tdir_bench --startup program [--root dir] [--repeat n]" << endl << endl <<
+           "--root dir -\tA directory for generated trees (a temporary one by default)." << endl <<
+           "--scale n -\tTree size multiplier, 1 gives about 20000 entries per tree." << endl <<
+           "--repeat n -\tRuns per measurement, the median run is shown (3 by default)." << endl <<
+           "-j jobs -\tThreads of parallel modes (a thread per core by default)." << endl <<
+           "--no-cold -\tSkip cold cache runs, they need root permissions to drop caches." << endl <<
+           "--startup program -\tTime whole runs of the tdir executable on a tiny tree instead" << endl <<
+           "\t\tof listing modes, start up costs dominate them." << endl << endl <<
+           "Output columns: shape mode cache entries seconds entries_per_sec syscalls_per_entry peak_rss_kb" << endl;
+}
+
+/*!
+ * Benchmark application function.
+ * \param[in] argc Application launch argument counter
+ * \param[in] argv Application launch argument values array pointer
+ * \return 0 on success, 1 on wrong arguments, 2 if trees can't be generated
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QTextCodec::setCodecForLocale(QTextCodec::codecForName("utf8"));
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QString rootPath = QDir(QDir::tempPath()).filePath("tdir-bench");
+    int scale = 1;
+    int repeat = 3;
+    int jobs = QThread::idealThreadCount();
+    bool coldRuns = true;
+    QStringList shapeNames;
+    QStringList modeNames;
+    QString startupProgram;
+
+    QStringList arguments = a.arguments();
+    for(int argNum = 1; argNum < arguments.count(); argNum++)
+    {
+        const QString &argument = arguments.at(argNum);
+        QString value = (argNum + 1 < arguments.count()) ? arguments.at(argNum + 1) : QString();
+        bool valueOk = true;
+
+        if(argument == "--root" && !value.isEmpty())
+        {
+            rootPath = value;
+        }
+        else if(argument == "--scale")
+        {
+            scale = value.toInt(&valueOk);
+            valueOk = valueOk && scale > 0;
+        }
+        else if(argument == "--repeat")
+        {
+            repeat = value.toInt(&valueOk);
+            valueOk = valueOk && repeat > 0;
+        }
+        else if(argument == "-j")
+        {
+            jobs = value.toInt(&valueOk);
+            valueOk = valueOk && jobs > 0;
+        }
+        else if(argument == "--shapes" && !value.isEmpty())
+        {
+            shapeNames = value.split(QChar(','));
+        }
+        else if(argument == "--modes" && !value.isEmpty())
+        {
+            modeNames = value.split(QChar(','));
+        }
+        else if(argument == "--startup" && !value.isEmpty())
+        {
+            startupProgram = value;
+        }
+        else if(argument == "--no-cold")
+        {
+            coldRuns = false;
+            continue;
+        }
+        else
+        {
+            viewHelp(out);
+            return (argument == "-h") ? 0 : 1;
+        }
+
+        if(!valueOk)
+        {
+            viewHelp(out);
+            return 1;
+        }
+        argNum++;
+    }
+
+    /* Start up runs don't list generated trees */
+    if(!startupProgram.isEmpty())
+    {
+        QString treePath = QDir(rootPath).filePath("startup");
+        if(!makeStartupTree(treePath))
+        {
+            err << "Can't generate " << treePath << endl;
+            return 2;
+        }
+
+        out << "# tdir_bench " << APP_VERSION << " startup program=" << startupProgram << " repeat=" << repeat << endl;
+        out << "shape\tmode\tcache\tentries\tseconds\tentries_per_sec\tsyscalls_per_entry\tpeak_rss_kb" << endl;
+        runStartup(out, startupProgram, treePath, repeat);
+        return 0;
+    }
+
+    if(coldRuns && !BenchRunner::dropCaches())
+    {
+        err << "Caches can't be dropped, cold cache runs are skipped." << endl;
+        coldRuns = false;
+    }
+
+    TreeGenerator generator(rootPath);
+    QList<BenchRunner::Mode> modes = BenchRunner::modes(jobs);
+
+    out << "# tdir_bench " << APP_VERSION << " scale=" << scale << " repeat=" << repeat <<
+           " jobs=" << jobs << " cores=" << QThread::idealThreadCount() << endl;
+    out << "shape\tmode\tcache\tentries\tseconds\tentries_per_sec\tsyscalls_per_entry\tpeak_rss_kb" << endl;
+
+    foreach (const TreeGenerator::Shape &shape, TreeGenerator::shapes(scale)) {
+        if(!shapeNames.isEmpty() && !shapeNames.contains(shape.name))
+        {
+            continue;
+        }
+
+        err << "Generating " << generator.treePath(shape) << "..." << endl;
+        if(!generator.generate(shape))
+        {
+            err << "Can't generate " << generator.treePath(shape) << endl;
+            return 2;
+        }
+
+        qint64 entries = TreeGenerator::entryCount(shape);
+
+        foreach (const BenchRunner::Mode &mode, modes) {
+            if(!modeNames.isEmpty() && !modeNames.contains(mode.name))
+            {
+                continue;
+            }
+
+            for(int cacheNum = (coldRuns ? 0 : 1); cacheNum < 2; cacheNum++)
+            {
+                bool cold = (cacheNum == 0);
+
+                /* An untimed run fills caches for warm runs */
+                if(!cold)
+                {
+                    BenchRunner::run(generator.treePath(shape), mode, false);
+                }
+
+                QList<BenchRunner::Result> results;
+                for(int runNum = 0; runNum < repeat; runNum++)
+                {
+                    BenchRunner::Result result = BenchRunner::run(generator.treePath(shape), mode, cold);
+                    if(result.ok)
+                    {
+                        results.append(result);
+                    }
+                }
+
+                out << shape.name << '\t' << mode.name << '\t' << (cold ? "cold" : "warm") << '\t' << entries;
+                printResult(out, results, entries);
+            }
+        }
+    }
+
+    return 0;
+}
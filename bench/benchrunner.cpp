@@ -0,0 +1,455 @@
+/*! \file       benchrunner.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief Bench Runner module source file.
+ *
+ *  This file contains the BenchRunner class source code.
+ */
+
+#include "benchrunner.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+/* The environment passed to spawned programs */
+extern char **environ;
+#endif
+
+#ifdef Q_OS_LINUX
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+/* Top & sort modes keep this many files */
+static const int bench_top_count = 100;
+
+/* io_uring mode queue depth */
+static const int bench_uring_depth = 64;
+
+/* Directories scanned at once per device in the device limited mode */
+static const int bench_device_jobs = 2;
+
+/*!
+ * \brief openSyscallCounter
+ * \return A disabled perf event counting system calls of this process
+ *         & its future threads or -1 if it can't be opened
+ */
+static int openSyscallCounter()
+{
+#ifdef Q_OS_LINUX
+    static const char *idPaths[] = {
+        "/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+        "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id"
+    };
+
+    quint64 tracepointId = 0;
+    for(size_t pathNum = 0; pathNum < sizeof(idPaths) / sizeof(idPaths[0]) && tracepointId == 0; pathNum++)
+    {
+        QFile idFile(idPaths[pathNum]);
+        if(idFile.open(QIODevice::ReadOnly))
+        {
+            tracepointId = idFile.readAll().trimmed().toULongLong();
+        }
+    }
+    if(tracepointId == 0)
+    {
+        return -1;
+    }
+
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_TRACEPOINT;
+    attr.size = sizeof(attr);
+    attr.config = tracepointId;
+    attr.disabled = 1;
+    attr.inherit = 1;                   /* Traversal threads are counted too */
+    attr.sample_period = 0;
+
+    return int(syscall(__NR_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+#else
+    return -1;
+#endif
+}
+
+/*!
+ * \brief measure
+ * \param[in] treePath A tree to list
+ * \param[in] mode A listing mode
+ * \return The run measurement without the peak RSS
+ *
+ * Lists the tree once with a new enumerator.
+ */
+static BenchRunner::Result measure(const QString &treePath, const BenchRunner::Mode &mode)
+{
+    BenchRunner::Result result;
+    result.ok = true;
+    result.syscalls = -1;
+    result.peakRssKb = -1;
+
+    int counter = openSyscallCounter();
+
+    FileEnumerator enumerator;
+    enumerator.setCurrentDir(treePath);
+    mode.setup(enumerator);
+
+#ifdef Q_OS_LINUX
+    if(counter >= 0)
+    {
+        ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+
+    QElapsedTimer timer;
+    timer.start();
+    enumerator.listFiles();
+    result.nsecs = timer.nsecsElapsed();
+
+#ifdef Q_OS_LINUX
+    if(counter >= 0)
+    {
+        ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+        quint64 count = 0;
+        if(read(counter, &count, sizeof(count)) == sizeof(count))
+        {
+            result.syscalls = qint64(count);
+        }
+        close(counter);
+    }
+#endif
+
+    return result;
+}
+
+/*!
+ * \brief BenchRunner::modes
+ * \param[in] jobs Number of threads of parallel modes
+ * \return Benchmarked listing modes
+ */
+QList<BenchRunner::Mode> BenchRunner::modes(int jobs)
+{
+    QList<Mode> modes;
+    Mode mode;
+
+    mode.name = "walk";
+    mode.setup = [](FileEnumerator &enumerator) {
+        enumerator.setRecursiveMode(true);
+    };
+    modes.append(mode);
+
+    mode.name = "no-pipeline";
+    mode.setup = [](FileEnumerator &enumerator) {
+        enumerator.setRecursiveMode(true);
+        enumerator.setPipelineMode(false);
+    };
+    modes.append(mode);
+
+    mode.name = "parallel";
+    mode.setup = [jobs](FileEnumerator &enumerator) {
+        enumerator.setRecursiveMode(true);
+        enumerator.setJobs(jobs);
+    };
+    modes.append(mode);
+
+    mode.name = "unordered";
+    mode.setup = [jobs](FileEnumerator &enumerator) {
+        enumerator.setRecursiveMode(true);
+        enumerator.setJobs(jobs);
+        enumerator.setUnorderedMode(true);
+    };
+    modes.append(mode);
+
+    mode.name = "device-jobs";
+    mode.setup = [jobs](FileEnumerator &enumerator) {
+        enumerator.setRecursiveMode(true);
+        enumerator.setJobs(jobs);
+        enumerator.setDeviceJobs(bench_device_jobs);
+    };
+    modes.append(mode);
+
+    mode.name = "inode-order";
+    mode.setup = [](FileEnumerator &enumerator) {
+        enumerator.setRecursiveMode(true);
+        enumerator.setInodeOrder(true);
+    };
+    modes.append(mode);
+
+    mode.name = "io-uring";
+    mode.setup = [](FileEnumerator &enumerator) {
+        enumerator.setRecursiveMode(true);
+        enumerator.setStatBatchDepth(bench_uring_depth);
+    };
+    modes.append(mode);
+
+    mode.name = "masks";
+    mode.setup = [](FileEnumerator &enumerator) {
+        enumerator.setRecursiveMode(true);
+        enumerator.setMask("*.log");
+        enumerator.addIncludeMask("*.cpp");
+        enumerator.addIncludeMask("file_00[0-4]?[0-9]_*");
+        enumerator.addExcludeMask("*7*.tmp");
+    };
+    modes.append(mode);
+
+    mode.name = "where";
+    mode.setup = [](FileEnumerator &enumerator) {
+        enumerator.setRecursiveMode(true);
+        enumerator.setPredicate("(name=*.log or name=*.cpp) and size>4K or not type=f");
+    };
+    modes.append(mode);
+
+    mode.name = "one-fs";
+    mode.setup = [](FileEnumerator &enumerator) {
+        enumerator.setRecursiveMode(true);
+        enumerator.setOneFileSystem(true);
+        enumerator.setLinksOnce(true);
+    };
+    modes.append(mode);
+
+    mode.name = "summarize";
+    mode.setup = [jobs](FileEnumerator &enumerator) {
+        enumerator.setSummarizeMode(true);
+        enumerator.setJobs(jobs);
+    };
+    modes.append(mode);
+
+    mode.name = "top";
+    mode.setup = [jobs](FileEnumerator &enumerator) {
+        enumerator.setRecursiveMode(true);
+        enumerator.setJobs(jobs);
+        enumerator.setTopCount(bench_top_count);
+    };
+    modes.append(mode);
+
+    mode.name = "sort";
+    mode.setup = [jobs](FileEnumerator &enumerator) {
+        enumerator.setRecursiveMode(true);
+        enumerator.setJobs(jobs);
+        enumerator.setSortMode(true);
+    };
+    modes.append(mode);
+
+    mode.name = "snapshot";
+    mode.setup = [jobs](FileEnumerator &enumerator) {
+        enumerator.setRecursiveMode(true);
+        enumerator.setJobs(jobs);
+        enumerator.setSnapshotPath(QDir(QDir::tempPath()).filePath("tdir-bench.snapshot"));
+    };
+    modes.append(mode);
+
+    mode.name = "name-index";
+    mode.setup = [jobs](FileEnumerator &enumerator) {
+        enumerator.setRecursiveMode(true);
+        enumerator.setJobs(jobs);
+        enumerator.setNameIndexPath(QDir(QDir::tempPath()).filePath("tdir-bench.idx"));
+    };
+    modes.append(mode);
+
+    mode.name = "dupes";
+    mode.setup = [jobs](FileEnumerator &enumerator) {
+        enumerator.setRecursiveMode(true);
+        enumerator.setJobs(jobs);
+        enumerator.setDupesMode(true);
+    };
+    modes.append(mode);
+
+    mode.name = "ndjson";
+    mode.setup = [](FileEnumerator &enumerator) {
+        enumerator.setRecursiveMode(true);
+        enumerator.setOutputFormat(RecordSink::FORMAT_NDJSON);
+    };
+    modes.append(mode);
+
+    mode.name = "binary";
+    mode.setup = [](FileEnumerator &enumerator) {
+        enumerator.setRecursiveMode(true);
+        enumerator.setOutputFormat(RecordSink::FORMAT_BINARY);
+    };
+    modes.append(mode);
+
+    return modes;
+}
+
+/*!
+ * \brief BenchRunner::dropCaches
+ * \return "false" if caches can't be dropped
+ *
+ * Writes dirty pages out & drops the page, dentry & inode caches.
+ */
+bool BenchRunner::dropCaches()
+{
+#ifdef Q_OS_LINUX
+    sync();
+
+    int fd = open("/proc/sys/vm/drop_caches", O_WRONLY | O_CLOEXEC);
+    if(fd < 0)
+    {
+        return false;
+    }
+    bool dropped = (write(fd, "3", 1) == 1);
+    close(fd);
+    return dropped;
+#else
+    return false;
+#endif
+}
+
+/*!
+ * \brief BenchRunner::run
+ * \param[in] treePath A tree to list
+ * \param[in] mode A listing mode
+ * \param[in] cold Set to "true" to drop caches before listing
+ * \return The run measurement, it is not "ok" if the run failed
+ */
+BenchRunner::Result BenchRunner::run(const QString &treePath, const Mode &mode, bool cold)
+{
+    Result result;
+    result.ok = false;
+    result.nsecs = 0;
+    result.syscalls = -1;
+    result.peakRssKb = -1;
+
+    if(cold && !dropCaches())
+    {
+        return result;
+    }
+
+#ifdef Q_OS_UNIX
+    int fds[2];
+    if(pipe(fds) != 0)
+    {
+        return result;
+    }
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if(pid < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return result;
+    }
+
+    if(pid == 0)
+    {
+        /* The child lists the tree to /dev/null & reports back through the pipe */
+        close(fds[0]);
+        int devNull = open("/dev/null", O_WRONLY);
+        if(devNull >= 0)
+        {
+            dup2(devNull, fileno(stdout));
+            close(devNull);
+        }
+
+        Result childResult = measure(treePath, mode);
+        ssize_t written = write(fds[1], &childResult, sizeof(childResult));
+        _exit(written == sizeof(childResult) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    Result childResult;
+    bool received = (read(fds[0], &childResult, sizeof(childResult)) == sizeof(childResult));
+    close(fds[0]);
+
+    int status = 0;
+    struct rusage usage;
+    memset(&usage, 0, sizeof(usage));
+    if(wait4(pid, &status, 0, &usage) != pid || !received || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+        return result;
+    }
+
+    result = childResult;
+#ifdef Q_OS_MAC
+    result.peakRssKb = usage.ru_maxrss / 1024;      /* Bytes on macOS */
+#else
+    result.peakRssKb = usage.ru_maxrss;
+#endif
+#else
+    result = measure(treePath, mode);
+#endif
+
+    return result;
+}
+
+/*!
+ * \brief BenchRunner::runProgram
+ * \param[in] programPath An executable to run
+ * \param[in] arguments Its arguments
+ * \return The run measurement, it is not "ok" if the program can't be run or exits with an error
+ *
+ * Runs the program with the output sent to /dev/null & times it from
+ * the spawn to the exit, so start up & exit costs are included.
+ */
+BenchRunner::Result BenchRunner::runProgram(const QString &programPath, const QStringList &arguments)
+{
+    Result result;
+    result.ok = false;
+    result.nsecs = 0;
+    result.syscalls = -1;
+    result.peakRssKb = -1;
+
+#ifdef Q_OS_UNIX
+    QList<QByteArray> encoded;
+    encoded.append(QFile::encodeName(programPath));
+    foreach (const QString &argument, arguments) {
+        encoded.append(QFile::encodeName(argument));
+    }
+
+    QVector<char *> argv;
+    for(int argNum = 0; argNum < encoded.count(); argNum++)
+    {
+        argv.append(encoded[argNum].data());
+    }
+    argv.append(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, fileno(stdout), "/dev/null", O_WRONLY, 0);
+
+    fflush(stdout);
+    QElapsedTimer timer;
+    timer.start();
+
+    pid_t pid = 0;
+    int spawned = posix_spawn(&pid, argv.at(0), &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if(spawned != 0)
+    {
+        return result;
+    }
+
+    int status = 0;
+    struct rusage usage;
+    memset(&usage, 0, sizeof(usage));
+    if(wait4(pid, &status, 0, &usage) != pid)
+    {
+        return result;
+    }
+    result.nsecs = timer.nsecsElapsed();
+    result.ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#ifdef Q_OS_MAC
+    result.peakRssKb = usage.ru_maxrss / 1024;      /* Bytes on macOS */
+#else
+    result.peakRssKb = usage.ru_maxrss;
+#endif
+#else
+    Q_UNUSED(programPath)
+    Q_UNUSED(arguments)
+#endif
+
+    return result;
+}
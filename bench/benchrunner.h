@@ -0,0 +1,67 @@
+/*! \file       benchrunner.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      Bench Runner module header file.
+ *
+ *  This file contains the BenchRunner class declaration.
+ */
+
+#ifndef BENCHRUNNER_H
+#define BENCHRUNNER_H
+
+#include <QtCore/qglobal.h>
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include <functional>
+
+#include "fileenumerator.h"
+
+/*! \class BenchRunner
+ *  \brief FileEnumerator benchmark runner class.
+ *
+ *  This class runs FileEnumerator::listFiles() once per measurement in
+ *  a forked child process with the output sent to /dev/null, so every run
+ *  starts with the same process state & its peak RSS is its own.
+ *  System calls are counted by the raw_syscalls:sys_enter tracepoint
+ *  if perf events are allowed. Cold runs drop the page, dentry & inode
+ *  caches before listing, it needs root permissions. Whole runs of
+ *  a tdir executable are timed from the spawn to the exit to measure
+ *  start up costs which listFiles() runs don't include.
+ */
+class BenchRunner
+{
+    public:
+        /*! A function to set a listing mode up */
+        typedef std::function<void (FileEnumerator &enumerator)> SetupFunction;
+
+        /*! \struct Mode
+         *  \brief A benchmarked listing mode.
+         */
+        struct Mode
+        {
+            QString name;           /*!< A mode name */
+            SetupFunction setup;    /*!< Sets the mode up on a new enumerator */
+        };
+
+        /*! \struct Result
+         *  \brief One run measurement.
+         */
+        struct Result
+        {
+            bool ok;                /*!< Set if the run succeeded */
+            qint64 nsecs;           /*!< listFiles() wall time in nanoseconds */
+            qint64 syscalls;        /*!< System calls made by listFiles(), -1 if they can't be counted */
+            qint64 peakRssKb;       /*!< The process peak resident set size in KB, -1 if it is not known */
+        };
+
+        static QList<Mode> modes(int jobs);
+        static bool dropCaches();
+        static Result run(const QString &treePath, const Mode &mode, bool cold);
+        static Result runProgram(const QString &programPath, const QStringList &arguments);
+};
+
+#endif // BENCHRUNNER_H
@@ -0,0 +1,272 @@
+/*! \file       treegenerator.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief Tree Generator module source file.
+ *
+ *  This file contains the TreeGenerator class source code.
+ */
+
+#include "treegenerator.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QPair>
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+/* Bumped when generated trees change, so old trees are regenerated */
+static const int generator_version = 1;
+
+/* Fixed generator seed */
+static const quint64 generator_seed = Q_UINT64_C(0x9E3779B97F4A7C15);
+
+/* Modification times are spread over about 3 years since this time */
+static const qint64 base_mtime = 1500000000;
+
+/*!
+ * \brief TreeGenerator::TreeGenerator
+ * \param[in] rootPath A directory to create trees in
+ *
+ * TreeGenerator Constructor
+ */
+TreeGenerator::TreeGenerator(const QString &rootPath)
+{
+    _rootPath = rootPath;
+    _state = generator_seed;
+}
+
+/*!
+ * \brief TreeGenerator::shapes
+ * \param[in] scale A tree size multiplier, 1 gives about 20000 entries per tree
+ * \return Benchmark tree shapes
+ *
+ * wide - one flat directory with many files,
+ * deep - a long chain of directories with a few files,
+ * small - a bushy tree of directories with small file counts,
+ * mixed - a tree with mixed extensions for mask benchmarks.
+ */
+QList<TreeGenerator::Shape> TreeGenerator::shapes(int scale)
+{
+    scale = qMax(scale, 1);
+    QList<Shape> shapes;
+
+    Shape wide;
+    wide.name = "wide";
+    wide.fanout = 0;
+    wide.depth = 0;
+    wide.filesPerDir = 20000 * scale;
+    wide.extensions << ".dat";
+    shapes.append(wide);
+
+    Shape deep;
+    deep.name = "deep";
+    deep.fanout = 1;
+    deep.depth = 250;                   /* Paths stay below PATH_MAX */
+    deep.filesPerDir = 80 * scale;
+    deep.extensions << ".dat";
+    shapes.append(deep);
+
+    Shape small;
+    small.name = "small";
+    small.fanout = 8;
+    small.depth = 3;
+    small.filesPerDir = 32 * scale;
+    small.extensions << ".txt" << ".dat";
+    shapes.append(small);
+
+    Shape mixed;
+    mixed.name = "mixed";
+    mixed.fanout = 4;
+    mixed.depth = 3;
+    mixed.filesPerDir = 240 * scale;
+    mixed.extensions << ".log" << ".LOG" << ".tmp" << ".txt" << ".cpp" << ".h" << ".jpg" << ".tar.gz";
+    shapes.append(mixed);
+
+    return shapes;
+}
+
+/*!
+ * \brief TreeGenerator::entryCount
+ * \param[in] shape A tree shape
+ * \return Number of files & directories in the tree below its root
+ */
+qint64 TreeGenerator::entryCount(const Shape &shape)
+{
+    qint64 dirs = 1;
+    qint64 levelDirs = 1;
+    for(int level = 0; level < shape.depth; level++)
+    {
+        levelDirs *= shape.fanout;
+        dirs += levelDirs;
+    }
+    return dirs * shape.filesPerDir + (dirs - 1);
+}
+
+/*!
+ * \brief TreeGenerator::treePath
+ * \param[in] shape A tree shape
+ * \return The tree root path
+ */
+QString TreeGenerator::treePath(const Shape &shape) const
+{
+    return QDir(_rootPath).filePath(shape.name);
+}
+
+/*!
+ * \brief TreeGenerator::generate
+ * \param[in] shape A tree shape
+ * \return "false" if the tree can't be created
+ *
+ * Creates the tree unless the same one is already there.
+ */
+bool TreeGenerator::generate(const Shape &shape)
+{
+    QString treeDir = treePath(shape);
+    QFile marker(treeDir + ".done");
+    QByteArray signature = QString("%1 %2 %3 %4 %5\n").arg(generator_version).arg(shape.fanout)
+                           .arg(shape.depth).arg(shape.filesPerDir).arg(shape.extensions.join(QChar(' '))).toUtf8();
+
+    if(marker.open(QIODevice::ReadOnly))
+    {
+        if(marker.readAll() == signature && QDir(treeDir).exists())
+        {
+            return true;
+        }
+        marker.close();
+    }
+
+    QDir(treeDir).removeRecursively();
+    QFile::remove(marker.fileName());
+    if(!QDir().mkpath(treeDir))
+    {
+        return false;
+    }
+
+    /* Every shape has its own sequence (FNV-1a of the name) */
+    quint64 nameHash = Q_UINT64_C(14695981039346656037);
+    foreach (const QChar &nameChar, shape.name) {
+        nameHash = (nameHash ^ nameChar.unicode()) * Q_UINT64_C(1099511628211);
+    }
+    _state = generator_seed ^ nameHash;
+    if(!_createDir(treeDir, shape, 0))
+    {
+        return false;
+    }
+
+    if(!marker.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        return false;
+    }
+    return marker.write(signature) == signature.size();
+}
+
+/*!
+ * \brief TreeGenerator::_next
+ * \return The next pseudo-random number (xorshift64*)
+ */
+quint64 TreeGenerator::_next()
+{
+    _state ^= _state >> 12;
+    _state ^= _state << 25;
+    _state ^= _state >> 27;
+    return _state * Q_UINT64_C(2685821657736338717);
+}
+
+/*!
+ * \brief TreeGenerator::_createDir
+ * \param[in] dirPath An existing directory to fill
+ * \param[in] shape A tree shape
+ * \param[in] level The directory level, the root level is 0
+ * \return "false" on a file system error
+ *
+ * Creates files & subdirectories of one directory, directories
+ * are filled in depth-first order without recursion.
+ */
+bool TreeGenerator::_createDir(const QString &dirPath, const Shape &shape, int level)
+{
+    QList<QPair<QString, int> > stack;
+    stack.append(qMakePair(dirPath, level));
+
+    while(!stack.isEmpty())
+    {
+        QPair<QString, int> current = stack.takeLast();
+        QDir dir(current.first);
+
+        for(int fileNum = 0; fileNum < shape.filesPerDir; fileNum++)
+        {
+            quint64 random = _next();
+            QString name = QString("file_%1_%2%3").arg(fileNum, 6, 10, QChar('0'))
+                                                  .arg(random % 100000, 5, 10, QChar('0'))
+                                                  .arg(shape.extensions.at(int((random >> 32) % quint64(shape.extensions.count()))));
+            if(!_createFile(dir.filePath(name)))
+            {
+                return false;
+            }
+        }
+
+        if(current.second >= shape.depth)
+        {
+            continue;
+        }
+
+        for(int subdirNum = shape.fanout - 1; subdirNum >= 0; subdirNum--)
+        {
+            QString subdir = dir.filePath(QString("dir_%1").arg(subdirNum, 3, 10, QChar('0')));
+            if(!dir.mkdir(QFileInfo(subdir).fileName()))
+            {
+                return false;
+            }
+            stack.append(qMakePair(subdir, current.second + 1));
+        }
+    }
+
+    return true;
+}
+
+/*!
+ * \brief TreeGenerator::_createFile
+ * \param[in] filePath A file path
+ * \return "false" on a file system error
+ *
+ * Creates a sparse file of a pseudo-random size & modification time.
+ */
+bool TreeGenerator::_createFile(const QString &filePath)
+{
+    quint64 random = _next();
+    qint64 size = qint64(random % 65536);
+    qint64 mtime = base_mtime + qint64((random >> 16) % 100000000);
+
+#ifdef Q_OS_UNIX
+    int fd = open(QFile::encodeName(filePath).constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(fd < 0)
+    {
+        return false;
+    }
+
+    bool ok = (ftruncate(fd, size) == 0);
+
+    struct timespec times[2];
+    times[0].tv_sec = mtime;
+    times[0].tv_nsec = 0;
+    times[1].tv_sec = mtime;
+    times[1].tv_nsec = long((random >> 40) % 1000000000);
+    ok = ok && (futimens(fd, times) == 0);
+
+    close(fd);
+    return ok;
+#else
+    QFile file(filePath);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || !file.resize(size))
+    {
+        return false;
+    }
+    return file.setFileTime(QDateTime::fromSecsSinceEpoch(mtime), QFileDevice::FileModificationTime);
+#endif
+}
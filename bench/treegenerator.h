@@ -0,0 +1,57 @@
+/*! \file       treegenerator.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      Tree Generator module header file.
+ *
+ *  This file contains the TreeGenerator class declaration.
+ */
+
+#ifndef TREEGENERATOR_H
+#define TREEGENERATOR_H
+
+#include <QtCore/qglobal.h>
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+/*! \class TreeGenerator
+ *  \brief Synthetic directory tree generator class.
+ *
+ *  This class creates benchmark trees of a few shapes. Names, sizes
+ *  & modification times come from a fixed seed pseudo-random sequence,
+ *  so the same shape & scale always give the same tree on any machine.
+ *  Files are sparse, only their metadata is written. A generated tree
+ *  is kept with a marker & reused while its shape version & scale match.
+ */
+class TreeGenerator
+{
+    public:
+        /*! \struct Shape
+         *  \brief A tree shape.
+         */
+        struct Shape
+        {
+            QString name;           /*!< A shape name & the tree directory name */
+            int fanout;             /*!< Subdirectories per directory */
+            int depth;              /*!< Directory levels below the root */
+            int filesPerDir;        /*!< Files in every directory */
+            QStringList extensions; /*!< File name extensions to choose from */
+        };
+
+        explicit TreeGenerator(const QString &rootPath);
+        static QList<Shape> shapes(int scale);
+        static qint64 entryCount(const Shape &shape);
+        QString treePath(const Shape &shape) const;
+        bool generate(const Shape &shape);
+    private:
+        QString _rootPath;          /*!< A directory to create trees in */
+        quint64 _state;             /*!< Pseudo-random generator state */
+
+        quint64 _next();
+        bool _createDir(const QString &dirPath, const Shape &shape, int level);
+        bool _createFile(const QString &filePath);
+};
+
+#endif // TREEGENERATOR_H
@@ -0,0 +1,221 @@
+/*! \file       contenthash.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief Content Hash module source file.
+ *
+ *  This file contains the ContentHash class source code.
+ */
+
+#include "contenthash.h"
+
+#include <QtEndian>
+
+#include <string.h>
+
+/* XXH64 primes */
+static const quint64 prime1 = Q_UINT64_C(11400714785074694791);
+static const quint64 prime2 = Q_UINT64_C(14029467366897019727);
+static const quint64 prime3 = Q_UINT64_C(1609587929392839161);
+static const quint64 prime4 = Q_UINT64_C(9650029242287828579);
+static const quint64 prime5 = Q_UINT64_C(2870177450012600261);
+
+/*!
+ * \brief rotateLeft
+ * \param[in] value A value
+ * \param[in] bits Bits to rotate by
+ * \return The rotated value
+ */
+static inline quint64 rotateLeft(quint64 value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+/*!
+ * \brief read64
+ * \param[in] data 8 bytes
+ * \return A little-endian number
+ */
+static inline quint64 read64(const char *data)
+{
+    quint64 value;
+    memcpy(&value, data, sizeof(value));
+    return qFromLittleEndian(value);
+}
+
+/*!
+ * \brief read32
+ * \param[in] data 4 bytes
+ * \return A little-endian number
+ */
+static inline quint32 read32(const char *data)
+{
+    quint32 value;
+    memcpy(&value, data, sizeof(value));
+    return qFromLittleEndian(value);
+}
+
+/*!
+ * \brief round
+ * \param[in] accumulator A lane accumulator
+ * \param[in] input 8 input bytes
+ * \return The new accumulator
+ */
+static inline quint64 round(quint64 accumulator, quint64 input)
+{
+    accumulator += input * prime2;
+    accumulator = rotateLeft(accumulator, 31);
+    return accumulator * prime1;
+}
+
+/*!
+ * \brief mergeRound
+ * \param[in] hash A hash
+ * \param[in] lane A lane accumulator
+ * \return The hash with the lane merged
+ */
+static inline quint64 mergeRound(quint64 hash, quint64 lane)
+{
+    hash ^= round(0, lane);
+    return hash * prime1 + prime4;
+}
+
+/*!
+ * \brief ContentHash::ContentHash
+ * \param[in] seed A hash seed
+ *
+ * ContentHash Constructor
+ */
+ContentHash::ContentHash(quint64 seed)
+{
+    _seed = seed;
+    _lanes[0] = seed + prime1 + prime2;
+    _lanes[1] = seed + prime2;
+    _lanes[2] = seed;
+    _lanes[3] = seed - prime1;
+    _stripeSize = 0;
+    _total = 0;
+}
+
+/*!
+ * \brief ContentHash::add
+ * \param[in] data Data to hash
+ * \param[in] size The data size in bytes
+ */
+void ContentHash::add(const char *data, qint64 size)
+{
+    _total += quint64(size);
+
+    /* Completing a stripe left from the previous piece */
+    if(_stripeSize > 0)
+    {
+        int taken = int(qMin(qint64(32 - _stripeSize), size));
+        memcpy(_stripe + _stripeSize, data, taken);
+        _stripeSize += taken;
+        data += taken;
+        size -= taken;
+
+        if(_stripeSize < 32)
+        {
+            return;
+        }
+
+        for(int lane = 0; lane < 4; lane++)
+        {
+            _lanes[lane] = round(_lanes[lane], read64(_stripe + lane * 8));
+        }
+        _stripeSize = 0;
+    }
+
+    /* Whole stripes are hashed in place, the lanes are independent */
+    quint64 lane0 = _lanes[0];
+    quint64 lane1 = _lanes[1];
+    quint64 lane2 = _lanes[2];
+    quint64 lane3 = _lanes[3];
+    while(size >= 32)
+    {
+        lane0 = round(lane0, read64(data));
+        lane1 = round(lane1, read64(data + 8));
+        lane2 = round(lane2, read64(data + 16));
+        lane3 = round(lane3, read64(data + 24));
+        data += 32;
+        size -= 32;
+    }
+    _lanes[0] = lane0;
+    _lanes[1] = lane1;
+    _lanes[2] = lane2;
+    _lanes[3] = lane3;
+
+    memcpy(_stripe, data, size_t(size));
+    _stripeSize = int(size);
+}
+
+/*!
+ * \brief ContentHash::result
+ * \return The hash of all added data
+ */
+quint64 ContentHash::result() const
+{
+    quint64 hash;
+    if(_total >= 32)
+    {
+        hash = rotateLeft(_lanes[0], 1) + rotateLeft(_lanes[1], 7) +
+               rotateLeft(_lanes[2], 12) + rotateLeft(_lanes[3], 18);
+        for(int lane = 0; lane < 4; lane++)
+        {
+            hash = mergeRound(hash, _lanes[lane]);
+        }
+    }
+    else
+    {
+        hash = _seed + prime5;
+    }
+    hash += _total;
+
+    /* The tail of less than a stripe */
+    const char *tail = _stripe;
+    int size = _stripeSize;
+    while(size >= 8)
+    {
+        hash ^= round(0, read64(tail));
+        hash = rotateLeft(hash, 27) * prime1 + prime4;
+        tail += 8;
+        size -= 8;
+    }
+    if(size >= 4)
+    {
+        hash ^= quint64(read32(tail)) * prime1;
+        hash = rotateLeft(hash, 23) * prime2 + prime3;
+        tail += 4;
+        size -= 4;
+    }
+    while(size > 0)
+    {
+        hash ^= quint64(quint8(*tail)) * prime5;
+        hash = rotateLeft(hash, 11) * prime1;
+        tail++;
+        size--;
+    }
+
+    /* Avalanche */
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    hash *= prime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+/*!
+ * \brief ContentHash::hash
+ * \param[in] data Data to hash
+ * \param[in] size The data size in bytes
+ * \param[in] seed A hash seed
+ * \return The data hash
+ */
+quint64 ContentHash::hash(const char *data, qint64 size, quint64 seed)
+{
+    ContentHash contentHash(seed);
+    contentHash.add(data, size);
+    return contentHash.result();
+}
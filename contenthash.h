@@ -0,0 +1,38 @@
+/*! \file       contenthash.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      Content Hash module header file.
+ *
+ *  This file contains the ContentHash class declaration.
+ */
+
+#ifndef CONTENTHASH_H
+#define CONTENTHASH_H
+
+#include <QtCore/qglobal.h>
+
+/*! \class ContentHash
+ *  \brief Streaming 64-bit content hash class.
+ *
+ *  This class computes XXH64. The input is consumed in 32 byte stripes by
+ *  four independent lanes, so the compiler keeps them in parallel & the
+ *  hash runs at memory speed. Data may be added in pieces of any size,
+ *  the result is the same as hashing it at once.
+ */
+class ContentHash
+{
+    public:
+        explicit ContentHash(quint64 seed = 0);
+        void add(const char *data, qint64 size);
+        quint64 result() const;
+        static quint64 hash(const char *data, qint64 size, quint64 seed = 0);
+    private:
+        quint64 _seed;          /*!< A hash seed */
+        quint64 _lanes[4];      /*!< Stripe accumulators */
+        char _stripe[32];       /*!< Bytes of an incomplete stripe */
+        int _stripeSize;        /*!< Number of bytes in the incomplete stripe */
+        quint64 _total;         /*!< Number of added bytes */
+};
+
+#endif // CONTENTHASH_H
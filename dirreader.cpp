@@ -0,0 +1,1151 @@
+/*! \file       dirreader.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief Directory Reader module source file.
+ *
+ *  This file contains the DirReader class source code.
+ */
+
+#include "dirreader.h"
+#include "uringstat.h"
+#include "scanstats.h"
+#include "filepredicate.h"
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QScopedPointer>
+
+#include <algorithm>
+#include <climits>
+
+/* Initial capacity of a record name buffer */
+static const int record_names_reserve = 16 * 1024;
+
+/*! \struct SortKey
+ *  \brief An entry sorting key.
+ */
+struct SortKey
+{
+    QString lowerName;  /*!< A decoded entry name in lower case */
+    QString name;       /*!< A decoded entry name */
+    int index;          /*!< An entry index */
+};
+
+#ifdef Q_OS_LINUX
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+/*! A raw directory entry record returned by getdents64 */
+struct linux_dirent64
+{
+    quint64 d_ino;              /*!< An inode number */
+    qint64 d_off;               /*!< An offset to the next record */
+    unsigned short d_reclen;    /*!< This record length */
+    unsigned char d_type;       /*!< An entry type */
+    char d_name[];              /*!< A null terminated entry name */
+};
+
+/* A buffer size to read directory entries of a stream with one system call */
+static const int dirstream_buffer_size = 32 * 1024;
+
+/*! \struct PendingEntry
+ *  \brief A file or a link waiting to be stated.
+ */
+struct PendingEntry
+{
+    int record;             /*!< An index of the record to store the size & modification time to */
+    bool matches;           /*!< Set if the name matches the filters */
+    bool check;             /*!< Set if the predicate needs stated fields to decide */
+    bool link;              /*!< Set if the directory entry type is a symbolic link */
+    bool unknownType;       /*!< Set if the file system doesn't tell the directory entry type */
+    int request;            /*!< An index of the stat request of the entry */
+};
+
+/* Stat requests of the current thread, reused by all streams to keep their capacity */
+static thread_local QVector<PendingEntry> thread_pending;
+static thread_local QVector<UringStat::Request> thread_requests;
+static thread_local QVector<int> thread_order;
+
+/* io_uring queue depth DirReader::read() stats entries with, 0 to stat them one by one */
+static int stat_batch_depth = 0;
+
+/* Set to stat entries of a chunk in inode order in DirReader::read() */
+static bool stat_inode_order = false;
+
+/* A ring of the current thread created on the first batch & the depth it was asked for */
+static thread_local QScopedPointer<UringStat> thread_ring;
+static thread_local int thread_ring_depth = 0;
+
+#ifdef STATX_SIZE
+/* Cleared on the first ENOSYS from statx to use fstatat afterwards */
+static volatile bool statx_supported = true;
+#endif
+
+/*!
+ * \brief statEntry
+ * \param[in] dirFd An open directory descriptor
+ * \param[in] name An entry name relative to the directory
+ * \param[out] mode An entry type & mode
+ * \param[out] entry An entry to store the size & modification time to
+ * \return "true" on success
+ *
+ * Stats an entry relative to the directory following symbolic links.
+ */
+static bool statEntry(int dirFd, const char *name, unsigned int &mode, DirEntry &entry)
+{
+#ifdef STATX_SIZE
+    if(statx_supported)
+    {
+        struct statx stx;
+        if(statx(dirFd, name, 0, STATX_TYPE | STATX_MODE | STATX_UID | STATX_NLINK | STATX_INO | STATX_SIZE | STATX_MTIME | STATX_CTIME | STATX_BLOCKS, &stx) == 0)
+        {
+            mode = stx.stx_mode;
+            entry.size = stx.stx_size;
+            entry.mtime = qint64(stx.stx_mtime.tv_sec) * 1000 + stx.stx_mtime.tv_nsec / 1000000;
+            entry.blocks = stx.stx_blocks;
+            entry.mtimeNsec = int(stx.stx_mtime.tv_nsec % 1000000);
+            entry.mode = stx.stx_mode;
+            entry.inode = stx.stx_ino;
+            entry.ctime = qint64(stx.stx_ctime.tv_sec) * 1000 + stx.stx_ctime.tv_nsec / 1000000;
+            entry.uid = stx.stx_uid;
+            entry.links = stx.stx_nlink;
+            return true;
+        }
+        if(errno != ENOSYS)
+        {
+            return false;
+        }
+        statx_supported = false;
+    }
+#endif
+
+    struct stat st;
+    if(fstatat(dirFd, name, &st, 0) != 0)
+    {
+        return false;
+    }
+
+    mode = st.st_mode;
+    entry.size = st.st_size;
+    entry.mtime = qint64(st.st_mtim.tv_sec) * 1000 + st.st_mtim.tv_nsec / 1000000;
+    entry.blocks = st.st_blocks;
+    entry.mtimeNsec = int(st.st_mtim.tv_nsec % 1000000);
+    entry.mode = st.st_mode;
+    entry.inode = st.st_ino;
+    entry.ctime = qint64(st.st_ctim.tv_sec) * 1000 + st.st_ctim.tv_nsec / 1000000;
+    entry.uid = st.st_uid;
+    entry.links = st.st_nlink;
+    return true;
+}
+
+/*!
+ * \brief statEntries
+ * \param[in] dirFd An open directory descriptor
+ * \param[in] batchDepth io_uring queue depth, 0 to stat entries one by one
+ * \param[in,out] requests Entries to stat, the mode is 0 for entries which can't be stated
+ *
+ * Stats entries of one directory in io_uring batches if they are enabled,
+ * the rest is stated one by one.
+ */
+static void statEntries(int dirFd, int batchDepth, QVector<UringStat::Request> &requests)
+{
+    if(batchDepth > 0 && requests.count() > 1)
+    {
+        if(thread_ring.isNull() || thread_ring_depth != batchDepth)
+        {
+            thread_ring.reset(new UringStat(batchDepth));
+            thread_ring_depth = batchDepth;
+        }
+        if(thread_ring->isValid())
+        {
+            thread_ring->stat(dirFd, requests);
+        }
+    }
+
+    for(int requestNum = 0; requestNum < requests.count(); requestNum++)
+    {
+        UringStat::Request &request = requests[requestNum];
+        if(request.done)
+        {
+            continue;
+        }
+
+        DirEntry entry;
+        if(!statEntry(dirFd, request.name, request.mode, entry))
+        {
+            request.mode = 0;
+        }
+        request.size = entry.size;
+        request.mtime = entry.mtime;
+        request.blocks = entry.blocks;
+        request.mtimeNsec = entry.mtimeNsec;
+        request.inode = entry.inode;
+        request.ctime = entry.ctime;
+        request.uid = entry.uid;
+        request.links = entry.links;
+        request.done = true;
+    }
+}
+#endif
+
+/*!
+ * \brief DirReader::isSupported
+ * \return "true" if the native reader can be used on this platform
+ */
+bool DirReader::isSupported()
+{
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+/*!
+ * \brief DirReader::setStatBatchDepth
+ * \param[in] depth io_uring queue depth, 0 to stat entries one by one
+ * \return "false" if io_uring statx is not supported, entries are stated one by one then
+ *
+ * The depth is used by read() in the whole process, streams take their own one.
+ * It must be called before directories are read.
+ */
+bool DirReader::setStatBatchDepth(int depth)
+{
+#ifdef Q_OS_LINUX
+    if(depth > 0 && UringStat::isSupported())
+    {
+        stat_batch_depth = depth;
+        return true;
+    }
+#endif
+    stat_batch_depth = 0;
+    return depth <= 0;
+}
+
+/*!
+ * \brief DirReader::setInodeOrder
+ * \param[in] inodeOrder Set to "true" to stat entries of a chunk in inode order
+ *
+ * Inode tables are laid out by inode number on most local file systems, so
+ * stating in this order seeks less on rotating disks & reads inode blocks
+ * once. Entries are returned in the same order anyway. The order is used
+ * by read() in the whole process, streams take their own one. It must be
+ * called before directories are read.
+ */
+void DirReader::setInodeOrder(bool inodeOrder)
+{
+    stat_inode_order = inodeOrder;
+}
+
+/*!
+ * \brief DirReader::read
+ * \param[in] dirPath A directory to read
+ * \param[in] matcher File name patterns, files are not filtered if it is empty
+ * \param[in] listDirs Set to "true" to get subdirectories too
+ * \param[out] entries Matching files & subdirectories
+ * \return "false" if the directory can't be read
+ *
+ * Reads a whole directory in one pass, entries are sorted by sortFitting(). Hidden entries, broken links & special
+ * files are skipped the same way QDir does it. On other platforms
+ * the directory is read by QDir.
+ */
+bool DirReader::read(const QString &dirPath, const GlobMatcher &matcher,
+                     bool listDirs, QVector<DirEntry> &entries)
+{
+    entries.clear();
+
+#ifdef Q_OS_LINUX
+    DirStream stream(dirPath);
+    stream.setInodeOrder(stat_inode_order);
+    stream.setStatBatchDepth(stat_batch_depth);
+    if(!stream.open())
+    {
+        return false;
+    }
+
+    while(!stream.atEnd())
+    {
+        stream.read(matcher, true, listDirs, INT_MAX, entries);
+    }
+    stream.close();
+
+    sortFitting(entries);
+    return true;
+#else
+    QDir dir(dirPath);
+    if(!dir.exists())
+    {
+        return false;
+    }
+
+    foreach (const QFileInfo &fileInfo, dir.entryInfoList(QDir::Files)) {
+        DirEntry entry;
+        entry.name = QFile::encodeName(fileInfo.fileName());
+        if(!matcher.matches(entry.name))
+        {
+            continue;
+        }
+
+        entry.isDir = false;
+        entry.size = fileInfo.size();
+        entry.mtime = fileInfo.lastModified().toMSecsSinceEpoch();
+        entry.blocks = (entry.size + 511) / 512;   /* Allocation is not known here */
+        entry.mtimeNsec = 0;
+        entry.mode = 0;               /* Only the native reader knows the mode & inode */
+        entry.inode = 0;
+        entry.ctime = 0;              /* The status change time is not known here */
+        entry.uid = fileInfo.ownerId();
+        entry.links = 1;               /* Hard links are not known here */
+        entry.isLink = fileInfo.isSymLink();
+        if(matcher.predicate() && !matcher.predicate()->matches(entry))
+        {
+            continue;
+        }
+        entries.append(entry);
+    }
+
+    if(listDirs)
+    {
+        foreach (const QString &subdir, dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+            DirEntry entry;
+            entry.name = QFile::encodeName(subdir);
+            entry.isDir = true;
+            entry.size = 0;
+            entry.mtime = 0;
+            entry.blocks = 0;
+            entry.mtimeNsec = 0;
+            entry.mode = 0;
+            entry.inode = 0;
+            entry.ctime = 0;
+            entry.uid = 0;
+            entry.links = 0;
+            entry.isLink = false;
+            entries.append(entry);
+        }
+    }
+
+    return true;
+#endif
+}
+
+/*!
+ * \brief entryName
+ * \param[in] entry An entry
+ * \return The decoded entry name
+ */
+static inline QString entryName(const DirEntry &entry)
+{
+    return QFile::decodeName(entry.name);
+}
+
+/*!
+ * \brief entryName
+ * \param[in] record A record
+ * \return The decoded record name
+ */
+static inline QString entryName(const EntryRecord &record)
+{
+    return QFile::decodeName(QByteArray::fromRawData(record.name, record.nameSize));
+}
+
+/*!
+ * \brief sortByName
+ * \param[in,out] entries Entries or records to sort
+ *
+ * Sorts by name the same way as QDir::Name | QDir::IgnoreCase does.
+ */
+template<typename Entry>
+static void sortByName(QVector<Entry> &entries)
+{
+    QVector<SortKey> keys;
+    keys.reserve(entries.count());
+    for(int entryNum = 0; entryNum < entries.count(); entryNum++)
+    {
+        SortKey key;
+        key.name = entryName(entries.at(entryNum));
+        key.lowerName = key.name.toLower();
+        key.index = entryNum;
+        keys.append(key);
+    }
+
+    std::sort(keys.begin(), keys.end(), [](const SortKey &left, const SortKey &right) {
+        int result = left.lowerName.compare(right.lowerName);
+        if(result == 0)
+        {
+            result = left.name.compare(right.name);
+        }
+        return result < 0;
+    });
+
+    QVector<Entry> sorted;
+    sorted.reserve(entries.count());
+    for(int keyNum = 0; keyNum < keys.count(); keyNum++)
+    {
+        sorted.append(entries.at(keys.at(keyNum).index));
+    }
+    entries.swap(sorted);
+}
+
+/*!
+ * \brief DirReader::sort
+ * \param[in,out] entries Entries to sort
+ *
+ * Sorts entries by name the same way as QDir::Name | QDir::IgnoreCase does.
+ */
+void DirReader::sort(QVector<DirEntry> &entries)
+{
+    sortByName(entries);
+}
+
+/*!
+ * \brief DirReader::sort
+ * \param[in,out] records Records to sort
+ *
+ * Sorts records the same way as entries, names are decoded for comparison only.
+ */
+void DirReader::sort(QVector<EntryRecord> &records)
+{
+    sortByName(records);
+}
+
+/*!
+ * \brief DirReader::sortFitting
+ * \param[in,out] entries Files & subdirectories of one directory
+ *
+ * Sorts files by name if they fit in one file chunk & subdirectories
+ * if they fit in one subdirectory chunk, which is the order a tree walk
+ * reading the directory in chunks gives. The rest keeps the file system order.
+ */
+void DirReader::sortFitting(QVector<DirEntry> &entries)
+{
+    int dirCount = 0;
+    foreach (const DirEntry &entry, entries) {
+        dirCount += entry.isDir ? 1 : 0;
+    }
+
+    bool sortFiles = (entries.count() - dirCount < DirStream::file_chunk_size);
+    bool sortDirs = (dirCount < DirStream::subdir_chunk_size);
+    if(sortFiles && sortDirs)
+    {
+        sortByName(entries);
+        return;
+    }
+
+    /* Files & subdirectories are used apart, so they are split to sort one of them */
+    QVector<DirEntry> files;
+    QVector<DirEntry> dirs;
+    files.reserve(entries.count() - dirCount);
+    dirs.reserve(dirCount);
+    foreach (const DirEntry &entry, entries) {
+        if(entry.isDir)
+        {
+            dirs.append(entry);
+        }
+        else
+        {
+            files.append(entry);
+        }
+    }
+
+    if(sortFiles)
+    {
+        sortByName(files);
+    }
+    if(sortDirs)
+    {
+        sortByName(dirs);
+    }
+    files += dirs;
+    entries = files;
+}
+
+/*!
+ * \brief byInode
+ * \param[in,out] entries Entries or records to sort
+ *
+ * Sorts by inode number keeping the order of equal ones.
+ */
+template<typename Entry>
+static void byInode(QVector<Entry> &entries)
+{
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry &left, const Entry &right) {
+        return left.inode < right.inode;
+    });
+}
+
+/*!
+ * \brief DirReader::sortByInode
+ * \param[in,out] entries Entries to sort
+ *
+ * Sorts entries in inode order, which is the order their inodes
+ * are found on disk of most local file systems.
+ */
+void DirReader::sortByInode(QVector<DirEntry> &entries)
+{
+    byInode(entries);
+}
+
+/*!
+ * \brief DirReader::sortByInode
+ * \param[in,out] records Records to sort
+ */
+void DirReader::sortByInode(QVector<EntryRecord> &records)
+{
+    byInode(records);
+}
+
+/*!
+ * \brief DirReader::toEntry
+ * \param[in] record A record
+ * \return An entry owning a copy of the record name
+ */
+DirEntry DirReader::toEntry(const EntryRecord &record)
+{
+    DirEntry entry;
+    entry.name = QByteArray(record.name, record.nameSize);
+    entry.isDir = record.isDir;
+    entry.size = record.size;
+    entry.mtime = record.mtime;
+    entry.blocks = record.blocks;
+    entry.mtimeNsec = record.mtimeNsec;
+    entry.mode = record.mode;
+    entry.inode = record.inode;
+    entry.ctime = record.ctime;
+    entry.uid = record.uid;
+    entry.links = record.links;
+    entry.isLink = record.isLink;
+    return entry;
+}
+
+/*!
+ * \brief DirReader::readEntry
+ * \param[in] dirPath A directory path
+ * \param[in] name An entry name
+ * \param[out] entry The entry following symbolic links
+ * \return "false" if the entry doesn't exist or it is not a file or a directory
+ *
+ * Reads one directory entry the same way as read() does.
+ */
+bool DirReader::readEntry(const QString &dirPath, const QByteArray &name, DirEntry &entry)
+{
+    entry.name = name;
+    entry.isDir = false;
+    entry.size = 0;
+    entry.mtime = 0;
+    entry.blocks = 0;
+    entry.mtimeNsec = 0;
+    entry.mode = 0;
+    entry.inode = 0;
+    entry.ctime = 0;
+    entry.uid = 0;
+    entry.links = 0;
+    entry.isLink = false;
+
+#ifdef Q_OS_LINUX
+    int dirFd = open(QFile::encodeName(dirPath).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(dirFd < 0)
+    {
+        return false;
+    }
+
+    unsigned int mode = 0;
+    bool exists = statEntry(dirFd, name.constData(), mode, entry);
+    ScanStats::add(ScanStats::STATS_ISSUED, 1);
+
+    /* Links are told by the entry itself the same way as its directory entry type does */
+    struct stat linkStat;
+    entry.isLink = exists && fstatat(dirFd, name.constData(), &linkStat, AT_SYMLINK_NOFOLLOW) == 0 &&
+                   S_ISLNK(linkStat.st_mode);
+    close(dirFd);
+
+    if(!exists || (!S_ISDIR(mode) && !S_ISREG(mode)))
+    {
+        return false;
+    }
+
+    if(S_ISDIR(mode))
+    {
+        entry.isDir = true;
+        entry.size = 0;
+        entry.mtime = 0;
+        entry.blocks = 0;
+        entry.mtimeNsec = 0;
+        entry.mode = 0;
+        entry.inode = 0;
+        entry.ctime = 0;
+        entry.uid = 0;
+        entry.links = 0;
+        entry.isLink = false;
+    }
+    return true;
+#else
+    QFileInfo fileInfo(QDir(dirPath), QFile::decodeName(name));
+    if(fileInfo.isDir())
+    {
+        entry.isDir = true;
+        return true;
+    }
+    if(!fileInfo.isFile())
+    {
+        return false;
+    }
+
+    entry.size = fileInfo.size();
+    entry.mtime = fileInfo.lastModified().toMSecsSinceEpoch();
+    entry.blocks = (entry.size + 511) / 512;   /* Allocation is not known here */
+    entry.mtimeNsec = 0;
+    entry.mode = 0;               /* Only the native reader knows the mode & inode */
+    entry.inode = 0;
+    entry.uid = fileInfo.ownerId();
+    entry.links = 1;               /* Hard links are not known here */
+    entry.isLink = fileInfo.isSymLink();
+    return true;
+#endif
+}
+
+/*!
+ * \brief DirReader::statDir
+ * \param[in] dirPath A directory to stat
+ * \param[out] mtime The directory modification time in nanoseconds since epoch
+ * \param[out] ctime The directory status change time in nanoseconds since epoch
+ * \return "false" if the directory can't be stated
+ *
+ * Gets the directory times which change when its entries are added,
+ * removed or renamed. The status change time is 0 where it is not available.
+ */
+bool DirReader::statDir(const QString &dirPath, qint64 &mtime, qint64 &ctime)
+{
+#ifdef Q_OS_LINUX
+    struct stat st;
+    if(stat(QFile::encodeName(dirPath).constData(), &st) != 0 || !S_ISDIR(st.st_mode))
+    {
+        return false;
+    }
+
+    mtime = qint64(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    ctime = qint64(st.st_ctim.tv_sec) * 1000000000 + st.st_ctim.tv_nsec;
+    return true;
+#else
+    QFileInfo dirInfo(dirPath);
+    if(!dirInfo.isDir())
+    {
+        return false;
+    }
+
+    mtime = dirInfo.lastModified().toMSecsSinceEpoch() * 1000000;
+    ctime = 0;
+    return true;
+#endif
+}
+
+/*!
+ * \brief DirStream::DirStream
+ * \param[in] dirPath A directory to read
+ *
+ * DirStream Constructor, the directory is opened by open() or the first read()
+ */
+DirStream::DirStream(const QString &dirPath)
+{
+    _path = dirPath;
+    _fd = -1;
+    _bufferPos = 0;
+    _bufferSize = 0;
+    _offset = 0;
+    _atEnd = false;
+    _next = 0;
+    _readNsecs = 0;
+    _inodeOrder = false;
+    _statBatchDepth = 0;
+}
+
+/*!
+ * \brief DirStream::~DirStream
+ *
+ * DirStream Destructor
+ */
+DirStream::~DirStream()
+{
+    close();
+}
+
+/*!
+ * \brief DirStream::path
+ * \return The directory path
+ */
+const QString &DirStream::path() const
+{
+    return _path;
+}
+
+/*!
+ * \brief DirStream::open
+ * \return "false" if the directory can't be opened
+ *
+ * Opens the directory at the position it was closed at.
+ */
+bool DirStream::open()
+{
+    if(isOpen())
+    {
+        return true;
+    }
+
+#ifdef Q_OS_LINUX
+    _fd = ::open(QFile::encodeName(_path).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(_fd < 0)
+    {
+        return false;
+    }
+    ScanStats::add(ScanStats::DIRS_OPENED, 1);
+
+    /* Continuing from the last consumed entry */
+    if(_offset != 0 && lseek(_fd, _offset, SEEK_SET) < 0)
+    {
+        ::close(_fd);
+        _fd = -1;
+        return false;
+    }
+
+    _buffer.resize(dirstream_buffer_size);
+    _bufferPos = 0;
+    _bufferSize = 0;
+    return true;
+#else
+    /* The whole directory is read by QDir, entries are filtered by read() */
+    if(!DirReader::read(_path, GlobMatcher(), true, _entries))
+    {
+        return false;
+    }
+    ScanStats::add(ScanStats::DIRS_OPENED, 1);
+    _fd = 0;
+    return true;
+#endif
+}
+
+/*!
+ * \brief DirStream::close
+ *
+ * Closes the directory keeping the position, so it can be opened again
+ * to continue reading. Buffered entries are released.
+ */
+void DirStream::close()
+{
+#ifdef Q_OS_LINUX
+    if(_fd >= 0)
+    {
+        ::close(_fd);
+    }
+    _buffer.clear();
+    _bufferPos = 0;
+    _bufferSize = 0;
+#endif
+    _records.clear();
+    _names.clear();
+    _fd = -1;
+}
+
+/*!
+ * \brief DirStream::isOpen
+ * \return "true" if the directory is open
+ */
+bool DirStream::isOpen() const
+{
+    return _fd >= 0;
+}
+
+/*!
+ * \brief DirStream::atEnd
+ * \return "true" if all entries have been read
+ */
+bool DirStream::atEnd() const
+{
+    return _atEnd;
+}
+
+/*!
+ * \brief DirStream::setInodeOrder
+ * \param[in] inodeOrder Set to "true" to stat entries of a chunk in inode order
+ */
+void DirStream::setInodeOrder(bool inodeOrder)
+{
+    _inodeOrder = inodeOrder;
+}
+
+/*!
+ * \brief DirStream::setStatBatchDepth
+ * \param[in] depth io_uring queue depth, 0 to stat entries one by one
+ *
+ * Entries are stated one by one where io_uring statx is not supported.
+ */
+void DirStream::setStatBatchDepth(int depth)
+{
+    _statBatchDepth = depth;
+}
+
+/*!
+ * \brief DirStream::rewind
+ *
+ * Moves to the first directory entry.
+ */
+void DirStream::rewind()
+{
+    _offset = 0;
+    _atEnd = false;
+    _readNsecs = 0;
+    _next = 0;
+
+#ifdef Q_OS_LINUX
+    _bufferPos = 0;
+    _bufferSize = 0;
+    if(_fd >= 0 && lseek(_fd, 0, SEEK_SET) < 0)
+    {
+        close();
+    }
+#endif
+}
+
+/*!
+ * \brief setNames
+ * \param[in,out] records Records to point to their names
+ * \param[in] names Record names in the record order, each is followed by a null
+ */
+static void setNames(QVector<EntryRecord> &records, const QByteArray &names)
+{
+    const char *name = names.constData();
+    for(int recordNum = 0; recordNum < records.count(); recordNum++)
+    {
+        records[recordNum].name = name;
+        name += records.at(recordNum).nameSize + 1;
+    }
+}
+
+/*!
+ * \brief DirStream::read
+ * \param[in] matcher File name patterns, files are not filtered if it is empty
+ * \param[in] files Set to "true" to get files
+ * \param[in] dirs Set to "true" to get subdirectories
+ * \param[in] maxEntries Maximal number of files & of subdirectories to read
+ * \param[out] entries A vector to append read entries to
+ * \return Number of appended entries
+ *
+ * Reads the next entries the same way as the record read does,
+ * every entry gets a copy of its name.
+ */
+int DirStream::read(const GlobMatcher &matcher, bool files, bool dirs, int maxEntries, QVector<DirEntry> &entries)
+{
+    int count = read(matcher, files, dirs, maxEntries, _records, _names);
+
+    entries.reserve(entries.count() + count);
+    for(int recordNum = 0; recordNum < count; recordNum++)
+    {
+        entries.append(DirReader::toEntry(_records.at(recordNum)));
+    }
+    return count;
+}
+
+/*!
+ * \brief DirStream::read
+ * \param[in] matcher File name patterns, files are not filtered if it is empty
+ * \param[in] files Set to "true" to get files
+ * \param[in] dirs Set to "true" to get subdirectories
+ * \param[in] maxEntries Maximal number of files & of subdirectories to read
+ * \param[out] records Read records replacing the previous ones
+ * \param[out] names A buffer for the record names replacing the previous ones
+ * \return Number of read records
+ *
+ * Reads the next entries in the file system order, the directory is opened
+ * again if it was closed. Files & subdirectories are counted apart, so
+ * a chunk ends when either of them reaches the limit. Fewer entries than
+ * requested may be read before the end, so the reading stops when atEnd() is "true".
+ * The vector & the buffer keep their capacity, so a caller reusing them
+ * reads without memory allocation once they have grown to a chunk size.
+ */
+int DirStream::read(const GlobMatcher &matcher, bool files, bool dirs, int maxEntries,
+                    QVector<EntryRecord> &records, QByteArray &names)
+{
+    /* Only a reserved buffer keeps its capacity on resize(0) */
+    if(names.capacity() == 0)
+    {
+        names.reserve(record_names_reserve);
+    }
+    records.resize(0);
+    names.resize(0);
+
+    if(_atEnd || !open())
+    {
+        _atEnd = true;
+        return 0;
+    }
+
+    /* Statistics are timed per call, the directory read time is added up to its end */
+    qint64 readStart = ScanStats::isEnabled() ? ScanStats::now() : 0;
+    int seen = 0;
+    int matched = 0;
+    int dirCount = 0;
+
+    EntryRecord entry;
+    entry.name = nullptr;
+    entry.parent = -1;
+    entry.size = 0;
+    entry.mtime = 0;
+    entry.blocks = 0;
+    entry.mtimeNsec = 0;
+    entry.mode = 0;
+    entry.inode = 0;
+    entry.ctime = 0;
+    entry.uid = 0;
+    entry.links = 0;
+    entry.isLink = false;
+
+    const FilePredicate *predicate = matcher.predicate();
+
+#ifdef Q_OS_LINUX
+    QVector<PendingEntry> &pending = thread_pending;
+    pending.resize(0);
+    qint64 readdirNsecs = 0;
+
+    while(records.count() - dirCount < maxEntries && dirCount < maxEntries)
+    {
+        if(_bufferPos >= _bufferSize)
+        {
+            qint64 callStart = readStart ? ScanStats::now() : 0;
+            long bytes = syscall(SYS_getdents64, _fd, _buffer.data(), _buffer.size());
+            if(readStart)
+            {
+                readdirNsecs += ScanStats::now() - callStart;
+            }
+            if(bytes <= 0)
+            {
+                _atEnd = true;
+                break;
+            }
+            _bufferPos = 0;
+            _bufferSize = int(bytes);
+        }
+
+        const linux_dirent64 *record = reinterpret_cast<const linux_dirent64 *>(_buffer.constData() + _bufferPos);
+        _bufferPos += record->d_reclen;
+        _offset = record->d_off;
+
+        /* Skipping hidden entries including "." & ".." */
+        if(record->d_name[0] == '.')
+        {
+            bool dotOrDotDot = (record->d_name[1] == '\0' || (record->d_name[1] == '.' && record->d_name[2] == '\0'));
+            seen += dotOrDotDot ? 0 : 1;
+            continue;
+        }
+        seen++;
+
+        unsigned char type = record->d_type;
+        if(type != DT_REG && type != DT_DIR && type != DT_LNK && type != DT_UNKNOWN)
+        {
+            continue;
+        }
+
+        int nameSize = int(strlen(record->d_name));
+        bool matches = false;
+
+        if(type == DT_DIR)
+        {
+            if(!dirs)
+            {
+                continue;
+            }
+        }
+        else
+        {
+            /* Names are matched as raw bytes before they are decoded */
+            matches = files && (matcher.isEmpty() || matcher.matches(record->d_name, nameSize));
+
+            /* The predicate is decided by the name & the entry type before stating where it can be */
+            FilePredicate::Result result = FilePredicate::RESULT_TRUE;
+            if(matches && predicate)
+            {
+                result = predicate->preMatch(record->d_name, nameSize,
+                                             (type == DT_LNK) ? 1 : ((type == DT_REG) ? 0 : -1));
+                matches = (result != FilePredicate::RESULT_FALSE);
+            }
+
+            /* A not matching name can be a subdirectory only */
+            if(!matches && (type == DT_REG || !dirs))
+            {
+                continue;
+            }
+
+            /* Files & links are stated after the chunk is read */
+            PendingEntry pendingEntry;
+            pendingEntry.record = records.count();
+            pendingEntry.matches = matches;
+            pendingEntry.check = (result == FilePredicate::RESULT_UNKNOWN);
+            pendingEntry.link = (type == DT_LNK);
+            pendingEntry.unknownType = (type == DT_UNKNOWN);
+            pendingEntry.request = pending.count();
+            pending.append(pendingEntry);
+        }
+
+        entry.nameSize = nameSize;
+        entry.inode = record->d_ino;
+        entry.isDir = (type == DT_DIR);
+        dirCount += entry.isDir ? 1 : 0;
+        names.append(record->d_name, nameSize + 1);
+        records.append(entry);
+    }
+
+    setNames(records, names);
+
+    /* Requests may be issued in inode order, every entry keeps the index of its request */
+    if(_inodeOrder && pending.count() > 1)
+    {
+        QVector<int> &order = thread_order;
+        order.resize(pending.count());
+        for(int entryNum = 0; entryNum < pending.count(); entryNum++)
+        {
+            order[entryNum] = entryNum;
+        }
+        std::stable_sort(order.begin(), order.end(), [&pending, &records](int left, int right) {
+            return records.at(pending.at(left).record).inode < records.at(pending.at(right).record).inode;
+        });
+        for(int requestNum = 0; requestNum < order.count(); requestNum++)
+        {
+            pending[order.at(requestNum)].request = requestNum;
+        }
+    }
+
+    QVector<UringStat::Request> &requests = thread_requests;
+    requests.resize(pending.count());
+    for(int entryNum = 0; entryNum < pending.count(); entryNum++)
+    {
+        UringStat::Request &request = requests[pending.at(entryNum).request];
+        request.name = records.at(pending.at(entryNum).record).name;
+        request.done = false;
+        request.mode = 0;
+        request.size = 0;
+        request.mtime = 0;
+        request.blocks = 0;
+        request.mtimeNsec = 0;
+        request.inode = 0;
+        request.ctime = 0;
+        request.uid = 0;
+        request.links = 0;
+    }
+
+    qint64 statStart = readStart ? ScanStats::now() : 0;
+    statEntries(_fd, _statBatchDepth, requests);
+    if(readStart)
+    {
+        ScanStats::addTime(ScanStats::PHASE_READDIR, readdirNsecs);
+        ScanStats::addTime(ScanStats::PHASE_MATCH, statStart - readStart - readdirNsecs);
+        ScanStats::addTime(ScanStats::PHASE_STAT, ScanStats::now() - statStart);
+        ScanStats::add(ScanStats::STATS_ISSUED, requests.count());
+    }
+
+    /* Stated records are completed or dropped keeping the file system order */
+    int count = 0;
+    int entryNum = 0;
+    for(int recordNum = 0; recordNum < records.count(); recordNum++)
+    {
+        EntryRecord current = records.at(recordNum);
+
+        if(entryNum < pending.count() && pending.at(entryNum).record == recordNum)
+        {
+            const PendingEntry &pendingEntry = pending.at(entryNum);
+            const UringStat::Request &request = requests.at(pendingEntry.request);
+            entryNum++;
+
+            if(S_ISDIR(request.mode) && dirs)
+            {
+                current.isDir = true;
+                current.inode = request.inode;
+            }
+            else if(S_ISREG(request.mode) && pendingEntry.matches)
+            {
+                current.size = request.size;
+                current.mtime = request.mtime;
+                current.blocks = request.blocks;
+                current.mtimeNsec = request.mtimeNsec;
+                current.mode = request.mode;
+                current.inode = request.inode;
+                current.ctime = request.ctime;
+                current.uid = request.uid;
+                current.links = request.links;
+                current.isLink = pendingEntry.link;
+
+                /* A link without an entry type is told by the entry itself, only where the predicate needs it */
+                if(pendingEntry.check && pendingEntry.unknownType)
+                {
+                    struct stat linkStat;
+                    current.isLink = fstatat(_fd, current.name, &linkStat, AT_SYMLINK_NOFOLLOW) == 0 &&
+                                     S_ISLNK(linkStat.st_mode);
+                    if(readStart)
+                    {
+                        ScanStats::add(ScanStats::STATS_ISSUED, 1);
+                    }
+                }
+
+                /* Rejected files are dropped before anything is formatted */
+                if(pendingEntry.check && !predicate->matches(current))
+                {
+                    continue;
+                }
+                matched++;
+            }
+            else
+            {
+                continue;
+            }
+        }
+
+        records[count++] = current;
+    }
+    records.resize(count);
+#else
+    while(records.count() - dirCount < maxEntries && dirCount < maxEntries && _next < _entries.count())
+    {
+        const DirEntry &dirEntry = _entries.at(_next++);
+        seen++;
+        if(dirEntry.isDir ? dirs : (files && matcher.matches(dirEntry.name) &&
+                                    (!predicate || predicate->matches(dirEntry))))
+        {
+            entry.nameSize = dirEntry.name.size();
+            entry.isDir = dirEntry.isDir;
+            entry.size = dirEntry.size;
+            entry.mtime = dirEntry.mtime;
+            entry.blocks = dirEntry.blocks;
+            entry.ctime = dirEntry.ctime;
+            entry.uid = dirEntry.uid;
+            entry.links = dirEntry.links;
+            entry.isLink = dirEntry.isLink;
+            names.append(dirEntry.name.constData(), entry.nameSize + 1);
+            records.append(entry);
+            matched += dirEntry.isDir ? 0 : 1;
+            dirCount += dirEntry.isDir ? 1 : 0;
+        }
+    }
+    _atEnd = (_next >= _entries.count());
+
+    setNames(records, names);
+    int count = records.count();
+#endif
+
+    if(readStart)
+    {
+        ScanStats::add(ScanStats::ENTRIES_SEEN, seen);
+        ScanStats::add(ScanStats::ENTRIES_MATCHED, matched);
+        _readNsecs += ScanStats::now() - readStart;
+        if(_atEnd)
+        {
+            ScanStats::addDirRead(_readNsecs);
+        }
+    }
+
+    return count;
+}
@@ -0,0 +1,146 @@
+/*! \file       dirreader.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      Directory Reader module header file.
+ *
+ *  This file contains the DirReader class declaration.
+ */
+
+#ifndef DIRREADER_H
+#define DIRREADER_H
+
+#include <QtCore/qglobal.h>
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "globmatcher.h"
+
+/*! \struct DirEntry
+ *  \brief A directory entry read by DirReader.
+ */
+struct DirEntry
+{
+    QByteArray name;    /*!< A raw entry name as it is stored in the file system */
+    bool isDir;         /*!< Set for directories & symbolic links to directories */
+    qint64 size;        /*!< A file size in bytes (files only) */
+    qint64 mtime;       /*!< A file modification time in milliseconds since epoch (files only) */
+    qint64 blocks;      /*!< Allocated 512 byte blocks (files only) */
+    int mtimeNsec;      /*!< Nanoseconds of the modification time within the millisecond (files only) */
+    unsigned int mode;  /*!< A file type & permissions (files only) */
+    quint64 inode;      /*!< An inode number of the file or the directory */
+    qint64 ctime;       /*!< A file status change time in milliseconds since epoch (files only) */
+    unsigned int uid;   /*!< An owner id of the file (files only) */
+    unsigned int links; /*!< Number of hard links to the file (files only) */
+    bool isLink;        /*!< Set for symbolic links to files if the directory entry type tells it (files only) */
+};
+
+/*! \struct EntryRecord
+ *  \brief A lightweight directory entry read by DirStream.
+ *
+ *  A record doesn't own its name, it points to a name buffer
+ *  filled by the same read, so reading allocates nothing per entry.
+ */
+struct EntryRecord
+{
+    const char *name;   /*!< A null terminated raw entry name, valid until the buffer is read into again */
+    int nameSize;       /*!< The name size in bytes */
+    int parent;         /*!< A parent directory handle, -1 if it is not known */
+    bool isDir;         /*!< Set for directories & symbolic links to directories */
+    qint64 size;        /*!< A file size in bytes (files only) */
+    qint64 mtime;       /*!< A file modification time in milliseconds since epoch (files only) */
+    qint64 blocks;      /*!< Allocated 512 byte blocks (files only) */
+    int mtimeNsec;      /*!< Nanoseconds of the modification time within the millisecond (files only) */
+    unsigned int mode;  /*!< A file type & permissions (files only) */
+    quint64 inode;      /*!< An inode number of the file or the directory */
+    qint64 ctime;       /*!< A file status change time in milliseconds since epoch (files only) */
+    unsigned int uid;   /*!< An owner id of the file (files only) */
+    unsigned int links; /*!< Number of hard links to the file (files only) */
+    bool isLink;        /*!< Set for symbolic links to files if the directory entry type tells it (files only) */
+};
+
+/*! \class DirReader
+ *  \brief Native directory reader class.
+ *
+ *  This class reads a directory in one pass through an open directory
+ *  descriptor. Entries are classified by their d_type & only matching
+ *  files are stated relative to the descriptor, asking for the size, times,
+ *  mode, owner, links & inode only, optionally in io_uring batches. A file
+ *  predicate carried by the matcher is decided by names & entry types before
+ *  files are stated where it can be. The entry set is the same as
+ *  QDir::entryList() gives for QDir::Files & QDir::Dirs filters, so is
+ *  the order of files & of subdirectories which fit in a chunk. Stat calls
+ *  can be issued in inode order, which is close to the on-disk order of
+ *  inode tables on most file systems, the entry order doesn't change then.
+ *  On other platforms directories are read by QDir.
+ */
+class DirReader
+{
+    public:
+        static bool isSupported();
+        static bool setStatBatchDepth(int depth);
+        static void setInodeOrder(bool inodeOrder);
+        static bool read(const QString &dirPath, const GlobMatcher &matcher,
+                         bool listDirs, QVector<DirEntry> &entries);
+        static void sort(QVector<DirEntry> &entries);
+        static void sort(QVector<EntryRecord> &records);
+        static void sortFitting(QVector<DirEntry> &entries);
+        static void sortByInode(QVector<DirEntry> &entries);
+        static void sortByInode(QVector<EntryRecord> &records);
+        static DirEntry toEntry(const EntryRecord &record);
+        static bool readEntry(const QString &dirPath, const QByteArray &name, DirEntry &entry);
+        static bool statDir(const QString &dirPath, qint64 &mtime, qint64 &ctime);
+};
+
+/*! \class DirStream
+ *  \brief Chunked directory reader class.
+ *
+ *  This class reads a directory in chunks of a limited number of entries
+ *  in the file system order, so huge directories are never kept in memory.
+ *  A stream can be closed to save descriptors & opened again to continue
+ *  from the same position. Entries are skipped the same way as DirReader does.
+ *  Entries can be read as records into buffers reused by the caller.
+ *  On other platforms the whole directory is read by QDir when it is opened.
+ */
+class DirStream
+{
+    public:
+        static const int file_chunk_size = 4096;    /*!< Files read at once by a tree walk */
+        static const int subdir_chunk_size = 256;   /*!< Subdirectories kept per directory by a tree walk */
+
+        explicit DirStream(const QString &dirPath);
+        ~DirStream();
+        const QString &path() const;
+        bool open();
+        void close();
+        bool isOpen() const;
+        bool atEnd() const;
+        void setInodeOrder(bool inodeOrder);
+        void setStatBatchDepth(int depth);
+        void rewind();
+        int read(const GlobMatcher &matcher, bool files, bool dirs, int maxEntries, QVector<DirEntry> &entries);
+        int read(const GlobMatcher &matcher, bool files, bool dirs, int maxEntries,
+                 QVector<EntryRecord> &records, QByteArray &names);
+    private:
+        QString _path;                  /*!< A directory path */
+        int _fd;                        /*!< An open directory descriptor or -1 */
+        QByteArray _buffer;             /*!< Raw records read by one system call */
+        int _bufferPos;                 /*!< The next record position in the buffer */
+        int _bufferSize;                /*!< Size of records in the buffer */
+        qint64 _offset;                 /*!< The position after the last consumed record */
+        bool _atEnd;                    /*!< Set when all entries have been read */
+        qint64 _readNsecs;              /*!< Time spent in read() with statistics enabled */
+        bool _inodeOrder;               /*!< Stat entries of a chunk in inode order */
+        int _statBatchDepth;            /*!< io_uring queue depth, 0 to stat entries one by one */
+        QVector<EntryRecord> _records;  /*!< Reusable records read for DirEntry reads */
+        QByteArray _names;              /*!< Reusable names of the records */
+        QVector<DirEntry> _entries;     /*!< Entries read by QDir on other platforms */
+        int _next;                      /*!< The next entry index on other platforms */
+
+        Q_DISABLE_COPY(DirStream)
+};
+
+#endif // DIRREADER_H
@@ -0,0 +1,589 @@
+/*! \file       dirwatcher.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief Directory Watcher module source file.
+ *
+ *  This file contains the DirWatcher class source code.
+ */
+
+#include "dirwatcher.h"
+#include "filepredicate.h"
+#include "treeguard.h"
+
+#include <QFile>
+#include <QMutexLocker>
+#include <QPair>
+
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+
+/* Events changing the listed directory entries */
+static const quint32 watch_events = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                                    IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB |
+                                    IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+/* A buffer size to read queued events with one system call */
+static const int watch_buffer_size = 64 * 1024;
+#endif
+
+/* An interval to rescan directories which can't be watched, in milliseconds */
+static const int watch_poll_interval = 10000;
+
+/*!
+ * \brief DirWatcher::DirWatcher
+ * \param[in] matcher File name patterns, files are not filtered if it is empty
+ * \param[in] recursive Set to "true" to watch subdirectories
+ * \param[in] changed A function to report changes to
+ * \param[in] parent A parent object
+ *
+ * DirWatcher Constructor
+ */
+DirWatcher::DirWatcher(const GlobMatcher &matcher, bool recursive, const ChangeFunction &changed, QObject *parent) :
+    QObject(parent)
+{
+    _matcher = matcher;
+    _recursive = recursive;
+    _changed = changed;
+    _notifier = nullptr;
+    _pollTimer = nullptr;
+
+#ifdef Q_OS_LINUX
+    _fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#else
+    _fd = -1;
+#endif
+}
+
+/*!
+ * \brief DirWatcher::~DirWatcher
+ *
+ * DirWatcher Destructor
+ */
+DirWatcher::~DirWatcher()
+{
+    if(_notifier) delete _notifier;
+    if(_pollTimer) delete _pollTimer;
+
+#ifdef Q_OS_LINUX
+    if(_fd >= 0)
+    {
+        close(_fd);
+    }
+#endif
+}
+
+/*!
+ * \brief DirWatcher::isSupported
+ * \return "true" if directories can be watched on this platform
+ */
+bool DirWatcher::isSupported()
+{
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+/*!
+ * \brief DirWatcher::isActive
+ * \return "true" if the watcher reports changes from the event loop
+ */
+bool DirWatcher::isActive() const
+{
+    return _fd >= 0 && _notifier != nullptr;
+}
+
+/*!
+ * \brief DirWatcher::watch
+ * \param[in] dirPath An absolute directory path
+ * \return "false" if the directory is watched by another path too
+ *
+ * Adds a directory watch. It must be called before the directory
+ * is read not to miss changes. The method is thread-safe.
+ */
+bool DirWatcher::watch(const QString &dirPath)
+{
+#ifdef Q_OS_LINUX
+    int wd = (_fd >= 0) ? inotify_add_watch(_fd, QFile::encodeName(dirPath).constData(), watch_events) : -1;
+
+    QMutexLocker locker(&_lock);
+
+    /* The watch limit is reached, the directory will be rescanned by the timer */
+    if(wd < 0)
+    {
+        _unwatched.insert(dirPath);
+        return true;
+    }
+
+    /* The same directory gets the same descriptor through a link or a bind mount, events go to all its paths */
+    QStringList &paths = _wdPaths[wd];
+    if(!paths.contains(dirPath))
+    {
+        paths.append(dirPath);
+    }
+    _pathWds.insert(dirPath, wd);
+    _unwatched.remove(dirPath);
+    return paths.count() == 1;
+#else
+    Q_UNUSED(dirPath)
+    return true;
+#endif
+}
+
+/*!
+ * \brief DirWatcher::setSnapshot
+ * \param[in] dirPath An absolute directory path
+ * \param[in] entries Listed directory entries
+ *
+ * Stores listed directory entries to compare changes with.
+ * The method is thread-safe.
+ */
+void DirWatcher::setSnapshot(const QString &dirPath, const QVector<DirEntry> &entries)
+{
+    Snapshot snapshot;
+    snapshot.reserve(entries.count());
+    foreach (const DirEntry &entry, entries) {
+        snapshot.insert(entry.name, entry);
+    }
+
+    QMutexLocker locker(&_lock);
+    _snapshots.insert(dirPath, snapshot);
+}
+
+/*!
+ * \brief DirWatcher::start
+ *
+ * Starts reporting changes from the event loop.
+ */
+void DirWatcher::start()
+{
+    if(_fd < 0 || _notifier)
+    {
+        return;
+    }
+
+    /* The signal is overloaded in newer Qt versions, so it is connected by its signature */
+    _notifier = new QSocketNotifier(_fd, QSocketNotifier::Read, this);
+    connect(_notifier, SIGNAL(activated(int)), this, SLOT(_readEvents()));
+
+    _pollTimer = new QTimer(this);
+    connect(_pollTimer, &QTimer::timeout, this, &DirWatcher::_pollUnwatched);
+    _pollTimer->start(watch_poll_interval);
+}
+
+/*!
+ * \brief DirWatcher::_childPath
+ * \return An absolute path of a directory entry
+ */
+QString DirWatcher::_childPath(const QString &dirPath, const QByteArray &name) const
+{
+    if(dirPath.endsWith(QChar('/')))
+    {
+        return dirPath + QFile::decodeName(name);
+    }
+    return dirPath + QChar('/') + QFile::decodeName(name);
+}
+
+/*!
+ * \brief DirWatcher::_matches
+ * \param[in] entry A stated file
+ * \return "true" if the file name matches name patterns & the file matches the predicate
+ */
+bool DirWatcher::_matches(const DirEntry &entry) const
+{
+    if(!_matcher.matches(entry.name))
+    {
+        return false;
+    }
+    return !_matcher.predicate() || _matcher.predicate()->matches(entry);
+}
+
+/*!
+ * \brief DirWatcher::_report
+ *
+ * Reports a file change.
+ */
+void DirWatcher::_report(char change, const QString &dirPath, const DirEntry &entry)
+{
+    if(_changed)
+    {
+        _changed(change, dirPath, entry);
+    }
+}
+
+/*!
+ * \brief DirWatcher::_compare
+ * \param[in] dirPath An absolute directory path
+ * \param[in] name An entry name
+ * \param[in] current The current entry state or nullptr if it is not listed any more
+ *
+ * Compares an entry with the snapshot, reports the difference & updates the snapshot.
+ */
+void DirWatcher::_compare(const QString &dirPath, const QByteArray &name, const DirEntry *current)
+{
+    Snapshot &snapshot = _snapshots[dirPath];
+    Snapshot::iterator known = snapshot.find(name);
+
+    bool wasKnown = (known != snapshot.end());
+    DirEntry old;
+
+    if(wasKnown)
+    {
+        old = known.value();
+
+        if(current && current->isDir == old.isDir)
+        {
+            if(!old.isDir && (old.size != current->size || old.mtime != current->mtime))
+            {
+                known.value() = *current;
+                _report('*', dirPath, *current);
+            }
+            return;
+        }
+
+        snapshot.erase(known);
+    }
+
+    if(current)
+    {
+        snapshot.insert(name, *current);
+    }
+
+    /* Subtrees are changed after the snapshot is updated */
+    if(wasKnown)
+    {
+        if(old.isDir)
+        {
+            _removeTree(_childPath(dirPath, name));
+        }
+        else
+        {
+            _report('-', dirPath, old);
+        }
+    }
+
+    if(current)
+    {
+        if(current->isDir)
+        {
+            _addTree(_childPath(dirPath, name));
+        }
+        else
+        {
+            _report('+', dirPath, *current);
+        }
+    }
+}
+
+/*!
+ * \brief DirWatcher::_refreshEntry
+ * \param[in] dirPath An absolute directory path
+ * \param[in] name A changed entry name
+ *
+ * Checks one changed entry.
+ */
+void DirWatcher::_refreshEntry(const QString &dirPath, const QByteArray &name)
+{
+    DirEntry current;
+    bool listed = !name.startsWith('.') && DirReader::readEntry(dirPath, name, current);
+
+    if(listed)
+    {
+        listed = current.isDir ? _recursive : _matches(current);
+    }
+
+    _compare(dirPath, name, listed ? &current : nullptr);
+}
+
+/*!
+ * \brief DirWatcher::_rescanDir
+ * \param[in] dirPath An absolute directory path
+ *
+ * Reads a whole directory again & reports the difference with the snapshot.
+ */
+void DirWatcher::_rescanDir(const QString &dirPath)
+{
+    QVector<DirEntry> entries;
+    if(!DirReader::read(dirPath, _matcher, _recursive, entries))
+    {
+        _removeTree(dirPath);
+        return;
+    }
+
+    Snapshot current;
+    current.reserve(entries.count());
+    foreach (const DirEntry &entry, entries) {
+        current.insert(entry.name, entry);
+    }
+
+    QList<QByteArray> names = _snapshots.value(dirPath).keys();
+    foreach (const QByteArray &name, names) {
+        if(!current.contains(name))
+        {
+            _compare(dirPath, name, nullptr);
+        }
+    }
+
+    for(Snapshot::const_iterator entry = current.constBegin(); entry != current.constEnd(); ++entry)
+    {
+        /* A subtree removal above could remove the directory itself */
+        if(!_snapshots.contains(dirPath))
+        {
+            return;
+        }
+        _compare(dirPath, entry.key(), &entry.value());
+    }
+}
+
+/*!
+ * \brief DirWatcher::_unwatch
+ * \param[in] dirPath An absolute directory path
+ *
+ * Forgets the watch of a directory path, the watch is removed
+ * when no other path to the same directory is left.
+ */
+void DirWatcher::_unwatch(const QString &dirPath)
+{
+#ifdef Q_OS_LINUX
+    int wd = _pathWds.take(dirPath);
+    if(wd > 0)
+    {
+        QStringList &paths = _wdPaths[wd];
+        paths.removeAll(dirPath);
+        if(paths.isEmpty())
+        {
+            _wdPaths.remove(wd);
+            inotify_rm_watch(_fd, wd);
+        }
+    }
+#endif
+    _unwatched.remove(dirPath);
+}
+
+/*!
+ * \brief DirWatcher::_addTree
+ * \param[in] dirPath An absolute path of a new directory
+ *
+ * Watches a new directory tree & reports all its files as created.
+ * A directory which is one of its own path ancestors (a link or bind
+ * mount cycle) is not added, so cycles end. Other paths to the same
+ * directory are added like the listing enters them.
+ */
+void DirWatcher::_addTree(const QString &dirPath)
+{
+    QSet<QPair<quint64, quint64> > added;
+    QStringList pending;
+    pending.append(dirPath);
+
+    while(!pending.isEmpty())
+    {
+        QString path = pending.takeLast();
+
+        /* Directories out of the watch limit have no descriptors to tell them, so they are told by identities */
+        bool seen = false;
+#ifdef Q_OS_LINUX
+        struct stat st;
+        if(stat(QFile::encodeName(path).constData(), &st) == 0)
+        {
+            QPair<quint64, quint64> identity(quint64(st.st_dev), quint64(st.st_ino));
+            seen = added.contains(identity);
+            added.insert(identity);
+        }
+#endif
+
+        /* Ancestors are stated only for directories met before, which is rare */
+        seen = !watch(path) || seen;
+        if(seen && TreeGuard::isOwnAncestor(path))
+        {
+            _unwatch(path);
+            continue;
+        }
+
+        QVector<DirEntry> entries;
+        DirReader::read(path, _matcher, _recursive, entries);
+        setSnapshot(path, entries);
+
+        foreach (const DirEntry &entry, entries) {
+            if(entry.isDir)
+            {
+                pending.append(_childPath(path, entry.name));
+            }
+            else
+            {
+                _report('+', path, entry);
+            }
+        }
+    }
+}
+
+/*!
+ * \brief DirWatcher::_removeTree
+ * \param[in] dirPath An absolute path of a removed directory
+ *
+ * Stops watching a directory tree & reports all its known files as deleted.
+ */
+void DirWatcher::_removeTree(const QString &dirPath)
+{
+    QString prefix = dirPath.endsWith(QChar('/')) ? dirPath : dirPath + QChar('/');
+
+    /* The directory itself goes first, its subtree is a continuous range of the sorted map */
+    QMap<QString, Snapshot>::iterator dir = _snapshots.find(dirPath);
+    if(dir == _snapshots.end())
+    {
+        dir = _snapshots.lowerBound(prefix);
+    }
+
+    while(dir != _snapshots.end() && (dir.key() == dirPath || dir.key().startsWith(prefix)))
+    {
+        for(Snapshot::const_iterator entry = dir.value().constBegin(); entry != dir.value().constEnd(); ++entry)
+        {
+            if(!entry.value().isDir)
+            {
+                _report('-', dir.key(), entry.value());
+            }
+        }
+
+        _unwatch(dir.key());
+
+        bool wasDir = (dir.key() == dirPath);
+        dir = _snapshots.erase(dir);
+        if(wasDir)
+        {
+            dir = _snapshots.lowerBound(prefix);
+        }
+    }
+}
+
+/*!
+ * \brief DirWatcher::_readEvents
+ *
+ * Reads queued inotify events & checks changed entries once per batch.
+ */
+void DirWatcher::_readEvents()
+{
+#ifdef Q_OS_LINUX
+    alignas(struct inotify_event) char buffer[watch_buffer_size];
+
+    QVector<QPair<QString, QByteArray> > changes;
+    QSet<QString> changeKeys;
+    QStringList removedRoots;
+    bool overflow = false;
+
+    forever
+    {
+        ssize_t length = read(_fd, buffer, sizeof(buffer));
+        if(length <= 0)
+        {
+            if(length < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+
+        for(char *ptr = buffer; ptr < buffer + length; )
+        {
+            const struct inotify_event *event = reinterpret_cast<const struct inotify_event *>(ptr);
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if(event->mask & IN_Q_OVERFLOW)
+            {
+                overflow = true;
+                continue;
+            }
+
+            QStringList dirPaths = _wdPaths.value(event->wd);
+            if(dirPaths.isEmpty())
+            {
+                continue;
+            }
+
+            if(event->mask & IN_IGNORED)
+            {
+                _wdPaths.remove(event->wd);
+                foreach (const QString &dirPath, dirPaths) {
+                    _pathWds.remove(dirPath);
+                }
+                continue;
+            }
+
+            /* An event of a directory with several paths is taken for each of them */
+            foreach (const QString &dirPath, dirPaths) {
+                /* A parent reports removal of its subdirectories, roots are removed here */
+                if(event->mask & (IN_DELETE_SELF | IN_MOVE_SELF))
+                {
+                    QString parentPath = dirPath.left(dirPath.lastIndexOf(QChar('/')));
+                    if(!_snapshots.contains(parentPath.isEmpty() ? QString("/") : parentPath))
+                    {
+                        removedRoots.append(dirPath);
+                    }
+                    continue;
+                }
+
+                if(event->len > 0)
+                {
+                    QByteArray name(event->name);
+                    QString key = dirPath + QChar('/') + QFile::decodeName(name);
+                    if(!changeKeys.contains(key))
+                    {
+                        changeKeys.insert(key);
+                        changes.append(qMakePair(dirPath, name));
+                    }
+                }
+            }
+        }
+    }
+
+    if(overflow)
+    {
+        /* Events are lost, all directories are compared with snapshots */
+        foreach (const QString &dirPath, _snapshots.keys()) {
+            if(_snapshots.contains(dirPath))
+            {
+                _rescanDir(dirPath);
+            }
+        }
+    }
+    else
+    {
+        for(int changeNum = 0; changeNum < changes.count(); changeNum++)
+        {
+            if(_snapshots.contains(changes.at(changeNum).first))
+            {
+                _refreshEntry(changes.at(changeNum).first, changes.at(changeNum).second);
+            }
+        }
+    }
+
+    foreach (const QString &dirPath, removedRoots) {
+        _removeTree(dirPath);
+    }
+
+    emit changesReported();
+#endif
+}
+
+/*!
+ * \brief DirWatcher::_pollUnwatched
+ *
+ * Tries to watch directories again & rescans them.
+ */
+void DirWatcher::_pollUnwatched()
+{
+    if(_unwatched.isEmpty())
+    {
+        return;
+    }
+
+    foreach (const QString &dirPath, _unwatched.values()) {
+        watch(dirPath);
+        _rescanDir(dirPath);
+    }
+
+    emit changesReported();
+}
@@ -0,0 +1,88 @@
+/*! \file       dirwatcher.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      Directory Watcher module header file.
+ *
+ *  This file contains the DirWatcher class declaration.
+ */
+
+#ifndef DIRWATCHER_H
+#define DIRWATCHER_H
+
+#include <QtCore/QObject>
+#include <QtCore/qglobal.h>
+
+#include <QByteArray>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QSet>
+#include <QSocketNotifier>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+#include <functional>
+
+#include "dirreader.h"
+#include "globmatcher.h"
+
+/*! \class DirWatcher
+ *  \brief Directory tree watcher class.
+ *
+ *  This class keeps inotify watches & entry snapshots of listed directories
+ *  & reports created, modified & deleted files from the application event loop.
+ *  Directories which can't be watched because of the watch limit are
+ *  rescanned by a timer, the queue overflow rescans all directories.
+ */
+class DirWatcher : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("Author", "Yury Osipov")
+    Q_CLASSINFO("e-mail", "yusosipov@ya.ru")
+    public:
+        /*! A change report function, change is '+' (created), '*' (modified) or '-' (deleted) */
+        typedef std::function<void (char change, const QString &dirPath, const DirEntry &entry)> ChangeFunction;
+
+        DirWatcher(const GlobMatcher &matcher, bool recursive, const ChangeFunction &changed, QObject *parent = nullptr);
+        ~DirWatcher();
+        static bool isSupported();
+        bool isActive() const;
+        bool watch(const QString &dirPath);
+        void setSnapshot(const QString &dirPath, const QVector<DirEntry> &entries);
+        void start();
+    private:
+        typedef QHash<QByteArray, DirEntry> Snapshot;
+
+        int _fd;                                /*!< An inotify descriptor */
+        QSocketNotifier *_notifier;             /*!< Notifies the event loop about inotify events */
+        QTimer *_pollTimer;                     /*!< Rescans not watched directories */
+        GlobMatcher _matcher;                   /*!< File name patterns */
+        bool _recursive;                        /*!< Watch subdirectories */
+        ChangeFunction _changed;                /*!< Change report function */
+
+        QHash<int, QStringList> _wdPaths;       /*!< Watch descriptor to directory paths map */
+        QHash<QString, int> _pathWds;           /*!< Directory to watch descriptor map */
+        QMap<QString, Snapshot> _snapshots;     /*!< Known entries of directories sorted by path */
+        QSet<QString> _unwatched;               /*!< Directories without watches */
+        QMutex _lock;                           /*!< Guards watching from traversal threads */
+
+        QString _childPath(const QString &dirPath, const QByteArray &name) const;
+        bool _matches(const DirEntry &entry) const;
+        void _report(char change, const QString &dirPath, const DirEntry &entry);
+        void _compare(const QString &dirPath, const QByteArray &name, const DirEntry *current);
+        void _refreshEntry(const QString &dirPath, const QByteArray &name);
+        void _rescanDir(const QString &dirPath);
+        void _unwatch(const QString &dirPath);
+        void _addTree(const QString &dirPath);
+        void _removeTree(const QString &dirPath);
+    private slots:
+        void _readEvents();
+        void _pollUnwatched();
+signals:
+        void changesReported();
+};
+
+#endif // DIRWATCHER_H
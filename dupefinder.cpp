@@ -0,0 +1,604 @@
+/*! \file       dupefinder.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief Dupe Finder module source file.
+ *
+ *  This file contains the DupeFinder class source code.
+ */
+
+#include "dupefinder.h"
+#include "contenthash.h"
+
+#include <QAtomicInt>
+#include <QFile>
+#include <QMutexLocker>
+#include <QThread>
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef Q_OS_UNIX
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* The first stage hashes this many bytes of every candidate */
+static const int head_size = 4096;
+
+/* Whole files are read by blocks of this size */
+static const int read_block_size = 1024 * 1024;
+
+/* A read buffer of the current thread */
+static thread_local QByteArray thread_buffer;
+
+/* The second read buffer of the current thread for content comparison */
+static thread_local QByteArray thread_other_buffer;
+
+/*! \class TaskThread
+ *  \brief A thread running a function.
+ */
+class TaskThread : public QThread
+{
+    public:
+        explicit TaskThread(const std::function<void ()> &task) : _task(task) {}
+    protected:
+        void run() Q_DECL_OVERRIDE { _task(); }
+    private:
+        std::function<void ()> _task;   /*!< A function to run */
+};
+
+/*!
+ * \brief hashFile
+ * \param[in] path A raw file path
+ * \param[in] size The file size it was stated with
+ * \param[in] whole Set to "true" to hash the whole file, the first block is hashed otherwise
+ * \param[out] hash The content hash
+ * \return "false" if the file can't be read or its size has changed
+ */
+static bool hashFile(const QByteArray &path, qint64 size, bool whole, quint64 &hash)
+{
+    qint64 limit = whole ? size : qMin(size, qint64(head_size));
+
+    QByteArray &buffer = thread_buffer;
+    if(buffer.size() < read_block_size)
+    {
+        buffer.resize(read_block_size);
+    }
+
+    ContentHash contentHash;
+    qint64 done = 0;
+
+#ifdef Q_OS_UNIX
+    int fd = open(path.constData(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+    {
+        return false;
+    }
+#ifdef Q_OS_LINUX
+    if(whole)
+    {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+#endif
+
+    while(done < limit)
+    {
+        ssize_t bytes = read(fd, buffer.data(), size_t(qMin(qint64(buffer.size()), limit - done)));
+        if(bytes < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(bytes <= 0)
+        {
+            break;
+        }
+        contentHash.add(buffer.constData(), bytes);
+        done += bytes;
+    }
+    close(fd);
+#else
+    QFile file(QFile::decodeName(path));
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    while(done < limit)
+    {
+        qint64 bytes = file.read(buffer.data(), qMin(qint64(buffer.size()), limit - done));
+        if(bytes <= 0)
+        {
+            break;
+        }
+        contentHash.add(buffer.constData(), bytes);
+        done += bytes;
+    }
+#endif
+
+    hash = contentHash.result();
+    return done == limit;
+}
+
+#ifdef Q_OS_UNIX
+/*!
+ * \brief readBlock
+ * \param[in] fd A file descriptor
+ * \param[out] data A buffer to read into
+ * \param[in] size Number of bytes to read
+ * \return "true" if all the bytes are read
+ */
+static bool readBlock(int fd, char *data, qint64 size)
+{
+    qint64 done = 0;
+    while(done < size)
+    {
+        ssize_t bytes = read(fd, data + done, size_t(size - done));
+        if(bytes < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(bytes <= 0)
+        {
+            return false;
+        }
+        done += bytes;
+    }
+    return true;
+}
+#endif
+
+/*!
+ * \brief compareFiles
+ * \param[in] left A raw path of the file a group is compared with
+ * \param[in] right A raw path of a candidate file
+ * \param[in] size The size both files were stated with
+ * \param[out] leftReadable Cleared if the "left" file can't be read as it was stated
+ * \param[out] rightReadable Cleared if the "right" file can't be read as it was stated
+ * \return "true" if both files are read & their contents are the same
+ */
+static bool compareFiles(const QByteArray &left, const QByteArray &right, qint64 size,
+                         bool &leftReadable, bool &rightReadable)
+{
+    QByteArray &leftBuffer = thread_buffer;
+    QByteArray &rightBuffer = thread_other_buffer;
+    if(leftBuffer.size() < read_block_size)
+    {
+        leftBuffer.resize(read_block_size);
+    }
+    if(rightBuffer.size() < read_block_size)
+    {
+        rightBuffer.resize(read_block_size);
+    }
+
+    leftReadable = true;
+    rightReadable = true;
+    bool same = true;
+    qint64 done = 0;
+
+#ifdef Q_OS_UNIX
+    int leftFd = open(left.constData(), O_RDONLY | O_CLOEXEC);
+    if(leftFd < 0)
+    {
+        leftReadable = false;
+        return false;
+    }
+    int rightFd = open(right.constData(), O_RDONLY | O_CLOEXEC);
+    if(rightFd < 0)
+    {
+        close(leftFd);
+        rightReadable = false;
+        return false;
+    }
+#ifdef Q_OS_LINUX
+    posix_fadvise(leftFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    posix_fadvise(rightFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    while(same && done < size)
+    {
+        qint64 bytes = qMin(qint64(read_block_size), size - done);
+        if(!readBlock(leftFd, leftBuffer.data(), bytes))
+        {
+            leftReadable = false;
+            same = false;
+        }
+        else if(!readBlock(rightFd, rightBuffer.data(), bytes))
+        {
+            rightReadable = false;
+            same = false;
+        }
+        else
+        {
+            same = (memcmp(leftBuffer.constData(), rightBuffer.constData(), size_t(bytes)) == 0);
+        }
+        done += bytes;
+    }
+    close(leftFd);
+    close(rightFd);
+#else
+    QFile leftFile(QFile::decodeName(left));
+    if(!leftFile.open(QIODevice::ReadOnly))
+    {
+        leftReadable = false;
+        return false;
+    }
+    QFile rightFile(QFile::decodeName(right));
+    if(!rightFile.open(QIODevice::ReadOnly))
+    {
+        rightReadable = false;
+        return false;
+    }
+
+    while(same && done < size)
+    {
+        qint64 bytes = qMin(qint64(read_block_size), size - done);
+        if(leftFile.read(leftBuffer.data(), bytes) != bytes)
+        {
+            leftReadable = false;
+            same = false;
+        }
+        else if(rightFile.read(rightBuffer.data(), bytes) != bytes)
+        {
+            rightReadable = false;
+            same = false;
+        }
+        else
+        {
+            same = (memcmp(leftBuffer.constData(), rightBuffer.constData(), size_t(bytes)) == 0);
+        }
+        done += bytes;
+    }
+#endif
+
+    return same;
+}
+
+/*!
+ * \brief DupeFinder::DupeFinder
+ * \param[in] jobs Number of threads to hash files on
+ *
+ * DupeFinder Constructor
+ */
+DupeFinder::DupeFinder(int jobs)
+{
+    _jobs = qMax(1, jobs);
+}
+
+/*!
+ * \brief DupeFinder::add
+ * \param[in] prefix A raw directory path ending with a separator
+ * \param[in] entries Directory entries, subdirectories are skipped
+ *
+ * Adds listed files, it may be called from several threads. Files of a directory
+ * are on its device, so the directory is stated once for hard link identities.
+ */
+void DupeFinder::add(const QByteArray &prefix, const QVector<DirEntry> &entries)
+{
+    quint64 device = 0;
+    bool deviceKnown = false;
+
+    QVector<File> files;
+    foreach (const DirEntry &entry, entries) {
+        if(entry.isDir || entry.size <= 0)
+        {
+            continue;
+        }
+
+#ifdef Q_OS_UNIX
+        if(!deviceKnown)
+        {
+            struct stat dirStat;
+            if(::stat(prefix.constData(), &dirStat) == 0)
+            {
+                device = quint64(dirStat.st_dev);
+            }
+            deviceKnown = true;
+        }
+#endif
+
+        File file;
+        file.path = prefix + entry.name;
+        file.size = entry.size;
+        file.device = device;
+        file.inode = entry.inode;
+        file.headHash = 0;
+        file.hash = 0;
+        file.readable = true;
+        files.append(file);
+    }
+
+    QMutexLocker locker(&_lock);
+    _files += files;
+}
+
+/*!
+ * \brief DupeFinder::find
+ * \return Groups of files with the same content, the largest reclaimable size first
+ *
+ * Hashes candidates & releases added files.
+ */
+QVector<DupeFinder::Group> DupeFinder::find()
+{
+    /* Files are ordered by size, then by device & inode to take hard links once */
+    std::sort(_files.begin(), _files.end(), [](const File &left, const File &right) {
+        if(left.size != right.size)
+        {
+            return left.size < right.size;
+        }
+        if(left.device != right.device)
+        {
+            return left.device < right.device;
+        }
+        if(left.inode != right.inode)
+        {
+            return left.inode < right.inode;
+        }
+        return left.path < right.path;
+    });
+
+    QVector<QVector<int> > groups;
+    int first = 0;
+    while(first < _files.count())
+    {
+        QVector<int> group;
+        int next = first;
+        while(next < _files.count() && _files.at(next).size == _files.at(first).size)
+        {
+            const File &file = _files.at(next);
+            if(group.isEmpty() || file.inode == 0 || file.inode != _files.at(group.last()).inode ||
+               file.device != _files.at(group.last()).device)
+            {
+                group.append(next);
+            }
+            next++;
+        }
+
+        /* Files of unique sizes are never opened */
+        if(group.count() > 1)
+        {
+            groups.append(group);
+        }
+        first = next;
+    }
+
+    /* The first blocks of all candidates */
+    QVector<int> candidates;
+    foreach (const QVector<int> &group, groups) {
+        candidates += group;
+    }
+    _hash(candidates, false);
+    groups = _split(_files, groups, [](const File &file) { return file.headHash; });
+
+    /* Whole contents of files which are larger than the first block */
+    candidates.clear();
+    foreach (const QVector<int> &group, groups) {
+        if(_files.at(group.first()).size > head_size)
+        {
+            candidates += group;
+        }
+    }
+    _hash(candidates, true);
+    groups = _split(_files, groups, [](const File &file) { return file.hash; });
+
+    /* Equal hashes are not proof, contents of the remaining candidates are compared */
+    groups = _verify(groups);
+
+    QVector<Group> result;
+    foreach (const QVector<int> &group, groups) {
+        Group dupes;
+        dupes.size = _files.at(group.first()).size;
+        dupes.hash = _files.at(group.first()).hash;
+        foreach (int fileNum, group) {
+            dupes.paths.append(_files.at(fileNum).path);
+        }
+        std::sort(dupes.paths.begin(), dupes.paths.end());
+        result.append(dupes);
+    }
+
+    std::sort(result.begin(), result.end(), [](const Group &left, const Group &right) {
+        qint64 leftBytes = left.size * (left.paths.count() - 1);
+        qint64 rightBytes = right.size * (right.paths.count() - 1);
+        if(leftBytes != rightBytes)
+        {
+            return leftBytes > rightBytes;
+        }
+        return left.paths.first() < right.paths.first();
+    });
+
+    _files.clear();
+    return result;
+}
+
+/*!
+ * \brief DupeFinder::_hash
+ * \param[in] files Indexes of files to hash
+ * \param[in] whole Set to "true" to hash whole files, the first blocks are hashed otherwise
+ *
+ * Files which can't be read are marked unreadable.
+ */
+void DupeFinder::_hash(const QVector<int> &files, bool whole)
+{
+    /* Workers change different files only */
+    File *data = _files.data();
+
+    _forEach(_jobs, files.count(), [data, &files, whole](int index) {
+        File &file = data[files.at(index)];
+        quint64 hash = 0;
+        if(!hashFile(file.path, file.size, whole, hash))
+        {
+            file.readable = false;
+            return;
+        }
+
+        if(whole)
+        {
+            file.hash = hash;
+        }
+        else
+        {
+            file.headHash = hash;
+
+            /* The first block is the whole content of a small file */
+            file.hash = (file.size <= head_size) ? hash : 0;
+        }
+    });
+}
+
+/*!
+ * \brief DupeFinder::_verify
+ * \param[in] groups Groups of file indexes with equal hashes
+ * \return Groups of at least two readable files with the same content
+ *
+ * Every group is compared on its own thread: the first remaining file of
+ * a group is read along with every other one, files of the same content
+ * make a group & the rest is compared again. Files which can't be read
+ * are marked unreadable.
+ */
+QVector<QVector<int> > DupeFinder::_verify(const QVector<QVector<int> > &groups)
+{
+    QVector<QVector<QVector<int> > > parts(groups.count());
+
+    /* Workers change files of different groups only */
+    File *data = _files.data();
+
+    _forEach(_jobs, groups.count(), [data, &groups, &parts](int index) {
+        QVector<int> rest = groups.at(index);
+        while(rest.count() > 1)
+        {
+            QVector<int> same;
+            QVector<int> other;
+            File &first = data[rest.first()];
+            for(int fileNum = 1; fileNum < rest.count() && first.readable; fileNum++)
+            {
+                File &file = data[rest.at(fileNum)];
+                if(compareFiles(first.path, file.path, first.size, first.readable, file.readable))
+                {
+                    same.append(rest.at(fileNum));
+                }
+                else if(file.readable)
+                {
+                    other.append(rest.at(fileNum));
+                }
+            }
+
+            if(!first.readable)
+            {
+                /* Readable files are compared again without the first one */
+                QVector<int> readable;
+                for(int fileNum = 1; fileNum < rest.count(); fileNum++)
+                {
+                    if(data[rest.at(fileNum)].readable)
+                    {
+                        readable.append(rest.at(fileNum));
+                    }
+                }
+                rest = readable;
+                continue;
+            }
+
+            if(!same.isEmpty())
+            {
+                same.prepend(rest.first());
+                parts[index].append(same);
+            }
+            rest = other;
+        }
+    });
+
+    QVector<QVector<int> > result;
+    foreach (const QVector<QVector<int> > &part, parts) {
+        result += part;
+    }
+    return result;
+}
+
+/*!
+ * \brief DupeFinder::_forEach
+ * \param[in] jobs Maximal number of threads
+ * \param[in] count Number of tasks
+ * \param[in] task A function to run for every task index
+ *
+ * Runs tasks on threads taking the next index as they finish.
+ */
+void DupeFinder::_forEach(int jobs, int count, const std::function<void (int index)> &task)
+{
+    if(jobs <= 1 || count <= 1)
+    {
+        for(int index = 0; index < count; index++)
+        {
+            task(index);
+        }
+        return;
+    }
+
+    QAtomicInt next(0);
+    QVector<TaskThread *> threads;
+    for(int threadNum = 0; threadNum < qMin(jobs, count); threadNum++)
+    {
+        TaskThread *thread = new TaskThread([&next, count, &task]() {
+            forever
+            {
+                int index = next.fetchAndAddRelaxed(1);
+                if(index >= count)
+                {
+                    break;
+                }
+                task(index);
+            }
+        });
+        thread->start();
+        threads.append(thread);
+    }
+
+    foreach (TaskThread *thread, threads) {
+        thread->wait();
+    }
+    qDeleteAll(threads);
+}
+
+/*!
+ * \brief DupeFinder::_split
+ * \param[in] files All files
+ * \param[in] groups Groups of file indexes
+ * \param[in] key A function to get a file hash to split by
+ * \return Groups of at least two readable files with equal keys
+ */
+QVector<QVector<int> > DupeFinder::_split(const QVector<File> &files, const QVector<QVector<int> > &groups,
+                                          const std::function<quint64 (const File &file)> &key)
+{
+    QVector<QVector<int> > result;
+
+    foreach (const QVector<int> &group, groups) {
+        QVector<int> readable;
+        foreach (int fileNum, group) {
+            if(files.at(fileNum).readable)
+            {
+                readable.append(fileNum);
+            }
+        }
+
+        std::sort(readable.begin(), readable.end(), [&files, &key](int left, int right) {
+            return key(files.at(left)) < key(files.at(right));
+        });
+
+        int first = 0;
+        while(first < readable.count())
+        {
+            int next = first + 1;
+            while(next < readable.count() && key(files.at(readable.at(next))) == key(files.at(readable.at(first))))
+            {
+                next++;
+            }
+            if(next - first > 1)
+            {
+                result.append(readable.mid(first, next - first));
+            }
+            first = next;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,76 @@
+/*! \file       dupefinder.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      Dupe Finder module header file.
+ *
+ *  This file contains the DupeFinder class declaration.
+ */
+
+#ifndef DUPEFINDER_H
+#define DUPEFINDER_H
+
+#include <QtCore/qglobal.h>
+
+#include <QByteArray>
+#include <QMutex>
+#include <QVector>
+
+#include <functional>
+
+#include "dirreader.h"
+
+/*! \class DupeFinder
+ *  \brief Duplicate file finder class.
+ *
+ *  This class groups listed files by the size they were stated with, so
+ *  files of unique sizes are never opened. Hard links of one file (the
+ *  same device & inode) are taken once. Files of colliding sizes are hashed in stages: the first
+ *  4 KB, then the whole file for those whose first blocks collide too. Files
+ *  of equal hashes are compared byte by byte before they are reported.
+ *  Files are hashed on a pool of threads with large sequential reads.
+ *  Empty files are not reported.
+ */
+class DupeFinder
+{
+    public:
+        /*! \struct Group
+         *  \brief Files with the same content.
+         */
+        struct Group
+        {
+            qint64 size;                /*!< A file size */
+            quint64 hash;               /*!< The content hash */
+            QVector<QByteArray> paths;  /*!< Raw file paths sorted by path */
+        };
+
+        explicit DupeFinder(int jobs);
+        void add(const QByteArray &prefix, const QVector<DirEntry> &entries);
+        QVector<Group> find();
+    private:
+        /*! \struct File
+         *  \brief A candidate file.
+         */
+        struct File
+        {
+            QByteArray path;            /*!< A raw file path */
+            qint64 size;                /*!< The file size */
+            quint64 device;             /*!< The device of the file directory, 0 if it is not known */
+            quint64 inode;              /*!< The file inode, 0 if it is not known */
+            quint64 headHash;           /*!< The first block hash */
+            quint64 hash;               /*!< The whole content hash */
+            bool readable;              /*!< Cleared if the file can't be read as it was stated */
+        };
+
+        int _jobs;                      /*!< Number of hashing threads */
+        QMutex _lock;                   /*!< Guards files added from traversal threads */
+        QVector<File> _files;           /*!< Files with a content */
+
+        void _hash(const QVector<int> &files, bool whole);
+        QVector<QVector<int> > _verify(const QVector<QVector<int> > &groups);
+        static void _forEach(int jobs, int count, const std::function<void (int index)> &task);
+        static QVector<QVector<int> > _split(const QVector<File> &files, const QVector<QVector<int> > &groups,
+                                             const std::function<quint64 (const File &file)> &key);
+};
+
+#endif // DUPEFINDER_H
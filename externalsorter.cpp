@@ -0,0 +1,281 @@
+/*! \file       externalsorter.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief External Sorter module source file.
+ *
+ *  This file contains the ExternalSorter class source code.
+ */
+
+#include "externalsorter.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QPair>
+
+#include <algorithm>
+#include <queue>
+#include <vector>
+
+/* Maximal number of runs merged at once, more runs are merged in several passes */
+static const int merge_fan_in = 64;
+
+/* Approximate memory taken by a line besides its bytes */
+static const int record_overhead = 64;
+
+/*!
+ * \brief ExternalSorter::ExternalSorter
+ * \param[in] memoryBudget Memory for lines in bytes before a sorted run is spilled
+ *
+ * ExternalSorter Constructor
+ */
+ExternalSorter::ExternalSorter(qint64 memoryBudget)
+{
+    _memoryBudget = memoryBudget;
+    _used = 0;
+}
+
+/*!
+ * \brief ExternalSorter::~ExternalSorter
+ *
+ * ExternalSorter Destructor, temporary files are removed
+ */
+ExternalSorter::~ExternalSorter()
+{
+    qDeleteAll(_runs);
+}
+
+/*!
+ * \brief ExternalSorter::add
+ * \param[in] key A sort key
+ * \param[in] line An encoded output line
+ */
+void ExternalSorter::add(const QByteArray &key, const QByteArray &line)
+{
+    Record record;
+    record.key = key;
+    record.line = line;
+    _records.append(record);
+    _used += key.size() + line.size() + record_overhead;
+
+    /* Lines stay in memory if the run can't be written, the next attempt is after the next budget */
+    if(_used >= _memoryBudget)
+    {
+        _spill();
+        _used = 0;
+    }
+}
+
+/*!
+ * \brief ExternalSorter::_sort
+ *
+ * Sorts lines in memory keeping the adding order of equal keys.
+ */
+void ExternalSorter::_sort()
+{
+    std::stable_sort(_records.begin(), _records.end(), [](const Record &left, const Record &right) {
+        return left.key < right.key;
+    });
+}
+
+/*!
+ * \brief ExternalSorter::_spill
+ * \return "false" if the run can't be written, lines are kept in memory then
+ *
+ * Writes lines in memory to a temporary file as a sorted run.
+ */
+bool ExternalSorter::_spill()
+{
+    QTemporaryFile *run = new QTemporaryFile(QDir(QDir::tempPath()).filePath("tdir-sort-XXXXXX"));
+    if(!run->open())
+    {
+        delete run;
+        return false;
+    }
+
+    _sort();
+
+    QDataStream stream(run);
+    foreach (const Record &record, _records) {
+        stream << record.key << record.line;
+    }
+
+    if(stream.status() != QDataStream::Ok || !run->flush())
+    {
+        delete run;
+        return false;
+    }
+
+    _runs.append(run);
+    _records.clear();
+    _records.squeeze();
+    return true;
+}
+
+/*!
+ * \brief ExternalSorter::_merge
+ * \param[in] runs Sorted runs to merge
+ * \param[in] records Sorted lines in memory to merge after the runs
+ * \param[in] consume A function to pass merged records to
+ * \return "false" if a run can't be read to its end
+ *
+ * Merges sorted sources with a heap of their current records,
+ * equal keys are taken from earlier sources first.
+ */
+bool ExternalSorter::_merge(const QList<QTemporaryFile *> &runs, const QVector<Record> &records, const RecordFunction &consume)
+{
+    /* A current record of a source */
+    typedef QPair<Record, int> Head;
+    auto greater = [](const Head &left, const Head &right) {
+        if(left.first.key != right.first.key)
+        {
+            return right.first.key < left.first.key;
+        }
+        return right.second < left.second;
+    };
+    std::priority_queue<Head, std::vector<Head>, decltype(greater)> heads(greater);
+
+    bool ok = true;
+    QVector<QDataStream *> streams;
+    for(int runNum = 0; runNum < runs.count(); runNum++)
+    {
+        runs.at(runNum)->seek(0);
+        streams.append(new QDataStream(runs.at(runNum)));
+        if(streams.last()->atEnd())
+        {
+            continue;
+        }
+
+        Record record;
+        *streams.last() >> record.key >> record.line;
+        if(streams.last()->status() == QDataStream::Ok)
+        {
+            heads.push(qMakePair(record, runNum));
+        }
+        else
+        {
+            ok = false;
+        }
+    }
+
+    /* Lines in memory are the last source */
+    const int memorySource = runs.count();
+    int nextRecord = 0;
+    if(nextRecord < records.count())
+    {
+        heads.push(qMakePair(records.at(nextRecord++), memorySource));
+    }
+
+    /* A short or damaged run stops the merge instead of being taken as its end */
+    while(ok && !heads.empty())
+    {
+        Head head = heads.top();
+        heads.pop();
+        consume(head.first);
+
+        if(head.second == memorySource)
+        {
+            if(nextRecord < records.count())
+            {
+                heads.push(qMakePair(records.at(nextRecord++), memorySource));
+            }
+            continue;
+        }
+
+        QDataStream *stream = streams.at(head.second);
+        if(!stream->atEnd())
+        {
+            Record record;
+            *stream >> record.key >> record.line;
+            if(stream->status() == QDataStream::Ok)
+            {
+                heads.push(qMakePair(record, head.second));
+            }
+            else
+            {
+                ok = false;
+            }
+        }
+    }
+
+    qDeleteAll(streams);
+    return ok;
+}
+
+/*!
+ * \brief ExternalSorter::write
+ * \param[in] out A writer to write sorted lines to
+ * \return "false" if a sorted run can't be read
+ *
+ * Writes all lines sorted by their keys & forgets them.
+ */
+bool ExternalSorter::write(OutputWriter &out)
+{
+    return read([&out](const QByteArray &key, const QByteArray &line) {
+        Q_UNUSED(key)
+        out.write(line);
+    });
+}
+
+/*!
+ * \brief ExternalSorter::read
+ * \param[in] consume A function to pass lines with their keys to
+ * \return "false" if a sorted run can't be read, the passed lines are incomplete then
+ *
+ * Passes all lines sorted by their keys & forgets them.
+ */
+bool ExternalSorter::read(const LineFunction &consume)
+{
+    /* The lines in memory become the last run, they are merged from memory if it can't be spilled */
+    if(!_runs.isEmpty() && !_records.isEmpty() && !_spill())
+    {
+        _sort();
+    }
+
+    /* Merging runs in passes until all of them can be merged at once */
+    while(_runs.count() > merge_fan_in)
+    {
+        QTemporaryFile *merged = new QTemporaryFile(QDir(QDir::tempPath()).filePath("tdir-sort-XXXXXX"));
+        if(!merged->open())
+        {
+            delete merged;
+            break;
+        }
+
+        QList<QTemporaryFile *> group = _runs.mid(0, merge_fan_in);
+        QDataStream stream(merged);
+        if(!_merge(group, QVector<Record>(), [&stream](const Record &record) {
+            stream << record.key << record.line;
+        }))
+        {
+            delete merged;
+            return false;
+        }
+
+        /* The source runs are kept & merged at once if the merged run can't be written */
+        if(stream.status() != QDataStream::Ok || !merged->flush())
+        {
+            delete merged;
+            break;
+        }
+
+        qDeleteAll(group);
+        _runs = _runs.mid(merge_fan_in);
+        _runs.append(merged);
+    }
+
+    if(_runs.isEmpty())
+    {
+        _sort();
+    }
+
+    bool ok = _merge(_runs, _records, [&consume](const Record &record) {
+        consume(record.key, record.line);
+    });
+
+    qDeleteAll(_runs);
+    _runs.clear();
+    _records.clear();
+    _used = 0;
+    return ok;
+}
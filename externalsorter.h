@@ -0,0 +1,65 @@
+/*! \file       externalsorter.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      External Sorter module header file.
+ *
+ *  This file contains the ExternalSorter class declaration.
+ */
+
+#ifndef EXTERNALSORTER_H
+#define EXTERNALSORTER_H
+
+#include <QtCore/qglobal.h>
+
+#include <QByteArray>
+#include <QList>
+#include <QTemporaryFile>
+#include <QVector>
+
+#include <functional>
+
+#include "outputwriter.h"
+
+/*! \class ExternalSorter
+ *  \brief External merge sort class for output lines.
+ *
+ *  This class sorts lines by byte keys in memory until they take the memory
+ *  budget, then sorted runs are spilled to temporary files & merged by a k-way
+ *  merge when lines are written. Lines stay in memory if a run can't be spilled.
+ */
+class ExternalSorter
+{
+    public:
+        /*! A sorted line function */
+        typedef std::function<void (const QByteArray &key, const QByteArray &line)> LineFunction;
+
+        explicit ExternalSorter(qint64 memoryBudget);
+        ~ExternalSorter();
+        void add(const QByteArray &key, const QByteArray &line);
+        bool read(const LineFunction &consume);
+        bool write(OutputWriter &out);
+    private:
+        /*! \struct Record
+         *  \brief A sorted line.
+         */
+        struct Record
+        {
+            QByteArray key;     /*!< A sort key */
+            QByteArray line;    /*!< An encoded output line */
+        };
+
+        /*! A merged record function */
+        typedef std::function<void (const Record &record)> RecordFunction;
+
+        qint64 _memoryBudget;               /*!< Memory for lines before a run is spilled */
+        qint64 _used;                       /*!< Memory taken by lines in memory */
+        QVector<Record> _records;           /*!< Lines in memory */
+        QList<QTemporaryFile *> _runs;      /*!< Spilled sorted runs */
+
+        void _sort();
+        bool _spill();
+        bool _merge(const QList<QTemporaryFile *> &runs, const QVector<Record> &records, const RecordFunction &consume);
+};
+
+#endif // EXTERNALSORTER_H
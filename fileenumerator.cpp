@@ -1,554 +1,2736 @@
-/*! \file       fileenumerator.cpp
- *  \author     Yury Osipov (yusosipov@ya.ru)
- *  \version    1.0.0.1
- *  \date       August, 2018
- *  \brief File Enumerator module source file.
- *
- *  This file contains the FileEnumerator class source code.
- */
-
-#include "fileenumerator.h"
-#include "options.h"
-
-#include <QDir>
-#include <QDateTime>
-#include <QTextStream>
-
-#ifdef __TDIR_DEBUG__
-#include <QDebug>
-#endif
-
-/* Fixing terminal encoding for different OS compability */
-#ifdef _WIN32
-    static const char *codecName = "IBM866";
-#else
-    static const char *codecName = "UTF-8";
-#endif
-
-/*
- * You can change file_modification_time format here.
- * It uses the same format as QDateTime::toString method.
- */
-static const char *file_modification_time_format = "dd.MM.yyyy hh:mm:ss";
-
-/*!
- * \brief FileEnumerator::FileEnumerator
- * \param parent A parent object calling constructor
- *
- * FileEnumerator Constructor
- */
-FileEnumerator::FileEnumerator(QObject *parent) : QObject (parent)
-{
-    _app = qobject_cast<QCoreApplication *>(parent);
-    _out = new QTextStream(stdout);
-    _out->setCodec(codecName);
-    _currentDir = new QString(QDir::current().absolutePath());  /*!< Saving app launch (current) dir by default */
-    _mask = new QStringList();
-    _runRecursively = false;                                    /*!< No recursive file enumeration mode by default */
-    _exitCode = TDIR_APPLICATION_NO_ERROR;                      /*!< Setting no error code by default */
-
-    _fillOptionList();
-
-}
-
-/*!
- * \brief FileEnumerator::_fillOptionList
- *
- * Filling a known options for the application
- */
-void FileEnumerator::_fillOptionList()
-{
-    _knownOptions["-r"] = TDIR_OPT_RECURSIVE;
-    _knownOptions["-h"] = TDIR_OPT_HELP;
-}
-
-/*!
- * \brief FileEnumerator::~FileEnumerator
- *
- * FileEnumerator Destructor
- */
-FileEnumerator::~FileEnumerator()
-{
-    if(_out) delete _out;
-    if(_currentDir) delete _currentDir;
-    if(_mask) delete _mask;
-    if(_appArguments) delete _appArguments;
-}
-
-/*!
- * \brief FileEnumerator::viewHelp
- *
- * Application help view method
- */
-void FileEnumerator::viewHelp()
-{
-    if(_exitCode !=0)
-    {
-        switch(_exitCode)
-        {
-            case  TDIR_ARG_ERR_WRONG_OPTION_POS:
-                *_out << "A wrong options order has been detected." << endl << endl;
-                break;
-            case TDIR_ARG_ERR_UNKNOWN_OPTION:
-                *_out << "An unknown option was set." << endl << endl;
-                break;
-            case TDIR_ARG_ERR_OPTION_DUPLICATION:
-                *_out << "An option duplication has been detected." << endl << endl;
-                break;
-            case TDIR_ARG_ERR_TOO_MANY:
-                *_out << "Too many arguments." << endl << endl;
-                break;
-            case TDIR_ARG_UNKNOWN_ERROR:
-                *_out << "An unknown error has happened." << endl << endl;
-                break;
-            case TDIR_MEM_ALLOCATION_ERROR:
-                *_out << "Memory allocation error has happened." << endl << endl;
-                break;
-            case TDIR_APPLICATION_ERROR:
-                *_out << "An application error has happened." << endl << endl;
-                break;
-            default:
-                *_out << "Unknown error has happened." << endl << endl;
-                break;
-        }
-    }
-
-    *_out << "\tTdir application help." << endl <<
-             "Usage:" << endl <<
-             "   tdir [path] [option]" << endl << endl;
-
-    *_out << "path -" << "\t\tThis is an optional parameter. You can set a path here to start file enumeration from." << endl <<
-             "\t\tAlso you can set here a file mask to enumerate files which match this mask." << endl <<
-             "\t\tIf this parameter is empty current folder is a start path." << endl << endl;
-
-    *_out << "option -" << "\tThis is an optional parameter. You can set it to \"-r\" for recursive file enumeration." << endl <<
-             "\t\tAlso you can set it to \"-h\" to display help." << endl << endl;
-}
-
-/*!
- * \brief FileEnumerator::_exit
- */
-void FileEnumerator::_exit()
-{
-    if(_exitCode != 0)
-    {
-        viewHelp();
-    }
-    exit(_exitCode);
-}
-
-/*!
- * \brief FileEnumerator::_findOptions
- * \return Number of found options (>=0) or error (<0)
- *
- * App call option finder method
- */
-int FileEnumerator::_findOptions()
-{
-    int ret = 0;
-
-    /* Check if args are accessible */
-    if(_appArguments == nullptr)
-    {
-        ret = -1;
-    }
-    else
-    {
-        /* Trying to find options ("-*") in arg list */
-        for(int argNum = 1; argNum < _appArguments->count(); argNum++ )
-        {
-            QString currentArg(_appArguments->at(argNum));
-            if(currentArg.contains("-"))
-            {
-                /* Check if option is known one */
-                if(!_knownOptions.contains(currentArg))
-                {
-                    ret = -2; /* Unknown option */
-                }
-                else
-                {
-                    /* Check if option was already found earlier (duplication) */
-                    if(_options.values().contains(currentArg))
-                    {
-                        ret = -3; /* Option duplication */
-                    }
-                    else
-                    {
-                        /* Save option finally, incrementing option counter */
-                        _options.insert(argNum, currentArg);
-                        ret++;
-                    }
-                }
-            }
-        }
-    }
-
-    return ret;
-}
-
-/*!
- * \brief FileEnumerator::run
- *
- * Class main working function
- */
-void FileEnumerator::run()
-{
-    /* Check for ability to get application call arguments */
-    if(_app == nullptr)
-    {
-#ifdef __TDIR_DEBUG__
-        qWarning() << "Can't get application call arguments!";
-#endif
-        _exitCode = TDIR_APPLICATION_ERROR;
-        _exit();
-    }
-
-    _appArguments =  new QStringList(_app->arguments());
-
-    /* Check for memory allocation error */
-    if(_appArguments == nullptr)
-    {
-#ifdef __TDIR_DEBUG__
-        qWarning() << "Can't allocate memory for application call arguments!";
-#endif
-        _exitCode = TDIR_MEM_ALLOCATION_ERROR;
-        _exit();
-    }
-
-    if(_appArguments->isEmpty())
-    {
-#ifdef __TDIR_DEBUG__
-        qWarning() << "Empty argument list!";
-#endif
-        _exitCode = TDIR_APPLICATION_ERROR;
-        _exit();
-    }
-
-    /* Application was launched without arguments */
-    if(_appArguments->count() == 1)
-    {
-        /* Calling file enumerator method with default settings (from current dir) */
-        listFiles();
-        _exitCode = TDIR_APPLICATION_NO_ERROR;
-        _exit();
-    }
-
-    /* Find recursive option & it's position & duplication */
-     int options = _findOptions();
-
-     /* Exiting with right code on error */
-     if(options < 0)
-     {
-        switch (options)
-        {
-            case -1:
-#ifdef __TDIR_DEBUG__
-                qWarning() << "Error getting arguments!";
-#endif
-                _exitCode = TDIR_APPLICATION_ERROR;
-                _exit();
-            break;
-            case -2:
-#ifdef __TDIR_DEBUG__
-                qWarning() << "Unknown option was found!";
-#endif
-                _exitCode = TDIR_OPT_UNKNOWN;
-                _exit();
-            break;
-        case -3:
-#ifdef __TDIR_DEBUG__
-                qWarning() << "Option duplication was found!";
-#endif
-                _exitCode = TDIR_ARG_ERR_OPTION_DUPLICATION;
-                _exit();
-            break;
-        default:
-#ifdef __TDIR_DEBUG__
-                qWarning() << "Unknown error during options parcing has happened!";
-#endif
-                _exitCode = TDIR_ARG_UNKNOWN_ERROR;
-                _exit();
-            break;
-        }
-     }
-
-     /* If application was called with one argument */
-     if(_appArguments->count() == 2)
-     {
-         if(options > 0)
-         {
-             /* Check if option is recursive mode */
-             if(_options.values().contains("-r"))
-             {
-                 /* Go recursively from current path */
-                 setRecursiveMode(true);
-                 listFiles();
-                 _exitCode = TDIR_APPLICATION_NO_ERROR;
-                 _exit();
-             }
-             /* Check if option is help */
-             else if(_options.values().contains("-h"))
-             {
-                 viewHelp();
-                 _exitCode = TDIR_APPLICATION_NO_ERROR;
-                 _exit();
-             }
-         }
-         /* Check if it is a valid path */
-         else
-         {
-             QDir dir(_appArguments->at(1));
-
-             /* Check if it is a valid directory name */
-             if(dir.exists())
-             {
-                 qDebug() << "Directory exists! Setting it to default one!";
-                 setCurrentDir(dir.absolutePath());
-                 listFiles();
-                 _exitCode = TDIR_APPLICATION_NO_ERROR;
-                 _exit();
-             }
-             /* Check if mask was applied */
-             else
-             {
-                 /* Check if it is a mask here */
-                 setMask(_appArguments->at(1));
-                 listFiles();
-                 _exitCode = TDIR_APPLICATION_NO_ERROR;
-                 _exit();
-             }
-         }
-     }
-
-     /* If application was called with one argument */
-     if(_appArguments->count() == 3)
-     {
-         if(options > 0)
-         {
-             /* Check if option is recursive mode */
-             if(_options.values().contains("-r"))
-             {
-                 if(!(_options.key("-r") == 2))
-                 {
-                     qDebug() << "Wrong option position!";
-                     _exitCode = TDIR_ARG_ERR_WRONG_OPTION_POS;
-                     _exit();
-                 }
-                 else
-                 {
-                     setRecursiveMode(true);
-
-                     QDir dir(_appArguments->at(1));
-
-                     /* Check if it is a valid directory name */
-                     if(dir.exists())
-                     {
-                         qDebug() << "Directory exists! Setting it to default one!";
-                         setCurrentDir(dir.absolutePath());
-                         listFiles();
-                         _exitCode = TDIR_APPLICATION_NO_ERROR;
-                         _exit();
-                     }
-                     /* Check if help option is the first */
-                     else if((_options.key("-h") == 1))
-                     {
-                         qDebug() << "Wrong option position!";
-                         _exitCode = TDIR_ARG_ERR_WRONG_OPTION_POS;
-                         _exit();
-                     }
-                     else
-                     {
-                         /* Check if it is a mask here */
-                         setMask(_appArguments->at(1));
-                         listFiles();
-                         _exitCode = TDIR_APPLICATION_NO_ERROR;
-                         _exit();
-                     }
-                 }
-             }
-             /* Check if option is help */
-             else if(_options.values().contains("-h"))
-             {
-                 if(!(_options.key("-h") == 2))
-                 {
-                     qDebug() << "Wrong option position!";
-                     _exitCode = TDIR_ARG_ERR_WRONG_OPTION_POS;
-                     _exit();
-                 }
-                 else
-                 {
-                    viewHelp();
-                    _exitCode = TDIR_APPLICATION_NO_ERROR;
-                    _exit();
-                 }
-             }
-             else
-             {
-                 _exitCode = TDIR_ARG_ERR_UNKNOWN_OPTION;
-                 _exit();
-             }
-         }
-         else
-         {
-             _exitCode = TDIR_ARG_ERR_WRONG_OPTION_POS;
-             _exit();
-         }
-     }
-
-     /* If application was called with too many arguments (>3) */
-     if(_appArguments->count() > 3)
-     {
-        _exitCode = TDIR_ARG_ERR_TOO_MANY;
-        _exit();
-     }
-
-    emit finished();
-}
-
-/*!
- * \brief FileEnumerator::setCurrentDir
- * \param dirPath
- *
- * Method function sets current (start) directory to start file enumeration
- */
-void FileEnumerator::setCurrentDir(const QString &dirPath)
-{
-    if(_currentDir == nullptr)
-    {
-        _currentDir = new QString(dirPath);
-    }
-    else
-    {
-        _currentDir->clear();
-        _currentDir->append(dirPath);
-    }
-}
-
-/*!
- * \brief FileEnumerator::setMask
- * \param[in] mask File mask
- *
- * This method stores a mask to a private variable
- */
-void FileEnumerator::setMask(const QString mask)
-{
-    if(_mask == nullptr)
-    {
-        _mask = new QStringList();
-        _mask->append(mask);
-    }
-    else
-    {
-        _mask->clear();
-        _mask->append(mask);
-    }
-}
-
-/*!
- * \brief FileEnumerator::setRecursiveMode
- * \param[in] recursiveMode Set to "true" to use recursive file enumeration
- *
- * This method sets a stored recursive flag
- */
-void FileEnumerator::setRecursiveMode(const bool recursiveMode)
-{
-    _runRecursively = recursiveMode;
-}
-
-/*!
- * \brief FileEnumerator::listFiles
- * \param[in] file A file to show info for
- *
- * A public class method to view info for a 1 file only.
- * Gives an interface for a private method.
- */
-void FileEnumerator::listFiles(const QFile &file)
-{
-    _listFiles(file);
-}
-
-/*!
- * \brief FileEnumerator::_listFiles
- * \param[in] file A file to show info for
- *
- * A private class method to view info for a 1 file only
- */
-void FileEnumerator::_listFiles(const QFile &file)
-{
-    QFileInfo fileInfo(file);
-    *_out << file.fileName() << " " <<
-             fileInfo.size() << " " << fileInfo.lastModified().toString(file_modification_time_format) << endl;
-}
-
-
-/*!
- * \brief FileEnumerator::_listFiles
- * \param[in] dir A root dir to start enumeration from
- *
- * Private file enumeration method function which can run recursively if it's needed.
- */
-void FileEnumerator::_listFiles(const QDir &dir)
-{
-    QCoreApplication::processEvents();      /*!< Processing events not to freeze event loop */
-
-    QStringList fileList;
-
-    /* Check if mask exists */
-    if(_mask)
-    {
-        if(!_mask->isEmpty())
-        {
-            /* Building a file list according to mask */
-            fileList = dir.entryList(*_mask, QDir::Files);
-        }
-        else
-        {
-            /* If mask is empty - looking for all files in dir */
-            fileList = dir.entryList(QDir::Files);
-        }
-    }
-    else
-    {
-        /* If mask doesn't exist - looking for all files in dir */
-        fileList = dir.entryList(QDir::Files);
-    }
-
-    /* Showing file information according to format:
-       path/file_name file_size file_modification_time */
-    foreach (QString file, fileList) {
-       QFileInfo fileInfo(dir.absoluteFilePath(file));
-       *_out << dir.absoluteFilePath(file) << " " <<
-              fileInfo.size() << " " << fileInfo.lastModified().toString(file_modification_time_format) << endl;
-    }
-
-    _out->flush();
-
-    /* Checking if recursive algorythm needed */
-    if(_runRecursively)
-    {
-        /* Building a dir list for current root dir */
-        QStringList dirList =
-               dir.entryList(QDir::Dirs);
-
-        /* Calling this function recursively for all dirs in a list */
-        foreach (QString subdir, dirList) {
-           /* Skipping "." & ".." directories */
-           if (subdir == QString(".") || subdir == QString(".."))
-           {
-               continue;
-           }
-           _listFiles(QDir(dir.absoluteFilePath(subdir)));
-        }
-    }
-}
-
-/*!
- * \brief FileEnumerator::listFiles
- *
- * Public method function of enumeration files to be called by a Class user.
- */
-void FileEnumerator::listFiles()
-{
-    _listFiles(QDir(*_currentDir));
-}
-
+/*! \file       fileenumerator.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief File Enumerator module source file.
+ *
+ *  This file contains the FileEnumerator class source code.
+ */
+
+#include "fileenumerator.h"
+#include "options.h"
+#include "traversalpool.h"
+#include "topcollector.h"
+#include "externalsorter.h"
+#include "snapshot.h"
+#include "nameindex.h"
+#include "scanstats.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTextStream>
+#include <QPair>
+#include <QSaveFile>
+#include <QScopedPointer>
+#include <QSet>
+#include <QThread>
+
+#include <stdio.h>
+
+#ifdef __TDIR_DEBUG__
+#include <QDebug>
+#endif
+
+/* Fixing terminal encoding for different OS compability */
+#ifdef _WIN32
+    static const char *codecName = "IBM866";
+#else
+    static const char *codecName = "UTF-8";
+#endif
+
+/*
+ * You can change file_modification_time format here.
+ * It uses the same format as QDateTime::toString method.
+ */
+static const char *file_modification_time_format = "dd.MM.yyyy hh:mm:ss";
+
+/* Memory for sorted lines before they are spilled to temporary files in sort mode */
+static const qint64 sort_memory_budget = 64 * 1024 * 1024;
+
+/* Output size collected from visited files before it is written */
+static const int output_chunk_size = 64 * 1024;
+
+/*!
+ * \brief FileEnumerator::FileEnumerator
+ * \param parent A parent object calling constructor
+ *
+ * FileEnumerator Constructor
+ */
+FileEnumerator::FileEnumerator(QObject *parent) : QObject (parent)
+{
+    _out = nullptr;                                             /*!< The help stream is created when help is shown */
+    _writer = new OutputWriter(fileno(stdout));
+    _codec = nullptr;                                           /*!< Codecs are looked up when output starts */
+    _utf8Output = false;
+    _rawNames = false;
+    _format = RecordSink::FORMAT_TEXT;                          /*!< Text lines by default */
+    _sink = nullptr;                                            /*!< The sink is created when output starts */
+    _chunk.reserve(output_chunk_size);                          /*!< Keeping the capacity on resize(0) */
+    _enumerator = nullptr;
+    _path.reserve(4096);
+    _file.isDir = false;
+    _file.size = 0;
+    _file.mtime = 0;
+    _file.blocks = 0;
+    _file.mtimeNsec = 0;
+    _file.mode = 0;
+    _file.inode = 0;
+    _file.ctime = 0;
+    _file.uid = 0;
+    _file.links = 0;
+    _file.isLink = false;
+    _pipelined = true;                                          /*!< Output is formatted on its own thread by default */
+    _pipeline = nullptr;
+    _currentDir = new QString(QDir::current().absolutePath());  /*!< Saving app launch (current) dir by default */
+    _mask = new QStringList();
+    _matcher = nullptr;
+    _nameMatcher = nullptr;
+    _runRecursively = false;                                    /*!< No recursive file enumeration mode by default */
+    _failedRoots = 0;
+    _jobs = 1;                                                  /*!< Single threaded traversal by default */
+    _unordered = false;                                         /*!< Ordered parallel traversal output by default */
+    _maxDepth = -1;                                             /*!< Unlimited recursion depth by default */
+    _inodeOrder = false;                                        /*!< The file system order by default */
+    _statBatchDepth = 0;                                        /*!< Files are stated one by one by default */
+    _deviceJobs = 0;                                            /*!< No per-device limit by default */
+    _oneFileSystem = false;                                     /*!< All file systems are entered by default */
+    _linksOnce = false;                                         /*!< Every hard link is listed by default */
+    _guard = nullptr;
+    _summarize = false;                                         /*!< Files are shown by default */
+    _summaryDepth = 0;                                          /*!< Only the start directory total by default */
+    _dupes = false;                                             /*!< Files are shown by default */
+    _topCount = 0;                                              /*!< All files are shown by default */
+    _sortMode = false;                                          /*!< Directory order by default */
+    _sortBy = SortByDefault;
+    _stats = false;                                             /*!< No statistics by default */
+    _progressInterval = 0;                                      /*!< No progress lines by default */
+    _index = nullptr;                                           /*!< No tree index by default */
+    _watchMode = false;                                         /*!< No watch mode by default */
+    _watcher = nullptr;
+    _appArguments = nullptr;
+    _exitCode = TDIR_APPLICATION_NO_ERROR;                      /*!< Setting no error code by default */
+
+    _fillOptionList();
+
+}
+
+/*!
+ * \brief FileEnumerator::_fillOptionList
+ *
+ * Filling a known options for the application
+ */
+void FileEnumerator::_fillOptionList()
+{
+    _knownOptions["-r"] = TDIR_OPT_RECURSIVE;
+    _knownOptions["-h"] = TDIR_OPT_HELP;
+    _knownOptions["-j"] = TDIR_OPT_JOBS;
+    _knownOptions["-u"] = TDIR_OPT_UNORDERED;
+    _knownOptions["--line-buffered"] = TDIR_OPT_LINE_BUFFERED;
+    _knownOptions["--index"] = TDIR_OPT_INDEX;
+    _knownOptions["--watch"] = TDIR_OPT_WATCH;
+    _knownOptions["--io-uring"] = TDIR_OPT_IO_URING;
+    _knownOptions["-i"] = TDIR_OPT_INCLUDE;
+    _knownOptions["-x"] = TDIR_OPT_EXCLUDE;
+    _knownOptions["--max-depth"] = TDIR_OPT_MAX_DEPTH;
+    _knownOptions["--summarize"] = TDIR_OPT_SUMMARIZE;
+    _knownOptions["--depth"] = TDIR_OPT_DEPTH;
+    _knownOptions["--top"] = TDIR_OPT_TOP;
+    _knownOptions["--sort"] = TDIR_OPT_SORT;
+    _knownOptions["--by"] = TDIR_OPT_BY;
+    _knownOptions["--format"] = TDIR_OPT_FORMAT;
+    _knownOptions["--stats"] = TDIR_OPT_STATS;
+    _knownOptions["--progress"] = TDIR_OPT_PROGRESS;
+    _knownOptions["--dupes"] = TDIR_OPT_DUPES;
+    _knownOptions["--where"] = TDIR_OPT_WHERE;
+    _knownOptions["--no-pipeline"] = TDIR_OPT_NO_PIPELINE;
+    _knownOptions["--one-file-system"] = TDIR_OPT_ONE_FILE_SYSTEM;
+    _knownOptions["--skip-fstype"] = TDIR_OPT_SKIP_FSTYPE;
+    _knownOptions["--links-once"] = TDIR_OPT_LINKS_ONCE;
+    _knownOptions["--snapshot"] = TDIR_OPT_SNAPSHOT;
+    _knownOptions["--diff"] = TDIR_OPT_DIFF;
+    _knownOptions["--name-index"] = TDIR_OPT_NAME_INDEX;
+    _knownOptions["--query"] = TDIR_OPT_QUERY;
+    _knownOptions["--inode-order"] = TDIR_OPT_INODE_ORDER;
+    _knownOptions["--device-jobs"] = TDIR_OPT_DEVICE_JOBS;
+    _knownOptions["--from-file"] = TDIR_OPT_FROM_FILE;
+}
+
+/*!
+ * \brief FileEnumerator::~FileEnumerator
+ *
+ * FileEnumerator Destructor
+ */
+FileEnumerator::~FileEnumerator()
+{
+    if(_writer) delete _writer;
+    if(_sink) delete _sink;
+    if(_out) delete _out;
+    if(_currentDir) delete _currentDir;
+    if(_mask) delete _mask;
+    if(_matcher) delete _matcher;
+    if(_nameMatcher) delete _nameMatcher;
+    if(_guard) delete _guard;
+    if(_appArguments) delete _appArguments;
+}
+
+/*!
+ * \brief FileEnumerator::viewHelp
+ *
+ * Application help view method
+ */
+void FileEnumerator::viewHelp()
+{
+    _setupCodec();
+
+    if(_exitCode !=0)
+    {
+        switch(_exitCode)
+        {
+            case  TDIR_ARG_ERR_WRONG_OPTION_POS:
+                *_out << "A wrong options order has been detected." << endl << endl;
+                break;
+            case TDIR_ARG_ERR_UNKNOWN_OPTION:
+                *_out << "An unknown option was set." << endl << endl;
+                break;
+            case TDIR_ARG_ERR_OPTION_DUPLICATION:
+                *_out << "An option duplication has been detected." << endl << endl;
+                break;
+            case TDIR_ARG_ERR_TOO_MANY:
+                *_out << "Too many arguments." << endl << endl;
+                break;
+            case TDIR_ARG_UNKNOWN_ERROR:
+                *_out << "An unknown error has happened." << endl << endl;
+                break;
+            case TDIR_MEM_ALLOCATION_ERROR:
+                *_out << "Memory allocation error has happened." << endl << endl;
+                break;
+            case TDIR_APPLICATION_ERROR:
+                *_out << "An application error has happened." << endl << endl;
+                break;
+            case TDIR_ARG_ERR_WRONG_VALUE:
+                *_out << "An option value is missing or wrong." << endl << endl;
+                break;
+            case TDIR_ROOT_ERROR:
+                *_out << "Some start directories can't be listed, they are shown above." << endl << endl;
+                break;
+            case TDIR_ARG_ERR_ROOTS_MODE:
+                *_out << "Several start directories can't be summarized, indexed, watched or written to a snapshot." << endl << endl;
+                break;
+            default:
+                *_out << "Unknown error has happened." << endl << endl;
+                break;
+        }
+    }
+
+    *_out << "\tTdir application help." << endl <<
+             "Usage:" << endl <<
+             "   tdir [path] [option] [-j jobs] [-u] [--line-buffered] [--index file] [--watch]" << endl <<
+             "\t[--io-uring depth] [-i mask]... [-x mask]... [--max-depth depth]" << endl <<
+             "\t[--summarize [--depth depth]] [--top count] [--sort] [--by name|size|mtime]" << endl <<
+             "\t[--format text|ndjson|binary] [--stats] [--progress seconds] [--dupes]" << endl <<
+             "\t[--where expression] [--no-pipeline] [--one-file-system] [--skip-fstype types]..." << endl <<
+             "\t[--links-once] [--snapshot file] [--name-index file] [--inode-order] [--device-jobs jobs]" << endl <<
+             "   tdir path path... [-r] [options] | tdir --from-file file|- [path]... [-r] [options]" << endl <<
+             "   tdir --diff old_file new_file [--format text|ndjson|binary]" << endl <<
+             "   tdir --query index_file mask [-i mask]... [-x mask]... [--format text|ndjson|binary]" << endl << endl;
+
+    *_out << "path -" << "\t\tThis is an optional parameter. You can set a path here to start file enumeration from." << endl <<
+             "\t\tAlso you can set here a file mask to enumerate files which match this mask." << endl <<
+             "\t\tIf this parameter is empty current folder is a start path." << endl << endl;
+
+    *_out << "option -" << "\tThis is an optional parameter. You can set it to \"-r\" for recursive file enumeration." << endl <<
+             "\t\tAlso you can set it to \"-h\" to display help." << endl <<
+             "\t\tIn recursive mode a directory reached again under itself through links or bind mounts" << endl <<
+             "\t\tisn't entered, other paths to the same directory are all listed." << endl << endl;
+
+    *_out << "--from-file file -" << "\tRead start directories from the file, a path per line, \"-\" reads stdin." << endl <<
+             "\t\tSeveral start directories (given as paths too) are listed by one process on the same" << endl <<
+             "\t\t\"-j jobs\" threads in the given order, lines of different directories are never mixed." << endl <<
+             "\t\tA directory which can't be listed is reported to stderr & the exit code is " << TDIR_ROOT_ERROR << "." << endl << endl;
+
+    *_out << "-j jobs -" << "\tScan directories on \"jobs\" threads in recursive mode." << endl <<
+             "\t\tSet it to 0 to use a thread per processor core." << endl << endl;
+
+    *_out << "--device-jobs jobs -" << "\tScan at most \"jobs\" directories of one file system at once with -j," << endl <<
+             "\t\tso a slow mount (like NFS) doesn't hold all threads. File systems are told" << endl <<
+             "\t\tby mount points of directory paths." << endl << endl;
+
+    *_out << "--inode-order -" << "\tStat files & enter subdirectories in inode order, which seeks less" << endl <<
+             "\t\ton rotating disks. Subdirectories are listed in inode order then." << endl << endl;
+
+    *_out << "--max-depth depth -" << "\tDon't enter subdirectories deeper than \"depth\" in recursive mode." << endl <<
+             "\t\tThe start directory depth is 0." << endl << endl;
+
+    *_out << "--one-file-system -" << "\tDon't enter directories on other file systems than the start one." << endl << endl;
+
+    *_out << "--skip-fstype types -" << "\tDon't enter file systems of comma separated types, it may be repeated." << endl <<
+             "\t\tTypes are wildcard masks of names \"mount\" shows, for example: proc,sysfs,nfs*." << endl << endl;
+
+    *_out << "--links-once -" << "\tList & count a file with several hard links once." << endl << endl;
+
+    *_out << "--summarize -" << "\tShow directory tree totals instead of files as:" << endl <<
+             "\t\t\"path files_count files_size allocated_512_byte_blocks\"." << endl <<
+             "\t\tSubdirectories are always included & shown before their parents." << endl << endl;
+
+    *_out << "--depth depth -" << "\tShow totals of subdirectories up to \"depth\" in summarize mode." << endl <<
+             "\t\tBy default only the start directory total is shown." << endl << endl;
+
+    *_out << "--top count -" << "\tShow only \"count\" first files in the sort order (the largest by default)." << endl << endl;
+
+    *_out << "--sort -" << "\tShow all files in the sort order (by path by default)." << endl <<
+             "\t\tLarge lists are sorted in temporary files." << endl << endl;
+
+    *_out << "--by field -" << "\tSort files by \"name\" (path), \"size\" (the largest first)" << endl <<
+             "\t\tor \"mtime\" (the newest first) in top & sort modes." << endl << endl;
+
+    *_out << "--dupes -" << "\tShow groups of files with the same content instead of files as:" << endl <<
+             "\t\t\"size file_size files files_count reclaimable bytes\", a path per line & an empty line." << endl <<
+             "\t\tOnly files of equal sizes are read, empty files are not reported." << endl << endl;
+
+    *_out << "--snapshot file -" << "\tWrite listed files to a compact snapshot file sorted by path instead of listing them." << endl <<
+             "\t\tPaths are stored relative to the start directory (see snapshot.h)." << endl << endl;
+
+    *_out << "--diff old new -" << "\tCompare two snapshot files & show changed files as:" << endl <<
+             "\t\t\"+ path size time\" (added), \"* path size time\" (size or time changed)," << endl <<
+             "\t\t\"- path size time\" (removed), paths are relative to the snapshot directories." << endl <<
+             "\t\tSnapshots are read sequentially, so files of any size are compared in bounded memory." << endl << endl;
+
+    *_out << "--name-index file -" << "\tWrite listed files to a name index file instead of listing them." << endl <<
+             "\t\tIt keeps paths, file fields & trigrams of names for \"--query\"." << endl << endl;
+
+    *_out << "--query file mask -" << "\tShow files of the name index matching the mask without reading directories," << endl <<
+             "\t\tfor example: --query tree.idx '*.core' or --query tree.idx '*part*'." << endl <<
+             "\t\tA warning goes to stderr if the start directory or a directory of a shown file" << endl <<
+             "\t\thas changed since the index was written." << endl << endl;
+
+    *_out << "--format format -" << "\tWrite files as \"text\" lines (by default), \"ndjson\" objects:" << endl <<
+             "\t\t{\"path\":..., \"size\":..., \"mtime_ns\":..., \"mode\":..., \"inode\":...}" << endl <<
+             "\t\tor \"binary\" length-prefixed records (see recordformat.h)." << endl <<
+             "\t\tPaths are UTF-8 in ndjson & binary formats, summarize & dupes modes can't be binary." << endl << endl;
+
+    *_out << "--stats -" << "\tWrite scan counters, time per phase & a directory read latency" << endl <<
+             "\t\thistogram to stderr when files are listed." << endl << endl;
+
+    *_out << "--progress seconds -" << "\tWrite a progress line to stderr every \"seconds\" while listing." << endl << endl;
+
+    *_out << "-u -" << "\t\tWrite directories in parallel mode as soon as they are scanned." << endl <<
+             "\t\tBy default the output order is the same as in the single threaded mode." << endl << endl;
+
+    *_out << "--line-buffered -" << "\tWrite file information as soon as a directory is read." << endl <<
+             "\t\tBy default it is written by large blocks." << endl << endl;
+
+    *_out << "--no-pipeline -" << "\tFormat & write files on the thread reading directories." << endl <<
+             "\t\tBy default they are formatted & written on another thread while" << endl <<
+             "\t\tdirectories are read, unless the output is a terminal or line buffered." << endl << endl;
+
+    *_out << "--index file -" << "\tKeep directory entries in the index file between runs." << endl <<
+             "\t\tDirectories which haven't changed since the previous run are not read." << endl <<
+             "\t\tNote that files changed in place are shown as they were indexed." << endl << endl;
+
+    *_out << "--watch -" << "\tKeep running after file enumeration & show changed files as:" << endl <<
+             "\t\t\"+ path size time\" (created), \"* path size time\" (modified)," << endl <<
+             "\t\t\"- path size time\" (deleted, the last known size & time)." << endl << endl;
+
+    *_out << "-i mask -" << "\tList files matching the mask too, it may be repeated." << endl <<
+             "\t\tFiles matching the path mask or any \"-i\" mask are listed." << endl << endl;
+
+    *_out << "-x mask -" << "\tDon't list files matching the mask, it may be repeated." << endl <<
+             "\t\tMasks are matched ignoring case, for example: -i '*.log' -x '*.tmp'." << endl << endl;
+
+    *_out << "--where expression -" << "\tList only files the expression is true for, for example:" << endl <<
+             "\t\t--where 'size>1G and mtime<1d and not (name=*.iso or user=root)'" << endl <<
+             "\t\tTests: name=mask, type=f|l (a link), size<>=bytes[K|M|G|T]," << endl <<
+             "\t\tmtime|ctime<>=age[s|m|h|d|w] or yyyy-MM-dd[Thh:mm:ss], user=name|id." << endl <<
+             "\t\tThey are joined by \"and\", \"or\", \"not\" & parentheses, \"and\" may be omitted." << endl <<
+             "\t\tFiles rejected by names & types are not stated." << endl << endl;
+
+    *_out << "--io-uring depth -" << "\tStat files through io_uring keeping \"depth\" requests in flight." << endl <<
+             "\t\tIt helps on network & cold cache file systems, 0 disables it." << endl <<
+             "\t\tFiles are stated one by one where io_uring is not available." << endl << endl;
+}
+
+/*!
+ * \brief FileEnumerator::_exit
+ *
+ * Reports the exit code by finished(), the caller returns from run() after it.
+ */
+void FileEnumerator::_exit()
+{
+    _writer->flush();
+
+    /* Keep reporting changes from the event loop in watch mode */
+    if(_exitCode == TDIR_APPLICATION_NO_ERROR && _watcher && _watcher->isActive())
+    {
+        return;
+    }
+
+    /* Help follows argument errors only, runtime failures have been reported to stderr already */
+    switch(_exitCode)
+    {
+        case TDIR_APPLICATION_NO_ERROR:
+        case TDIR_ROOT_ERROR:
+        case TDIR_SNAPSHOT_ERROR:
+        case TDIR_NAME_INDEX_ERROR:
+        case TDIR_SORT_ERROR:
+            break;
+        default:
+            viewHelp();
+            break;
+    }
+    emit finished(_exitCode);
+}
+
+/*!
+ * \brief FileEnumerator::_reportError
+ * \param[in] filePath A file which can't be used
+ * \param[in] error Why, like "can't be opened"
+ *
+ * Writes a one line diagnostic to stderr, so it doesn't mix with listed files.
+ */
+void FileEnumerator::_reportError(const QString &filePath, const QString &error)
+{
+    QTextStream err(stderr);
+    err << "tdir: " << filePath << ": " << error << endl;
+}
+
+/*!
+ * \brief FileEnumerator::_findOptions
+ * \return Number of found options (>=0) or error (<0)
+ *
+ * App call option finder method
+ */
+int FileEnumerator::_findOptions()
+{
+    int ret = 0;
+
+    /* Check if args are accessible */
+    if(_appArguments == nullptr)
+    {
+        ret = -1;
+    }
+    else
+    {
+        /* Trying to find options ("-*") in arg list */
+        for(int argNum = 1; argNum < _appArguments->count(); argNum++ )
+        {
+            QString currentArg(_appArguments->at(argNum));
+            if(currentArg.contains("-"))
+            {
+                /* Check if option is known one */
+                if(!_knownOptions.contains(currentArg))
+                {
+                    ret = -2; /* Unknown option */
+                }
+                else
+                {
+                    /* Check if option was already found earlier (duplication) */
+                    if(_options.values().contains(currentArg))
+                    {
+                        ret = -3; /* Option duplication */
+                    }
+                    else
+                    {
+                        /* Save option finally, incrementing option counter */
+                        _options.insert(argNum, currentArg);
+                        ret++;
+                    }
+                }
+            }
+        }
+    }
+
+    return ret;
+}
+
+/*!
+ * \brief FileEnumerator::_takeExtendedOptions
+ * \return Number of found extended options (>=0) or error (<0)
+ *
+ * Extended option finder method. Extended options may be placed anywhere
+ * & are removed from the stored argument list together with their values,
+ * so the rest of arguments are parsed by their positions as usual.
+ */
+int FileEnumerator::_takeExtendedOptions()
+{
+    int ret = 0;
+
+    /* Check if args are accessible */
+    if(_appArguments == nullptr)
+    {
+        return -1;
+    }
+
+    QSet<int> foundOptions;
+    int argNum = 1;
+
+    while(argNum < _appArguments->count())
+    {
+        int optionId = _knownOptions.value(_appArguments->at(argNum), TDIR_OPT_UNKNOWN);
+
+        /* Skipping positional arguments & options */
+        if(optionId == TDIR_OPT_RECURSIVE || optionId == TDIR_OPT_HELP || optionId == TDIR_OPT_UNKNOWN)
+        {
+            argNum++;
+            continue;
+        }
+
+        /* Check if option was already found earlier (duplication), masks may be repeated */
+        if(foundOptions.contains(optionId) && optionId != TDIR_OPT_INCLUDE && optionId != TDIR_OPT_EXCLUDE)
+        {
+            return -3;
+        }
+        foundOptions.insert(optionId);
+
+        switch(optionId)
+        {
+            case TDIR_OPT_JOBS:
+            {
+                bool valueOk = false;
+                int jobs = (argNum + 1 < _appArguments->count()) ?
+                            _appArguments->at(argNum + 1).toInt(&valueOk) : -1;
+
+                if(!valueOk || jobs < 0)
+                {
+                    return -4; /* Wrong option value */
+                }
+
+                setJobs((jobs == 0) ? QThread::idealThreadCount() : jobs);
+                _appArguments->removeAt(argNum + 1);
+                break;
+            }
+            case TDIR_OPT_MAX_DEPTH:
+            {
+                bool valueOk = false;
+                int maxDepth = (argNum + 1 < _appArguments->count()) ?
+                                _appArguments->at(argNum + 1).toInt(&valueOk) : -1;
+
+                if(!valueOk || maxDepth < 0)
+                {
+                    return -4; /* Wrong option value */
+                }
+
+                setMaxDepth(maxDepth);
+                _appArguments->removeAt(argNum + 1);
+                break;
+            }
+            case TDIR_OPT_SUMMARIZE:
+                setSummarizeMode(true);
+                break;
+            case TDIR_OPT_DUPES:
+                setDupesMode(true);
+                break;
+            case TDIR_OPT_DEPTH:
+            {
+                bool valueOk = false;
+                int summaryDepth = (argNum + 1 < _appArguments->count()) ?
+                                    _appArguments->at(argNum + 1).toInt(&valueOk) : -1;
+
+                if(!valueOk || summaryDepth < 0)
+                {
+                    return -4; /* Wrong option value */
+                }
+
+                setSummaryDepth(summaryDepth);
+                _appArguments->removeAt(argNum + 1);
+                break;
+            }
+            case TDIR_OPT_TOP:
+            {
+                bool valueOk = false;
+                int topCount = (argNum + 1 < _appArguments->count()) ?
+                                _appArguments->at(argNum + 1).toInt(&valueOk) : -1;
+
+                if(!valueOk || topCount < 1)
+                {
+                    return -4; /* Wrong option value */
+                }
+
+                setTopCount(topCount);
+                _appArguments->removeAt(argNum + 1);
+                break;
+            }
+            case TDIR_OPT_SORT:
+                setSortMode(true);
+                break;
+            case TDIR_OPT_STATS:
+                setStatsMode(true);
+                break;
+            case TDIR_OPT_PROGRESS:
+            {
+                bool valueOk = false;
+                int interval = (argNum + 1 < _appArguments->count()) ?
+                                _appArguments->at(argNum + 1).toInt(&valueOk) : -1;
+
+                if(!valueOk || interval < 1)
+                {
+                    return -4; /* Wrong option value */
+                }
+
+                setProgressInterval(interval);
+                _appArguments->removeAt(argNum + 1);
+                break;
+            }
+            case TDIR_OPT_FORMAT:
+            {
+                RecordSink::Format format = RecordSink::FORMAT_TEXT;
+                if(argNum + 1 >= _appArguments->count() ||
+                   !RecordSink::formatByName(_appArguments->at(argNum + 1), format))
+                {
+                    return -4; /* Wrong option value */
+                }
+
+                setOutputFormat(format);
+                _appArguments->removeAt(argNum + 1);
+                break;
+            }
+            case TDIR_OPT_BY:
+            {
+                QString field = (argNum + 1 < _appArguments->count()) ? _appArguments->at(argNum + 1) : QString();
+
+                if(field == "name")
+                {
+                    setSortField(SortByName);
+                }
+                else if(field == "size")
+                {
+                    setSortField(SortBySize);
+                }
+                else if(field == "mtime")
+                {
+                    setSortField(SortByMtime);
+                }
+                else
+                {
+                    return -4; /* Wrong option value */
+                }
+
+                _appArguments->removeAt(argNum + 1);
+                break;
+            }
+            case TDIR_OPT_UNORDERED:
+                setUnorderedMode(true);
+                break;
+            case TDIR_OPT_LINE_BUFFERED:
+                setLineBuffered(true);
+                break;
+            case TDIR_OPT_NO_PIPELINE:
+                setPipelineMode(false);
+                break;
+            case TDIR_OPT_ONE_FILE_SYSTEM:
+                setOneFileSystem(true);
+                break;
+            case TDIR_OPT_LINKS_ONCE:
+                setLinksOnce(true);
+                break;
+            case TDIR_OPT_INODE_ORDER:
+                setInodeOrder(true);
+                break;
+            case TDIR_OPT_DEVICE_JOBS:
+            {
+                bool valueOk = false;
+                int deviceJobs = (argNum + 1 < _appArguments->count()) ?
+                                  _appArguments->at(argNum + 1).toInt(&valueOk) : -1;
+
+                if(!valueOk || deviceJobs < 1)
+                {
+                    return -4; /* Wrong option value */
+                }
+
+                setDeviceJobs(deviceJobs);
+                _appArguments->removeAt(argNum + 1);
+                break;
+            }
+            case TDIR_OPT_SKIP_FSTYPE:
+                if(argNum + 1 >= _appArguments->count() || _appArguments->at(argNum + 1).isEmpty())
+                {
+                    return -4; /* Wrong option value */
+                }
+
+                addSkippedTypes(_appArguments->at(argNum + 1));
+                _appArguments->removeAt(argNum + 1);
+                break;
+            case TDIR_OPT_WATCH:
+                setWatchMode(true);
+                break;
+            case TDIR_OPT_SNAPSHOT:
+                /* The snapshot directory must exist, the file is replaced when files are listed */
+                if(argNum + 1 >= _appArguments->count() || _appArguments->at(argNum + 1).isEmpty() ||
+                   !QFileInfo(_appArguments->at(argNum + 1)).absoluteDir().exists())
+                {
+                    return -4; /* Wrong option value */
+                }
+
+                setSnapshotPath(_appArguments->at(argNum + 1));
+                _appArguments->removeAt(argNum + 1);
+                break;
+            case TDIR_OPT_NAME_INDEX:
+                /* The index directory must exist, the file is replaced when files are listed */
+                if(argNum + 1 >= _appArguments->count() || _appArguments->at(argNum + 1).isEmpty() ||
+                   !QFileInfo(_appArguments->at(argNum + 1)).absoluteDir().exists())
+                {
+                    return -4; /* Wrong option value */
+                }
+
+                setNameIndexPath(_appArguments->at(argNum + 1));
+                _appArguments->removeAt(argNum + 1);
+                break;
+            case TDIR_OPT_FROM_FILE:
+                /* The list is read when the options are taken, "-" is the standard input */
+                if(argNum + 1 >= _appArguments->count() || _appArguments->at(argNum + 1).isEmpty() ||
+                   (_appArguments->at(argNum + 1) != "-" && !QFileInfo(_appArguments->at(argNum + 1)).isFile()))
+                {
+                    return -4; /* Wrong option value */
+                }
+
+                setRootListPath(_appArguments->at(argNum + 1));
+                _appArguments->removeAt(argNum + 1);
+                break;
+            case TDIR_OPT_QUERY:
+                if(argNum + 2 >= _appArguments->count() ||
+                   _appArguments->at(argNum + 1).isEmpty() || _appArguments->at(argNum + 2).isEmpty())
+                {
+                    return -4; /* Wrong option value */
+                }
+
+                setQuery(_appArguments->at(argNum + 1), _appArguments->at(argNum + 2));
+                _appArguments->removeAt(argNum + 2);
+                _appArguments->removeAt(argNum + 1);
+                break;
+            case TDIR_OPT_DIFF:
+                if(argNum + 2 >= _appArguments->count() ||
+                   _appArguments->at(argNum + 1).isEmpty() || _appArguments->at(argNum + 2).isEmpty())
+                {
+                    return -4; /* Wrong option value */
+                }
+
+                setDiffPaths(_appArguments->at(argNum + 1), _appArguments->at(argNum + 2));
+                _appArguments->removeAt(argNum + 2);
+                _appArguments->removeAt(argNum + 1);
+                break;
+            case TDIR_OPT_INDEX:
+                if(argNum + 1 >= _appArguments->count() || _appArguments->at(argNum + 1).isEmpty())
+                {
+                    return -4; /* Wrong option value */
+                }
+
+                setIndexPath(_appArguments->at(argNum + 1));
+                _appArguments->removeAt(argNum + 1);
+                break;
+            case TDIR_OPT_WHERE:
+            {
+                FilePredicate predicate;
+                if(argNum + 1 >= _appArguments->count() || !predicate.compile(_appArguments->at(argNum + 1)))
+                {
+                    return -4; /* Wrong option value */
+                }
+
+                setPredicate(_appArguments->at(argNum + 1));
+                _appArguments->removeAt(argNum + 1);
+                break;
+            }
+            case TDIR_OPT_INCLUDE:
+            case TDIR_OPT_EXCLUDE:
+                if(argNum + 1 >= _appArguments->count() || _appArguments->at(argNum + 1).isEmpty())
+                {
+                    return -4; /* Wrong option value */
+                }
+
+                if(optionId == TDIR_OPT_INCLUDE)
+                {
+                    addIncludeMask(_appArguments->at(argNum + 1));
+                }
+                else
+                {
+                    addExcludeMask(_appArguments->at(argNum + 1));
+                }
+                _appArguments->removeAt(argNum + 1);
+                break;
+            case TDIR_OPT_IO_URING:
+            {
+                bool valueOk = false;
+                int depth = (argNum + 1 < _appArguments->count()) ?
+                             _appArguments->at(argNum + 1).toInt(&valueOk) : -1;
+
+                if(!valueOk || depth < 0)
+                {
+                    return -4; /* Wrong option value */
+                }
+
+                setStatBatchDepth(depth);
+                _appArguments->removeAt(argNum + 1);
+                break;
+            }
+        }
+
+        _appArguments->removeAt(argNum);
+        ret++;
+    }
+
+    /* Binary records have no place for directory totals & duplicate groups */
+    if((_summarize || _dupes) && _format == RecordSink::FORMAT_BINARY)
+    {
+        return -4;
+    }
+
+    return ret;
+}
+
+/*!
+ * \brief FileEnumerator::_takeRoots
+ * \return 1 if several start directories or a root list were taken, 0 for a single path or mask,
+ *         -1 if an option is mixed with directories, -4 if the root list can't be read,
+ *         -5 if several directories are set for a single tree mode
+ *
+ * Takes start directories out of the argument list, only "-r" may follow them.
+ * Directories which can't be listed are reported to stderr & counted failed.
+ */
+int FileEnumerator::_takeRoots()
+{
+    if(_appArguments == nullptr)
+    {
+        return -1;
+    }
+
+    QStringList roots;
+    bool recursive = false;
+    for(int argNum = 1; argNum < _appArguments->count(); argNum++)
+    {
+        const QString &argument = _appArguments->at(argNum);
+        if(argument == "-r" && argNum == _appArguments->count() - 1)
+        {
+            recursive = true;
+        }
+        else
+        {
+            roots.append(argument);
+        }
+    }
+
+    /* A single path or mask keeps its positional meaning */
+    if(_rootListPath.isEmpty() && roots.count() < 2)
+    {
+        return 0;
+    }
+
+    /* Two arguments with -h or -r are the positional forms like "<dir> -h" */
+    if(_rootListPath.isEmpty() && _appArguments->count() == 3 &&
+       (roots.contains("-h") || roots.contains("-r")))
+    {
+        return 0;
+    }
+
+    foreach (const QString &root, roots) {
+        if(_knownOptions.contains(root))
+        {
+            return -1; /* Wrong option position */
+        }
+    }
+
+    if(!_rootListPath.isEmpty() && !_readRootList(roots))
+    {
+        return -4; /* Wrong option value */
+    }
+
+    /* Totals, snapshots & indexes describe one tree */
+    if(roots.count() > 1 && (_summarize || !_snapshotPath.isEmpty() || !_nameIndexPath.isEmpty() ||
+                             !_indexPath.isEmpty() || _watchMode))
+    {
+        return -5;
+    }
+
+    QTextStream err(stderr);
+    QStringList rootPaths;
+    foreach (const QString &root, roots) {
+        QFileInfo rootInfo(root);
+        if(!rootInfo.isDir() || !rootInfo.isReadable() || !rootInfo.isExecutable())
+        {
+            err << "tdir: " << root << ": can't be listed" << endl;
+            _failedRoots++;
+            continue;
+        }
+        rootPaths.append(QDir(root).absolutePath());
+    }
+
+    setRoots(rootPaths);
+    if(recursive)
+    {
+        setRecursiveMode(true);
+    }
+    return 1;
+}
+
+/*!
+ * \brief FileEnumerator::_readRootList
+ * \param[in,out] roots Start directories to append the read ones to
+ * \return "false" if the root list can't be read
+ *
+ * Reads a path per line, empty lines are skipped.
+ */
+bool FileEnumerator::_readRootList(QStringList &roots) const
+{
+    QFile file(_rootListPath);
+    bool opened = (_rootListPath == "-") ? file.open(stdin, QIODevice::ReadOnly) :
+                                           file.open(QIODevice::ReadOnly);
+    if(!opened)
+    {
+        return false;
+    }
+
+    foreach (QByteArray line, file.readAll().split('\n')) {
+        if(line.endsWith('\r'))
+        {
+            line.chop(1);
+        }
+        if(!line.isEmpty())
+        {
+            roots.append(QFile::decodeName(line));
+        }
+    }
+    return true;
+}
+
+/*!
+ * \brief FileEnumerator::_rootPaths
+ * \return Absolute start directories, the current one if several were not set
+ */
+QStringList FileEnumerator::_rootPaths() const
+{
+    if(!_roots.isEmpty())
+    {
+        return _roots;
+    }
+    return QStringList() << QDir(*_currentDir).absolutePath();
+}
+
+/*!
+ * \brief FileEnumerator::run
+ *
+ * Class main working function
+ */
+void FileEnumerator::run()
+{
+    /* Check for application call arguments set by setArguments() */
+    if(_appArguments == nullptr)
+    {
+#ifdef __TDIR_DEBUG__
+        qWarning() << "Can't get application call arguments!";
+#endif
+        _exitCode = TDIR_APPLICATION_ERROR;
+        _exit();
+        return;
+    }
+
+    if(_appArguments->isEmpty())
+    {
+#ifdef __TDIR_DEBUG__
+        qWarning() << "Empty argument list!";
+#endif
+        _exitCode = TDIR_APPLICATION_ERROR;
+        _exit();
+        return;
+    }
+
+    /* Take options which are not bound to positions out of the argument list */
+    int extendedOptions = _takeExtendedOptions();
+
+    if(extendedOptions < 0)
+    {
+        switch (extendedOptions)
+        {
+            case -3:
+#ifdef __TDIR_DEBUG__
+                qWarning() << "Option duplication was found!";
+#endif
+                _exitCode = TDIR_ARG_ERR_OPTION_DUPLICATION;
+                _exit();
+            return;
+            case -4:
+#ifdef __TDIR_DEBUG__
+                qWarning() << "Wrong option value was found!";
+#endif
+                _exitCode = TDIR_ARG_ERR_WRONG_VALUE;
+                _exit();
+            return;
+            default:
+#ifdef __TDIR_DEBUG__
+                qWarning() << "Error getting arguments!";
+#endif
+                _exitCode = TDIR_APPLICATION_ERROR;
+                _exit();
+            return;
+        }
+    }
+
+    /* Snapshots are compared instead of listing files */
+    if(!_diffPaths.isEmpty())
+    {
+        _exitCode = _diffSnapshots() ? TDIR_APPLICATION_NO_ERROR : TDIR_SNAPSHOT_ERROR;
+        _exit();
+        return;
+    }
+
+    /* Files are found in the name index instead of directories */
+    if(!_queryIndexPath.isEmpty())
+    {
+        _exitCode = _queryNameIndex() ? TDIR_APPLICATION_NO_ERROR : TDIR_NAME_INDEX_ERROR;
+        _exit();
+        return;
+    }
+
+    /* Several start directories are listed together */
+    int roots = _takeRoots();
+
+    if(roots < 0)
+    {
+        switch (roots)
+        {
+            case -4:
+#ifdef __TDIR_DEBUG__
+                qWarning() << "Can't read the start directory list!";
+#endif
+                _exitCode = TDIR_ARG_ERR_WRONG_VALUE;
+                _exit();
+            return;
+            case -5:
+#ifdef __TDIR_DEBUG__
+                qWarning() << "Several start directories for a single tree mode!";
+#endif
+                _exitCode = TDIR_ARG_ERR_ROOTS_MODE;
+                _exit();
+            return;
+            default:
+#ifdef __TDIR_DEBUG__
+                qWarning() << "Wrong option position!";
+#endif
+                _exitCode = TDIR_ARG_ERR_WRONG_OPTION_POS;
+                _exit();
+            return;
+        }
+    }
+
+    if(roots > 0)
+    {
+        _exitCode = _roots.isEmpty() ? TDIR_APPLICATION_NO_ERROR : listFiles();
+        if(_exitCode == TDIR_APPLICATION_NO_ERROR && _failedRoots > 0)
+        {
+            _exitCode = TDIR_ROOT_ERROR;
+        }
+        _exit();
+        return;
+    }
+
+    /* Application was launched without arguments */
+    if(_appArguments->count() == 1)
+    {
+        /* Calling file enumerator method with default settings (from current dir) */
+        _exitCode = listFiles();
+        _exit();
+        return;
+    }
+
+    /* Find recursive option & it's position & duplication */
+     int options = _findOptions();
+
+     /* Exiting with right code on error */
+     if(options < 0)
+     {
+        switch (options)
+        {
+            case -1:
+#ifdef __TDIR_DEBUG__
+                qWarning() << "Error getting arguments!";
+#endif
+                _exitCode = TDIR_APPLICATION_ERROR;
+                _exit();
+            return;
+            case -2:
+#ifdef __TDIR_DEBUG__
+                qWarning() << "Unknown option was found!";
+#endif
+                _exitCode = TDIR_OPT_UNKNOWN;
+                _exit();
+            return;
+        case -3:
+#ifdef __TDIR_DEBUG__
+                qWarning() << "Option duplication was found!";
+#endif
+                _exitCode = TDIR_ARG_ERR_OPTION_DUPLICATION;
+                _exit();
+            return;
+        default:
+#ifdef __TDIR_DEBUG__
+                qWarning() << "Unknown error during options parcing has happened!";
+#endif
+                _exitCode = TDIR_ARG_UNKNOWN_ERROR;
+                _exit();
+            return;
+        }
+     }
+
+     /* If application was called with one argument */
+     if(_appArguments->count() == 2)
+     {
+         if(options > 0)
+         {
+             /* Check if option is recursive mode */
+             if(_options.values().contains("-r"))
+             {
+                 /* Go recursively from current path */
+                 setRecursiveMode(true);
+                 _exitCode = listFiles();
+                 _exit();
+                 return;
+             }
+             /* Check if option is help */
+             else if(_options.values().contains("-h"))
+             {
+                 viewHelp();
+                 _exitCode = TDIR_APPLICATION_NO_ERROR;
+                 _exit();
+                 return;
+             }
+         }
+         /* Check if it is a valid path */
+         else
+         {
+             QDir dir(_appArguments->at(1));
+
+             /* Check if it is a valid directory name */
+             if(dir.exists())
+             {
+                 qDebug() << "Directory exists! Setting it to default one!";
+                 setCurrentDir(dir.absolutePath());
+                 _exitCode = listFiles();
+                 _exit();
+                 return;
+             }
+             /* Check if mask was applied */
+             else
+             {
+                 /* Check if it is a mask here */
+                 setMask(_appArguments->at(1));
+                 _exitCode = listFiles();
+                 _exit();
+                 return;
+             }
+         }
+     }
+
+     /* If application was called with one argument */
+     if(_appArguments->count() == 3)
+     {
+         if(options > 0)
+         {
+             /* Check if option is recursive mode */
+             if(_options.values().contains("-r"))
+             {
+                 if(!(_options.key("-r") == 2))
+                 {
+                     qDebug() << "Wrong option position!";
+                     _exitCode = TDIR_ARG_ERR_WRONG_OPTION_POS;
+                     _exit();
+                     return;
+                 }
+                 else
+                 {
+                     setRecursiveMode(true);
+
+                     QDir dir(_appArguments->at(1));
+
+                     /* Check if it is a valid directory name */
+                     if(dir.exists())
+                     {
+                         qDebug() << "Directory exists! Setting it to default one!";
+                         setCurrentDir(dir.absolutePath());
+                         _exitCode = listFiles();
+                         _exit();
+                         return;
+                     }
+                     /* Check if help option is the first */
+                     else if((_options.key("-h") == 1))
+                     {
+                         qDebug() << "Wrong option position!";
+                         _exitCode = TDIR_ARG_ERR_WRONG_OPTION_POS;
+                         _exit();
+                         return;
+                     }
+                     else
+                     {
+                         /* Check if it is a mask here */
+                         setMask(_appArguments->at(1));
+                         _exitCode = listFiles();
+                         _exit();
+                         return;
+                     }
+                 }
+             }
+             /* Check if option is help */
+             else if(_options.values().contains("-h"))
+             {
+                 if(!(_options.key("-h") == 2))
+                 {
+                     qDebug() << "Wrong option position!";
+                     _exitCode = TDIR_ARG_ERR_WRONG_OPTION_POS;
+                     _exit();
+                     return;
+                 }
+                 else
+                 {
+                    viewHelp();
+                    _exitCode = TDIR_APPLICATION_NO_ERROR;
+                    _exit();
+                    return;
+                 }
+             }
+             else
+             {
+                 _exitCode = TDIR_ARG_ERR_UNKNOWN_OPTION;
+                 _exit();
+                 return;
+             }
+         }
+         else
+         {
+             _exitCode = TDIR_ARG_ERR_WRONG_OPTION_POS;
+             _exit();
+             return;
+         }
+     }
+
+     /* If application was called with too many arguments (>3) */
+     if(_appArguments->count() > 3)
+     {
+        _exitCode = TDIR_ARG_ERR_TOO_MANY;
+        _exit();
+        return;
+     }
+
+    _exit();
+}
+
+/*!
+ * \brief FileEnumerator::setArguments
+ * \param[in] arguments Application call arguments, the first one is the program name
+ *
+ * Arguments are parsed by run().
+ */
+void FileEnumerator::setArguments(const QStringList &arguments)
+{
+    if(_appArguments) delete _appArguments;
+    _appArguments = new QStringList(arguments);
+}
+
+/*!
+ * \brief FileEnumerator::setCurrentDir
+ * \param dirPath
+ *
+ * Method function sets current (start) directory to start file enumeration
+ */
+void FileEnumerator::setCurrentDir(const QString &dirPath)
+{
+    if(_currentDir == nullptr)
+    {
+        _currentDir = new QString(dirPath);
+    }
+    else
+    {
+        _currentDir->clear();
+        _currentDir->append(dirPath);
+    }
+}
+
+/*!
+ * \brief FileEnumerator::setMask
+ * \param[in] mask File mask
+ *
+ * This method stores a mask to a private variable
+ */
+void FileEnumerator::setMask(const QString mask)
+{
+    if(_mask == nullptr)
+    {
+        _mask = new QStringList();
+        _mask->append(mask);
+    }
+    else
+    {
+        _mask->clear();
+        _mask->append(mask);
+    }
+}
+
+/*!
+ * \brief FileEnumerator::addIncludeMask
+ * \param[in] mask A file mask to include
+ *
+ * This method adds a mask files are listed by besides the stored mask
+ */
+void FileEnumerator::addIncludeMask(const QString &mask)
+{
+    _includeMasks.append(mask);
+}
+
+/*!
+ * \brief FileEnumerator::setPredicate
+ * \param[in] expression A file predicate expression (see filepredicate.h), an empty one removes it
+ *
+ * This method sets a stored file predicate expression, it is compiled when files are listed
+ */
+void FileEnumerator::setPredicate(const QString &expression)
+{
+    _predicate = expression;
+}
+
+/*!
+ * \brief FileEnumerator::addExcludeMask
+ * \param[in] mask A file mask to exclude
+ *
+ * This method adds a mask of files not to list
+ */
+void FileEnumerator::addExcludeMask(const QString &mask)
+{
+    _excludeMasks.append(mask);
+}
+
+/*!
+ * \brief FileEnumerator::setOneFileSystem
+ * \param[in] oneFileSystem Set to "true" not to enter directories on other file systems
+ *
+ * This method sets a stored file system boundary flag
+ */
+void FileEnumerator::setOneFileSystem(const bool oneFileSystem)
+{
+    _oneFileSystem = oneFileSystem;
+}
+
+/*!
+ * \brief FileEnumerator::addSkippedTypes
+ * \param[in] types Comma separated file system type masks
+ *
+ * This method adds file system types not to enter
+ */
+void FileEnumerator::addSkippedTypes(const QString &types)
+{
+    foreach (const QString &type, types.split(QChar(','), QString::SkipEmptyParts)) {
+        _skippedTypes.append(type.trimmed());
+    }
+}
+
+/*!
+ * \brief FileEnumerator::setLinksOnce
+ * \param[in] linksOnce Set to "true" to list a file with several hard links once
+ *
+ * This method sets a stored hard link flag
+ */
+void FileEnumerator::setLinksOnce(const bool linksOnce)
+{
+    _linksOnce = linksOnce;
+}
+
+/*!
+ * \brief FileEnumerator::exitCode
+ * \return The exit code of the last run()
+ */
+int FileEnumerator::exitCode() const
+{
+    return _exitCode;
+}
+
+/*!
+ * \brief FileEnumerator::setRoots
+ * \param[in] roots Absolute start directories to list together
+ *
+ * This method sets stored start directories, a single one becomes the current dir
+ */
+void FileEnumerator::setRoots(const QStringList &roots)
+{
+    _roots = roots;
+    if(roots.count() == 1)
+    {
+        setCurrentDir(roots.first());
+    }
+}
+
+/*!
+ * \brief FileEnumerator::setRootListPath
+ * \param[in] rootListPath A file to read start directories from, "-" for stdin
+ *
+ * This method sets a stored start directory list path
+ */
+void FileEnumerator::setRootListPath(const QString &rootListPath)
+{
+    _rootListPath = rootListPath;
+}
+
+/*!
+ * \brief FileEnumerator::setRecursiveMode
+ * \param[in] recursiveMode Set to "true" to use recursive file enumeration
+ *
+ * This method sets a stored recursive flag
+ */
+void FileEnumerator::setRecursiveMode(const bool recursiveMode)
+{
+    _runRecursively = recursiveMode;
+}
+
+/*!
+ * \brief FileEnumerator::setJobs
+ * \param[in] jobs Number of threads to scan directories on in recursive mode
+ *
+ * This method sets a stored number of parallel traversal jobs
+ */
+void FileEnumerator::setJobs(const int jobs)
+{
+    _jobs = (jobs > 0) ? jobs : 1;
+}
+
+/*!
+ * \brief FileEnumerator::setInodeOrder
+ * \param[in] inodeOrder Set to "true" to stat files & enter subdirectories in inode order
+ *
+ * This method sets a stored inode order flag
+ */
+void FileEnumerator::setInodeOrder(const bool inodeOrder)
+{
+    _inodeOrder = inodeOrder;
+}
+
+/*!
+ * \brief FileEnumerator::setStatBatchDepth
+ * \param[in] depth io_uring queue depth to stat files with, 0 to stat them one by one
+ *
+ * This method sets a stored stat batch depth
+ */
+void FileEnumerator::setStatBatchDepth(const int depth)
+{
+    _statBatchDepth = (depth > 0) ? depth : 0;
+}
+
+/*!
+ * \brief FileEnumerator::setDeviceJobs
+ * \param[in] deviceJobs Maximal number of directories scanned at once on one device, 0 for no limit
+ *
+ * This method sets a stored per-device limit of parallel traversal jobs
+ */
+void FileEnumerator::setDeviceJobs(const int deviceJobs)
+{
+    _deviceJobs = (deviceJobs > 0) ? deviceJobs : 0;
+}
+
+/*!
+ * \brief FileEnumerator::setMaxDepth
+ * \param[in] maxDepth Maximal subdirectory depth in recursive mode, unlimited if it is negative
+ *
+ * This method sets a stored maximal recursion depth
+ */
+void FileEnumerator::setMaxDepth(const int maxDepth)
+{
+    _maxDepth = maxDepth;
+}
+
+/*!
+ * \brief FileEnumerator::setSummarizeMode
+ * \param[in] summarizeMode Set to "true" to show directory size totals instead of files
+ *
+ * This method sets a stored summarize mode flag. Totals always include
+ * subdirectories, so the recursive mode is set too.
+ */
+void FileEnumerator::setSummarizeMode(const bool summarizeMode)
+{
+    _summarize = summarizeMode;
+    if(summarizeMode)
+    {
+        _runRecursively = true;
+    }
+}
+
+/*!
+ * \brief FileEnumerator::setSummaryDepth
+ * \param[in] summaryDepth Maximal depth of shown directory totals, the start directory depth is 0
+ *
+ * This method sets a stored summary depth
+ */
+void FileEnumerator::setSummaryDepth(const int summaryDepth)
+{
+    _summaryDepth = summaryDepth;
+}
+
+/*!
+ * \brief FileEnumerator::setDupesMode
+ * \param[in] dupesMode Set to "true" to show duplicate file groups instead of files
+ *
+ * This method sets a stored dupes mode flag
+ */
+void FileEnumerator::setDupesMode(const bool dupesMode)
+{
+    _dupes = dupesMode;
+}
+
+/*!
+ * \brief FileEnumerator::setTopCount
+ * \param[in] topCount Number of first files to show in the sort order, 0 to show all files
+ *
+ * This method sets a stored top file count
+ */
+void FileEnumerator::setTopCount(const int topCount)
+{
+    _topCount = (topCount > 0) ? topCount : 0;
+}
+
+/*!
+ * \brief FileEnumerator::setSortMode
+ * \param[in] sortMode Set to "true" to show all files in the sort order
+ *
+ * This method sets a stored sort mode flag
+ */
+void FileEnumerator::setSortMode(const bool sortMode)
+{
+    _sortMode = sortMode;
+}
+
+/*!
+ * \brief FileEnumerator::setSortField
+ * \param[in] sortField A field to sort files by
+ *
+ * This method sets a stored sort field
+ */
+void FileEnumerator::setSortField(const SortField sortField)
+{
+    _sortBy = sortField;
+}
+
+/*!
+ * \brief FileEnumerator::setSnapshotPath
+ * \param[in] snapshotPath A snapshot file path to write files to or an empty string to list them
+ *
+ * This method sets a stored snapshot file path
+ */
+void FileEnumerator::setSnapshotPath(const QString &snapshotPath)
+{
+    _snapshotPath = snapshotPath;
+}
+
+/*!
+ * \brief FileEnumerator::setDiffPaths
+ * \param[in] oldPath An old snapshot file path
+ * \param[in] newPath A new snapshot file path
+ *
+ * This method sets stored snapshot file paths to compare by run()
+ */
+void FileEnumerator::setDiffPaths(const QString &oldPath, const QString &newPath)
+{
+    _diffPaths = QStringList() << oldPath << newPath;
+}
+
+/*!
+ * \brief FileEnumerator::setNameIndexPath
+ * \param[in] nameIndexPath A name index file path to write files to or an empty string to list them
+ *
+ * This method sets a stored name index file path
+ */
+void FileEnumerator::setNameIndexPath(const QString &nameIndexPath)
+{
+    _nameIndexPath = nameIndexPath;
+}
+
+/*!
+ * \brief FileEnumerator::setQuery
+ * \param[in] indexPath A name index file path
+ * \param[in] mask A file mask to find
+ *
+ * This method sets a stored name index query run by run()
+ */
+void FileEnumerator::setQuery(const QString &indexPath, const QString &mask)
+{
+    _queryIndexPath = indexPath;
+    _queryMask = mask;
+}
+
+/*!
+ * \brief FileEnumerator::setStatsMode
+ * \param[in] statsMode Set to "true" to write scan statistics to stderr
+ *
+ * This method sets a stored statistics flag
+ */
+void FileEnumerator::setStatsMode(const bool statsMode)
+{
+    _stats = statsMode;
+}
+
+/*!
+ * \brief FileEnumerator::setProgressInterval
+ * \param[in] seconds Seconds between progress lines written to stderr, 0 to disable them
+ *
+ * This method sets a stored progress interval
+ */
+void FileEnumerator::setProgressInterval(const int seconds)
+{
+    _progressInterval = (seconds > 0) ? seconds : 0;
+}
+
+/*!
+ * \brief FileEnumerator::setOutputFormat
+ * \param[in] format An output format
+ *
+ * This method sets a stored output format
+ */
+void FileEnumerator::setOutputFormat(const RecordSink::Format format)
+{
+    _format = format;
+}
+
+/*!
+ * \brief FileEnumerator::setUnorderedMode
+ * \param[in] unorderedMode Set to "true" to write directories as soon as they are scanned
+ *
+ * This method sets a stored parallel traversal output order flag
+ */
+void FileEnumerator::setUnorderedMode(const bool unorderedMode)
+{
+    _unordered = unorderedMode;
+}
+
+/*!
+ * \brief FileEnumerator::setLineBuffered
+ * \param[in] lineBuffered Set to "true" to write file information as soon as a directory is read
+ *
+ * This method sets the output writer buffering mode
+ */
+void FileEnumerator::setLineBuffered(const bool lineBuffered)
+{
+    _writer->setLineBuffered(lineBuffered);
+}
+
+/*!
+ * \brief FileEnumerator::setPipelineMode
+ * \param[in] pipelineMode Set to "true" to format & write streamed files on their own thread
+ *
+ * This method sets a stored pipeline mode flag, the pipeline is not used
+ * for terminals & line buffered output anyway
+ */
+void FileEnumerator::setPipelineMode(const bool pipelineMode)
+{
+    _pipelined = pipelineMode;
+}
+
+/*!
+ * \brief FileEnumerator::setIndexPath
+ * \param[in] indexPath A tree index file path or an empty string not to use the index
+ *
+ * This method sets a stored tree index file path
+ */
+void FileEnumerator::setIndexPath(const QString &indexPath)
+{
+    _indexPath = indexPath;
+}
+
+/*!
+ * \brief FileEnumerator::setWatchMode
+ * \param[in] watchMode Set to "true" to report changed files after enumeration
+ *
+ * This method sets a stored watch mode flag
+ */
+void FileEnumerator::setWatchMode(const bool watchMode)
+{
+    _watchMode = watchMode;
+}
+
+/*!
+ * \brief FileEnumerator::_writeChange
+ * \param[in] change A change type: '+' (created), '*' (modified) or '-' (deleted)
+ * \param[in] dirPath An absolute directory path
+ * \param[in] entry A changed file
+ *
+ * Writes a changed file information in watch mode.
+ */
+void FileEnumerator::_writeChange(char change, const QString &dirPath, const DirEntry &entry)
+{
+    QString prefix = dirPath.endsWith(QChar('/')) ? dirPath : dirPath + QChar('/');
+
+    QByteArray line;
+    _appendLine(line, _rawNames ? _encode(prefix) + entry.name : _encode(prefix + QFile::decodeName(entry.name)),
+                entry, change);
+    _writer->write(line);
+}
+
+/*!
+ * \brief FileEnumerator::_flushOutput
+ *
+ * Writes reported changes out.
+ */
+void FileEnumerator::_flushOutput()
+{
+    _writer->flush();
+}
+
+/*!
+ * \brief FileEnumerator::listFiles
+ * \param[in] file A file to show info for
+ *
+ * A public class method to view info for a 1 file only.
+ * Gives an interface for a private method.
+ */
+void FileEnumerator::listFiles(const QFile &file)
+{
+    _listFiles(file);
+}
+
+/*!
+ * \brief FileEnumerator::_listFiles
+ * \param[in] file A file to show info for
+ *
+ * A private class method to view info for a 1 file only
+ */
+void FileEnumerator::_listFiles(const QFile &file)
+{
+    _startOutput();
+
+    QFileInfo fileInfo(file);
+    DirEntry entry;
+    if(!DirReader::readEntry(fileInfo.absolutePath(), QFile::encodeName(fileInfo.fileName()), entry) || entry.isDir)
+    {
+        entry.size = fileInfo.size();
+        entry.mtime = fileInfo.lastModified().toMSecsSinceEpoch();
+        entry.mtimeNsec = 0;
+        entry.mode = 0;
+        entry.inode = 0;
+    }
+
+    QByteArray line;
+    _appendLine(line, _encode(file.fileName()), entry);
+    _writer->write(line);
+    _writer->flush();
+}
+
+/*!
+ * \brief FileEnumerator::_encode
+ * \param[in] text A text to encode
+ * \return The text encoded with the output codec
+ */
+QByteArray FileEnumerator::_encode(const QString &text) const
+{
+    return _utf8Output ? text.toUtf8() : _codec->fromUnicode(text);
+}
+
+/*!
+ * \brief FileEnumerator::_setupCodec
+ *
+ * Looks the output codec up & creates the help stream on the first output,
+ * so runs which fail on arguments before it don't pay for them.
+ */
+void FileEnumerator::_setupCodec()
+{
+    if(_codec)
+    {
+        return;
+    }
+
+    _codec = QTextCodec::codecForName(codecName);
+    _out = new QTextStream(stdout);
+    _out->setCodec(_codec);
+    _utf8Output = (_codec->mibEnum() == 106);                   /*!< UTF-8 MIB enum */
+    _rawNames = _utf8Output && (QTextCodec::codecForLocale()->mibEnum() == 106);
+}
+
+/*!
+ * \brief FileEnumerator::_startOutput
+ *
+ * Creates the output sink & writes its header. Paths are always
+ * UTF-8 in machine-readable formats whatever the terminal codec is.
+ */
+void FileEnumerator::_startOutput()
+{
+    if(_sink)
+    {
+        return;
+    }
+
+    _setupCodec();
+
+    if(_format != RecordSink::FORMAT_TEXT)
+    {
+        _utf8Output = true;
+        _rawNames = (QTextCodec::codecForLocale()->mibEnum() == 106);   /*!< UTF-8 MIB enum */
+    }
+
+    _sink = RecordSink::create(_format, file_modification_time_format, _codec);
+    _writer->write(_sink->header());
+}
+
+/*!
+ * \brief FileEnumerator::_appendLine
+ * \param[out] out A buffer to append the record to
+ * \param[in] path An encoded file path
+ * \param[in] entry The file
+ * \param[in] change A change type in watch mode or 0
+ *
+ * Formats file information with the output sink.
+ */
+void FileEnumerator::_appendLine(QByteArray &out, const QByteArray &path, const DirEntry &entry, char change) const
+{
+    _sink->append(out, path, entry, change);
+}
+
+
+/*!
+ * \brief FileEnumerator::_readDir
+ * \param[in] dirPath An absolute dir path
+ * \param[out] entries Matching files & subdirectories in recursive mode
+ *
+ * Private one directory reading method function. If the index is used,
+ * unchanged directories are taken from it & read ones are stored to it.
+ * It is called from parallel traversal threads, so it must not change the object.
+ */
+void FileEnumerator::_readDir(const QString &dirPath, QVector<DirEntry> &entries) const
+{
+    qint64 mtime = 0;
+    qint64 ctime = 0;
+
+    /* Pruned directories are neither read nor watched */
+    quint64 device = 0;
+    if(_guard && !_guard->enter(dirPath, device))
+    {
+        return;
+    }
+
+    /* A directory is watched before it is read not to miss changes */
+    if(_watcher)
+    {
+        _watcher->watch(dirPath);
+    }
+
+    /* The directory times are taken before reading not to miss changes made meanwhile */
+    if(_index && DirReader::statDir(dirPath, mtime, ctime))
+    {
+        /* The index keeps files matching the masks, ages of the predicate change between runs */
+        const GlobMatcher &matcher = _nameMatcher ? *_nameMatcher : *_matcher;
+        if(!_index->lookup(dirPath, mtime, ctime, entries) &&
+           DirReader::read(dirPath, matcher, _runRecursively, entries))
+        {
+            _index->store(dirPath, mtime, ctime, entries);
+        }
+
+        if(_matcher->predicate())
+        {
+            _matcher->predicate()->filter(entries);
+        }
+    }
+    else
+    {
+        DirReader::read(dirPath, *_matcher, _runRecursively, entries);
+    }
+
+    if(_watcher)
+    {
+        _watcher->setSnapshot(dirPath, entries);
+    }
+
+    /* The index & the watcher keep all hard links, only the listed ones are dropped */
+    if(_guard)
+    {
+        _guard->filterFiles(device, entries);
+    }
+}
+
+/*!
+ * \brief FileEnumerator::_appendFiles
+ * \param[out] out A buffer to append encoded file information to
+ * \param[in] prefix A directory path ending with a separator
+ * \param[in] entries Directory entries, subdirectories are skipped
+ *
+ * Formats file information according to format:
+ * path/file_name file_size file_modification_time
+ */
+void FileEnumerator::_appendFiles(QByteArray &out, const QString &prefix, const QVector<DirEntry> &entries) const
+{
+    ScanStats::PhaseTimer timer(ScanStats::PHASE_FORMAT);
+
+    /* Building an encoded path prefix once for all entries */
+    QByteArray encodedPrefix = _encode(prefix);
+
+    /* Paths are rendered into one reserved buffer */
+    QByteArray path;
+    path.reserve(encodedPrefix.size() + 256);
+
+    foreach (const DirEntry &entry, entries) {
+        if(entry.isDir)
+        {
+            continue;
+        }
+
+        /* Raw names are written as is if both file system & output are UTF-8 */
+        if(_rawNames)
+        {
+            path.resize(0);
+            path.append(encodedPrefix);
+            path.append(entry.name);
+            _appendLine(out, path, entry);
+        }
+        else
+        {
+            _appendLine(out, _encode(prefix + QFile::decodeName(entry.name)), entry);
+        }
+    }
+}
+
+/*!
+ * \brief FileEnumerator::_listDir
+ * \param[in] dir A dir to enumerate files in
+ * \param[in] depth The dir depth, the root depth is 0
+ * \param[out] out A buffer to append encoded file information to
+ * \return Absolute paths of subdirectories to enumerate in recursive mode or an empty list
+ *
+ * Private one directory enumeration method function.
+ * It is called from parallel traversal threads, so it must not change the object.
+ */
+QStringList FileEnumerator::_listDir(const QDir &dir, int depth, QByteArray &out) const
+{
+    QVector<DirEntry> entries;
+    QStringList subdirList;
+
+    _readDir(dir.absolutePath(), entries);
+
+    QString prefix = dir.absolutePath();
+    if(!prefix.endsWith(QChar('/')))
+    {
+        prefix.append(QChar('/'));
+    }
+
+    _appendFiles(out, prefix, entries);
+
+    return _subdirList(prefix, depth, entries);
+}
+
+/*!
+ * \brief FileEnumerator::_subdirList
+ * \param[in] prefix A directory path ending with a separator
+ * \param[in] depth The directory depth, the root depth is 0
+ * \param[in] entries Directory entries
+ * \return Absolute paths of subdirectories to enter
+ */
+QStringList FileEnumerator::_subdirList(const QString &prefix, int depth, const QVector<DirEntry> &entries) const
+{
+    QStringList subdirList;
+
+    /* Subdirectories deeper than the maximal depth are not entered */
+    if(_maxDepth >= 0 && depth >= _maxDepth)
+    {
+        return subdirList;
+    }
+
+    /* Subdirectories may be entered in inode order per chunk as the streaming walk does, files keep the name order */
+    if(_inodeOrder)
+    {
+        QVector<DirEntry> subdirs;
+        foreach (const DirEntry &entry, entries) {
+            if(entry.isDir)
+            {
+                subdirs.append(entry);
+            }
+        }
+
+        for(int first = 0; first < subdirs.count(); first += DirStream::subdir_chunk_size)
+        {
+            QVector<DirEntry> chunk = subdirs.mid(first, DirStream::subdir_chunk_size);
+            DirReader::sortByInode(chunk);
+            foreach (const DirEntry &entry, chunk) {
+                subdirList.append(prefix + QFile::decodeName(entry.name));
+            }
+        }
+        return subdirList;
+    }
+
+    foreach (const DirEntry &entry, entries) {
+        if(entry.isDir)
+        {
+            subdirList.append(prefix + QFile::decodeName(entry.name));
+        }
+    }
+
+    return subdirList;
+}
+
+/*!
+ * \brief FileEnumerator::_limitDevices
+ * \param[in,out] pool A pool to limit
+ *
+ * Limits parallel scans per device told by the mount points of the guard,
+ * so a slow mount holds a few workers only.
+ */
+void FileEnumerator::_limitDevices(TraversalPool &pool) const
+{
+    if(_deviceJobs > 0 && _guard)
+    {
+        TreeGuard *guard = _guard;
+        pool.setDeviceLimit(_deviceJobs, [guard](const QString &dirPath) {
+            return guard->deviceOf(dirPath);
+        });
+    }
+}
+
+/*!
+ * \brief FileEnumerator::_sortKey
+ * \param[in] sortBy A field to sort by
+ * \param[in] path An encoded file path
+ * \param[in] entry The file
+ * \return A key comparable as bytes
+ *
+ * Sizes & times are stored big-endian & inverted before the path,
+ * so the largest & the newest files go first & equal ones go by path.
+ */
+QByteArray FileEnumerator::_sortKey(SortField sortBy, const QByteArray &path, const DirEntry &entry) const
+{
+    if(sortBy == SortByName)
+    {
+        return path;
+    }
+
+    quint64 value = quint64(sortBy == SortBySize ? entry.size : entry.mtime) ^ Q_UINT64_C(0x8000000000000000);
+    value = ~value;
+
+    QByteArray key(8, Qt::Uninitialized);
+    for(int byteNum = 7; byteNum >= 0; byteNum--)
+    {
+        key[byteNum] = char(value & 0xFF);
+        value >>= 8;
+    }
+    key.append(path);
+    return key;
+}
+
+/*!
+ * \brief FileEnumerator::_orderFiles
+ *
+ * Scans directories on the traversal pool & writes either the first
+ * files in the sort order (top mode) or all of them sorted (sort mode).
+ * Top mode keeps only the top lines, sort mode spills sorted runs to
+ * temporary files when lines take too much memory.
+ * \return "false" if spilled sorted runs can't be read back
+ */
+bool FileEnumerator::_orderFiles()
+{
+    SortField sortBy = _sortBy;
+    if(sortBy == SortByDefault)
+    {
+        sortBy = (_topCount > 0) ? SortBySize : SortByName;
+    }
+
+    TopCollector top(_topCount);
+    ExternalSorter sorter(sort_memory_budget);
+    QMutex lock;
+
+    TraversalPool pool(_jobs, [&](const QString &dirPath, int depth, QByteArray &output) {
+        Q_UNUSED(output)
+        QVector<DirEntry> entries;
+        _readDir(dirPath, entries);
+
+        QString prefix = dirPath.endsWith(QChar('/')) ? dirPath : dirPath + QChar('/');
+        QByteArray encodedPrefix = _encode(prefix);
+
+        /* Keys are built out of the lock */
+        ScanStats::PhaseTimer timer(ScanStats::PHASE_FORMAT);
+        QVector<QPair<QByteArray, int> > keys;
+        QVector<QByteArray> paths;
+        for(int entryNum = 0; entryNum < entries.count(); entryNum++)
+        {
+            const DirEntry &entry = entries.at(entryNum);
+            if(entry.isDir)
+            {
+                continue;
+            }
+
+            QByteArray path = _rawNames ? encodedPrefix + entry.name : _encode(prefix + QFile::decodeName(entry.name));
+            keys.append(qMakePair(_sortKey(sortBy, path, entry), entryNum));
+            paths.append(path);
+        }
+
+        QMutexLocker locker(&lock);
+        for(int keyNum = 0; keyNum < keys.count(); keyNum++)
+        {
+            const DirEntry &entry = entries.at(keys.at(keyNum).second);
+
+            /* Lines which can't get to the top are not formatted */
+            if(_topCount > 0 && !top.accepts(keys.at(keyNum).first))
+            {
+                continue;
+            }
+
+            QByteArray line;
+            _appendLine(line, paths.at(keyNum), entry);
+
+            if(_topCount > 0)
+            {
+                top.add(keys.at(keyNum).first, line);
+            }
+            else
+            {
+                sorter.add(keys.at(keyNum).first, line);
+            }
+        }
+
+        return _subdirList(prefix, depth, entries);
+    }, false);
+
+    _limitDevices(pool);
+    pool.run(_rootPaths(), *_writer);
+
+    if(_topCount > 0)
+    {
+        top.write(*_writer);
+        return true;
+    }
+    return sorter.write(*_writer);
+}
+
+/*!
+ * \brief FileEnumerator::enterDir
+ * \param[in] dir A directory handle
+ * \param[in] dirPath The directory path
+ * \return "true" to list the directory
+ *
+ * Starts a directory visited by the streaming enumerator.
+ */
+bool FileEnumerator::enterDir(int dir, const QString &dirPath)
+{
+    Q_UNUSED(dir)
+
+    /* Names are decoded & encoded with the prefix only if the output can't take raw names */
+    if(!_rawNames && !_pipeline)
+    {
+        _dirPrefix = dirPath.endsWith(QChar('/')) ? dirPath : dirPath + QChar('/');
+    }
+
+    _chunk.resize(0);
+    return true;
+}
+
+/*!
+ * \brief FileEnumerator::visitFile
+ * \param[in] file A visited file
+ * \return "true" to continue
+ *
+ * Formats a file straight from its record, the path is rendered
+ * into a reused buffer, so nothing is allocated per file. In pipeline
+ * mode the raw path & the record are passed to the pipeline instead.
+ */
+bool FileEnumerator::visitFile(const EntryRecord &file)
+{
+    if(_pipeline)
+    {
+        _enumerator->appendPath(_pipeline->paths(), file);
+        _pipeline->add(file);
+        return true;
+    }
+
+    ScanStats::PhaseTimer timer(ScanStats::PHASE_FORMAT);
+
+    _path.resize(0);
+    if(_rawNames)
+    {
+        _enumerator->appendPath(_path, file);
+    }
+    else
+    {
+        _path.append(_encode(_dirPrefix + QFile::decodeName(QByteArray::fromRawData(file.name, file.nameSize))));
+    }
+
+    _file.size = file.size;
+    _file.mtime = file.mtime;
+    _file.blocks = file.blocks;
+    _file.mtimeNsec = file.mtimeNsec;
+    _file.mode = file.mode;
+    _file.inode = file.inode;
+    _appendLine(_chunk, _path, _file);
+
+    if(_chunk.size() >= output_chunk_size)
+    {
+        _writer->write(_chunk);
+        _chunk.resize(0);
+    }
+    return true;
+}
+
+/*!
+ * \brief FileEnumerator::leaveFiles
+ * \param[in] dir A directory handle
+ *
+ * Writes the rest of the directory output.
+ */
+void FileEnumerator::leaveFiles(int dir)
+{
+    Q_UNUSED(dir)
+
+    /* The pipeline thread owns the writer while it runs */
+    if(!_pipeline)
+    {
+        _writer->write(_chunk);
+        _chunk.resize(0);
+        _writer->endDirectory();
+    }
+}
+
+/*!
+ * \brief FileEnumerator::_writeTotals
+ * \param[in] dirPath A directory path
+ * \param[in] totals The directory tree totals
+ *
+ * Writes directory totals with the output sink.
+ */
+void FileEnumerator::_writeTotals(const QString &dirPath, const Summarizer::Totals &totals)
+{
+    QByteArray line;
+    _sink->appendTotals(line, _encode(dirPath), totals.files, totals.bytes, totals.blocks);
+    _writer->write(line);
+}
+
+/*!
+ * \brief FileEnumerator::_summarizeFiles
+ *
+ * Sums directory trees on the traversal pool & writes totals of directories
+ * up to the summary depth, subdirectories before their parents.
+ */
+void FileEnumerator::_summarizeFiles()
+{
+    QString rootPath = QDir(*_currentDir).absolutePath();
+
+    Summarizer summarizer(_summaryDepth);
+    summarizer.start(rootPath);
+
+    TraversalPool pool(_jobs, [this, &summarizer](const QString &dirPath, int depth, QByteArray &output) {
+        Q_UNUSED(output)
+        QVector<DirEntry> entries;
+        _readDir(dirPath, entries);
+        return summarizer.add(dirPath, entries, _maxDepth < 0 || depth < _maxDepth);
+    }, false);
+
+    _limitDevices(pool);
+    pool.run(rootPath, *_writer);
+
+    summarizer.report([this](const QString &dirPath, int depth, const Summarizer::Totals &totals) {
+        Q_UNUSED(depth)
+        _writeTotals(dirPath, totals);
+    });
+}
+
+/*!
+ * \brief FileEnumerator::_findDupes
+ *
+ * Collects file sizes on the traversal pool, then hashes files of colliding
+ * sizes on all processor cores (or "jobs" threads), compares files of equal
+ * hashes & writes duplicate groups with the largest reclaimable size first.
+ */
+void FileEnumerator::_findDupes()
+{
+    DupeFinder finder(_jobs > 1 ? _jobs : QThread::idealThreadCount());
+
+    TraversalPool pool(_jobs, [this, &finder](const QString &dirPath, int depth, QByteArray &output) {
+        Q_UNUSED(output)
+        QVector<DirEntry> entries;
+        _readDir(dirPath, entries);
+
+        QString prefix = dirPath.endsWith(QChar('/')) ? dirPath : dirPath + QChar('/');
+        finder.add(QFile::encodeName(prefix), entries);
+        return _subdirList(prefix, depth, entries);
+    }, false);
+
+    _limitDevices(pool);
+    pool.run(_rootPaths(), *_writer);
+
+    QVector<DupeFinder::Group> groups = finder.find();
+
+    qint64 files = 0;
+    qint64 bytes = 0;
+    QByteArray out;
+    foreach (const DupeFinder::Group &group, groups) {
+        QVector<QByteArray> paths;
+        foreach (const QByteArray &path, group.paths) {
+            paths.append(_rawNames ? path : _encode(QFile::decodeName(path)));
+        }
+
+        out.resize(0);
+        _sink->appendGroup(out, group.size, group.hash, paths);
+        _writer->write(out);
+
+        files += group.paths.count();
+        bytes += group.size * (group.paths.count() - 1);
+    }
+
+    out.resize(0);
+    _sink->appendGroupTotals(out, groups.count(), files, bytes);
+    _writer->write(out);
+}
+
+/*!
+ * \brief FileEnumerator::_writeSnapshot
+ * \return "false" if the snapshot file can't be written or sorted runs can't be read back
+ *
+ * Scans directories on the traversal pool & writes files to the snapshot file
+ * sorted by raw relative paths. Large lists are sorted in temporary files, so
+ * the file is replaced only when all files have been written.
+ */
+bool FileEnumerator::_writeSnapshot()
+{
+    QString rootPath = QDir(*_currentDir).absolutePath();
+    QString rootPrefix = rootPath.endsWith(QChar('/')) ? rootPath : rootPath + QChar('/');
+
+    ExternalSorter sorter(sort_memory_budget);
+    QMutex lock;
+
+    TraversalPool pool(_jobs, [&](const QString &dirPath, int depth, QByteArray &output) {
+        Q_UNUSED(output)
+        QVector<DirEntry> entries;
+        _readDir(dirPath, entries);
+
+        QString prefix = dirPath.endsWith(QChar('/')) ? dirPath : dirPath + QChar('/');
+        QByteArray relativePrefix = QFile::encodeName(prefix.mid(rootPrefix.size()));
+
+        /* Records are encoded out of the lock */
+        ScanStats::PhaseTimer timer(ScanStats::PHASE_FORMAT);
+        QVector<QPair<QByteArray, QByteArray> > records;
+        foreach (const DirEntry &entry, entries) {
+            if(!entry.isDir)
+            {
+                QByteArray fields;
+                SnapshotWriter::appendFields(fields, entry);
+                records.append(qMakePair(relativePrefix + entry.name, fields));
+            }
+        }
+
+        QMutexLocker locker(&lock);
+        for(int recordNum = 0; recordNum < records.count(); recordNum++)
+        {
+            sorter.add(records.at(recordNum).first, records.at(recordNum).second);
+        }
+
+        return _subdirList(prefix, depth, entries);
+    }, false);
+
+    _limitDevices(pool);
+    pool.run(rootPath, *_writer);
+
+    QSaveFile file(_snapshotPath);
+    if(!file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+
+    OutputWriter out(file.handle());
+    SnapshotWriter snapshot(out);
+    snapshot.writeHeader(QFile::encodeName(rootPath));
+    bool sorted = sorter.read([&snapshot](const QByteArray &path, const QByteArray &fields) {
+        snapshot.add(path, fields);
+    });
+    out.flush();
+
+    if(!sorted || out.hasError())
+    {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+/*!
+ * \brief FileEnumerator::_diffSnapshots
+ * \return "false" if a snapshot file can't be read or it is damaged
+ *
+ * Merges two snapshots sorted by paths & writes files which are only
+ * in the old one ('-'), only in the new one ('+') or which have another
+ * size or modification time ('*'). Records are decoded one by one from
+ * mapped snapshot windows, so memory doesn't grow with snapshot sizes.
+ */
+bool FileEnumerator::_diffSnapshots()
+{
+    SnapshotReader oldSnapshot(_diffPaths.at(0));
+    SnapshotReader newSnapshot(_diffPaths.at(1));
+    if(!oldSnapshot.open())
+    {
+        _reportError(_diffPaths.at(0), oldSnapshot.errorString());
+        return false;
+    }
+    if(!newSnapshot.open())
+    {
+        _reportError(_diffPaths.at(1), newSnapshot.errorString());
+        return false;
+    }
+
+    _startOutput();
+
+    QByteArray oldPath;
+    QByteArray newPath;
+    DirEntry oldEntry;
+    DirEntry newEntry;
+    bool oldFound = oldSnapshot.next(oldPath, oldEntry);
+    bool newFound = newSnapshot.next(newPath, newEntry);
+
+    QByteArray line;
+    while(oldFound || newFound)
+    {
+        line.resize(0);
+
+        /* Paths are compared as bytes in the order they were sorted by */
+        if(!newFound || (oldFound && oldPath < newPath))
+        {
+            _appendLine(line, _rawNames ? oldPath : _encode(QFile::decodeName(oldPath)), oldEntry, '-');
+            oldFound = oldSnapshot.next(oldPath, oldEntry);
+        }
+        else if(!oldFound || newPath < oldPath)
+        {
+            _appendLine(line, _rawNames ? newPath : _encode(QFile::decodeName(newPath)), newEntry, '+');
+            newFound = newSnapshot.next(newPath, newEntry);
+        }
+        else
+        {
+            if(oldEntry.size != newEntry.size || oldEntry.mtime != newEntry.mtime ||
+               oldEntry.mtimeNsec != newEntry.mtimeNsec)
+            {
+                _appendLine(line, _rawNames ? newPath : _encode(QFile::decodeName(newPath)), newEntry, '*');
+            }
+            oldFound = oldSnapshot.next(oldPath, oldEntry);
+            newFound = newSnapshot.next(newPath, newEntry);
+        }
+
+        _writer->write(line);
+    }
+
+    _writer->flush();
+
+    /* A damaged snapshot ends the diff where it is found */
+    if(oldSnapshot.hasError())
+    {
+        _reportError(_diffPaths.at(0), oldSnapshot.errorString());
+    }
+    if(newSnapshot.hasError())
+    {
+        _reportError(_diffPaths.at(1), newSnapshot.errorString());
+    }
+    return !oldSnapshot.hasError() && !newSnapshot.hasError();
+}
+
+/*!
+ * \brief FileEnumerator::_buildNameIndex
+ * \return "false" if the name index file can't be written
+ *
+ * Scans directories on the traversal pool & writes files to the name index.
+ * A directory is added when it is read, so its parent is always added before it.
+ */
+bool FileEnumerator::_buildNameIndex()
+{
+    QString rootPath = QDir(*_currentDir).absolutePath();
+
+    NameIndexBuilder builder;
+    QHash<QString, quint32> parents;    /*!< Parent directory numbers of directories to read */
+    parents.insert(rootPath, NameIndex::no_parent);
+    QMutex lock;
+
+    TraversalPool pool(_jobs, [&](const QString &dirPath, int depth, QByteArray &output) {
+        Q_UNUSED(output)
+
+        /* The directory time is taken before reading not to miss changes made meanwhile */
+        qint64 mtime = 0;
+        qint64 ctime = 0;
+        DirReader::statDir(dirPath, mtime, ctime);
+
+        QVector<DirEntry> entries;
+        _readDir(dirPath, entries);
+
+        QString prefix = dirPath.endsWith(QChar('/')) ? dirPath : dirPath + QChar('/');
+        QStringList subdirList = _subdirList(prefix, depth, entries);
+
+        /* Trigrams are taken in parallel, only records are added under the lock */
+        QVector<quint32> trigrams;
+        NameIndexBuilder::fileTrigrams(entries, trigrams);
+
+        QMutexLocker locker(&lock);
+        quint32 parent = parents.take(dirPath);
+        QString name = (parent == NameIndex::no_parent) ? dirPath : dirPath.mid(dirPath.lastIndexOf(QChar('/')) + 1);
+        quint32 dir = builder.addDir(parent, QFile::encodeName(name), mtime);
+        builder.addFiles(dir, entries, trigrams);
+
+        foreach (const QString &subdirPath, subdirList) {
+            parents.insert(subdirPath, dir);
+        }
+        return subdirList;
+    }, false);
+
+    _limitDevices(pool);
+    pool.run(rootPath, *_writer);
+
+    if(!builder.save(_nameIndexPath))
+    {
+        _reportError(_nameIndexPath, builder.errorString());
+        return false;
+    }
+    return true;
+}
+
+/*!
+ * \brief FileEnumerator::_queryNameIndex
+ * \return "false" if the name index file can't be read or it is damaged
+ *
+ * Writes files of the name index matching the query mask & "-i" masks
+ * but not "-x" ones. Directories are not read, only the start directory
+ * & directories of found files are stated to warn about a stale index.
+ */
+bool FileEnumerator::_queryNameIndex()
+{
+    NameIndex index(_queryIndexPath);
+    if(!index.open())
+    {
+        _reportError(_queryIndexPath, index.errorString());
+        return false;
+    }
+
+    _startOutput();
+
+    QByteArray line;
+    index.query(QStringList(_queryMask) + _includeMasks, _excludeMasks,
+                [this, &line](const QByteArray &path, const DirEntry &entry) {
+        line.resize(0);
+        _appendLine(line, _rawNames ? path : _encode(QFile::decodeName(path)), entry);
+        _writer->write(line);
+    });
+    _writer->flush();
+
+    if(!index.changedDir().isEmpty())
+    {
+        QTextStream err(stderr);
+        err << "tdir: " << QFile::decodeName(index.changedDir())
+            << " has changed since the name index was written, the results may be stale." << endl;
+    }
+    return true;
+}
+
+/*!
+ * \brief FileEnumerator::_listFiles
+ * \param[in] dir A root dir to start enumeration from
+ *
+ * Private file enumeration method function which goes through subdirectories
+ * in recursive mode. Whole directories are read, so it is used with the index
+ * & in watch mode which keep whole directories anyway.
+ */
+void FileEnumerator::_listFiles(const QDir &dir)
+{
+    /* Pending directories with their depths, the next one is on the top */
+    QList<QPair<QString, int> > stack;
+    stack.append(qMakePair(dir.absolutePath(), 0));
+
+    while(!stack.isEmpty())
+    {
+        QPair<QString, int> current = stack.takeLast();
+
+        /* Changes of listed directories are reported meanwhile in watch mode only */
+        if(_watcher)
+        {
+            QCoreApplication::processEvents();  /*!< Processing events not to freeze event loop */
+        }
+
+        /* Reusing one buffer for all directories */
+        _chunk.resize(0);
+        QStringList subdirList = _listDir(QDir(current.first), current.second, _chunk);
+
+        _writer->write(_chunk);
+        _writer->endDirectory();
+
+        /* Pushing in reverse order to list the first subdirectory next */
+        for(int subdirNum = subdirList.count() - 1; subdirNum >= 0; subdirNum--)
+        {
+            stack.append(qMakePair(subdirList.at(subdirNum), current.second + 1));
+        }
+    }
+}
+
+/*!
+ * \brief FileEnumerator::listFiles
+ *
+ * Public method function of enumeration files to be called by a Class user.
+ * \return TDIR_APPLICATION_NO_ERROR or the exit code of a failed snapshot, name index or sort
+ */
+int FileEnumerator::listFiles()
+{
+    int exitCode = TDIR_APPLICATION_NO_ERROR;
+
+    /* Counters are collected for the progress lines too */
+    if(_stats || _progressInterval > 0)
+    {
+        ScanStats::setEnabled(true);
+        ScanStats::startProgress(_progressInterval);
+    }
+
+    _startOutput();
+
+    /* Compiling all masks once for all directories */
+    if(_matcher) delete _matcher;
+    _matcher = new GlobMatcher((_mask ? *_mask : QStringList()) + _includeMasks, _excludeMasks);
+
+    /* The predicate is compiled once, ages are counted from the listing start */
+    if(_nameMatcher) delete _nameMatcher;
+    _nameMatcher = nullptr;
+    if(!_predicate.isEmpty())
+    {
+        QSharedPointer<FilePredicate> predicate(new FilePredicate());
+        if(predicate->compile(_predicate))
+        {
+            _nameMatcher = new GlobMatcher(*_matcher);
+            _matcher->setPredicate(predicate);
+        }
+    }
+
+    /* Loading the index built with the same masks & mode */
+    if(!_indexPath.isEmpty())
+    {
+        QString signature = QString("%1|%2").arg(_matcher->signature())
+                                            .arg(_runRecursively ? 1 : 0);
+        _index = new TreeIndex(_indexPath, signature);
+        _index->load();
+    }
+
+    /* Directories are entered out of cycles & only on the allowed file systems */
+    if(_guard) delete _guard;
+    _guard = new TreeGuard();
+    _guard->setOneFileSystem(_oneFileSystem);
+    _guard->setSkippedTypes(_skippedTypes);
+    _guard->setLinksOnce(_linksOnce);
+    foreach (const QString &rootPath, _rootPaths()) {
+        _guard->addRoot(rootPath);
+    }
+
+    /* Files of a directory chunk are stated in inode order */
+    DirReader::setInodeOrder(_inodeOrder);
+
+    /* Entries are stated one by one where io_uring is not available */
+    int statBatchDepth = _statBatchDepth;
+    if(!DirReader::setStatBatchDepth(statBatchDepth))
+    {
+#ifdef __TDIR_DEBUG__
+        qWarning() << "io_uring statx is not supported!";
+#endif
+        statBatchDepth = 0;
+    }
+
+    /* Listed directories are watched in watch mode */
+    if(_watchMode && DirWatcher::isSupported() && !_watcher)
+    {
+        _watcher = new DirWatcher(*_matcher, _runRecursively,
+                                  [this](char change, const QString &dirPath, const DirEntry &entry) {
+            _writeChange(change, dirPath, entry);
+        }, this);
+        connect(_watcher, &DirWatcher::changesReported, this, &FileEnumerator::_flushOutput);
+    }
+
+    /* Only directory totals are written in summarize mode */
+    if(_summarize)
+    {
+        _summarizeFiles();
+    }
+    /* Only duplicate groups are written in dupes mode */
+    else if(_dupes)
+    {
+        _findDupes();
+    }
+    /* Files are written to the snapshot file in snapshot mode */
+    else if(!_snapshotPath.isEmpty())
+    {
+        if(!_writeSnapshot())
+        {
+            _reportError(_snapshotPath, "can't be written");
+            exitCode = TDIR_SNAPSHOT_ERROR;
+        }
+    }
+    /* Files are written to the name index file in name index mode */
+    else if(!_nameIndexPath.isEmpty())
+    {
+        if(!_buildNameIndex())
+        {
+            exitCode = TDIR_NAME_INDEX_ERROR;
+        }
+    }
+    /* Files are written in the sort order in top & sort modes */
+    else if(_topCount > 0 || _sortMode)
+    {
+        if(!_orderFiles())
+        {
+            QTextStream err(stderr);
+            err << "tdir: temporary sort files can't be read back, the sorted list is incomplete" << endl;
+            exitCode = TDIR_SORT_ERROR;
+        }
+    }
+    /* Scanning directories on a thread pool in parallel recursive mode & all start directories on one pool */
+    else if((_runRecursively && _jobs > 1) || _roots.count() > 1)
+    {
+        TraversalPool pool(_jobs, [this](const QString &dirPath, int depth, QByteArray &output) {
+            return _listDir(QDir(dirPath), depth, output);
+        }, !_unordered);
+
+        _limitDevices(pool);
+        pool.run(_rootPaths(), *_writer);
+    }
+    /* The index & the watcher need whole directories */
+    else if(_index || _watcher)
+    {
+        _listFiles(QDir(*_currentDir));
+    }
+    /* Streaming directories in chunks otherwise */
+    else
+    {
+        TreeEnumerator enumerator;
+        enumerator.setMatcher(*_matcher);
+        enumerator.setRecursive(_runRecursively);
+        enumerator.setMaxDepth(_maxDepth);
+        enumerator.setSorted(true);
+        enumerator.setInodeOrder(_inodeOrder);
+        enumerator.setStatBatchDepth(statBatchDepth);
+        enumerator.setGuard(_guard);
+
+        /* Formatting & writing overlap with reading unless the output is awaited line by line */
+        QScopedPointer<RecordPipeline> pipeline;
+        if(_pipelined && !_writer->isLineBuffered() && !_writer->isInteractive())
+        {
+            pipeline.reset(new RecordPipeline(*_writer, [this](QByteArray &out, const QByteArray &path, const DirEntry &entry) {
+                _appendLine(out, _rawNames ? path : _encode(QFile::decodeName(path)), entry);
+            }));
+        }
+
+        _enumerator = &enumerator;
+        _pipeline = pipeline.data();
+        enumerator.enumerate(QDir(*_currentDir).absolutePath(), *this);
+        if(_pipeline)
+        {
+            _pipeline->finish();
+        }
+        _pipeline = nullptr;
+        _enumerator = nullptr;
+    }
+
+    _writer->flush();
+
+    ScanStats::stopProgress();
+    if(_stats)
+    {
+        ScanStats::report();
+    }
+
+    if(_index)
+    {
+        if(!_index->save())
+        {
+#ifdef __TDIR_DEBUG__
+            qWarning() << "Can't write the index file!";
+#endif
+        }
+        delete _index;
+        _index = nullptr;
+    }
+
+    if(_watcher)
+    {
+        _watcher->start();
+    }
+
+    return exitCode;
+}
+
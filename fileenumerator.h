@@ -1,74 +1,218 @@
-/*! \file       fileenumerator.h
- *  \author     Yury Osipov (yusosipov@ya.ru)
- *  \version    1.0.0.1
- *  \date       August, 2018
- *  \brief      File Enumerator module header file.
- *
- *  This file contains the FileEnumerator class declaration.
- */
-
-#ifndef FILEENUMERATOR_H
-#define FILEENUMERATOR_H
-
-#include <QtCore/QObject>
-#include <QtCore/qglobal.h>
-#include <QCoreApplication>
-
-#include <QDir>
-#include <QTextStream>
-
-#include "exitcodes.h"
-
-/*! \class FileEnumerator
- *  \brief File Enumerator Class.
- *
- *  This class enumerates files in the specified
- *  directory or recursively.
- */
-class FileEnumerator : public QObject
-{
-    Q_OBJECT
-    Q_CLASSINFO("Author", "Yury Osipov")
-    Q_CLASSINFO("e-mail", "yusosipov@ya.ru")
-    private:
-        QCoreApplication *_app;             /*!< A pointer to the application to get it's args */
-        QStringList *_appArguments;         /*!< A pointer to stored application arguments */
-
-
-        QMap<int, QString> _options;        /*!< A map between arg pos & stored option */
-
-        QMap<QString, int> _knownOptions;   /*!< A map between a known option & option ID (see options.h) */
-
-        QString *_currentDir;               /*!< A root path to start file enumeration */
-        QStringList *_mask;                 /*!< A pointer to a stored file mask */
-
-        QTextStream *_out;                  /*!< A pointer to store the setted up standard output stream */
-
-        bool _runRecursively;               /*!< Recursive file enumeration flag */
-
-        int _exitCode;                      /*!< Stores exit code to pass on application exit */
-
-        void _fillOptionList();
-
-        int _findOptions();
-
-        void _listFiles(const QDir &dir);
-        void _listFiles(const QFile &file);
-
-        void _exit();
-    public:
-        FileEnumerator(QObject *parent = nullptr);
-        ~FileEnumerator();
-        void setCurrentDir(const QString &dirPath);
-        void setRecursiveMode(const bool recursiveMode);
-        void setMask(const QString mask);
-        void listFiles();
-        void listFiles(const QFile &file);
-        void viewHelp();
-public slots:
-        void run();
-signals:
-        void finished();
-};
-
-#endif // FILEENUMERATOR_H
+/*! \file       fileenumerator.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      File Enumerator module header file.
+ *
+ *  This file contains the FileEnumerator class declaration.
+ */
+
+#ifndef FILEENUMERATOR_H
+#define FILEENUMERATOR_H
+
+#include <QtCore/QObject>
+#include <QtCore/qglobal.h>
+
+#include <QDir>
+#include <QTextStream>
+#include <QTextCodec>
+
+#include "exitcodes.h"
+#include "dirreader.h"
+#include "outputwriter.h"
+#include "treeindex.h"
+#include "dirwatcher.h"
+#include "globmatcher.h"
+#include "summarizer.h"
+#include "recordsink.h"
+#include "treeenumerator.h"
+#include "dupefinder.h"
+#include "filepredicate.h"
+#include "recordpipeline.h"
+#include "treeguard.h"
+#include "traversalpool.h"
+
+/*! \class FileEnumerator
+ *  \brief File Enumerator Class.
+ *
+ *  This class enumerates files in the specified
+ *  directory or recursively.
+ */
+class FileEnumerator : public QObject, private EntryVisitor
+{
+    Q_OBJECT
+    Q_CLASSINFO("Author", "Yury Osipov")
+    Q_CLASSINFO("e-mail", "yusosipov@ya.ru")
+    public:
+        /*! A field to sort files by in top & sort modes */
+        enum SortField
+        {
+            SortByDefault,                  /*!< Size in top mode, name in sort mode */
+            SortByName,                     /*!< File path */
+            SortBySize,                     /*!< File size, the largest first */
+            SortByMtime                     /*!< Modification time, the newest first */
+        };
+    private:
+        QStringList *_appArguments;         /*!< A pointer to stored application arguments */
+
+
+        QMap<int, QString> _options;        /*!< A map between arg pos & stored option */
+
+        QMap<QString, int> _knownOptions;   /*!< A map between a known option & option ID (see options.h) */
+
+        QString *_currentDir;               /*!< A root path to start file enumeration */
+        QStringList *_mask;                 /*!< A pointer to a stored file mask */
+        QStringList _includeMasks;          /*!< File masks to include besides the stored mask */
+        QStringList _excludeMasks;          /*!< File masks to exclude */
+        GlobMatcher *_matcher;              /*!< A pointer to the masks compiled while listing files */
+        QString _predicate;                 /*!< A file predicate expression, files are filtered by masks only if it is empty */
+        GlobMatcher *_nameMatcher;          /*!< A pointer to the masks without the predicate for the index or null */
+
+        QTextStream *_out;                  /*!< A pointer to store the setted up standard output stream */
+        OutputWriter *_writer;              /*!< A pointer to the buffered file list output writer */
+        QTextCodec *_codec;                 /*!< Output codec, it is looked up on the first output */
+        bool _utf8Output;                   /*!< Output codec is UTF-8, no conversion is needed */
+        bool _rawNames;                     /*!< File names can be written without decoding & encoding */
+        RecordSink::Format _format;         /*!< Output format */
+        RecordSink *_sink;                  /*!< A pointer to the output record formatter */
+
+        bool _stats;                        /*!< Write scan statistics to stderr flag */
+        int _progressInterval;              /*!< Seconds between progress lines, 0 for none */
+        QByteArray _chunk;                  /*!< A reusable buffer for one directory output */
+        TreeEnumerator *_enumerator;        /*!< The engine visiting files while streaming directories */
+        QString _dirPrefix;                 /*!< The visited directory path ending with a separator */
+        QByteArray _path;                   /*!< A reusable buffer to render a visited file path to */
+        DirEntry _file;                     /*!< Reusable fields of a visited file, the name is not used */
+        bool _pipelined;                    /*!< Format & write streamed files on their own thread flag */
+        RecordPipeline *_pipeline;          /*!< A pointer to the pipeline streamed files are passed to or null */
+
+        bool _runRecursively;               /*!< Recursive file enumeration flag */
+
+        QStringList _roots;                 /*!< Absolute start directories listed together, empty for the current one */
+        QString _rootListPath;              /*!< A file to read start directories from, "-" for stdin, or empty */
+        int _failedRoots;                   /*!< Number of start directories which can't be listed */
+
+        int _jobs;                          /*!< Number of parallel traversal jobs */
+        bool _unordered;                    /*!< Parallel traversal output order flag */
+        int _maxDepth;                      /*!< Maximal recursion depth, unlimited if it is negative */
+        bool _inodeOrder;                   /*!< Stat files & enter subdirectories in inode order flag */
+        int _statBatchDepth;                /*!< io_uring queue depth to stat files with, 0 to stat them one by one */
+        int _deviceJobs;                    /*!< Maximal parallel directory scans per device, 0 for no limit */
+
+        bool _oneFileSystem;                /*!< Don't enter directories on other devices than the root flag */
+        QStringList _skippedTypes;          /*!< File system type masks not to enter */
+        bool _linksOnce;                    /*!< List a file with several hard links once flag */
+        TreeGuard *_guard;                  /*!< A pointer to the guard of entered directories while listing files */
+
+        bool _summarize;                    /*!< Show directory size totals instead of files flag */
+        int _summaryDepth;                  /*!< Maximal depth of shown directory totals */
+
+        bool _dupes;                        /*!< Show duplicate file groups instead of files flag */
+
+        int _topCount;                      /*!< Number of first files to show in the sort order, 0 for all */
+        bool _sortMode;                     /*!< Show all files in the sort order flag */
+        SortField _sortBy;                  /*!< A field to sort files by */
+
+        QString _snapshotPath;              /*!< A snapshot file path to write files to instead of listing them, or empty */
+        QStringList _diffPaths;             /*!< Old & new snapshot file paths to compare, or empty */
+
+        QString _nameIndexPath;             /*!< A name index file path to write files to instead of listing them, or empty */
+        QString _queryIndexPath;            /*!< A name index file path to find files in, or empty */
+        QString _queryMask;                 /*!< A file mask to find in the name index */
+
+        QString _indexPath;                 /*!< A tree index file path, the index is not used if it is empty */
+        TreeIndex *_index;                  /*!< A pointer to the tree index used while listing files */
+
+        bool _watchMode;                    /*!< Report changed files after enumeration flag */
+        DirWatcher *_watcher;               /*!< A pointer to the directory watcher in watch mode */
+
+        int _exitCode;                      /*!< Stores exit code to pass on application exit */
+
+        void _fillOptionList();
+
+        int _findOptions();
+        int _takeExtendedOptions();
+        int _takeRoots();
+        bool _readRootList(QStringList &roots) const;
+        QStringList _rootPaths() const;
+
+        QByteArray _encode(const QString &text) const;
+        void _setupCodec();
+        void _startOutput();
+        void _appendLine(QByteArray &out, const QByteArray &path, const DirEntry &entry, char change = 0) const;
+
+        void _readDir(const QString &dirPath, QVector<DirEntry> &entries) const;
+        void _appendFiles(QByteArray &out, const QString &prefix, const QVector<DirEntry> &entries) const;
+        QStringList _listDir(const QDir &dir, int depth, QByteArray &out) const;
+        void _writeTotals(const QString &dirPath, const Summarizer::Totals &totals);
+        void _summarizeFiles();
+        QStringList _subdirList(const QString &prefix, int depth, const QVector<DirEntry> &entries) const;
+        QByteArray _sortKey(SortField sortBy, const QByteArray &path, const DirEntry &entry) const;
+        bool _orderFiles();
+        void _findDupes();
+        bool _writeSnapshot();
+        bool _diffSnapshots();
+        bool _buildNameIndex();
+        bool _queryNameIndex();
+        void _limitDevices(TraversalPool &pool) const;
+        void _writeChange(char change, const QString &dirPath, const DirEntry &entry);
+        void _listFiles(const QDir &dir);
+        void _listFiles(const QFile &file);
+
+        void _exit();
+        void _reportError(const QString &filePath, const QString &error);
+
+        bool enterDir(int dir, const QString &dirPath);
+        bool visitFile(const EntryRecord &file);
+        void leaveFiles(int dir);
+    public:
+        FileEnumerator(QObject *parent = nullptr);
+        ~FileEnumerator();
+        void setArguments(const QStringList &arguments);
+        void setCurrentDir(const QString &dirPath);
+        void setRecursiveMode(const bool recursiveMode);
+        void setRoots(const QStringList &roots);
+        void setRootListPath(const QString &rootListPath);
+        void setMask(const QString mask);
+        void addIncludeMask(const QString &mask);
+        void addExcludeMask(const QString &mask);
+        void setPredicate(const QString &expression);
+        void setJobs(const int jobs);
+        void setMaxDepth(const int maxDepth);
+        void setInodeOrder(const bool inodeOrder);
+        void setStatBatchDepth(const int depth);
+        void setDeviceJobs(const int deviceJobs);
+        void setOneFileSystem(const bool oneFileSystem);
+        void addSkippedTypes(const QString &types);
+        void setLinksOnce(const bool linksOnce);
+        void setSummarizeMode(const bool summarizeMode);
+        void setSummaryDepth(const int summaryDepth);
+        void setDupesMode(const bool dupesMode);
+        void setTopCount(const int topCount);
+        void setSortMode(const bool sortMode);
+        void setSortField(const SortField sortField);
+        void setSnapshotPath(const QString &snapshotPath);
+        void setDiffPaths(const QString &oldPath, const QString &newPath);
+        void setNameIndexPath(const QString &nameIndexPath);
+        void setQuery(const QString &indexPath, const QString &mask);
+        void setOutputFormat(const RecordSink::Format format);
+        void setStatsMode(const bool statsMode);
+        void setProgressInterval(const int seconds);
+        void setUnorderedMode(const bool unorderedMode);
+        void setLineBuffered(const bool lineBuffered);
+        void setPipelineMode(const bool pipelineMode);
+        void setIndexPath(const QString &indexPath);
+        void setWatchMode(const bool watchMode);
+        int listFiles();
+        void listFiles(const QFile &file);
+        void viewHelp();
+        int exitCode() const;
+public slots:
+        void run();
+private slots:
+        void _flushOutput();
+signals:
+        void finished(int exitCode);
+};
+
+#endif // FILEENUMERATOR_H
@@ -0,0 +1,729 @@
+/*! \file       filepredicate.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief File Predicate module source file.
+ *
+ *  This file contains the FilePredicate class source code.
+ */
+
+#include "filepredicate.h"
+
+#include <QDateTime>
+#include <QStringList>
+
+#include <algorithm>
+#include <climits>
+#include <string.h>
+
+#ifdef Q_OS_UNIX
+#include <pwd.h>
+#endif
+
+/* Age suffixes & their lengths in milliseconds */
+static const char age_suffixes[] = "smhdw";
+static const qint64 age_units[] = { 1000LL, 60000LL, 3600000LL, 86400000LL, 604800000LL };
+
+/*!
+ * \brief isOperatorChar
+ * \param[in] ch A character
+ * \return "true" if the character is a part of a comparison operator
+ */
+static inline bool isOperatorChar(QChar ch)
+{
+    return ch == QChar('<') || ch == QChar('>') || ch == QChar('=') || ch == QChar('!');
+}
+
+/*!
+ * \brief FilePredicate::FilePredicate
+ *
+ * FilePredicate Constructor, an empty predicate accepts any file
+ */
+FilePredicate::FilePredicate()
+{
+    _root = -1;
+    _now = 0;
+}
+
+/*!
+ * \brief FilePredicate::compile
+ * \param[in] expression An expression described in the class documentation
+ * \return "false" if the expression is empty or it can't be parsed
+ */
+bool FilePredicate::compile(const QString &expression)
+{
+    _expression = expression;
+    _nodes.clear();
+    _operands.clear();
+    _matchers.clear();
+    _root = -1;
+    _now = QDateTime::currentMSecsSinceEpoch();
+
+    QVector<Token> tokens;
+    if(!_tokenize(expression, tokens) || tokens.isEmpty())
+    {
+        return false;
+    }
+
+    int pos = 0;
+    int root = _parseOr(tokens, pos);
+    if(root < 0 || pos != tokens.count())
+    {
+        _nodes.clear();
+        _operands.clear();
+        _matchers.clear();
+        return false;
+    }
+
+    _root = root;
+    return true;
+}
+
+/*!
+ * \brief FilePredicate::isEmpty
+ * \return "true" if there is no compiled expression & any file is accepted
+ */
+bool FilePredicate::isEmpty() const
+{
+    return _root < 0;
+}
+
+/*!
+ * \brief FilePredicate::expression
+ * \return The source expression
+ */
+const QString &FilePredicate::expression() const
+{
+    return _expression;
+}
+
+/*!
+ * \brief FilePredicate::preMatch
+ * \param[in] name A raw file name
+ * \param[in] nameSize The name size
+ * \param[in] link 1 for a link, 0 for a regular file, -1 if the directory entry type is not known
+ * \return The result decided before the file is stated
+ */
+FilePredicate::Result FilePredicate::preMatch(const char *name, int nameSize, int link) const
+{
+    if(_root < 0)
+    {
+        return RESULT_TRUE;
+    }
+
+    Fields fields;
+    fields.name = name;
+    fields.nameSize = nameSize;
+    fields.link = link;
+    fields.stated = false;
+    fields.size = 0;
+    fields.mtime = 0;
+    fields.ctime = 0;
+    fields.uid = 0;
+    return _evaluate(_root, fields);
+}
+
+/*!
+ * \brief FilePredicate::matches
+ * \param[in] record A stated file record
+ * \return "true" if the file is accepted
+ */
+bool FilePredicate::matches(const EntryRecord &record) const
+{
+    if(_root < 0)
+    {
+        return true;
+    }
+
+    Fields fields;
+    fields.name = record.name;
+    fields.nameSize = record.nameSize;
+    fields.link = record.isLink ? 1 : 0;
+    fields.stated = true;
+    fields.size = record.size;
+    fields.mtime = record.mtime;
+    fields.ctime = record.ctime;
+    fields.uid = record.uid;
+    return _evaluate(_root, fields) == RESULT_TRUE;
+}
+
+/*!
+ * \brief FilePredicate::matches
+ * \param[in] entry A stated file entry
+ * \return "true" if the file is accepted
+ */
+bool FilePredicate::matches(const DirEntry &entry) const
+{
+    if(_root < 0)
+    {
+        return true;
+    }
+
+    Fields fields;
+    fields.name = entry.name.constData();
+    fields.nameSize = entry.name.size();
+    fields.link = entry.isLink ? 1 : 0;
+    fields.stated = true;
+    fields.size = entry.size;
+    fields.mtime = entry.mtime;
+    fields.ctime = entry.ctime;
+    fields.uid = entry.uid;
+    return _evaluate(_root, fields) == RESULT_TRUE;
+}
+
+/*!
+ * \brief FilePredicate::filter
+ * \param[in,out] entries Entries to drop rejected files from, subdirectories are kept
+ *
+ * Keeps the order of the remaining entries.
+ */
+void FilePredicate::filter(QVector<DirEntry> &entries) const
+{
+    if(_root < 0)
+    {
+        return;
+    }
+
+    int count = 0;
+    for(int entryNum = 0; entryNum < entries.count(); entryNum++)
+    {
+        if(entries.at(entryNum).isDir || matches(entries.at(entryNum)))
+        {
+            if(count != entryNum)
+            {
+                entries[count] = entries.at(entryNum);
+            }
+            count++;
+        }
+    }
+    entries.resize(count);
+}
+
+/*!
+ * \brief FilePredicate::_tokenize
+ * \param[in] expression An expression
+ * \param[out] tokens Expression tokens
+ * \return "false" if a quote is not closed
+ *
+ * Splits the expression into words, quoted words, comparison
+ * operators & parentheses. Spaces separate words only.
+ */
+bool FilePredicate::_tokenize(const QString &expression, QVector<Token> &tokens)
+{
+    const int size = expression.size();
+    int pos = 0;
+    while(pos < size)
+    {
+        QChar ch = expression.at(pos);
+        if(ch.isSpace())
+        {
+            pos++;
+            continue;
+        }
+
+        Token token;
+        token.word = false;
+        token.value = false;
+
+        if(ch == QChar('(') || ch == QChar(')'))
+        {
+            token.text = ch;
+            pos++;
+        }
+        else if(isOperatorChar(ch))
+        {
+            while(pos < size && isOperatorChar(expression.at(pos)))
+            {
+                token.text.append(expression.at(pos++));
+            }
+        }
+        else if(ch == QChar('\'') || ch == QChar('"'))
+        {
+            int end = expression.indexOf(ch, pos + 1);
+            if(end < 0)
+            {
+                return false;
+            }
+            token.text = expression.mid(pos + 1, end - pos - 1);
+            token.value = true;
+            pos = end + 1;
+        }
+        else
+        {
+            while(pos < size)
+            {
+                ch = expression.at(pos);
+                if(ch.isSpace() || ch == QChar('(') || ch == QChar(')') || isOperatorChar(ch) ||
+                   ch == QChar('\'') || ch == QChar('"'))
+                {
+                    break;
+                }
+                token.text.append(ch);
+                pos++;
+            }
+            token.word = true;
+            token.value = true;
+        }
+
+        tokens.append(token);
+    }
+    return true;
+}
+
+/*!
+ * \brief isKeyword
+ * \param[in] token A token text
+ * \param[in] word Set if the token is an unquoted word
+ * \param[in] keyword A keyword in lower case
+ * \return "true" if the token is the keyword
+ */
+static inline bool isKeyword(const QString &token, bool word, const char *keyword)
+{
+    return word && token.compare(QLatin1String(keyword), Qt::CaseInsensitive) == 0;
+}
+
+/*!
+ * \brief FilePredicate::_parseOr
+ * \param[in] tokens Expression tokens
+ * \param[in,out] pos The next token position
+ * \return A node index or -1 on a syntax error
+ */
+int FilePredicate::_parseOr(const QVector<Token> &tokens, int &pos)
+{
+    QVector<int> operands;
+    forever
+    {
+        int operand = _parseAnd(tokens, pos);
+        if(operand < 0)
+        {
+            return -1;
+        }
+        operands.append(operand);
+
+        if(pos < tokens.count() && isKeyword(tokens.at(pos).text, tokens.at(pos).word, "or"))
+        {
+            pos++;
+            continue;
+        }
+        break;
+    }
+
+    return (operands.count() == 1) ? operands.first() : _addNode(NODE_OR, operands);
+}
+
+/*!
+ * \brief FilePredicate::_parseAnd
+ * \param[in] tokens Expression tokens
+ * \param[in,out] pos The next token position
+ * \return A node index or -1 on a syntax error
+ *
+ * Operands following each other without "and" are joined by "and" too.
+ */
+int FilePredicate::_parseAnd(const QVector<Token> &tokens, int &pos)
+{
+    QVector<int> operands;
+    forever
+    {
+        int operand = _parseUnary(tokens, pos);
+        if(operand < 0)
+        {
+            return -1;
+        }
+        operands.append(operand);
+
+        if(pos >= tokens.count())
+        {
+            break;
+        }
+
+        const Token &token = tokens.at(pos);
+        if(isKeyword(token.text, token.word, "and"))
+        {
+            pos++;
+        }
+        else if(isKeyword(token.text, token.word, "or") || (!token.value && token.text == QLatin1String(")")))
+        {
+            break;
+        }
+    }
+
+    return (operands.count() == 1) ? operands.first() : _addNode(NODE_AND, operands);
+}
+
+/*!
+ * \brief FilePredicate::_parseUnary
+ * \param[in] tokens Expression tokens
+ * \param[in,out] pos The next token position
+ * \return A node index or -1 on a syntax error
+ */
+int FilePredicate::_parseUnary(const QVector<Token> &tokens, int &pos)
+{
+    if(pos >= tokens.count())
+    {
+        return -1;
+    }
+
+    const Token &token = tokens.at(pos);
+    if(isKeyword(token.text, token.word, "not"))
+    {
+        pos++;
+        int operand = _parseUnary(tokens, pos);
+        return (operand < 0) ? -1 : _addNode(NODE_NOT, QVector<int>() << operand);
+    }
+
+    if(!token.value && token.text == QLatin1String("("))
+    {
+        pos++;
+        int node = _parseOr(tokens, pos);
+        if(node < 0 || pos >= tokens.count() || tokens.at(pos).value || tokens.at(pos).text != QLatin1String(")"))
+        {
+            return -1;
+        }
+        pos++;
+        return node;
+    }
+
+    return _parseTest(tokens, pos);
+}
+
+/*!
+ * \brief FilePredicate::_parseTest
+ * \param[in] tokens Expression tokens
+ * \param[in,out] pos The next token position
+ * \return A node index or -1 on a syntax error
+ *
+ * Parses a "field operator value" test.
+ */
+int FilePredicate::_parseTest(const QVector<Token> &tokens, int &pos)
+{
+    if(pos + 2 >= tokens.count())
+    {
+        return -1;
+    }
+
+    const Token &field = tokens.at(pos);
+    const Token &op = tokens.at(pos + 1);
+    const Token &value = tokens.at(pos + 2);
+    if(!field.word || op.value || !value.value)
+    {
+        return -1;
+    }
+
+    Node node;
+    node.value = 0;
+    node.first = 0;
+    node.count = 0;
+    node.stated = true;
+
+    if(op.text == QLatin1String("=") || op.text == QLatin1String("=="))
+    {
+        node.compare = COMPARE_EQUAL;
+    }
+    else if(op.text == QLatin1String("!="))
+    {
+        node.compare = COMPARE_NOT_EQUAL;
+    }
+    else if(op.text == QLatin1String("<"))
+    {
+        node.compare = COMPARE_LESS;
+    }
+    else if(op.text == QLatin1String("<="))
+    {
+        node.compare = COMPARE_LESS_EQUAL;
+    }
+    else if(op.text == QLatin1String(">"))
+    {
+        node.compare = COMPARE_GREATER;
+    }
+    else if(op.text == QLatin1String(">="))
+    {
+        node.compare = COMPARE_GREATER_EQUAL;
+    }
+    else
+    {
+        return -1;
+    }
+
+    const bool equality = (node.compare == COMPARE_EQUAL || node.compare == COMPARE_NOT_EQUAL);
+    const QString name = field.text.toLower();
+    bool valid = false;
+
+    if(name == QLatin1String("name"))
+    {
+        node.type = NODE_NAME;
+        node.stated = false;
+        node.value = _matchers.count();
+        _matchers.append(GlobMatcher(QStringList() << value.text, QStringList()));
+        valid = equality;
+    }
+    else if(name == QLatin1String("type"))
+    {
+        node.type = NODE_TYPE;
+        node.stated = false;
+        node.value = (value.text == QLatin1String("l")) ? 1 : 0;
+        valid = equality && (value.text == QLatin1String("f") || value.text == QLatin1String("l"));
+    }
+    else if(name == QLatin1String("size"))
+    {
+        node.type = NODE_SIZE;
+        valid = _parseSize(value.text, node.value);
+    }
+    else if(name == QLatin1String("mtime") || name == QLatin1String("ctime"))
+    {
+        node.type = (name == QLatin1String("mtime")) ? NODE_MTIME : NODE_CTIME;
+        valid = !equality && _parseTime(value.text, node.compare, node.value);
+    }
+    else if(name == QLatin1String("user"))
+    {
+        node.type = NODE_USER;
+        valid = equality && _parseUser(value.text, node.value);
+    }
+
+    if(!valid)
+    {
+        return -1;
+    }
+
+    pos += 3;
+    _nodes.append(node);
+    return _nodes.count() - 1;
+}
+
+/*!
+ * \brief FilePredicate::_addNode
+ * \param[in] type An "and", "or" or "not" node type
+ * \param[in] operands Operand node indexes
+ * \return The node index
+ *
+ * Operands which don't need stated fields are moved first,
+ * so they decide before the stated ones are looked at.
+ */
+int FilePredicate::_addNode(NodeType type, const QVector<int> &operands)
+{
+    QVector<int> ordered = operands;
+    std::stable_sort(ordered.begin(), ordered.end(), [this](int left, int right) {
+        return !_nodes.at(left).stated && _nodes.at(right).stated;
+    });
+
+    Node node;
+    node.type = type;
+    node.compare = COMPARE_EQUAL;
+    node.value = 0;
+    node.first = _operands.count();
+    node.count = ordered.count();
+    node.stated = false;
+    foreach (int operand, ordered) {
+        node.stated = node.stated || _nodes.at(operand).stated;
+        _operands.append(operand);
+    }
+
+    _nodes.append(node);
+    return _nodes.count() - 1;
+}
+
+/*!
+ * \brief FilePredicate::_parseTime
+ * \param[in] text An age or a local time
+ * \param[in,out] compare A comparison, it is reversed for ages
+ * \param[out] value Milliseconds since epoch
+ * \return "false" if the text is neither an age nor a time
+ *
+ * An age is turned into the time it is counted back to, so a file
+ * younger than the age has a time greater than the value.
+ */
+bool FilePredicate::_parseTime(const QString &text, Compare &compare, qint64 &value) const
+{
+    QString number = text;
+    qint64 unit = age_units[3];
+    const char *suffix = text.isEmpty() ? nullptr : strchr(age_suffixes, text.at(text.size() - 1).toLower().toLatin1());
+    if(suffix && *suffix)
+    {
+        unit = age_units[suffix - age_suffixes];
+        number.chop(1);
+    }
+
+    bool numberOk = false;
+    qint64 age = number.toLongLong(&numberOk);
+    if(numberOk && age >= 0 && age <= LLONG_MAX / unit)
+    {
+        value = _now - age * unit;
+        switch(compare)
+        {
+            case COMPARE_LESS:          compare = COMPARE_GREATER; break;
+            case COMPARE_LESS_EQUAL:    compare = COMPARE_GREATER_EQUAL; break;
+            case COMPARE_GREATER:       compare = COMPARE_LESS; break;
+            case COMPARE_GREATER_EQUAL: compare = COMPARE_LESS_EQUAL; break;
+            default: break;
+        }
+        return true;
+    }
+
+    QDateTime time;
+    if(text.contains(QChar('T')))
+    {
+        time = QDateTime::fromString(text, Qt::ISODate);
+    }
+    else
+    {
+        time = QDateTime(QDate::fromString(text, Qt::ISODate), QTime(0, 0));
+    }
+
+    if(!time.isValid())
+    {
+        return false;
+    }
+    value = time.toMSecsSinceEpoch();
+    return true;
+}
+
+/*!
+ * \brief FilePredicate::_parseSize
+ * \param[in] text A number with an optional K, M, G or T suffix
+ * \param[out] value Bytes
+ * \return "false" if the text is not a size
+ */
+bool FilePredicate::_parseSize(const QString &text, qint64 &value)
+{
+    static const char suffixes[] = "kmgt";
+
+    QString number = text;
+    int shift = 0;
+    const char *suffix = text.isEmpty() ? nullptr : strchr(suffixes, text.at(text.size() - 1).toLower().toLatin1());
+    if(suffix && *suffix)
+    {
+        shift = 10 * int(suffix - suffixes + 1);
+        number.chop(1);
+    }
+
+    bool numberOk = false;
+    qint64 size = number.toLongLong(&numberOk);
+    if(!numberOk || size < 0 || size > (LLONG_MAX >> shift))
+    {
+        return false;
+    }
+    value = size << shift;
+    return true;
+}
+
+/*!
+ * \brief FilePredicate::_parseUser
+ * \param[in] text A user id or name
+ * \param[out] value The user id
+ * \return "false" if there is no such user
+ */
+bool FilePredicate::_parseUser(const QString &text, qint64 &value)
+{
+    bool idOk = false;
+    uint uid = text.toUInt(&idOk);
+    if(idOk)
+    {
+        value = uid;
+        return true;
+    }
+
+#ifdef Q_OS_UNIX
+    struct passwd *user = getpwnam(text.toLocal8Bit().constData());
+    if(user)
+    {
+        value = user->pw_uid;
+        return true;
+    }
+#endif
+    return false;
+}
+
+/*!
+ * \brief FilePredicate::_evaluate
+ * \param[in] nodeNum A node index
+ * \param[in] fields File fields
+ * \return The node result, unknown if it depends on fields which are not stated yet
+ */
+FilePredicate::Result FilePredicate::_evaluate(int nodeNum, const Fields &fields) const
+{
+    const Node &node = _nodes.at(nodeNum);
+    qint64 value = 0;
+
+    switch(node.type)
+    {
+        case NODE_AND:
+        case NODE_OR:
+        {
+            /* The first deciding operand ends the evaluation */
+            const Result deciding = (node.type == NODE_AND) ? RESULT_FALSE : RESULT_TRUE;
+            Result result = (node.type == NODE_AND) ? RESULT_TRUE : RESULT_FALSE;
+            for(int operandNum = 0; operandNum < node.count; operandNum++)
+            {
+                Result operand = _evaluate(_operands.at(node.first + operandNum), fields);
+                if(operand == deciding)
+                {
+                    return deciding;
+                }
+                if(operand == RESULT_UNKNOWN)
+                {
+                    result = RESULT_UNKNOWN;
+                }
+            }
+            return result;
+        }
+        case NODE_NOT:
+        {
+            Result operand = _evaluate(_operands.at(node.first), fields);
+            if(operand == RESULT_UNKNOWN)
+            {
+                return RESULT_UNKNOWN;
+            }
+            return (operand == RESULT_TRUE) ? RESULT_FALSE : RESULT_TRUE;
+        }
+        case NODE_NAME:
+        {
+            bool matches = _matchers.at(int(node.value)).matches(fields.name, fields.nameSize);
+            return (matches == (node.compare == COMPARE_EQUAL)) ? RESULT_TRUE : RESULT_FALSE;
+        }
+        case NODE_TYPE:
+            if(fields.link < 0)
+            {
+                return RESULT_UNKNOWN;
+            }
+            value = fields.link;
+            break;
+        case NODE_SIZE:
+            value = fields.size;
+            break;
+        case NODE_MTIME:
+            value = fields.mtime;
+            break;
+        case NODE_CTIME:
+            value = fields.ctime;
+            break;
+        case NODE_USER:
+            value = fields.uid;
+            break;
+    }
+
+    if(node.stated && !fields.stated)
+    {
+        return RESULT_UNKNOWN;
+    }
+    return _compare(node.compare, value, node.value) ? RESULT_TRUE : RESULT_FALSE;
+}
+
+/*!
+ * \brief FilePredicate::_compare
+ * \param[in] compare A comparison
+ * \param[in] left A file field
+ * \param[in] right A value to compare with
+ * \return The comparison result
+ */
+bool FilePredicate::_compare(Compare compare, qint64 left, qint64 right)
+{
+    switch(compare)
+    {
+        case COMPARE_EQUAL:         return left == right;
+        case COMPARE_NOT_EQUAL:     return left != right;
+        case COMPARE_LESS:          return left < right;
+        case COMPARE_LESS_EQUAL:    return left <= right;
+        case COMPARE_GREATER:       return left > right;
+        case COMPARE_GREATER_EQUAL: return left >= right;
+    }
+    return false;
+}
@@ -0,0 +1,150 @@
+/*! \file       filepredicate.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      File Predicate module header file.
+ *
+ *  This file contains the FilePredicate class declaration.
+ */
+
+#ifndef FILEPREDICATE_H
+#define FILEPREDICATE_H
+
+#include <QtCore/qglobal.h>
+
+#include <QString>
+#include <QVector>
+
+#include "dirreader.h"
+#include "globmatcher.h"
+
+/*! \class FilePredicate
+ *  \brief Compiled file filter expression class.
+ *
+ *  This class compiles an expression of tests combined with "and", "or",
+ *  "not" & parentheses, "and" may be omitted:
+ *
+ *      size>1G and (mtime<1d or name='*.log') and not user=root
+ *
+ *  Tests are "name" (=, != a wildcard pattern), "type" (=, != "f" for a
+ *  regular file or "l" for a link to a file), "size" (a number of bytes with
+ *  an optional K, M, G or T suffix), "mtime" & "ctime" (<, <=, >, >= an age
+ *  with an s, m, h, d or w suffix, days by default, or a yyyy-MM-dd[Thh:mm:ss]
+ *  local time) & "user" (=, != a user name or id). Ages are counted
+ *  from the moment the expression is compiled.
+ *
+ *  The expression is compiled into a tree whose "and" & "or" operands are
+ *  ordered cheap first: name & type tests before the stated fields. Before
+ *  a file is stated, the tree is evaluated with the stated fields unknown,
+ *  so files rejected by their names & directory entry types are never stated.
+ */
+class FilePredicate
+{
+    public:
+        /*! \enum Result
+         *  \brief A three-valued test result.
+         */
+        enum Result
+        {
+            RESULT_FALSE,       /*!< The file is rejected */
+            RESULT_TRUE,        /*!< The file is accepted */
+            RESULT_UNKNOWN      /*!< The file must be stated to decide */
+        };
+
+        FilePredicate();
+        bool compile(const QString &expression);
+        bool isEmpty() const;
+        const QString &expression() const;
+        Result preMatch(const char *name, int nameSize, int link) const;
+        bool matches(const EntryRecord &record) const;
+        bool matches(const DirEntry &entry) const;
+        void filter(QVector<DirEntry> &entries) const;
+    private:
+        /*! \enum NodeType
+         *  \brief Expression tree node types.
+         */
+        enum NodeType
+        {
+            NODE_AND,           /*!< All operands are true */
+            NODE_OR,            /*!< Any operand is true */
+            NODE_NOT,           /*!< The operand is false */
+            NODE_NAME,          /*!< The name matches a pattern */
+            NODE_TYPE,          /*!< The file is a link or a regular file */
+            NODE_SIZE,          /*!< A size comparison */
+            NODE_MTIME,         /*!< A modification time comparison */
+            NODE_CTIME,         /*!< A status change time comparison */
+            NODE_USER           /*!< An owner comparison */
+        };
+
+        /*! \enum Compare
+         *  \brief Comparison operators.
+         */
+        enum Compare
+        {
+            COMPARE_EQUAL,
+            COMPARE_NOT_EQUAL,
+            COMPARE_LESS,
+            COMPARE_LESS_EQUAL,
+            COMPARE_GREATER,
+            COMPARE_GREATER_EQUAL
+        };
+
+        /*! \struct Node
+         *  \brief An expression tree node.
+         */
+        struct Node
+        {
+            NodeType type;      /*!< The node type */
+            Compare compare;    /*!< A comparison of tests */
+            qint64 value;       /*!< A value to compare with, a matcher index of name tests */
+            int first;          /*!< The first operand index in the operand list */
+            int count;          /*!< Number of operands */
+            bool stated;        /*!< Set if the node depends on stated fields */
+        };
+
+        /*! \struct Fields
+         *  \brief File fields a tree is evaluated on.
+         */
+        struct Fields
+        {
+            const char *name;   /*!< A raw name */
+            int nameSize;       /*!< The name size */
+            int link;           /*!< 1 for a link, 0 for a regular file, -1 if it is not known */
+            bool stated;        /*!< Set if the fields below are known */
+            qint64 size;        /*!< A file size in bytes */
+            qint64 mtime;       /*!< A modification time in milliseconds since epoch */
+            qint64 ctime;       /*!< A status change time in milliseconds since epoch */
+            unsigned int uid;   /*!< An owner id */
+        };
+
+        /*! \struct Token
+         *  \brief An expression token.
+         */
+        struct Token
+        {
+            QString text;       /*!< The token text without quotes */
+            bool word;          /*!< Set for unquoted words which may be keywords */
+            bool value;         /*!< Set for words & quoted words */
+        };
+
+        QString _expression;            /*!< The source expression */
+        QVector<Node> _nodes;           /*!< Tree nodes */
+        QVector<int> _operands;         /*!< Operand node indexes of all nodes */
+        QVector<GlobMatcher> _matchers; /*!< Patterns of name tests */
+        int _root;                      /*!< The root node index, -1 if the predicate is empty */
+        qint64 _now;                    /*!< Milliseconds since epoch ages are counted from */
+
+        static bool _tokenize(const QString &expression, QVector<Token> &tokens);
+        int _parseOr(const QVector<Token> &tokens, int &pos);
+        int _parseAnd(const QVector<Token> &tokens, int &pos);
+        int _parseUnary(const QVector<Token> &tokens, int &pos);
+        int _parseTest(const QVector<Token> &tokens, int &pos);
+        int _addNode(NodeType type, const QVector<int> &operands);
+        bool _parseTime(const QString &text, Compare &compare, qint64 &value) const;
+        static bool _parseSize(const QString &text, qint64 &value);
+        static bool _parseUser(const QString &text, qint64 &value);
+        Result _evaluate(int node, const Fields &fields) const;
+        static bool _compare(Compare compare, qint64 left, qint64 right);
+};
+
+#endif // FILEPREDICATE_H
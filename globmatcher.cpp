@@ -0,0 +1,572 @@
+/*! \file       globmatcher.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief Glob Matcher module source file.
+ *
+ *  This file contains the GlobMatcher class source code.
+ */
+
+#include "globmatcher.h"
+
+#include <QFile>
+#include <QTextCodec>
+
+#include <bitset>
+#include <string.h>
+#include <vector>
+
+/* Automaton state sets up to this size in words are kept on the stack */
+static const int stack_state_words = 8;
+
+/*! \struct GlobToken
+ *  \brief A compiled pattern element.
+ */
+struct GlobToken
+{
+    std::bitset<256> bytes;     /*!< Bytes accepted by the token */
+    bool loop;                  /*!< The token accepts any number of bytes (may be skipped) */
+};
+
+/*!
+ * \brief foldByte
+ * \param[in] byte A byte to fold
+ * \return The byte in lower case if it is an ASCII letter
+ */
+static inline uchar foldByte(uchar byte)
+{
+    return (byte >= 'A' && byte <= 'Z') ? byte + ('a' - 'A') : byte;
+}
+
+/*!
+ * \brief equalsFolded
+ * \param[in] name Name bytes
+ * \param[in] lower Lower case bytes to compare with
+ * \param[in] length Number of bytes to compare
+ * \return "true" if bytes are equal ignoring ASCII case
+ */
+static inline bool equalsFolded(const char *name, const char *lower, int length)
+{
+    for(int pos = 0; pos < length; pos++)
+    {
+        if(foldByte(uchar(name[pos])) != uchar(lower[pos]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*!
+ * \brief addFolded
+ * \param[out] bytes A byte set to add to
+ * \param[in] byte A lower case byte, its upper case is added too
+ */
+static inline void addFolded(std::bitset<256> &bytes, uchar byte)
+{
+    bytes.set(byte);
+    if(byte >= 'a' && byte <= 'z')
+    {
+        bytes.set(byte - ('a' - 'A'));
+    }
+}
+
+/*!
+ * \brief addCharToken
+ * \param[out] tokens Tokens to append to
+ * \param[in] bytes Single byte characters to accept
+ * \param[in] utf8 Set to "true" to accept multibyte UTF-8 characters too
+ *
+ * Appends tokens accepting one character from a set of ASCII characters
+ * and, in UTF-8, any non-ASCII character.
+ */
+static void addCharToken(QVector<GlobToken> &tokens, std::bitset<256> bytes, bool utf8)
+{
+    GlobToken token;
+    token.loop = false;
+    token.bytes = bytes;
+    token.bytes.reset(0);
+
+    if(!utf8)
+    {
+        tokens.append(token);
+        return;
+    }
+
+    /* A lead byte followed by any number of continuation bytes */
+    std::bitset<256> continuation;
+    for(int byte = 0x80; byte < 0xC0; byte++)
+    {
+        token.bytes.reset(byte);
+        continuation.set(byte);
+    }
+    tokens.append(token);
+
+    token.loop = true;
+    token.bytes = continuation;
+    tokens.append(token);
+}
+
+/*!
+ * \brief tokenize
+ * \param[in] pattern A lower case ASCII wildcard pattern
+ * \param[in] utf8 Set to "true" if names are UTF-8 encoded
+ * \return Pattern tokens
+ *
+ * Splits a wildcard pattern the same way as QRegExp::Wildcard does:
+ * "*" matches any characters, "?" matches one character & "[...]" matches one
+ * character of a set, "!" or "^" negates the set. An unclosed "[" is a literal.
+ */
+static QVector<GlobToken> tokenize(const QByteArray &pattern, bool utf8)
+{
+    QVector<GlobToken> tokens;
+    const int length = pattern.size();
+
+    for(int pos = 0; pos < length; )
+    {
+        uchar byte = uchar(pattern.at(pos));
+        GlobToken token;
+        token.loop = false;
+
+        if(byte == '*')
+        {
+            /* Repeated stars are the same as one */
+            if(tokens.isEmpty() || !tokens.last().loop || !tokens.last().bytes.all())
+            {
+                token.loop = true;
+                token.bytes.set();
+                token.bytes.reset(0);
+                tokens.append(token);
+            }
+            pos++;
+            continue;
+        }
+
+        if(byte == '?')
+        {
+            std::bitset<256> bytes;
+            bytes.set();
+            addCharToken(tokens, bytes, utf8);
+            pos++;
+            continue;
+        }
+
+        if(byte == '[')
+        {
+            int setPos = pos + 1;
+            bool negated = false;
+            if(setPos < length && (pattern.at(setPos) == '!' || pattern.at(setPos) == '^'))
+            {
+                negated = true;
+                setPos++;
+            }
+
+            /* The first "]" of a set is a literal */
+            std::bitset<256> bytes;
+            int first = setPos;
+            bool closed = false;
+            while(setPos < length)
+            {
+                uchar setByte = uchar(pattern.at(setPos));
+                if(setByte == ']' && setPos > first)
+                {
+                    closed = true;
+                    setPos++;
+                    break;
+                }
+
+                if(setPos + 2 < length && pattern.at(setPos + 1) == '-' && pattern.at(setPos + 2) != ']')
+                {
+                    for(int rangeByte = setByte; rangeByte <= uchar(pattern.at(setPos + 2)); rangeByte++)
+                    {
+                        addFolded(bytes, foldByte(uchar(rangeByte)));
+                    }
+                    setPos += 3;
+                }
+                else
+                {
+                    addFolded(bytes, setByte);
+                    setPos++;
+                }
+            }
+
+            if(closed)
+            {
+                if(negated)
+                {
+                    addCharToken(tokens, ~bytes, utf8);
+                }
+                else
+                {
+                    token.bytes = bytes;
+                    tokens.append(token);
+                }
+                pos = setPos;
+                continue;
+            }
+        }
+
+        addFolded(token.bytes, byte);
+        tokens.append(token);
+        pos++;
+    }
+
+    return tokens;
+}
+
+/*!
+ * \brief GlobMatcher::PatternSet::PatternSet
+ *
+ * PatternSet Constructor
+ */
+GlobMatcher::PatternSet::PatternSet()
+{
+    _words = 0;
+}
+
+/*!
+ * \brief GlobMatcher::PatternSet::compile
+ * \param[in] patterns Wildcard patterns
+ * \param[in] utf8 Set to "true" if names are UTF-8 encoded
+ */
+void GlobMatcher::PatternSet::compile(const QStringList &patterns, bool utf8)
+{
+    QVector<QByteArray> automatonPatterns;
+
+    foreach (const QString &pattern, patterns) {
+        QByteArray bytes = QFile::encodeName(pattern);
+
+        /* Non-ASCII characters are compared ignoring case by QRegExp only */
+        bool ascii = true;
+        for(int pos = 0; pos < bytes.size() && ascii; pos++)
+        {
+            ascii = (uchar(bytes.at(pos)) < 0x80);
+        }
+        if(!ascii)
+        {
+            _regExps.append(QRegExp(pattern, Qt::CaseInsensitive, QRegExp::Wildcard));
+            continue;
+        }
+
+        QByteArray lower = bytes.toLower();
+        int metaPos = -1;
+        for(int pos = 0; pos < lower.size() && metaPos < 0; pos++)
+        {
+            char byte = lower.at(pos);
+            if(byte == '*' || byte == '?' || byte == '[')
+            {
+                metaPos = pos;
+            }
+        }
+
+        if(metaPos < 0)
+        {
+            _literals.append(lower);
+        }
+        else if(metaPos == 0 && lower.at(0) == '*' && lower.indexOf('*', 1) < 0 &&
+                lower.indexOf('?') < 0 && lower.indexOf('[') < 0)
+        {
+            _suffixes.append(lower.mid(1));
+        }
+        else
+        {
+            automatonPatterns.append(lower);
+        }
+    }
+
+    _compileAutomaton(automatonPatterns, utf8);
+}
+
+/*!
+ * \brief GlobMatcher::PatternSet::_compileAutomaton
+ * \param[in] patterns Lower case ASCII wildcard patterns
+ * \param[in] utf8 Set to "true" if names are UTF-8 encoded
+ * \return "false" if there are no patterns
+ *
+ * Builds one bit-parallel automaton for all patterns. Every pattern token is
+ * a state followed by the final state of the pattern, a byte moves active states
+ * to the next ones or keeps looping states active.
+ */
+bool GlobMatcher::PatternSet::_compileAutomaton(const QVector<QByteArray> &patterns, bool utf8)
+{
+    QVector<QVector<GlobToken> > patternTokens;
+    int states = 0;
+
+    foreach (const QByteArray &pattern, patterns) {
+        patternTokens.append(tokenize(pattern, utf8));
+        states += patternTokens.last().count() + 1;
+    }
+
+    if(states == 0)
+    {
+        _words = 0;
+        return false;
+    }
+
+    _words = (states + 63) / 64;
+    _advance.fill(0, 256 * _words);
+    _loop.fill(0, 256 * _words);
+    _loopStates.fill(0, _words);
+    _start.fill(0, _words);
+    _accept.fill(0, _words);
+
+    int base = 0;
+    foreach (const QVector<GlobToken> &tokens, patternTokens) {
+        _start[base / 64] |= Q_UINT64_C(1) << (base % 64);
+
+        for(int tokenNum = 0; tokenNum < tokens.count(); tokenNum++)
+        {
+            const GlobToken &token = tokens.at(tokenNum);
+            const int state = base + tokenNum;
+            const quint64 bit = Q_UINT64_C(1) << (state % 64);
+            QVector<quint64> &table = token.loop ? _loop : _advance;
+
+            for(int byte = 1; byte < 256; byte++)
+            {
+                if(token.bytes.test(byte))
+                {
+                    table[byte * _words + state / 64] |= bit;
+                }
+            }
+
+            if(token.loop)
+            {
+                _loopStates[state / 64] |= bit;
+            }
+        }
+
+        const int finalState = base + tokens.count();
+        _accept[finalState / 64] |= Q_UINT64_C(1) << (finalState % 64);
+        base = finalState + 1;
+    }
+
+    _close(_start.data());
+    return true;
+}
+
+/*!
+ * \brief GlobMatcher::PatternSet::_close
+ * \param[in,out] states Active states
+ *
+ * Activates states following active looping states, as they may be skipped.
+ */
+void GlobMatcher::PatternSet::_close(quint64 *states) const
+{
+    bool changed = true;
+    while(changed)
+    {
+        changed = false;
+        quint64 carry = 0;
+        for(int word = 0; word < _words; word++)
+        {
+            quint64 skipping = states[word] & _loopStates.at(word);
+            quint64 added = ((skipping << 1) | carry) & ~states[word];
+            carry = skipping >> 63;
+            if(added)
+            {
+                states[word] |= added;
+                changed = true;
+            }
+        }
+    }
+}
+
+/*!
+ * \brief GlobMatcher::PatternSet::_runAutomaton
+ * \param[in] name Name bytes
+ * \param[in] length Name length
+ * \return "true" if the name matches any automaton pattern
+ */
+bool GlobMatcher::PatternSet::_runAutomaton(const char *name, int length) const
+{
+    quint64 stackStates[2 * stack_state_words];
+    std::vector<quint64> heapStates;
+    quint64 *active = stackStates;
+    if(_words > stack_state_words)
+    {
+        heapStates.resize(2 * _words);
+        active = heapStates.data();
+    }
+    quint64 *next = active + _words;
+
+    memcpy(active, _start.constData(), _words * sizeof(quint64));
+
+    for(int pos = 0; pos < length; pos++)
+    {
+        const int byte = uchar(name[pos]);
+        const quint64 *advance = _advance.constData() + byte * _words;
+        const quint64 *loop = _loop.constData() + byte * _words;
+
+        quint64 carry = 0;
+        quint64 any = 0;
+        for(int word = 0; word < _words; word++)
+        {
+            quint64 moved = active[word] & advance[word];
+            next[word] = (moved << 1) | carry | (active[word] & loop[word]);
+            carry = moved >> 63;
+            any |= next[word];
+        }
+
+        /* No pattern can match the rest of the name */
+        if(!any)
+        {
+            return false;
+        }
+
+        _close(next);
+        qSwap(active, next);
+    }
+
+    for(int word = 0; word < _words; word++)
+    {
+        if(active[word] & _accept.at(word))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*!
+ * \brief GlobMatcher::PatternSet::isEmpty
+ * \return "true" if there are no patterns
+ */
+bool GlobMatcher::PatternSet::isEmpty() const
+{
+    return _literals.isEmpty() && _suffixes.isEmpty() && _regExps.isEmpty() && _words == 0;
+}
+
+/*!
+ * \brief GlobMatcher::PatternSet::matches
+ * \param[in] name Name bytes
+ * \param[in] length Name length
+ * \return "true" if the name matches any pattern of the set
+ */
+bool GlobMatcher::PatternSet::matches(const char *name, int length) const
+{
+    foreach (const QByteArray &literal, _literals) {
+        if(literal.size() == length && equalsFolded(name, literal.constData(), length))
+        {
+            return true;
+        }
+    }
+
+    /* "*.ext" patterns are checked without the automaton */
+    foreach (const QByteArray &suffix, _suffixes) {
+        if(suffix.size() <= length && equalsFolded(name + length - suffix.size(), suffix.constData(), suffix.size()))
+        {
+            return true;
+        }
+    }
+
+    if(_words > 0 && _runAutomaton(name, length))
+    {
+        return true;
+    }
+
+    if(!_regExps.isEmpty())
+    {
+        QString decodedName = QFile::decodeName(QByteArray(name, length));
+        foreach (const QRegExp &regExp, _regExps) {
+            if(regExp.exactMatch(decodedName))
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/*!
+ * \brief GlobMatcher::GlobMatcher
+ *
+ * GlobMatcher Constructor, an empty matcher matches any name
+ */
+GlobMatcher::GlobMatcher()
+{
+}
+
+/*!
+ * \brief GlobMatcher::GlobMatcher
+ * \param[in] includes Wildcard patterns of names to match, any name matches if it is empty
+ * \param[in] excludes Wildcard patterns of names not to match
+ *
+ * GlobMatcher Constructor
+ */
+GlobMatcher::GlobMatcher(const QStringList &includes, const QStringList &excludes)
+{
+    const bool utf8 = (QTextCodec::codecForLocale()->mibEnum() == 106);     /*!< UTF-8 MIB enum */
+
+    _includePatterns = includes;
+    _excludePatterns = excludes;
+    _includes.compile(includes, utf8);
+    _excludes.compile(excludes, utf8);
+}
+
+/*!
+ * \brief GlobMatcher::isEmpty
+ * \return "true" if there are no patterns & any name matches
+ */
+bool GlobMatcher::isEmpty() const
+{
+    return _includes.isEmpty() && _excludes.isEmpty();
+}
+
+/*!
+ * \brief GlobMatcher::matches
+ * \param[in] name Raw name bytes as they are read from a directory
+ * \param[in] length Name length
+ * \return "true" if the name is included & not excluded
+ */
+bool GlobMatcher::matches(const char *name, int length) const
+{
+    if(!_includes.isEmpty() && !_includes.matches(name, length))
+    {
+        return false;
+    }
+    return _excludes.isEmpty() || !_excludes.matches(name, length);
+}
+
+/*!
+ * \brief GlobMatcher::matches
+ * \param[in] name Raw name bytes
+ * \return "true" if the name is included & not excluded
+ */
+bool GlobMatcher::matches(const QByteArray &name) const
+{
+    return matches(name.constData(), name.size());
+}
+
+/*!
+ * \brief GlobMatcher::signature
+ * \return A text identifying the pattern lists
+ */
+QString GlobMatcher::signature() const
+{
+    QString result = _includePatterns.join(QChar('|'));
+    foreach (const QString &pattern, _excludePatterns) {
+        result.append(QLatin1String("|!")).append(pattern);
+    }
+    return result;
+}
+
+/*!
+ * \brief GlobMatcher::setPredicate
+ * \param[in] predicate A compiled file predicate or null
+ *
+ * The predicate is shared by copies of the matcher.
+ */
+void GlobMatcher::setPredicate(const QSharedPointer<const FilePredicate> &predicate)
+{
+    _predicate = predicate;
+}
+
+/*!
+ * \brief GlobMatcher::predicate
+ * \return The file predicate or "nullptr" if files are filtered by names only
+ */
+const FilePredicate *GlobMatcher::predicate() const
+{
+    return _predicate.data();
+}
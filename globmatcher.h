@@ -0,0 +1,86 @@
+/*! \file       globmatcher.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      Glob Matcher module header file.
+ *
+ *  This file contains the GlobMatcher class declaration.
+ */
+
+#ifndef GLOBMATCHER_H
+#define GLOBMATCHER_H
+
+#include <QtCore/qglobal.h>
+
+#include <QByteArray>
+#include <QRegExp>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class FilePredicate;
+
+/*! \class GlobMatcher
+ *  \brief Compiled file name pattern matcher class.
+ *
+ *  This class matches raw file names against include & exclude wildcard
+ *  patterns. A name matches if it matches any include pattern (or there
+ *  are no include patterns) & doesn't match any exclude pattern. Matching
+ *  ignores ASCII case the same way QDir name filters do.
+ *
+ *  Literal names & "*suffix" patterns are compared directly, the other
+ *  patterns are compiled into one automaton run once over the name bytes.
+ *  Patterns with non-ASCII sets are matched by QRegExp on decoded names.
+ *
+ *  A matcher may carry a file predicate over stated fields, directory
+ *  readers apply it with the patterns, so it reaches them everywhere
+ *  the matcher does. matches() checks the patterns only.
+ */
+class GlobMatcher
+{
+    public:
+        GlobMatcher();
+        GlobMatcher(const QStringList &includes, const QStringList &excludes);
+        bool isEmpty() const;
+        bool matches(const char *name, int length) const;
+        bool matches(const QByteArray &name) const;
+        QString signature() const;
+        void setPredicate(const QSharedPointer<const FilePredicate> &predicate);
+        const FilePredicate *predicate() const;
+    private:
+        /*! \class PatternSet
+         *  \brief A set of patterns compiled together.
+         */
+        class PatternSet
+        {
+            public:
+                PatternSet();
+                void compile(const QStringList &patterns, bool utf8);
+                bool isEmpty() const;
+                bool matches(const char *name, int length) const;
+            private:
+                QVector<QByteArray> _literals;      /*!< Whole names in lower case */
+                QVector<QByteArray> _suffixes;      /*!< Name suffixes in lower case */
+                QVector<QRegExp> _regExps;          /*!< Patterns the automaton can't match */
+
+                int _words;                         /*!< Automaton state set size in 64 bit words */
+                QVector<quint64> _advance;          /*!< States moving to the next one by a byte, per byte */
+                QVector<quint64> _loop;             /*!< States staying by a byte, per byte */
+                QVector<quint64> _loopStates;       /*!< States which may be skipped */
+                QVector<quint64> _start;            /*!< Initial states */
+                QVector<quint64> _accept;           /*!< Final states */
+
+                bool _compileAutomaton(const QVector<QByteArray> &patterns, bool utf8);
+                bool _runAutomaton(const char *name, int length) const;
+                void _close(quint64 *states) const;
+        };
+
+        QStringList _includePatterns;   /*!< Source include patterns */
+        QStringList _excludePatterns;   /*!< Source exclude patterns */
+        PatternSet _includes;           /*!< Compiled include patterns */
+        PatternSet _excludes;           /*!< Compiled exclude patterns */
+        QSharedPointer<const FilePredicate> _predicate;  /*!< A file predicate applied by readers or null */
+};
+
+#endif // GLOBMATCHER_H
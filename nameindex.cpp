@@ -0,0 +1,934 @@
+/*! \file       nameindex.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief Name Index module source file.
+ *
+ *  This file contains the NameIndexBuilder & NameIndex class source code.
+ */
+
+#include "nameindex.h"
+#include "globmatcher.h"
+#include "outputwriter.h"
+#include "recordformat.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QPair>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <iterator>
+#include <queue>
+#include <vector>
+#include <string.h>
+
+/* Name index magic & format version */
+static const char name_index_magic[4] = { 'T', 'D', 'N', 'I' };
+static const quint32 name_index_version = 1;
+
+/* Table record sizes */
+static const int header_size = 72;
+static const int dir_record_size = 24;
+static const int file_record_size = 40;
+static const int trigram_record_size = 12;
+
+/* Output is written by chunks of this size */
+static const int write_chunk_size = 64 * 1024;
+
+/* Trigram & file number pairs kept in memory before a sorted run is spilled, 128 MB */
+static const int trigram_run_size = 16 * 1024 * 1024;
+
+/* The name table stays below the container size limit */
+static const int name_table_limit = 0x7F000000;
+
+const quint32 NameIndexBuilder::no_trigram;
+const quint32 NameIndex::no_parent;
+
+/*!
+ * \brief foldByte
+ * \param[in] byte A byte to fold
+ * \return The byte in lower case if it is an ASCII letter
+ */
+static inline quint32 foldByte(uchar byte)
+{
+    return (byte >= 'A' && byte <= 'Z') ? byte + ('a' - 'A') : byte;
+}
+
+/*!
+ * \brief appendTrigrams
+ * \param[out] trigrams A list to append trigrams to
+ * \param[in] text Bytes to take trigrams of
+ * \param[in] length The text size
+ */
+static void appendTrigrams(QVector<quint32> &trigrams, const char *text, int length)
+{
+    for(int pos = 0; pos + 3 <= length; pos++)
+    {
+        trigrams.append((foldByte(uchar(text[pos])) << 16) |
+                        (foldByte(uchar(text[pos + 1])) << 8) |
+                        foldByte(uchar(text[pos + 2])));
+    }
+}
+
+/*!
+ * \brief padTo8
+ * \param[in,out] out A buffer to pad with zeros up to an 8 byte offset
+ * \param[in] offset The file offset of the buffer end
+ * \return The padded file offset
+ */
+static quint64 padTo8(QByteArray &out, quint64 offset)
+{
+    while(offset % 8 != 0)
+    {
+        out.append('\0');
+        offset++;
+    }
+    return offset;
+}
+
+/*!
+ * \brief NameIndexBuilder::NameIndexBuilder
+ *
+ * NameIndexBuilder Constructor
+ */
+NameIndexBuilder::NameIndexBuilder()
+{
+    _fileCount = 0;
+    _fileTable = nullptr;
+}
+
+/*!
+ * \brief NameIndexBuilder::~NameIndexBuilder
+ *
+ * NameIndexBuilder Destructor, temporary files are removed
+ */
+NameIndexBuilder::~NameIndexBuilder()
+{
+    delete _fileTable;
+    qDeleteAll(_runs);
+}
+
+/*!
+ * \brief NameIndexBuilder::fileTrigrams
+ * \param[in] entries Directory entries, subdirectories are skipped
+ * \param[out] trigrams Distinct trigrams of every file name in the entry order,
+ *                      each file ends with no_trigram
+ *
+ * Takes trigrams without the builder, so it may be called on several threads at once.
+ */
+void NameIndexBuilder::fileTrigrams(const QVector<DirEntry> &entries, QVector<quint32> &trigrams)
+{
+    QVector<quint32> nameTrigrams;
+    trigrams.resize(0);
+
+    foreach (const DirEntry &entry, entries) {
+        if(entry.isDir)
+        {
+            continue;
+        }
+
+        /* A trigram repeated in the name is posted once */
+        nameTrigrams.resize(0);
+        appendTrigrams(nameTrigrams, entry.name.constData(), entry.name.size());
+        std::sort(nameTrigrams.begin(), nameTrigrams.end());
+        for(int trigramNum = 0; trigramNum < nameTrigrams.count(); trigramNum++)
+        {
+            if(trigramNum == 0 || nameTrigrams.at(trigramNum) != nameTrigrams.at(trigramNum - 1))
+            {
+                trigrams.append(nameTrigrams.at(trigramNum));
+            }
+        }
+        trigrams.append(no_trigram);
+    }
+}
+
+/*!
+ * \brief NameIndexBuilder::addDir
+ * \param[in] parent The parent directory number, NameIndex::no_parent for the root
+ * \param[in] name A raw directory name, the absolute path for the root
+ * \param[in] mtimeNsecs The directory modification time in nanoseconds since epoch
+ * \return The directory number
+ *
+ * The parent must be added before its subdirectories.
+ */
+quint32 NameIndexBuilder::addDir(quint32 parent, const QByteArray &name, qint64 mtimeNsecs)
+{
+    DirRecord record;
+    record.parent = parent;
+    record.nameOffset = _intern(name);
+    record.nameSize = quint32(name.size());
+    record.mtimeNsecs = mtimeNsecs;
+    _dirs.append(record);
+    return quint32(_dirs.count() - 1);
+}
+
+/*!
+ * \brief NameIndexBuilder::addFiles
+ * \param[in] dir The directory number
+ * \param[in] entries Directory entries, subdirectories are skipped
+ * \param[in] trigrams Trigrams of the entries taken by fileTrigrams()
+ */
+void NameIndexBuilder::addFiles(quint32 dir, const QVector<DirEntry> &entries, const QVector<quint32> &trigrams)
+{
+    /* A failed build keeps no more files */
+    if(!_errorString.isEmpty())
+    {
+        return;
+    }
+
+    int trigramNum = 0;
+
+    foreach (const DirEntry &entry, entries) {
+        if(entry.isDir)
+        {
+            continue;
+        }
+
+        appendLittleEndian(_fileChunk, dir, 4);
+        appendLittleEndian(_fileChunk, _intern(entry.name), 4);
+        appendLittleEndian(_fileChunk, quint32(entry.name.size()), 4);
+        appendLittleEndian(_fileChunk, entry.mode, 4);
+        appendLittleEndian(_fileChunk, quint64(entry.size), 8);
+        appendLittleEndian(_fileChunk, quint64(entry.mtime * 1000000 + entry.mtimeNsec), 8);
+        appendLittleEndian(_fileChunk, entry.inode, 8);
+
+        const quint64 fileNum = _fileCount++;
+        for(; trigrams.at(trigramNum) != no_trigram; trigramNum++)
+        {
+            _trigrams.append((quint64(trigrams.at(trigramNum)) << 32) | fileNum);
+        }
+        trigramNum++;
+    }
+
+    if(_fileChunk.size() >= write_chunk_size)
+    {
+        _spillFiles();
+    }
+    if(_trigrams.count() >= trigram_run_size)
+    {
+        _spillTrigrams();
+    }
+}
+
+/*!
+ * \brief NameIndexBuilder::save
+ * \param[in] filePath The index file path
+ * \return "false" if the index file can't be written
+ *
+ * Replaces the index file when it has been written completely.
+ */
+bool NameIndexBuilder::save(const QString &filePath)
+{
+    if(!_errorString.isEmpty())
+    {
+        return false;
+    }
+
+    /* The trigram table is taken by the first merge, postings are written by the second one */
+    std::sort(_trigrams.begin(), _trigrams.end());
+
+    QVector<TrigramRecord> trigramTable;
+    quint32 postingCount = 0;
+    bool merged = _mergeTrigrams([&trigramTable, &postingCount](quint64 pair) {
+        const quint32 trigram = quint32(pair >> 32);
+        if(trigramTable.isEmpty() || trigramTable.last().trigram != trigram)
+        {
+            TrigramRecord record;
+            record.trigram = trigram;
+            record.firstPosting = postingCount;
+            record.postingCount = 0;
+            trigramTable.append(record);
+        }
+        trigramTable.last().postingCount++;
+        postingCount++;
+    });
+    if(!merged)
+    {
+        _errorString = "temporary files can't be read back";
+        return false;
+    }
+
+    const quint32 trigramCount = quint32(trigramTable.count());
+    const quint64 namesOffset = header_size;
+    const quint64 dirsOffset = (namesOffset + quint64(_names.size()) + 7) / 8 * 8;
+    const quint64 filesOffset = dirsOffset + quint64(_dirs.count()) * dir_record_size;
+    const quint64 trigramsOffset = filesOffset + quint64(_fileCount) * file_record_size;
+    const quint64 postingsOffset = (trigramsOffset + quint64(trigramCount) * trigram_record_size + 7) / 8 * 8;
+
+    QSaveFile file(filePath);
+    if(!file.open(QIODevice::WriteOnly))
+    {
+        _errorString = "can't be written";
+        return false;
+    }
+
+    OutputWriter out(file.handle());
+    QByteArray chunk;
+    chunk.reserve(write_chunk_size + 64);
+
+    chunk.append(name_index_magic, sizeof(name_index_magic));
+    appendLittleEndian(chunk, name_index_version, 4);
+    appendLittleEndian(chunk, quint32(_dirs.count()), 4);
+    appendLittleEndian(chunk, _fileCount, 4);
+    appendLittleEndian(chunk, trigramCount, 4);
+    appendLittleEndian(chunk, 0, 4);
+    appendLittleEndian(chunk, namesOffset, 8);
+    appendLittleEndian(chunk, quint64(_names.size()), 8);
+    appendLittleEndian(chunk, dirsOffset, 8);
+    appendLittleEndian(chunk, filesOffset, 8);
+    appendLittleEndian(chunk, trigramsOffset, 8);
+    appendLittleEndian(chunk, postingsOffset, 8);
+    out.write(chunk);
+    out.write(_names);
+
+    chunk.resize(0);
+    padTo8(chunk, namesOffset + quint64(_names.size()));
+
+    foreach (const DirRecord &record, _dirs) {
+        appendLittleEndian(chunk, record.parent, 4);
+        appendLittleEndian(chunk, record.nameOffset, 4);
+        appendLittleEndian(chunk, record.nameSize, 4);
+        appendLittleEndian(chunk, 0, 4);
+        appendLittleEndian(chunk, quint64(record.mtimeNsecs), 8);
+        if(chunk.size() >= write_chunk_size)
+        {
+            out.write(chunk);
+            chunk.resize(0);
+        }
+    }
+    out.write(chunk);
+
+    /* Spilled file records go first, the rest is still in memory */
+    bool filesRead = true;
+    if(_fileTable)
+    {
+        _fileTable->seek(0);
+        while(!_fileTable->atEnd())
+        {
+            chunk = _fileTable->read(write_chunk_size);
+            if(chunk.isEmpty())
+            {
+                filesRead = false;
+                break;
+            }
+            out.write(chunk);
+        }
+    }
+    out.write(_fileChunk);
+
+    chunk.resize(0);
+    foreach (const TrigramRecord &record, trigramTable) {
+        appendLittleEndian(chunk, record.trigram, 4);
+        appendLittleEndian(chunk, record.firstPosting, 4);
+        appendLittleEndian(chunk, record.postingCount, 4);
+        if(chunk.size() >= write_chunk_size)
+        {
+            out.write(chunk);
+            chunk.resize(0);
+        }
+    }
+    padTo8(chunk, trigramsOffset + quint64(trigramCount) * trigram_record_size);
+
+    merged = _mergeTrigrams([&chunk, &out](quint64 pair) {
+        appendLittleEndian(chunk, pair & 0xFFFFFFFF, 4);
+        if(chunk.size() >= write_chunk_size)
+        {
+            out.write(chunk);
+            chunk.resize(0);
+        }
+    });
+
+    out.write(chunk);
+    out.flush();
+
+    if(!filesRead || !merged)
+    {
+        file.cancelWriting();
+        _errorString = "temporary files can't be read back";
+        return false;
+    }
+    if(out.hasError() || !file.commit())
+    {
+        file.cancelWriting();
+        _errorString = "can't be written";
+        return false;
+    }
+    return true;
+}
+
+/*!
+ * \brief NameIndexBuilder::errorString
+ * \return Why the index can't be built or saved, empty without an error
+ */
+QString NameIndexBuilder::errorString() const
+{
+    return _errorString;
+}
+
+/*!
+ * \brief NameIndexBuilder::_intern
+ * \param[in] name A raw name
+ * \return The name offset in the name table, equal names share one offset
+ */
+quint32 NameIndexBuilder::_intern(const QByteArray &name)
+{
+    QHash<QByteArray, quint32>::const_iterator stored = _nameOffsets.constFind(name);
+    if(stored != _nameOffsets.constEnd())
+    {
+        return stored.value();
+    }
+
+    /* The build fails instead of growing the table past the container limit */
+    if(_names.size() > name_table_limit - name.size())
+    {
+        _errorString = "can't keep so many names";
+        return 0;
+    }
+
+    quint32 offset = quint32(_names.size());
+    _names.append(name);
+    _nameOffsets.insert(name, offset);
+    return offset;
+}
+
+/*!
+ * \brief NameIndexBuilder::_spillFiles
+ * \return "false" if the file records can't be written to the temporary file
+ */
+bool NameIndexBuilder::_spillFiles()
+{
+    if(!_fileTable)
+    {
+        _fileTable = new QTemporaryFile(QDir(QDir::tempPath()).filePath("tdir-index-XXXXXX"));
+        if(!_fileTable->open())
+        {
+            _errorString = "temporary files can't be written";
+            return false;
+        }
+    }
+
+    if(_fileTable->write(_fileChunk) != _fileChunk.size())
+    {
+        _errorString = "temporary files can't be written";
+        return false;
+    }
+    _fileChunk.resize(0);
+    return true;
+}
+
+/*!
+ * \brief NameIndexBuilder::_spillTrigrams
+ * \return "false" if the trigrams can't be written to a temporary run
+ */
+bool NameIndexBuilder::_spillTrigrams()
+{
+    QTemporaryFile *run = new QTemporaryFile(QDir(QDir::tempPath()).filePath("tdir-index-XXXXXX"));
+    if(!run->open())
+    {
+        delete run;
+        _errorString = "temporary files can't be written";
+        return false;
+    }
+
+    std::sort(_trigrams.begin(), _trigrams.end());
+
+    QDataStream stream(run);
+    foreach (quint64 pair, _trigrams) {
+        stream << pair;
+    }
+
+    if(stream.status() != QDataStream::Ok || !run->flush())
+    {
+        delete run;
+        _errorString = "temporary files can't be written";
+        return false;
+    }
+
+    _runs.append(run);
+    _trigrams.resize(0);
+    return true;
+}
+
+/*!
+ * \brief NameIndexBuilder::_mergeTrigrams
+ * \param[in] consume A function to pass the pairs to
+ * \return "false" if a run can't be read
+ *
+ * Merges spilled runs & sorted pairs in memory with a heap of their current pairs,
+ * so every pair is passed once in ascending order.
+ */
+bool NameIndexBuilder::_mergeTrigrams(const PairFunction &consume)
+{
+    /* A current pair of a source */
+    typedef QPair<quint64, int> Head;
+    auto greater = [](const Head &left, const Head &right) {
+        return right.first < left.first;
+    };
+    std::priority_queue<Head, std::vector<Head>, decltype(greater)> heads(greater);
+
+    bool ok = true;
+    QVector<QDataStream *> streams;
+    for(int runNum = 0; runNum < _runs.count(); runNum++)
+    {
+        _runs.at(runNum)->seek(0);
+        streams.append(new QDataStream(_runs.at(runNum)));
+
+        quint64 pair = 0;
+        *streams.last() >> pair;
+        if(streams.last()->status() == QDataStream::Ok)
+        {
+            heads.push(qMakePair(pair, runNum));
+        }
+        else
+        {
+            ok = false;
+        }
+    }
+
+    /* Pairs in memory are the last source */
+    const int memorySource = _runs.count();
+    int nextPair = 0;
+    if(nextPair < _trigrams.count())
+    {
+        heads.push(qMakePair(_trigrams.at(nextPair++), memorySource));
+    }
+
+    /* A short run stops the merge, every spilled run has at least one pair */
+    while(ok && !heads.empty())
+    {
+        Head head = heads.top();
+        heads.pop();
+        consume(head.first);
+
+        if(head.second == memorySource)
+        {
+            if(nextPair < _trigrams.count())
+            {
+                heads.push(qMakePair(_trigrams.at(nextPair++), memorySource));
+            }
+            continue;
+        }
+
+        QDataStream *stream = streams.at(head.second);
+        if(!stream->atEnd())
+        {
+            quint64 pair = 0;
+            *stream >> pair;
+            if(stream->status() == QDataStream::Ok)
+            {
+                heads.push(qMakePair(pair, head.second));
+            }
+            else
+            {
+                ok = false;
+            }
+        }
+    }
+
+    qDeleteAll(streams);
+    return ok;
+}
+
+/*!
+ * \brief NameIndex::NameIndex
+ * \param[in] filePath A name index file path
+ *
+ * NameIndex Constructor
+ */
+NameIndex::NameIndex(const QString &filePath) : _file(filePath)
+{
+    _data = nullptr;
+    _size = 0;
+    _dirCount = 0;
+    _fileCount = 0;
+    _trigramCount = 0;
+    _names = nullptr;
+    _namesSize = 0;
+    _dirs = nullptr;
+    _files = nullptr;
+    _trigrams = nullptr;
+    _postings = nullptr;
+    _postingCount = 0;
+}
+
+/*!
+ * \brief NameIndex::~NameIndex
+ *
+ * NameIndex Destructor
+ */
+NameIndex::~NameIndex()
+{
+    if(_data)
+    {
+        _file.unmap(_data);
+    }
+}
+
+/*!
+ * \brief NameIndex::open
+ * \return "false" if the file can't be mapped or it is not a name index
+ *
+ * Maps the file & checks that all tables are inside it.
+ */
+bool NameIndex::open()
+{
+    if(!_file.open(QIODevice::ReadOnly))
+    {
+        _errorString = "can't be opened";
+        return false;
+    }
+
+    _size = _file.size();
+    if(_size < header_size)
+    {
+        _errorString = "isn't a name index file";
+        return false;
+    }
+
+    _data = _file.map(0, _size);
+    if(_data == nullptr)
+    {
+        _errorString = "can't be mapped";
+        return false;
+    }
+
+    const char *header = reinterpret_cast<const char *>(_data);
+    if(memcmp(header, name_index_magic, sizeof(name_index_magic)) != 0)
+    {
+        _errorString = "isn't a name index file";
+        return false;
+    }
+    if(quint32(readLittleEndian(header + 4, 4)) != name_index_version)
+    {
+        _errorString = "has an unsupported name index version";
+        return false;
+    }
+
+    _dirCount = quint32(readLittleEndian(header + 8, 4));
+    _fileCount = quint32(readLittleEndian(header + 12, 4));
+    _trigramCount = quint32(readLittleEndian(header + 16, 4));
+    quint64 namesOffset = readLittleEndian(header + 24, 8);
+    _namesSize = readLittleEndian(header + 32, 8);
+    quint64 dirsOffset = readLittleEndian(header + 40, 8);
+    quint64 filesOffset = readLittleEndian(header + 48, 8);
+    quint64 trigramsOffset = readLittleEndian(header + 56, 8);
+    quint64 postingsOffset = readLittleEndian(header + 64, 8);
+
+    const quint64 size = quint64(_size);
+    if(namesOffset > size || _namesSize > size - namesOffset ||
+       dirsOffset > size || quint64(_dirCount) * dir_record_size > size - dirsOffset ||
+       filesOffset > size || quint64(_fileCount) * file_record_size > size - filesOffset ||
+       trigramsOffset > size || quint64(_trigramCount) * trigram_record_size > size - trigramsOffset ||
+       postingsOffset > size || _dirCount == 0)
+    {
+        _errorString = "is truncated or damaged";
+        return false;
+    }
+
+    _names = header + namesOffset;
+    _dirs = header + dirsOffset;
+    _files = header + filesOffset;
+    _trigrams = header + trigramsOffset;
+    _postings = header + postingsOffset;
+    _postingCount = (size - postingsOffset) / 4;
+    return true;
+}
+
+/*!
+ * \brief NameIndex::fileCount
+ * \return Number of indexed files
+ */
+quint32 NameIndex::fileCount() const
+{
+    return _fileCount;
+}
+
+/*!
+ * \brief NameIndex::query
+ * \param[in] includes Wildcard patterns of names to find, all files if it is empty
+ * \param[in] excludes Wildcard patterns of names to skip
+ * \param[in] consume A function to pass found files to in the file table order
+ *
+ * Files of a damaged record are skipped.
+ */
+void NameIndex::query(const QStringList &includes, const QStringList &excludes, const FileFunction &consume)
+{
+    GlobMatcher matcher(includes, excludes);
+
+    /* Candidates of all include patterns, every file is a candidate if a pattern has no trigrams */
+    bool scanAll = includes.isEmpty();
+    QVector<quint32> candidates;
+    foreach (const QString &mask, includes) {
+        QVector<quint32> files;
+        if(!_candidates(mask, files))
+        {
+            scanAll = true;
+            break;
+        }
+
+        QVector<quint32> merged;
+        merged.reserve(candidates.count() + files.count());
+        std::set_union(candidates.constBegin(), candidates.constEnd(),
+                       files.constBegin(), files.constEnd(), std::back_inserter(merged));
+        candidates.swap(merged);
+    }
+
+    _dirStates.fill(0, int(_dirCount));
+    _changedDir.clear();
+    _checkDir(0);
+
+    const quint32 count = scanAll ? _fileCount : quint32(candidates.count());
+    quint32 lastDir = no_parent;
+    QByteArray dirPath;
+    QByteArray path;
+    DirEntry entry;
+    entry.isDir = false;
+    entry.blocks = 0;
+    entry.ctime = 0;
+    entry.uid = 0;
+    entry.links = 0;
+    entry.isLink = false;
+
+    for(quint32 candidateNum = 0; candidateNum < count; candidateNum++)
+    {
+        const quint32 fileNum = scanAll ? candidateNum : candidates.at(int(candidateNum));
+        const char *record = _files + quint64(fileNum) * file_record_size;
+        const quint32 dir = quint32(readLittleEndian(record, 4));
+        const quint64 nameOffset = readLittleEndian(record + 4, 4);
+        const quint64 nameSize = readLittleEndian(record + 8, 4);
+
+        if(dir >= _dirCount || nameOffset + nameSize > _namesSize ||
+           !matcher.matches(_names + nameOffset, int(nameSize)))
+        {
+            continue;
+        }
+
+        _checkDir(dir);
+        if(dir != lastDir)
+        {
+            dirPath.resize(0);
+            _appendPath(dirPath, dir);
+            lastDir = dir;
+        }
+
+        /* Milliseconds are rounded down for times before epoch too */
+        qint64 mtimeNsecs = qint64(readLittleEndian(record + 24, 8));
+        qint64 mtimeMsecs = mtimeNsecs / 1000000;
+        if(mtimeNsecs % 1000000 < 0)
+        {
+            mtimeMsecs--;
+        }
+
+        entry.mode = (unsigned int)readLittleEndian(record + 12, 4);
+        entry.size = qint64(readLittleEndian(record + 16, 8));
+        entry.mtime = mtimeMsecs;
+        entry.mtimeNsec = int(mtimeNsecs - mtimeMsecs * 1000000);
+        entry.inode = readLittleEndian(record + 32, 8);
+
+        path = dirPath;
+        path.append(_names + nameOffset, int(nameSize));
+        consume(path, entry);
+    }
+}
+
+/*!
+ * \brief NameIndex::changedDir
+ * \return A directory changed since the index was built or an empty path if none was found
+ *
+ * Only the root & directories of files found by query() are checked.
+ */
+const QByteArray &NameIndex::changedDir() const
+{
+    return _changedDir;
+}
+
+/*!
+ * \brief NameIndex::errorString
+ * \return Why open() failed, like "has an unsupported name index version", empty without an error
+ */
+QString NameIndex::errorString() const
+{
+    return _errorString;
+}
+
+/*!
+ * \brief NameIndex::_candidates
+ * \param[in] mask A wildcard pattern
+ * \param[out] files Sorted numbers of files having all trigrams of literal pattern parts
+ * \return "false" if the pattern has no trigrams, so every file is a candidate
+ *
+ * Literal parts end at wildcards, sets & non-ASCII characters,
+ * the latter are compared ignoring case by the matcher only.
+ */
+bool NameIndex::_candidates(const QString &mask, QVector<quint32> &files) const
+{
+    QByteArray bytes = QFile::encodeName(mask);
+    QVector<quint32> trigrams;
+
+    int runStart = 0;
+    for(int pos = 0; pos <= bytes.size(); pos++)
+    {
+        const uchar byte = (pos < bytes.size()) ? uchar(bytes.at(pos)) : uchar('*');
+        if(byte != '*' && byte != '?' && byte != '[' && byte < 0x80)
+        {
+            continue;
+        }
+
+        appendTrigrams(trigrams, bytes.constData() + runStart, pos - runStart);
+        runStart = pos + 1;
+
+        /* A set is skipped up to its closing bracket, the rest of an open set is not used */
+        if(byte == '[')
+        {
+            int close = bytes.indexOf(']', pos + 2);
+            if(close < 0)
+            {
+                break;
+            }
+            pos = close;
+            runStart = close + 1;
+        }
+    }
+
+    if(trigrams.isEmpty())
+    {
+        return false;
+    }
+
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+
+    /* Posting lists are found by a binary search & intersected from the shortest one */
+    QVector<QPair<quint32, quint32> > lists;
+    foreach (quint32 trigram, trigrams) {
+        quint32 low = 0;
+        quint32 high = _trigramCount;
+        while(low < high)
+        {
+            quint32 middle = low + (high - low) / 2;
+            if(quint32(readLittleEndian(_trigrams + quint64(middle) * trigram_record_size, 4)) < trigram)
+            {
+                low = middle + 1;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+
+        const char *record = _trigrams + quint64(low) * trigram_record_size;
+        if(low == _trigramCount || quint32(readLittleEndian(record, 4)) != trigram)
+        {
+            files.clear();
+            return true;
+        }
+
+        quint32 first = quint32(readLittleEndian(record + 4, 4));
+        quint32 postings = quint32(readLittleEndian(record + 8, 4));
+        if(quint64(first) + postings > _postingCount)
+        {
+            files.clear();
+            return true;
+        }
+        lists.append(qMakePair(postings, first));
+    }
+    std::sort(lists.begin(), lists.end());
+
+    files.resize(0);
+    for(quint32 postingNum = 0; postingNum < lists.at(0).first; postingNum++)
+    {
+        quint32 fileNum = quint32(readLittleEndian(_postings + (quint64(lists.at(0).second) + postingNum) * 4, 4));
+        if(fileNum < _fileCount)
+        {
+            files.append(fileNum);
+        }
+    }
+
+    for(int listNum = 1; listNum < lists.count() && !files.isEmpty(); listNum++)
+    {
+        const char *postings = _postings + quint64(lists.at(listNum).second) * 4;
+        const quint32 postingCount = lists.at(listNum).first;
+        quint32 postingNum = 0;
+        int kept = 0;
+        for(int fileNum = 0; fileNum < files.count() && postingNum < postingCount; fileNum++)
+        {
+            while(postingNum < postingCount &&
+                  quint32(readLittleEndian(postings + quint64(postingNum) * 4, 4)) < files.at(fileNum))
+            {
+                postingNum++;
+            }
+            if(postingNum < postingCount &&
+               quint32(readLittleEndian(postings + quint64(postingNum) * 4, 4)) == files.at(fileNum))
+            {
+                files[kept++] = files.at(fileNum);
+            }
+        }
+        files.resize(kept);
+    }
+    return true;
+}
+
+/*!
+ * \brief NameIndex::_appendPath
+ * \param[out] out A buffer to append the directory path ending with a separator to
+ * \param[in] dir The directory number
+ */
+void NameIndex::_appendPath(QByteArray &out, quint32 dir) const
+{
+    const char *record = _dirs + quint64(dir) * dir_record_size;
+    const quint32 parent = quint32(readLittleEndian(record, 4));
+    const quint64 nameOffset = readLittleEndian(record + 4, 4);
+    const quint64 nameSize = readLittleEndian(record + 8, 4);
+
+    /* Parents are added before subdirectories, so a damaged chain can't loop */
+    if(parent != no_parent && parent < dir)
+    {
+        _appendPath(out, parent);
+    }
+
+    if(nameOffset + nameSize <= _namesSize)
+    {
+        out.append(_names + nameOffset, int(nameSize));
+    }
+    if(!out.endsWith('/'))
+    {
+        out.append('/');
+    }
+}
+
+/*!
+ * \brief NameIndex::_checkDir
+ * \param[in] dir The directory number
+ *
+ * Compares the directory modification time with the indexed one once.
+ */
+void NameIndex::_checkDir(quint32 dir)
+{
+    if(_dirStates.at(int(dir)) != 0)
+    {
+        return;
+    }
+
+    QByteArray path;
+    _appendPath(path, dir);
+    if(path.size() > 1)
+    {
+        path.chop(1);
+    }
+
+    qint64 mtime = 0;
+    qint64 ctime = 0;
+    const qint64 indexed = qint64(readLittleEndian(_dirs + quint64(dir) * dir_record_size + 16, 8));
+    if(DirReader::statDir(QFile::decodeName(path), mtime, ctime) && mtime == indexed)
+    {
+        _dirStates[int(dir)] = 1;
+        return;
+    }
+
+    _dirStates[int(dir)] = 2;
+    if(_changedDir.isEmpty())
+    {
+        _changedDir = path;
+    }
+}
@@ -0,0 +1,164 @@
+/*! \file       nameindex.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      Name Index module header file.
+ *
+ *  This file contains the NameIndexBuilder & NameIndex class declarations.
+ *
+ *  A name index is a file of fixed size tables read in place from a memory
+ *  mapping. All numbers are little-endian, tables start at 8 byte offsets:
+ *      header      char[4] magic "TDNI", quint32 version, quint32 dir_count,
+ *                  quint32 file_count, quint32 trigram_count, quint32 reserved,
+ *                  quint64 names_offset, quint64 names_size, quint64 dirs_offset,
+ *                  quint64 files_offset, quint64 trigrams_offset, quint64 postings_offset
+ *      names       raw names one after another, every name is stored once
+ *      dirs        quint32 parent (0xFFFFFFFF for the root), quint32 name_offset,
+ *                  quint32 name_size, quint32 reserved, qint64 mtime_nsecs
+ *      files       quint32 dir, quint32 name_offset, quint32 name_size, quint32 mode,
+ *                  qint64 size, qint64 mtime_nsecs, quint64 inode
+ *      trigrams    quint32 trigram, quint32 first_posting, quint32 posting_count
+ *                  sorted by the trigram
+ *      postings    quint32 file numbers in the file table order per trigram
+ *  The root directory name is its absolute path, paths of other directories
+ *  are their parent paths & names. A trigram is three bytes of a file name
+ *  with ASCII letters in lower case, the first byte is the highest one.
+ */
+
+#ifndef NAMEINDEX_H
+#define NAMEINDEX_H
+
+#include <QtCore/qglobal.h>
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QTemporaryFile>
+#include <QVector>
+
+#include <functional>
+
+#include "dirreader.h"
+
+/*! \class NameIndexBuilder
+ *  \brief Name index file builder class.
+ *
+ *  This class collects directories & names of a listed tree in memory &
+ *  writes them as a name index. File records are spilled to a temporary
+ *  file as they are added & file name trigrams to sorted temporary runs
+ *  merged when the index is saved, so trees of any size are indexed.
+ *  Trigrams are taken by fileTrigrams() without the builder, so listing
+ *  threads take them before they serialize calls to the builder.
+ */
+class NameIndexBuilder
+{
+    public:
+        /*! The end of trigrams of one file name */
+        static const quint32 no_trigram = 0xFFFFFFFF;
+
+        NameIndexBuilder();
+        ~NameIndexBuilder();
+        static void fileTrigrams(const QVector<DirEntry> &entries, QVector<quint32> &trigrams);
+        quint32 addDir(quint32 parent, const QByteArray &name, qint64 mtimeNsecs);
+        void addFiles(quint32 dir, const QVector<DirEntry> &entries, const QVector<quint32> &trigrams);
+        bool save(const QString &filePath);
+        QString errorString() const;
+    private:
+        /*! \struct DirRecord
+         *  \brief An indexed directory.
+         */
+        struct DirRecord
+        {
+            quint32 parent;         /*!< A parent directory number */
+            quint32 nameOffset;     /*!< The name offset in the name table */
+            quint32 nameSize;       /*!< The name size */
+            qint64 mtimeNsecs;      /*!< The modification time in nanoseconds since epoch */
+        };
+
+        /*! \struct TrigramRecord
+         *  \brief A trigram with its posting list.
+         */
+        struct TrigramRecord
+        {
+            quint32 trigram;        /*!< A trigram */
+            quint32 firstPosting;   /*!< The first posting number */
+            quint32 postingCount;   /*!< Number of postings */
+        };
+
+        /*! A merged trigram & file number pair function */
+        typedef std::function<void (quint64 pair)> PairFunction;
+
+        QByteArray _names;                  /*!< The name table */
+        QHash<QByteArray, quint32> _nameOffsets; /*!< Offsets of stored names */
+        QVector<DirRecord> _dirs;           /*!< Indexed directories */
+        quint32 _fileCount;                 /*!< Number of indexed files */
+        QByteArray _fileChunk;              /*!< Encoded file records not spilled yet */
+        QTemporaryFile *_fileTable;         /*!< Spilled file records or null */
+        QVector<quint64> _trigrams;         /*!< File name trigrams above file numbers not spilled yet */
+        QList<QTemporaryFile *> _runs;      /*!< Spilled sorted trigram runs */
+        QString _errorString;               /*!< Why the index can't be built, empty without an error */
+
+        quint32 _intern(const QByteArray &name);
+        bool _spillFiles();
+        bool _spillTrigrams();
+        bool _mergeTrigrams(const PairFunction &consume);
+
+        Q_DISABLE_COPY(NameIndexBuilder)
+};
+
+/*! \class NameIndex
+ *  \brief Name index file query class.
+ *
+ *  This class answers file mask queries from a mapped name index without
+ *  reading directories. Trigrams of literal mask parts select candidate
+ *  files by intersecting sorted posting lists, masks without such parts
+ *  are matched against every file name. Matching names are checked by
+ *  the same matcher as listed ones, so results equal a listing of the
+ *  tree when it was indexed. Directories of found files & the root are
+ *  stated to tell if the index is older than the tree.
+ */
+class NameIndex
+{
+    public:
+        /*! A found file function */
+        typedef std::function<void (const QByteArray &path, const DirEntry &entry)> FileFunction;
+
+        /*! The parent number of the root directory */
+        static const quint32 no_parent = 0xFFFFFFFF;
+
+        explicit NameIndex(const QString &filePath);
+        ~NameIndex();
+        bool open();
+        quint32 fileCount() const;
+        void query(const QStringList &includes, const QStringList &excludes, const FileFunction &consume);
+        const QByteArray &changedDir() const;
+        QString errorString() const;
+    private:
+        QFile _file;                        /*!< The index file */
+        uchar *_data;                       /*!< The mapped file or null */
+        qint64 _size;                       /*!< The file size */
+        quint32 _dirCount;                  /*!< Number of directories */
+        quint32 _fileCount;                 /*!< Number of files */
+        quint32 _trigramCount;              /*!< Number of trigrams */
+        const char *_names;                 /*!< The name table */
+        quint64 _namesSize;                 /*!< The name table size */
+        const char *_dirs;                  /*!< The directory table */
+        const char *_files;                 /*!< The file table */
+        const char *_trigrams;              /*!< The trigram table */
+        const char *_postings;              /*!< The posting table */
+        quint64 _postingCount;              /*!< Number of postings */
+        QVector<char> _dirStates;           /*!< 0 - not checked, 1 - unchanged, 2 - changed, per directory */
+        QByteArray _changedDir;             /*!< The first found changed directory path or empty */
+        QString _errorString;               /*!< Why the file can't be opened, empty without an error */
+
+        bool _candidates(const QString &mask, QVector<quint32> &files) const;
+        void _appendPath(QByteArray &out, quint32 dir) const;
+        void _checkDir(quint32 dir);
+
+        Q_DISABLE_COPY(NameIndex)
+};
+
+#endif // NAMEINDEX_H
@@ -1,25 +1,55 @@
-/*! \file       exitcodes.h
- *  \author     Yury Osipov (yusosipov@ya.ru)
- *  \version    1.0.0.1
- *  \date       August, 2018
- *  \brief      Options header file.
- *
- *  This file contains the set of options for the application launch.
- */
-
-#ifndef OPTIONS_H
-#define OPTIONS_H
-
-/*! \enum TdirOptEnum
- *  \brief Tdir options enum.
- *
- *  This enum contains options to call on application launch.
- */
-enum TdirOptEnum
-{
-    TDIR_OPT_RECURSIVE,      /*!< No error occured */
-    TDIR_OPT_HELP,           /*!< Some options were misordered */
-    TDIR_OPT_UNKNOWN,        /*!< Unknown option was found */
-};
-
-#endif // OPTIONS_H
+/*! \file       exitcodes.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      Options header file.
+ *
+ *  This file contains the set of options for the application launch.
+ */
+
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+/*! \enum TdirOptEnum
+ *  \brief Tdir options enum.
+ *
+ *  This enum contains options to call on application launch.
+ */
+enum TdirOptEnum
+{
+    TDIR_OPT_RECURSIVE,      /*!< No error occured */
+    TDIR_OPT_HELP,           /*!< Some options were misordered */
+    TDIR_OPT_JOBS,           /*!< Number of parallel traversal jobs */
+    TDIR_OPT_UNORDERED,      /*!< Parallel traversal output is not ordered */
+    TDIR_OPT_LINE_BUFFERED,  /*!< Output is flushed after every directory */
+    TDIR_OPT_INDEX,          /*!< A persistent tree index file */
+    TDIR_OPT_WATCH,          /*!< Report changed files after enumeration */
+    TDIR_OPT_IO_URING,       /*!< Stat files in io_uring batches */
+    TDIR_OPT_INCLUDE,        /*!< A file mask to include, may be repeated */
+    TDIR_OPT_EXCLUDE,        /*!< A file mask to exclude, may be repeated */
+    TDIR_OPT_MAX_DEPTH,      /*!< Maximal recursion depth */
+    TDIR_OPT_SUMMARIZE,      /*!< Show directory size totals instead of files */
+    TDIR_OPT_DEPTH,          /*!< Maximal depth of shown directory totals */
+    TDIR_OPT_TOP,            /*!< Show first files in the sort order only */
+    TDIR_OPT_SORT,           /*!< Show all files in the sort order */
+    TDIR_OPT_BY,             /*!< A field to sort files by */
+    TDIR_OPT_FORMAT,         /*!< Output format */
+    TDIR_OPT_STATS,          /*!< Write scan statistics */
+    TDIR_OPT_PROGRESS,       /*!< Write progress lines */
+    TDIR_OPT_DUPES,          /*!< Show duplicate file groups instead of files */
+    TDIR_OPT_WHERE,          /*!< A file predicate expression */
+    TDIR_OPT_NO_PIPELINE,    /*!< Format & write output on the enumerating thread */
+    TDIR_OPT_ONE_FILE_SYSTEM,/*!< Don't enter directories on other file systems */
+    TDIR_OPT_SKIP_FSTYPE,    /*!< File system types not to enter, may be repeated */
+    TDIR_OPT_LINKS_ONCE,     /*!< List a file with several hard links once */
+    TDIR_OPT_SNAPSHOT,       /*!< Write a sorted snapshot file instead of listing files */
+    TDIR_OPT_DIFF,           /*!< Compare two snapshot files */
+    TDIR_OPT_NAME_INDEX,     /*!< Write a name index file instead of listing files */
+    TDIR_OPT_QUERY,          /*!< Find files by a mask in a name index file */
+    TDIR_OPT_INODE_ORDER,    /*!< Stat files & enter subdirectories in inode order */
+    TDIR_OPT_DEVICE_JOBS,    /*!< Maximal parallel directory scans per device */
+    TDIR_OPT_FROM_FILE,      /*!< A file to read start directories from */
+    TDIR_OPT_UNKNOWN,        /*!< Unknown option was found */
+};
+
+#endif // OPTIONS_H
@@ -0,0 +1,224 @@
+/*! \file       outputwriter.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief Output Writer module source file.
+ *
+ *  This file contains the OutputWriter class source code.
+ */
+
+#include "outputwriter.h"
+#include "scanstats.h"
+
+#include <errno.h>
+#include <string.h>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/uio.h>
+#endif
+
+/*!
+ * \brief OutputWriter::OutputWriter
+ * \param[in] fd A file descriptor to write to
+ * \param[in] bufferSize Output buffer size in bytes
+ *
+ * OutputWriter Constructor
+ */
+OutputWriter::OutputWriter(int fd, int bufferSize)
+{
+    _fd = fd;
+    _buffer.resize(bufferSize);
+    _used = 0;
+    _lineBuffered = false;                                      /*!< Block buffering by default */
+#ifdef Q_OS_WIN
+    _interactive = _isatty(_fd);                                /*!< Flushing on directory boundaries for terminals */
+#else
+    _interactive = isatty(_fd);                                 /*!< Flushing on directory boundaries for terminals */
+#endif
+    _error = false;
+}
+
+/*!
+ * \brief OutputWriter::~OutputWriter
+ *
+ * OutputWriter Destructor, writes the rest of the buffer
+ */
+OutputWriter::~OutputWriter()
+{
+    flush();
+}
+
+/*!
+ * \brief OutputWriter::setLineBuffered
+ * \param[in] lineBuffered Set to "true" to flush after every written chunk
+ */
+void OutputWriter::setLineBuffered(const bool lineBuffered)
+{
+    _lineBuffered = lineBuffered;
+}
+
+/*!
+ * \brief OutputWriter::isLineBuffered
+ * \return "true" if every written chunk is flushed at once
+ */
+bool OutputWriter::isLineBuffered() const
+{
+    return _lineBuffered;
+}
+
+/*!
+ * \brief OutputWriter::isInteractive
+ * \return "true" if the output is a terminal
+ */
+bool OutputWriter::isInteractive() const
+{
+    return _interactive;
+}
+
+/*!
+ * \brief OutputWriter::hasError
+ * \return "true" if writing has failed
+ */
+bool OutputWriter::hasError() const
+{
+    return _error;
+}
+
+/*!
+ * \brief OutputWriter::write
+ * \param[in] chunk Encoded complete lines to write
+ */
+void OutputWriter::write(const QByteArray &chunk)
+{
+    write(chunk.constData(), chunk.size());
+}
+
+/*!
+ * \brief OutputWriter::write
+ * \param[in] data Encoded complete lines to write
+ * \param[in] size Data size in bytes
+ *
+ * Appends data to the buffer. If it doesn't fit, the buffer & the data
+ * are written at once without copying the data.
+ */
+void OutputWriter::write(const char *data, int size)
+{
+    if(size <= 0)
+    {
+        return;
+    }
+
+    if(_used + size <= _buffer.size())
+    {
+        memcpy(_buffer.data() + _used, data, size);
+        _used += size;
+    }
+    else
+    {
+        _writeAll(_buffer.constData(), _used, data, size);
+        _used = 0;
+    }
+
+    if(_lineBuffered)
+    {
+        flush();
+    }
+}
+
+/*!
+ * \brief OutputWriter::endDirectory
+ *
+ * Marks a directory boundary. The buffer is flushed here only if the
+ * output is a terminal, so a user can see the progress.
+ */
+void OutputWriter::endDirectory()
+{
+    if(_interactive)
+    {
+        flush();
+    }
+}
+
+/*!
+ * \brief OutputWriter::flush
+ *
+ * Writes the buffer content.
+ */
+void OutputWriter::flush()
+{
+    if(_used > 0)
+    {
+        _writeAll(_buffer.constData(), _used, nullptr, 0);
+        _used = 0;
+    }
+}
+
+/*!
+ * \brief OutputWriter::_writeAll
+ * \param[in] first A first block to write
+ * \param[in] firstSize The first block size
+ * \param[in] second A second block to write or nullptr
+ * \param[in] secondSize The second block size
+ *
+ * Writes two blocks with as few system calls as possible,
+ * retrying on partial writes & interrupts.
+ */
+void OutputWriter::_writeAll(const char *first, qint64 firstSize, const char *second, qint64 secondSize)
+{
+    ScanStats::PhaseTimer timer(ScanStats::PHASE_OUTPUT);
+
+    while(!_error && (firstSize > 0 || secondSize > 0))
+    {
+        qint64 written;
+
+#ifdef Q_OS_WIN
+        if(firstSize == 0)
+        {
+            first = second;
+            firstSize = secondSize;
+            second = nullptr;
+            secondSize = 0;
+        }
+        written = _write(_fd, first, static_cast<unsigned int>(firstSize));
+#else
+        struct iovec blocks[2];
+        int blockCount = 0;
+        if(firstSize > 0)
+        {
+            blocks[blockCount].iov_base = const_cast<char *>(first);
+            blocks[blockCount].iov_len = firstSize;
+            blockCount++;
+        }
+        if(secondSize > 0)
+        {
+            blocks[blockCount].iov_base = const_cast<char *>(second);
+            blocks[blockCount].iov_len = secondSize;
+            blockCount++;
+        }
+        written = writev(_fd, blocks, blockCount);
+#endif
+
+        if(written < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            _error = true;
+            break;
+        }
+        ScanStats::add(ScanStats::WRITE_CALLS, 1);
+        ScanStats::add(ScanStats::BYTES_WRITTEN, written);
+
+        /* Skipping written bytes on a partial write */
+        qint64 firstWritten = qMin(written, firstSize);
+        first += firstWritten;
+        firstSize -= firstWritten;
+        written -= firstWritten;
+        second += written;
+        secondSize -= written;
+    }
+}
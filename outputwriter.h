@@ -0,0 +1,51 @@
+/*! \file       outputwriter.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      Output Writer module header file.
+ *
+ *  This file contains the OutputWriter class declaration.
+ */
+
+#ifndef OUTPUTWRITER_H
+#define OUTPUTWRITER_H
+
+#include <QtCore/qglobal.h>
+
+#include <QByteArray>
+
+/*! \class OutputWriter
+ *  \brief Buffered output writer class.
+ *
+ *  This class collects already encoded output lines in a large
+ *  reusable buffer & writes it to a file descriptor with one system
+ *  call when it is full. Chunks which don't fit into the buffer are
+ *  written together with it by one writev call.
+ */
+class OutputWriter
+{
+    public:
+        explicit OutputWriter(int fd = 1, int bufferSize = 256 * 1024);
+        ~OutputWriter();
+        void setLineBuffered(const bool lineBuffered);
+        bool isLineBuffered() const;
+        bool isInteractive() const;
+        void write(const QByteArray &chunk);
+        void write(const char *data, int size);
+        void endDirectory();
+        void flush();
+        bool hasError() const;
+    private:
+        int _fd;                /*!< A file descriptor to write to */
+        QByteArray _buffer;     /*!< Output buffer */
+        int _used;              /*!< Number of bytes used in the buffer */
+        bool _lineBuffered;     /*!< Flush after every written chunk */
+        bool _interactive;      /*!< Output is a terminal, flush on directory boundaries */
+        bool _error;            /*!< Set on a write error, further output is dropped */
+
+        void _writeAll(const char *first, qint64 firstSize, const char *second, qint64 secondSize);
+
+        Q_DISABLE_COPY(OutputWriter)
+};
+
+#endif // OUTPUTWRITER_H
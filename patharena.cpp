@@ -0,0 +1,172 @@
+/*! \file       patharena.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief Path Arena module source file.
+ *
+ *  This file contains the PathArena class source code.
+ */
+
+#include "patharena.h"
+
+#include <QFile>
+
+/* Initial prefix buffer capacity, it is kept when nodes are dropped */
+static const int prefix_buffer_reserve = 4096;
+
+/*!
+ * \brief PathArena::PathArena
+ *
+ * PathArena Constructor
+ */
+PathArena::PathArena()
+{
+    _prefixes.reserve(prefix_buffer_reserve);
+}
+
+/*!
+ * \brief PathArena::clear
+ *
+ * Drops all nodes keeping the memory.
+ */
+void PathArena::clear()
+{
+    truncate(0);
+}
+
+/*!
+ * \brief PathArena::addRoot
+ * \param[in] rootPath A scan root path
+ * \return The root node
+ *
+ * Drops all nodes & starts a new tree.
+ */
+int PathArena::addRoot(const QString &rootPath)
+{
+    clear();
+
+    QByteArray encodedRoot = QFile::encodeName(rootPath);
+
+    Node node;
+    node.parent = -1;
+    node.prefixOffset = 0;
+    node.nameSize = encodedRoot.size();
+    _prefixes.append(encodedRoot);
+    if(!encodedRoot.endsWith('/'))
+    {
+        _prefixes.append('/');
+    }
+    node.prefixSize = _prefixes.size();
+    _nodes.append(node);
+    return 0;
+}
+
+/*!
+ * \brief PathArena::addDir
+ * \param[in] parent A parent node
+ * \param[in] name A raw directory name
+ * \param[in] nameSize The name size in bytes
+ * \return The directory node
+ */
+int PathArena::addDir(int parent, const char *name, int nameSize)
+{
+    const Node &parentNode = _nodes.at(parent);
+
+    Node node;
+    node.parent = parent;
+    node.prefixOffset = _prefixes.size();
+    node.prefixSize = parentNode.prefixSize + nameSize + 1;
+    node.nameSize = nameSize;
+
+    /* The parent prefix is copied from the same buffer, so it must not move while appending,
+       the capacity is doubled to keep appends amortized */
+    int needed = node.prefixOffset + node.prefixSize;
+    if(needed > _prefixes.capacity())
+    {
+        _prefixes.reserve(qMax(needed, 2 * _prefixes.capacity()));
+    }
+    _prefixes.append(_prefixes.constData() + parentNode.prefixOffset, parentNode.prefixSize);
+    _prefixes.append(name, nameSize);
+    _prefixes.append('/');
+
+    _nodes.append(node);
+    return _nodes.count() - 1;
+}
+
+/*!
+ * \brief PathArena::truncate
+ * \param[in] count Number of the first nodes to keep
+ *
+ * Drops the nodes added after the first "count" ones.
+ */
+void PathArena::truncate(int count)
+{
+    if(count >= _nodes.count())
+    {
+        return;
+    }
+
+    _prefixes.resize(_nodes.at(count).prefixOffset);
+    _nodes.resize(count);
+}
+
+/*!
+ * \brief PathArena::count
+ * \return Number of nodes
+ */
+int PathArena::count() const
+{
+    return _nodes.count();
+}
+
+/*!
+ * \brief PathArena::parent
+ * \param[in] node A node
+ * \return The parent node, -1 for the root
+ */
+int PathArena::parent(int node) const
+{
+    return _nodes.at(node).parent;
+}
+
+/*!
+ * \brief PathArena::appendPrefix
+ * \param[out] out A buffer to append to
+ * \param[in] node A directory node
+ *
+ * Appends the raw directory path ending with a separator.
+ */
+void PathArena::appendPrefix(QByteArray &out, int node) const
+{
+    const Node &dirNode = _nodes.at(node);
+    out.append(_prefixes.constData() + dirNode.prefixOffset, dirNode.prefixSize);
+}
+
+/*!
+ * \brief PathArena::appendPath
+ * \param[out] out A buffer to append to
+ * \param[in] node A directory node
+ * \param[in] name A raw entry name in the directory
+ * \param[in] nameSize The name size in bytes
+ *
+ * Appends the raw entry path.
+ */
+void PathArena::appendPath(QByteArray &out, int node, const char *name, int nameSize) const
+{
+    appendPrefix(out, node);
+    out.append(name, nameSize);
+}
+
+/*!
+ * \brief PathArena::path
+ * \param[in] node A directory node
+ * \return The decoded directory path, the root path is returned as it was added
+ */
+QString PathArena::path(int node) const
+{
+    const Node &dirNode = _nodes.at(node);
+
+    /* The root name is the whole root path, other prefixes end with an added separator */
+    int size = (dirNode.parent < 0) ? dirNode.nameSize : dirNode.prefixSize - 1;
+    return QFile::decodeName(QByteArray::fromRawData(_prefixes.constData() + dirNode.prefixOffset, size));
+}
@@ -0,0 +1,59 @@
+/*! \file       patharena.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      Path Arena module header file.
+ *
+ *  This file contains the PathArena class declaration.
+ */
+
+#ifndef PATHARENA_H
+#define PATHARENA_H
+
+#include <QtCore/qglobal.h>
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+/*! \class PathArena
+ *  \brief Directory path tree arena class.
+ *
+ *  This class keeps directories of a scan as (parent node, name) nodes.
+ *  Every node interns its raw path prefix ending with a separator in one
+ *  shared buffer, the name is the tail of the prefix. A file path is
+ *  rendered by appending the prefix of its directory & the file name
+ *  straight to an output buffer, so paths are never built per entry.
+ *  Nodes are added & dropped in the traversal stack order, so memory
+ *  is bounded by the paths on the stack & reused for the whole scan.
+ */
+class PathArena
+{
+    public:
+        PathArena();
+        void clear();
+        int addRoot(const QString &rootPath);
+        int addDir(int parent, const char *name, int nameSize);
+        void truncate(int count);
+        int count() const;
+        int parent(int node) const;
+        void appendPrefix(QByteArray &out, int node) const;
+        void appendPath(QByteArray &out, int node, const char *name, int nameSize) const;
+        QString path(int node) const;
+    private:
+        /*! \struct Node
+         *  \brief A directory node.
+         */
+        struct Node
+        {
+            int parent;         /*!< A parent node, -1 for the root */
+            int prefixOffset;   /*!< The prefix offset in the prefix buffer */
+            int prefixSize;     /*!< The prefix size including the trailing separator */
+            int nameSize;       /*!< The name size, the name ends before the trailing separator */
+        };
+
+        QVector<Node> _nodes;   /*!< Nodes in the order they were added */
+        QByteArray _prefixes;   /*!< Raw path prefixes of all nodes */
+};
+
+#endif // PATHARENA_H
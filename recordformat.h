@@ -0,0 +1,74 @@
+/*! \file       recordformat.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      Binary record format header file.
+ *
+ *  This file describes the binary file record format written by
+ *  "--format binary" & read by RecordReader.
+ *
+ *  A stream starts with a header:
+ *      char[4] magic "TDRB", quint32 version
+ *  Each file record follows as:
+ *      quint32 record_size         (bytes after this field)
+ *      qint64  mtime_nsecs         (modification time in nanoseconds since epoch)
+ *      qint64  size                (file size in bytes)
+ *      quint64 inode
+ *      quint32 mode                (st_mode, 0 if it is not known)
+ *      quint8  change              (0 for listed files, '+', '*' or '-' in watch mode)
+ *      char[record_size - 29] path (not terminated)
+ *  All numbers are little-endian. The path is the rest of the record, so the
+ *  fixed fields can't change without a new version & readers reject streams
+ *  of versions newer than they know.
+ */
+
+#ifndef RECORDFORMAT_H
+#define RECORDFORMAT_H
+
+#include <QtCore/qglobal.h>
+
+#include <QByteArray>
+
+/* Stream header magic & format version */
+static const char record_format_magic[4] = { 'T', 'D', 'R', 'B' };
+static const quint32 record_format_version = 1;
+static const int record_format_header_size = 8;
+
+/* Record size field & fixed record fields sizes */
+static const int record_size_field = 4;
+static const int record_fixed_size = 8 + 8 + 8 + 4 + 1;
+
+/*!
+ * \brief appendLittleEndian
+ * \param[out] out A buffer to append to
+ * \param[in] value A value to append
+ * \param[in] size Number of low value bytes to append
+ */
+inline void appendLittleEndian(QByteArray &out, quint64 value, int size)
+{
+    char bytes[8];
+    for(int byteNum = 0; byteNum < size; byteNum++)
+    {
+        bytes[byteNum] = char(value & 0xFF);
+        value >>= 8;
+    }
+    out.append(bytes, size);
+}
+
+/*!
+ * \brief readLittleEndian
+ * \param[in] data Bytes to read from
+ * \param[in] size Number of bytes to read
+ * \return The read value
+ */
+inline quint64 readLittleEndian(const char *data, int size)
+{
+    quint64 value = 0;
+    for(int byteNum = size - 1; byteNum >= 0; byteNum--)
+    {
+        value = (value << 8) | quint8(data[byteNum]);
+    }
+    return value;
+}
+
+#endif // RECORDFORMAT_H
@@ -0,0 +1,192 @@
+/*! \file       recordpipeline.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief Record Pipeline module source file.
+ *
+ *  This file contains the RecordPipeline class source code.
+ */
+
+#include "recordpipeline.h"
+#include "scanstats.h"
+
+/* Number of batches, all of them in flight stop the enumerating thread */
+static const int pipeline_batch_count = 8;
+
+/* Number of files in a batch */
+static const int pipeline_batch_records = 4096;
+
+/* Raw path bytes in a batch */
+static const int pipeline_batch_path_size = 256 * 1024;
+
+/* Output size formatted before it is written */
+static const int pipeline_output_chunk_size = 64 * 1024;
+
+/*!
+ * \brief RecordPipeline::RecordPipeline
+ * \param[in] writer A writer to write formatted files to
+ * \param[in] format File format function
+ *
+ * RecordPipeline Constructor, it starts the pipeline thread
+ */
+RecordPipeline::RecordPipeline(OutputWriter &writer, const FormatFunction &format)
+    : _full(pipeline_batch_count), _free(pipeline_batch_count)
+{
+    _writer = &writer;
+    _format = format;
+    _finished = false;
+
+    for(int batchNum = 0; batchNum < pipeline_batch_count; batchNum++)
+    {
+        Batch *batch = new Batch;
+        batch->paths.reserve(pipeline_batch_path_size + 4096);
+        batch->pathEnds.reserve(pipeline_batch_records);
+        batch->records.reserve(pipeline_batch_records);
+        _batches.append(batch);
+    }
+
+    _current = _batches.first();
+    for(int batchNum = 1; batchNum < _batches.count(); batchNum++)
+    {
+        _free.push(_batches.at(batchNum));
+    }
+
+    _thread = new FormatThread(this);
+    _thread->start();
+}
+
+/*!
+ * \brief RecordPipeline::~RecordPipeline
+ *
+ * RecordPipeline Destructor, it writes files left in the pipeline
+ */
+RecordPipeline::~RecordPipeline()
+{
+    finish();
+    delete _thread;
+    qDeleteAll(_batches);
+}
+
+/*!
+ * \brief RecordPipeline::paths
+ * \return A buffer to append the raw path of the next file to
+ */
+QByteArray &RecordPipeline::paths()
+{
+    return _current->paths;
+}
+
+/*!
+ * \brief RecordPipeline::add
+ * \param[in] record A file record
+ *
+ * Adds a file whose path has been appended to paths() since the previous file.
+ * Waits if all batches are in flight.
+ */
+void RecordPipeline::add(const EntryRecord &record)
+{
+    _current->pathEnds.append(_current->paths.size());
+    _current->records.append(record);
+
+    if(_current->records.count() >= pipeline_batch_records ||
+       _current->paths.size() >= pipeline_batch_path_size)
+    {
+        _push();
+    }
+}
+
+/*!
+ * \brief RecordPipeline::finish
+ *
+ * Passes the last files & waits until everything is written.
+ */
+void RecordPipeline::finish()
+{
+    if(_finished)
+    {
+        return;
+    }
+    _finished = true;
+
+    if(!_current->records.isEmpty())
+    {
+        _full.push(_current);
+        _current = nullptr;
+    }
+    _full.close();
+    _thread->wait();
+}
+
+/*!
+ * \brief RecordPipeline::_push
+ *
+ * Passes the current batch to the pipeline thread & takes a free one.
+ */
+void RecordPipeline::_push()
+{
+    _full.push(_current);
+    _free.pop(_current);
+
+    _current->paths.resize(0);
+    _current->pathEnds.resize(0);
+    _current->records.resize(0);
+}
+
+/*!
+ * \brief RecordPipeline::_formatBatches
+ *
+ * Formats & writes batches until the enumerating thread finishes.
+ * It is run on the pipeline thread.
+ */
+void RecordPipeline::_formatBatches()
+{
+    QByteArray out;
+    out.reserve(pipeline_output_chunk_size + 4096);
+
+    DirEntry entry;
+    entry.isDir = false;
+
+    Batch *batch;
+    while(_full.pop(batch))
+    {
+        const int count = batch->records.count();
+        int recordNum = 0;
+        int start = 0;
+
+        while(recordNum < count)
+        {
+            {
+                ScanStats::PhaseTimer timer(ScanStats::PHASE_FORMAT);
+
+                for(; recordNum < count && out.size() < pipeline_output_chunk_size; recordNum++)
+                {
+                    const EntryRecord &record = batch->records.at(recordNum);
+                    const int end = batch->pathEnds.at(recordNum);
+
+                    entry.size = record.size;
+                    entry.mtime = record.mtime;
+                    entry.blocks = record.blocks;
+                    entry.mtimeNsec = record.mtimeNsec;
+                    entry.mode = record.mode;
+                    entry.inode = record.inode;
+                    entry.ctime = record.ctime;
+                    entry.uid = record.uid;
+                    entry.links = record.links;
+                    entry.isLink = record.isLink;
+                    _format(out, QByteArray::fromRawData(batch->paths.constData() + start, end - start), entry);
+                    start = end;
+                }
+            }
+
+            if(out.size() >= pipeline_output_chunk_size)
+            {
+                _writer->write(out);
+                out.resize(0);
+            }
+        }
+
+        _free.push(batch);
+    }
+
+    _writer->write(out);
+}
@@ -0,0 +1,87 @@
+/*! \file       recordpipeline.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      Record Pipeline module header file.
+ *
+ *  This file contains the RecordPipeline class declaration.
+ */
+
+#ifndef RECORDPIPELINE_H
+#define RECORDPIPELINE_H
+
+#include <QtCore/qglobal.h>
+
+#include <QByteArray>
+#include <QThread>
+#include <QVector>
+
+#include <functional>
+
+#include "dirreader.h"
+#include "outputwriter.h"
+#include "spscring.h"
+
+/*! \class RecordPipeline
+ *  \brief Enumeration & output overlapping class.
+ *
+ *  This class formats & writes visited files on its own thread, so
+ *  the enumerating thread goes on reading directories while the output
+ *  is formatted or a pipe reader (like gzip) is slow. Files are passed
+ *  in batches of raw paths & records through a ring of full batches,
+ *  written batches come back through a ring of free ones. When all
+ *  batches are in flight the enumerating thread waits, so memory stays
+ *  bounded & the whole pipeline runs at the speed of its slower side.
+ */
+class RecordPipeline
+{
+    public:
+        /*! A format function: appends a line of a file with a raw path to the output,
+         *  it is called from the pipeline thread */
+        typedef std::function<void (QByteArray &out, const QByteArray &path, const DirEntry &entry)> FormatFunction;
+
+        RecordPipeline(OutputWriter &writer, const FormatFunction &format);
+        ~RecordPipeline();
+        QByteArray &paths();
+        void add(const EntryRecord &record);
+        void finish();
+    private:
+        /*! \struct Batch
+         *  \brief Files passed to the pipeline thread at once.
+         */
+        struct Batch
+        {
+            QByteArray paths;               /*!< Raw paths of all files one after another */
+            QVector<int> pathEnds;          /*!< The path end offset of every file */
+            QVector<EntryRecord> records;   /*!< File records, names are not used */
+        };
+
+        /*! \class FormatThread
+         *  \brief The pipeline thread.
+         */
+        class FormatThread : public QThread
+        {
+            public:
+                explicit FormatThread(RecordPipeline *pipeline) : _pipeline(pipeline) {}
+            protected:
+                void run() Q_DECL_OVERRIDE { _pipeline->_formatBatches(); }
+            private:
+                RecordPipeline *_pipeline;  /*!< The pipeline owning the thread */
+        };
+
+        OutputWriter *_writer;              /*!< Output writer, it is used by the pipeline thread only */
+        FormatFunction _format;             /*!< File format function */
+        QVector<Batch *> _batches;          /*!< All batches */
+        SpscRing<Batch *> _full;            /*!< Batches to format */
+        SpscRing<Batch *> _free;            /*!< Batches to fill */
+        Batch *_current;                    /*!< A batch being filled */
+        FormatThread *_thread;              /*!< The pipeline thread */
+        bool _finished;                     /*!< Set when all files have been written */
+
+        void _push();
+        void _formatBatches();
+
+        Q_DISABLE_COPY(RecordPipeline)
+};
+
+#endif // RECORDPIPELINE_H
@@ -0,0 +1,162 @@
+/*! \file       recordreader.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief Record Reader module source file.
+ *
+ *  This file contains the RecordReader class source code.
+ */
+
+#include "recordreader.h"
+#include "recordformat.h"
+
+#include <string.h>
+
+/* The longest record accepted, longer ones mean a corrupted stream */
+static const int max_record_size = 64 * 1024 * 1024;
+
+/*!
+ * \brief RecordReader::RecordReader
+ * \param[in] device An open device to read from
+ * \param[in] bufferSize Bytes to read from the device at once
+ *
+ * RecordReader Constructor
+ */
+RecordReader::RecordReader(QIODevice *device, int bufferSize)
+{
+    _device = device;
+    _bufferSize = (bufferSize > 0) ? bufferSize : 4096;
+    _buffer.reserve(_bufferSize);
+    _pos = 0;
+    _version = 0;
+    _error = false;
+}
+
+/*!
+ * \brief RecordReader::readHeader
+ * \return "false" if the stream is not a tdir binary stream or its version is newer
+ *
+ * Reads the stream header, it is read by next() if it is not called.
+ */
+bool RecordReader::readHeader()
+{
+    if(_version != 0)
+    {
+        return true;
+    }
+    if(_error || !_fill(record_format_header_size))
+    {
+        _error = true;
+        return false;
+    }
+
+    const char *data = _buffer.constData() + _pos;
+    quint32 version = quint32(readLittleEndian(data + sizeof(record_format_magic), 4));
+    if(memcmp(data, record_format_magic, sizeof(record_format_magic)) != 0 ||
+       version == 0 || version > record_format_version)
+    {
+        _error = true;
+        return false;
+    }
+
+    _version = version;
+    _pos += record_format_header_size;
+    return true;
+}
+
+/*!
+ * \brief RecordReader::next
+ * \param[out] record A record to read to
+ * \return "false" at the end of the stream or on an error
+ */
+bool RecordReader::next(FileRecord &record)
+{
+    if(!readHeader() || !_fill(record_size_field))
+    {
+        return false;
+    }
+
+    int recordSize = int(readLittleEndian(_buffer.constData() + _pos, record_size_field));
+    if(recordSize < record_fixed_size || recordSize > max_record_size ||
+       !_fill(record_size_field + recordSize))
+    {
+        _error = true;
+        return false;
+    }
+
+    const char *data = _buffer.constData() + _pos + record_size_field;
+    record.mtimeNsecs = qint64(readLittleEndian(data, 8));
+    record.size = qint64(readLittleEndian(data + 8, 8));
+    record.inode = readLittleEndian(data + 16, 8);
+    record.mode = quint32(readLittleEndian(data + 24, 4));
+    record.change = data[28];
+
+    /* The path is the rest of the record */
+    int pathSize = recordSize - record_fixed_size;
+    record.path.resize(pathSize);
+    memcpy(record.path.data(), data + record_fixed_size, pathSize);
+
+    _pos += record_size_field + recordSize;
+    return true;
+}
+
+/*!
+ * \brief RecordReader::hasError
+ * \return "true" if the stream is wrong or truncated
+ */
+bool RecordReader::hasError() const
+{
+    return _error;
+}
+
+/*!
+ * \brief RecordReader::version
+ * \return The stream format version or 0 if the header is not read
+ */
+quint32 RecordReader::version() const
+{
+    return _version;
+}
+
+/*!
+ * \brief RecordReader::_fill
+ * \param[in] size Number of bytes needed after the current position
+ * \return "false" if the device ends before
+ *
+ * Moves not decoded bytes to the buffer start & reads more from the device.
+ * A clean end of the stream on a record boundary is not an error.
+ */
+bool RecordReader::_fill(int size)
+{
+    int available = _buffer.size() - _pos;
+    if(available >= size)
+    {
+        return true;
+    }
+
+    if(_pos > 0)
+    {
+        _buffer.remove(0, _pos);
+        _pos = 0;
+    }
+
+    while(available < size)
+    {
+        int toRead = qMax(size - available, _bufferSize);
+        _buffer.resize(available + toRead);
+        qint64 read = _device->read(_buffer.data() + available, toRead);
+        if(read <= 0)
+        {
+            _buffer.resize(available);
+            if(available > 0)
+            {
+                _error = true;
+            }
+            return false;
+        }
+        available += int(read);
+        _buffer.resize(available);
+    }
+
+    return true;
+}
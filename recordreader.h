@@ -0,0 +1,60 @@
+/*! \file       recordreader.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      Record Reader module header file.
+ *
+ *  This file contains the RecordReader class declaration.
+ */
+
+#ifndef RECORDREADER_H
+#define RECORDREADER_H
+
+#include <QtCore/qglobal.h>
+
+#include <QByteArray>
+#include <QIODevice>
+
+/*! \struct FileRecord
+ *  \brief A file record read from a binary stream.
+ */
+struct FileRecord
+{
+    QByteArray path;        /*!< A file path as it was written */
+    qint64 size;            /*!< A file size in bytes */
+    qint64 mtimeNsecs;      /*!< A modification time in nanoseconds since epoch */
+    quint32 mode;           /*!< A file type & permissions, 0 if it is not known */
+    quint64 inode;          /*!< An inode number, 0 if it is not known */
+    char change;            /*!< 0 for listed files, '+', '*' or '-' in watch mode */
+};
+
+/*! \class RecordReader
+ *  \brief Binary record stream reader class.
+ *
+ *  This class reads records written by "tdir --format binary" from a device
+ *  in large blocks & decodes them in place without parsing text. The path
+ *  buffer of a passed record is reused, so reading a stream into the same
+ *  record doesn't allocate memory per record.
+ */
+class RecordReader
+{
+    public:
+        explicit RecordReader(QIODevice *device, int bufferSize = 256 * 1024);
+        bool readHeader();
+        bool next(FileRecord &record);
+        bool hasError() const;
+        quint32 version() const;
+    private:
+        QIODevice *_device;     /*!< A device to read from */
+        QByteArray _buffer;     /*!< Read bytes */
+        int _bufferSize;        /*!< Bytes to read at once */
+        int _pos;               /*!< Position of the first not decoded byte */
+        quint32 _version;       /*!< The stream format version, 0 before the header is read */
+        bool _error;            /*!< Set on a wrong header or a truncated record */
+
+        bool _fill(int size);
+
+        Q_DISABLE_COPY(RecordReader)
+};
+
+#endif // RECORDREADER_H
@@ -0,0 +1,537 @@
+/*! \file       recordsink.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief Record Sink module source file.
+ *
+ *  This file contains the RecordSink classes source code.
+ */
+
+#include "recordsink.h"
+#include "recordformat.h"
+
+/*!
+ * \brief appendUnsigned
+ * \param[out] out A buffer to append to
+ * \param[in] value A number
+ *
+ * Appends a decimal number without a temporary string.
+ */
+static inline void appendUnsigned(QByteArray &out, quint64 value)
+{
+    char digits[20];
+    int pos = sizeof(digits);
+
+    do
+    {
+        digits[--pos] = char('0' + value % 10);
+        value /= 10;
+    }
+    while(value > 0);
+
+    out.append(digits + pos, int(sizeof(digits)) - pos);
+}
+
+/*!
+ * \brief appendNumber
+ * \param[out] out A buffer to append to
+ * \param[in] value A number
+ */
+static inline void appendNumber(QByteArray &out, qint64 value)
+{
+    if(value < 0)
+    {
+        out.append('-');
+        appendUnsigned(out, quint64(0) - quint64(value));
+        return;
+    }
+    appendUnsigned(out, quint64(value));
+}
+
+/*!
+ * \brief RecordSink::~RecordSink
+ *
+ * RecordSink Destructor
+ */
+RecordSink::~RecordSink()
+{
+}
+
+/*!
+ * \brief RecordSink::create
+ * \param[in] format An output format
+ * \param[in] timeFormat A QDateTime::toString format of modification times in text lines
+ * \param[in] codec A text output codec
+ * \return A new sink, the caller owns it
+ */
+RecordSink *RecordSink::create(Format format, const QString &timeFormat, QTextCodec *codec)
+{
+    switch(format)
+    {
+        case FORMAT_NDJSON:
+            return new NdjsonSink;
+        case FORMAT_BINARY:
+            return new BinarySink;
+        default:
+            return new TextSink(timeFormat, codec);
+    }
+}
+
+/*!
+ * \brief RecordSink::formatByName
+ * \param[in] name A format name: "text", "ndjson" or "binary"
+ * \param[out] format The format
+ * \return "false" if the name is unknown
+ */
+bool RecordSink::formatByName(const QString &name, Format &format)
+{
+    if(name == "text")
+    {
+        format = FORMAT_TEXT;
+    }
+    else if(name == "ndjson")
+    {
+        format = FORMAT_NDJSON;
+    }
+    else if(name == "binary")
+    {
+        format = FORMAT_BINARY;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+/*!
+ * \brief RecordSink::header
+ * \return Bytes to write once before all records
+ */
+QByteArray RecordSink::header() const
+{
+    return QByteArray();
+}
+
+/*!
+ * \brief RecordSink::hasTotals
+ * \return "true" if the sink can format directory totals
+ */
+bool RecordSink::hasTotals() const
+{
+    return false;
+}
+
+/*!
+ * \brief RecordSink::appendTotals
+ * \param[out] out A buffer to append to
+ * \param[in] path An encoded directory path
+ * \param[in] files Number of files
+ * \param[in] bytes Files size in bytes
+ * \param[in] blocks Allocated 512 byte blocks
+ *
+ * Directory totals are dropped by sinks which can't format them.
+ */
+void RecordSink::appendTotals(QByteArray &out, const QByteArray &path, qint64 files, qint64 bytes, qint64 blocks) const
+{
+    Q_UNUSED(out)
+    Q_UNUSED(path)
+    Q_UNUSED(files)
+    Q_UNUSED(bytes)
+    Q_UNUSED(blocks)
+}
+
+/*!
+ * \brief RecordSink::appendGroup
+ * \param[out] out A buffer to append to
+ * \param[in] size A file size
+ * \param[in] hash The content hash
+ * \param[in] paths Encoded paths of files with the same content
+ *
+ * Duplicate groups are dropped by sinks which can't format them.
+ */
+void RecordSink::appendGroup(QByteArray &out, qint64 size, quint64 hash, const QVector<QByteArray> &paths) const
+{
+    Q_UNUSED(out)
+    Q_UNUSED(size)
+    Q_UNUSED(hash)
+    Q_UNUSED(paths)
+}
+
+/*!
+ * \brief RecordSink::appendGroupTotals
+ * \param[out] out A buffer to append to
+ * \param[in] groups Number of duplicate groups
+ * \param[in] files Number of files in the groups
+ * \param[in] bytes Bytes which would be freed by keeping one file of every group
+ */
+void RecordSink::appendGroupTotals(QByteArray &out, qint64 groups, qint64 files, qint64 bytes) const
+{
+    Q_UNUSED(out)
+    Q_UNUSED(groups)
+    Q_UNUSED(files)
+    Q_UNUSED(bytes)
+}
+
+/*!
+ * \brief TextSink::TextSink
+ * \param[in] timeFormat A QDateTime::toString format of modification times
+ * \param[in] codec An output codec
+ *
+ * TextSink Constructor
+ */
+TextSink::TextSink(const QString &timeFormat, QTextCodec *codec)
+    : _timeFormatter(timeFormat, codec)
+{
+}
+
+/*!
+ * \brief TextSink::hasTotals
+ * \return "true"
+ */
+bool TextSink::hasTotals() const
+{
+    return true;
+}
+
+/*!
+ * \brief TextSink::append
+ * \param[out] out A buffer to append the line to
+ * \param[in] path An encoded file path
+ * \param[in] entry The file
+ * \param[in] change A change type in watch mode or 0
+ *
+ * Formats file information according to format:
+ * path/file_name file_size file_modification_time
+ */
+void TextSink::append(QByteArray &out, const QByteArray &path, const DirEntry &entry, char change) const
+{
+    if(change)
+    {
+        out.append(change);
+        out.append(' ');
+    }
+    out.append(path);
+    out.append(' ');
+    appendNumber(out, entry.size);
+    out.append(' ');
+    _timeFormatter.append(out, entry.mtime);
+    out.append('\n');
+}
+
+/*!
+ * \brief TextSink::appendTotals
+ * \param[out] out A buffer to append the line to
+ * \param[in] path An encoded directory path
+ * \param[in] files Number of files
+ * \param[in] bytes Files size in bytes
+ * \param[in] blocks Allocated 512 byte blocks
+ *
+ * Formats directory totals according to format:
+ * path files_count files_size allocated_blocks
+ */
+void TextSink::appendTotals(QByteArray &out, const QByteArray &path, qint64 files, qint64 bytes, qint64 blocks) const
+{
+    out.append(path);
+    out.append(' ');
+    appendNumber(out, files);
+    out.append(' ');
+    appendNumber(out, bytes);
+    out.append(' ');
+    appendNumber(out, blocks);
+    out.append('\n');
+}
+
+/*!
+ * \brief TextSink::appendGroup
+ * \param[out] out A buffer to append the block to
+ * \param[in] size A file size
+ * \param[in] hash The content hash
+ * \param[in] paths Encoded paths of files with the same content
+ *
+ * Formats a duplicate group as a header line, a path per line & an empty line:
+ * size file_size files files_count reclaimable bytes
+ */
+void TextSink::appendGroup(QByteArray &out, qint64 size, quint64 hash, const QVector<QByteArray> &paths) const
+{
+    Q_UNUSED(hash)
+
+    out.append("size ");
+    appendNumber(out, size);
+    out.append(" files ");
+    appendNumber(out, paths.count());
+    out.append(" reclaimable ");
+    appendNumber(out, size * (paths.count() - 1));
+    out.append('\n');
+    foreach (const QByteArray &path, paths) {
+        out.append(path);
+        out.append('\n');
+    }
+    out.append('\n');
+}
+
+/*!
+ * \brief TextSink::appendGroupTotals
+ * \param[out] out A buffer to append the line to
+ * \param[in] groups Number of duplicate groups
+ * \param[in] files Number of files in the groups
+ * \param[in] bytes Bytes which would be freed by keeping one file of every group
+ *
+ * Formats totals as:
+ * groups groups_count files files_count reclaimable bytes
+ */
+void TextSink::appendGroupTotals(QByteArray &out, qint64 groups, qint64 files, qint64 bytes) const
+{
+    out.append("groups ");
+    appendNumber(out, groups);
+    out.append(" files ");
+    appendNumber(out, files);
+    out.append(" reclaimable ");
+    appendNumber(out, bytes);
+    out.append('\n');
+}
+
+/*!
+ * \brief NdjsonSink::hasTotals
+ * \return "true"
+ */
+bool NdjsonSink::hasTotals() const
+{
+    return true;
+}
+
+/*!
+ * \brief NdjsonSink::append
+ * \param[out] out A buffer to append the line to
+ * \param[in] path A UTF-8 file path
+ * \param[in] entry The file
+ * \param[in] change A change type in watch mode or 0
+ *
+ * Formats file information as:
+ * {"change":"+","path":"...","size":1,"mtime_ns":1,"mode":33188,"inode":1}
+ * The change is written in watch mode only.
+ */
+void NdjsonSink::append(QByteArray &out, const QByteArray &path, const DirEntry &entry, char change) const
+{
+    out.append('{');
+    if(change)
+    {
+        out.append("\"change\":\"");
+        out.append(change);
+        out.append("\",");
+    }
+    out.append("\"path\":");
+    _appendString(out, path);
+    out.append(",\"size\":");
+    appendNumber(out, entry.size);
+    out.append(",\"mtime_ns\":");
+    appendNumber(out, entry.mtime * 1000000 + entry.mtimeNsec);
+    out.append(",\"mode\":");
+    appendUnsigned(out, entry.mode);
+    out.append(",\"inode\":");
+    appendUnsigned(out, entry.inode);
+    out.append("}\n");
+}
+
+/*!
+ * \brief NdjsonSink::appendTotals
+ * \param[out] out A buffer to append the line to
+ * \param[in] path A UTF-8 directory path
+ * \param[in] files Number of files
+ * \param[in] bytes Files size in bytes
+ * \param[in] blocks Allocated 512 byte blocks
+ *
+ * Formats directory totals as:
+ * {"path":"...","files":1,"size":1,"blocks":1}
+ */
+void NdjsonSink::appendTotals(QByteArray &out, const QByteArray &path, qint64 files, qint64 bytes, qint64 blocks) const
+{
+    out.append("{\"path\":");
+    _appendString(out, path);
+    out.append(",\"files\":");
+    appendNumber(out, files);
+    out.append(",\"size\":");
+    appendNumber(out, bytes);
+    out.append(",\"blocks\":");
+    appendNumber(out, blocks);
+    out.append("}\n");
+}
+
+/*!
+ * \brief NdjsonSink::appendGroup
+ * \param[out] out A buffer to append the line to
+ * \param[in] size A file size
+ * \param[in] hash The content hash
+ * \param[in] paths UTF-8 paths of files with the same content
+ *
+ * Formats a duplicate group as:
+ * {"size":1,"hash":"0123456789abcdef","reclaimable":1,"paths":["...","..."]}
+ */
+void NdjsonSink::appendGroup(QByteArray &out, qint64 size, quint64 hash, const QVector<QByteArray> &paths) const
+{
+    static const char hexDigits[] = "0123456789abcdef";
+
+    out.append("{\"size\":");
+    appendNumber(out, size);
+    out.append(",\"hash\":\"");
+    for(int shift = 60; shift >= 0; shift -= 4)
+    {
+        out.append(hexDigits[(hash >> shift) & 0x0F]);
+    }
+    out.append("\",\"reclaimable\":");
+    appendNumber(out, size * (paths.count() - 1));
+    out.append(",\"paths\":[");
+    for(int pathNum = 0; pathNum < paths.count(); pathNum++)
+    {
+        if(pathNum > 0)
+        {
+            out.append(',');
+        }
+        _appendString(out, paths.at(pathNum));
+    }
+    out.append("]}\n");
+}
+
+/*!
+ * \brief NdjsonSink::appendGroupTotals
+ * \param[out] out A buffer to append the line to
+ * \param[in] groups Number of duplicate groups
+ * \param[in] files Number of files in the groups
+ * \param[in] bytes Bytes which would be freed by keeping one file of every group
+ *
+ * Formats totals as:
+ * {"groups":1,"files":2,"reclaimable":1}
+ */
+void NdjsonSink::appendGroupTotals(QByteArray &out, qint64 groups, qint64 files, qint64 bytes) const
+{
+    out.append("{\"groups\":");
+    appendNumber(out, groups);
+    out.append(",\"files\":");
+    appendNumber(out, files);
+    out.append(",\"reclaimable\":");
+    appendNumber(out, bytes);
+    out.append("}\n");
+}
+
+/*!
+ * \brief NdjsonSink::_appendString
+ * \param[out] out A buffer to append the string to
+ * \param[in] text UTF-8 text
+ *
+ * Appends a quoted JSON string. Valid UTF-8 sequences are copied as they are,
+ * other bytes are replaced with U+FFFD.
+ */
+void NdjsonSink::_appendString(QByteArray &out, const QByteArray &text)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+
+    out.append('"');
+
+    const int size = text.size();
+    int pos = 0;
+    while(pos < size)
+    {
+        quint8 byte = quint8(text.at(pos));
+
+        if(byte < 0x80)
+        {
+            switch(byte)
+            {
+                case '"':  out.append("\\\""); break;
+                case '\\': out.append("\\\\"); break;
+                case '\n': out.append("\\n"); break;
+                case '\r': out.append("\\r"); break;
+                case '\t': out.append("\\t"); break;
+                default:
+                    if(byte < 0x20)
+                    {
+                        out.append("\\u00");
+                        out.append(hexDigits[byte >> 4]);
+                        out.append(hexDigits[byte & 0x0F]);
+                    }
+                    else
+                    {
+                        out.append(char(byte));
+                    }
+                    break;
+            }
+            pos++;
+            continue;
+        }
+
+        /* A sequence length & the smallest code point it may encode */
+        int length = 0;
+        quint32 codePoint = 0;
+        quint32 minimum = 0;
+        if((byte & 0xE0) == 0xC0)
+        {
+            length = 2;
+            codePoint = byte & 0x1F;
+            minimum = 0x80;
+        }
+        else if((byte & 0xF0) == 0xE0)
+        {
+            length = 3;
+            codePoint = byte & 0x0F;
+            minimum = 0x800;
+        }
+        else if((byte & 0xF8) == 0xF0)
+        {
+            length = 4;
+            codePoint = byte & 0x07;
+            minimum = 0x10000;
+        }
+
+        bool valid = (length > 0 && pos + length <= size);
+        for(int byteNum = 1; valid && byteNum < length; byteNum++)
+        {
+            quint8 next = quint8(text.at(pos + byteNum));
+            valid = ((next & 0xC0) == 0x80);
+            codePoint = (codePoint << 6) | (next & 0x3F);
+        }
+        valid = valid && codePoint >= minimum && codePoint <= 0x10FFFF &&
+                (codePoint < 0xD800 || codePoint > 0xDFFF);
+
+        if(valid)
+        {
+            out.append(text.constData() + pos, length);
+            pos += length;
+        }
+        else
+        {
+            out.append("\xEF\xBF\xBD");
+            pos++;
+        }
+    }
+
+    out.append('"');
+}
+
+/*!
+ * \brief BinarySink::header
+ * \return The stream magic & format version
+ */
+QByteArray BinarySink::header() const
+{
+    QByteArray header(record_format_magic, sizeof(record_format_magic));
+    appendLittleEndian(header, record_format_version, 4);
+    return header;
+}
+
+/*!
+ * \brief BinarySink::append
+ * \param[out] out A buffer to append the record to
+ * \param[in] path A file path
+ * \param[in] entry The file
+ * \param[in] change A change type in watch mode or 0
+ */
+void BinarySink::append(QByteArray &out, const QByteArray &path, const DirEntry &entry, char change) const
+{
+    appendLittleEndian(out, quint64(record_fixed_size + path.size()), 4);
+    appendLittleEndian(out, quint64(entry.mtime * 1000000 + entry.mtimeNsec), 8);
+    appendLittleEndian(out, quint64(entry.size), 8);
+    appendLittleEndian(out, entry.inode, 8);
+    appendLittleEndian(out, entry.mode, 4);
+    out.append(change);
+    out.append(path);
+}
@@ -0,0 +1,105 @@
+/*! \file       recordsink.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      Record Sink module header file.
+ *
+ *  This file contains the RecordSink class & output format declarations.
+ */
+
+#ifndef RECORDSINK_H
+#define RECORDSINK_H
+
+#include <QtCore/qglobal.h>
+
+#include <QByteArray>
+#include <QString>
+#include <QTextCodec>
+#include <QVector>
+
+#include "dirreader.h"
+#include "timeformatter.h"
+
+/*! \class RecordSink
+ *  \brief File record formatter base class.
+ *
+ *  A sink formats file records & directory totals into an output buffer
+ *  which is written by OutputWriter. Sinks are called from traversal
+ *  threads concurrently, so they must not change their state.
+ */
+class RecordSink
+{
+    public:
+        /*! \enum Format
+         *  \brief Output formats.
+         */
+        enum Format
+        {
+            FORMAT_TEXT,    /*!< "path size dd.MM.yyyy hh:mm:ss" lines in the output codec */
+            FORMAT_NDJSON,  /*!< A JSON object per line in UTF-8 */
+            FORMAT_BINARY   /*!< Length-prefixed binary records, see recordformat.h */
+        };
+
+        virtual ~RecordSink();
+        static RecordSink *create(Format format, const QString &timeFormat, QTextCodec *codec);
+        static bool formatByName(const QString &name, Format &format);
+        virtual QByteArray header() const;
+        virtual bool hasTotals() const;
+        virtual void append(QByteArray &out, const QByteArray &path, const DirEntry &entry, char change = 0) const = 0;
+        virtual void appendTotals(QByteArray &out, const QByteArray &path, qint64 files, qint64 bytes, qint64 blocks) const;
+        virtual void appendGroup(QByteArray &out, qint64 size, quint64 hash, const QVector<QByteArray> &paths) const;
+        virtual void appendGroupTotals(QByteArray &out, qint64 groups, qint64 files, qint64 bytes) const;
+};
+
+/*! \class TextSink
+ *  \brief Text line formatter class.
+ *
+ *  This class formats the classic "path size time" lines,
+ *  changes in watch mode are prefixed with "+ ", "* " or "- ".
+ */
+class TextSink : public RecordSink
+{
+    public:
+        TextSink(const QString &timeFormat, QTextCodec *codec);
+        bool hasTotals() const;
+        void append(QByteArray &out, const QByteArray &path, const DirEntry &entry, char change = 0) const;
+        void appendTotals(QByteArray &out, const QByteArray &path, qint64 files, qint64 bytes, qint64 blocks) const;
+        void appendGroup(QByteArray &out, qint64 size, quint64 hash, const QVector<QByteArray> &paths) const;
+        void appendGroupTotals(QByteArray &out, qint64 groups, qint64 files, qint64 bytes) const;
+    private:
+        TimeFormatter _timeFormatter;   /*!< The compiled modification time formatter */
+};
+
+/*! \class NdjsonSink
+ *  \brief Newline delimited JSON formatter class.
+ *
+ *  This class formats an object per file with the path, size, modification
+ *  time in nanoseconds since epoch, mode & inode. Paths are expected in UTF-8,
+ *  bytes which are not valid UTF-8 are replaced with U+FFFD.
+ */
+class NdjsonSink : public RecordSink
+{
+    public:
+        bool hasTotals() const;
+        void append(QByteArray &out, const QByteArray &path, const DirEntry &entry, char change = 0) const;
+        void appendTotals(QByteArray &out, const QByteArray &path, qint64 files, qint64 bytes, qint64 blocks) const;
+        void appendGroup(QByteArray &out, qint64 size, quint64 hash, const QVector<QByteArray> &paths) const;
+        void appendGroupTotals(QByteArray &out, qint64 groups, qint64 files, qint64 bytes) const;
+    private:
+        static void _appendString(QByteArray &out, const QByteArray &text);
+};
+
+/*! \class BinarySink
+ *  \brief Binary record formatter class.
+ *
+ *  This class writes records described in recordformat.h,
+ *  paths are written as raw bytes. Directory totals are not supported.
+ */
+class BinarySink : public RecordSink
+{
+    public:
+        QByteArray header() const;
+        void append(QByteArray &out, const QByteArray &path, const DirEntry &entry, char change = 0) const;
+};
+
+#endif // RECORDSINK_H
@@ -0,0 +1,308 @@
+/*! \file       scanstats.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief Scan Statistics module source file.
+ *
+ *  This file contains the ScanStats class source code.
+ */
+
+#include "scanstats.h"
+
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QString>
+#include <QTextStream>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <atomic>
+
+#include <stdio.h>
+
+/*! \struct StatsBlock
+ *  \brief Counters of one thread.
+ *
+ *  Only the owning thread changes a block, others may read it any time.
+ */
+struct StatsBlock
+{
+    std::atomic<qint64> counters[ScanStats::COUNTER_COUNT];         /*!< Event counters */
+    std::atomic<qint64> nsecs[ScanStats::PHASE_COUNT];              /*!< Time per phase */
+    std::atomic<qint64> histogram[ScanStats::histogram_buckets];    /*!< Directory read latencies */
+
+    StatsBlock()
+    {
+        for(int index = 0; index < ScanStats::COUNTER_COUNT; index++) counters[index].store(0);
+        for(int index = 0; index < ScanStats::PHASE_COUNT; index++) nsecs[index].store(0);
+        for(int index = 0; index < ScanStats::histogram_buckets; index++) histogram[index].store(0);
+    }
+};
+
+/*! \class ProgressThread
+ *  \brief Periodic progress line writer thread.
+ */
+class ProgressThread : public QThread
+{
+    public:
+        explicit ProgressThread(int seconds) : _seconds(seconds), _stopped(false) {}
+        void stop();
+    protected:
+        void run();
+    private:
+        int _seconds;               /*!< Seconds between progress lines */
+        QMutex _lock;               /*!< Guards the stop flag */
+        QWaitCondition _condition;  /*!< Wakes the thread to stop */
+        bool _stopped;              /*!< Stop flag */
+};
+
+bool ScanStats::_enabled = false;
+
+/* Blocks of all threads which have counted anything, they are never freed */
+static QMutex blocks_lock;
+static QList<StatsBlock *> blocks;
+
+/* The block of the current thread */
+static thread_local StatsBlock *thread_block = nullptr;
+
+/* Time statistics were enabled at */
+static qint64 started_at = 0;
+
+/* The progress line writer */
+static ProgressThread *progress_thread = nullptr;
+
+/*!
+ * \brief threadBlock
+ * \return The current thread counters, created on the first call
+ */
+static StatsBlock *threadBlock()
+{
+    if(!thread_block)
+    {
+        thread_block = new StatsBlock;
+        QMutexLocker locker(&blocks_lock);
+        blocks.append(thread_block);
+    }
+    return thread_block;
+}
+
+/*!
+ * \brief bump
+ * \param[in,out] value A value of the current thread block
+ * \param[in] delta A value to add
+ *
+ * Adds without a locked instruction, only the owner changes the value.
+ */
+static inline void bump(std::atomic<qint64> &value, qint64 delta)
+{
+    value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+/*!
+ * \brief sumCounter
+ * \param[in] counter A counter
+ * \return The counter summed over all threads
+ */
+static qint64 sumCounter(ScanStats::Counter counter)
+{
+    QMutexLocker locker(&blocks_lock);
+    qint64 sum = 0;
+    foreach (const StatsBlock *block, blocks) {
+        sum += block->counters[counter].load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+/*!
+ * \brief seconds
+ * \param[in] nsecs Nanoseconds
+ * \return Seconds with milliseconds as text
+ */
+static QString seconds(qint64 nsecs)
+{
+    return QString::number(nsecs / 1e9, 'f', 3);
+}
+
+/*!
+ * \brief ProgressThread::stop
+ *
+ * Stops the thread & waits for it.
+ */
+void ProgressThread::stop()
+{
+    {
+        QMutexLocker locker(&_lock);
+        _stopped = true;
+        _condition.wakeAll();
+    }
+    wait();
+}
+
+/*!
+ * \brief ProgressThread::run
+ *
+ * Writes a progress line every few seconds until it is stopped.
+ */
+void ProgressThread::run()
+{
+    QTextStream err(stderr);
+    QMutexLocker locker(&_lock);
+
+    forever
+    {
+        _condition.wait(&_lock, ulong(_seconds) * 1000);
+        if(_stopped)
+        {
+            break;
+        }
+
+        err << "tdir: " << seconds(ScanStats::now() - started_at) << " s, " <<
+               sumCounter(ScanStats::DIRS_OPENED) << " dirs, " <<
+               sumCounter(ScanStats::ENTRIES_SEEN) << " entries, " <<
+               sumCounter(ScanStats::ENTRIES_MATCHED) << " matched, " <<
+               sumCounter(ScanStats::BYTES_WRITTEN) << " bytes written" << endl;
+    }
+}
+
+/*!
+ * \brief ScanStats::setEnabled
+ * \param[in] enabled Set to "true" to collect statistics
+ *
+ * It must be called before scanning, the elapsed time is counted from here.
+ */
+void ScanStats::setEnabled(bool enabled)
+{
+    if(enabled && !_enabled)
+    {
+        started_at = now();
+    }
+    _enabled = enabled;
+}
+
+/*!
+ * \brief ScanStats::startProgress
+ * \param[in] seconds Seconds between progress lines written to stderr
+ */
+void ScanStats::startProgress(int seconds)
+{
+    if(progress_thread || seconds <= 0)
+    {
+        return;
+    }
+
+    progress_thread = new ProgressThread(seconds);
+    progress_thread->start();
+}
+
+/*!
+ * \brief ScanStats::stopProgress
+ */
+void ScanStats::stopProgress()
+{
+    if(progress_thread)
+    {
+        progress_thread->stop();
+        delete progress_thread;
+        progress_thread = nullptr;
+    }
+}
+
+/*!
+ * \brief ScanStats::report
+ *
+ * Writes counters summed over all threads, phase times
+ * & not empty latency buckets to stderr.
+ */
+void ScanStats::report()
+{
+    qint64 counters[COUNTER_COUNT] = {};
+    qint64 nsecs[PHASE_COUNT] = {};
+    qint64 histogram[histogram_buckets] = {};
+    {
+        QMutexLocker locker(&blocks_lock);
+        foreach (const StatsBlock *block, blocks) {
+            for(int index = 0; index < COUNTER_COUNT; index++) counters[index] += block->counters[index].load();
+            for(int index = 0; index < PHASE_COUNT; index++) nsecs[index] += block->nsecs[index].load();
+            for(int index = 0; index < histogram_buckets; index++) histogram[index] += block->histogram[index].load();
+        }
+    }
+
+    static const char *phaseNames[PHASE_COUNT] = { "readdir", "match", "stat", "format", "output" };
+
+    QTextStream err(stderr);
+    err << "tdir statistics:" << endl <<
+           "  elapsed       " << seconds(now() - started_at) << " s" << endl <<
+           "  directories   " << counters[DIRS_OPENED] << " opened" << endl <<
+           "  entries       " << counters[ENTRIES_SEEN] << " seen, " << counters[ENTRIES_MATCHED] << " matched" << endl <<
+           "  stats         " << counters[STATS_ISSUED] << " issued" << endl <<
+           "  output        " << counters[BYTES_WRITTEN] << " bytes in " << counters[WRITE_CALLS] << " writes" << endl <<
+           "  pruned        " << counters[DIRS_PRUNED] << " directories, " << counters[LINKS_SKIPPED] << " hard links" << endl;
+
+    /* Phases of parallel scans are summed over threads */
+    err << "  phase time (s, summed over threads):" << endl;
+    for(int index = 0; index < PHASE_COUNT; index++)
+    {
+        err << "    " << QString(phaseNames[index]).leftJustified(10) << seconds(nsecs[index]) << endl;
+    }
+
+    err << "  directory read latency:" << endl;
+    for(int index = 0; index < histogram_buckets; index++)
+    {
+        if(histogram[index] == 0)
+        {
+            continue;
+        }
+
+        QString range;
+        if(index == 0)
+        {
+            range = "< 1 us";
+        }
+        else if(index == histogram_buckets - 1)
+        {
+            range = QString(">= %1 us").arg(Q_INT64_C(1) << (index - 1));
+        }
+        else
+        {
+            range = QString("%1-%2 us").arg(Q_INT64_C(1) << (index - 1)).arg(Q_INT64_C(1) << index);
+        }
+        err << "    " << range.leftJustified(20) << histogram[index] << endl;
+    }
+}
+
+/*!
+ * \brief ScanStats::_add
+ * \param[in] counter A counter
+ * \param[in] value A value to add
+ */
+void ScanStats::_add(Counter counter, qint64 value)
+{
+    bump(threadBlock()->counters[counter], value);
+}
+
+/*!
+ * \brief ScanStats::_addTime
+ * \param[in] phase A phase
+ * \param[in] nsecs Nanoseconds to add
+ */
+void ScanStats::_addTime(Phase phase, qint64 nsecs)
+{
+    bump(threadBlock()->nsecs[phase], nsecs);
+}
+
+/*!
+ * \brief ScanStats::_addDirRead
+ * \param[in] nsecs Time spent reading one whole directory
+ */
+void ScanStats::_addDirRead(qint64 nsecs)
+{
+    qint64 usecs = nsecs / 1000;
+    int bucket = 0;
+    while(usecs > 0 && bucket < histogram_buckets - 1)
+    {
+        usecs >>= 1;
+        bucket++;
+    }
+    bump(threadBlock()->histogram[bucket], 1);
+}
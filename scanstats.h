@@ -0,0 +1,97 @@
+/*! \file       scanstats.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      Scan Statistics module header file.
+ *
+ *  This file contains the ScanStats class declaration.
+ */
+
+#ifndef SCANSTATS_H
+#define SCANSTATS_H
+
+#include <QtCore/qglobal.h>
+
+#include <chrono>
+
+/*! \class ScanStats
+ *  \brief Scan counters & phase timing class.
+ *
+ *  This class collects counters, time per scan phase & a directory read
+ *  latency histogram. Every thread adds to its own block of counters, so
+ *  counting doesn't need locks or atomic read-modify-write operations,
+ *  blocks are summed when they are reported. When statistics are disabled
+ *  every call costs one flag check.
+ */
+class ScanStats
+{
+    public:
+        /*! \enum Counter
+         *  \brief Counted events.
+         */
+        enum Counter
+        {
+            DIRS_OPENED,        /*!< Directory descriptors opened */
+            ENTRIES_SEEN,       /*!< Directory entries read except "." & ".." */
+            ENTRIES_MATCHED,    /*!< Files passed the masks & listed */
+            STATS_ISSUED,       /*!< Stat requests */
+            BYTES_WRITTEN,      /*!< Output bytes */
+            WRITE_CALLS,        /*!< Output system calls */
+            DIRS_PRUNED,        /*!< Directories not entered by the tree guard */
+            LINKS_SKIPPED,      /*!< Files skipped as other hard links to listed files */
+            COUNTER_COUNT
+        };
+
+        /*! \enum Phase
+         *  \brief Timed scan phases.
+         */
+        enum Phase
+        {
+            PHASE_READDIR,      /*!< Reading directory entries */
+            PHASE_MATCH,        /*!< Classifying entries & matching names */
+            PHASE_STAT,         /*!< Stating files */
+            PHASE_FORMAT,       /*!< Formatting output lines */
+            PHASE_OUTPUT,       /*!< Writing output */
+            PHASE_COUNT
+        };
+
+        /*! Latency buckets: < 1 us, then [2^(n-1), 2^n) us, the last one is open */
+        static const int histogram_buckets = 24;
+
+        /*! \class PhaseTimer
+         *  \brief Adds the time of its scope to a phase.
+         */
+        class PhaseTimer
+        {
+            public:
+                explicit PhaseTimer(Phase phase) : _phase(phase), _start(_enabled ? now() : 0) {}
+                ~PhaseTimer() { if(_start) addTime(_phase, now() - _start); }
+            private:
+                Phase _phase;       /*!< A timed phase */
+                qint64 _start;      /*!< Scope start time, 0 if statistics are disabled */
+
+                Q_DISABLE_COPY(PhaseTimer)
+        };
+
+        static void setEnabled(bool enabled);
+        static bool isEnabled() { return _enabled; }
+        static qint64 now()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+        static void add(Counter counter, qint64 value) { if(_enabled) _add(counter, value); }
+        static void addTime(Phase phase, qint64 nsecs) { if(_enabled) _addTime(phase, nsecs); }
+        static void addDirRead(qint64 nsecs) { if(_enabled) _addDirRead(nsecs); }
+        static void startProgress(int seconds);
+        static void stopProgress();
+        static void report();
+    private:
+        static bool _enabled;       /*!< Statistics collection flag */
+
+        static void _add(Counter counter, qint64 value);
+        static void _addTime(Phase phase, qint64 nsecs);
+        static void _addDirRead(qint64 nsecs);
+};
+
+#endif // SCANSTATS_H
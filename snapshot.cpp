@@ -0,0 +1,354 @@
+/*! \file       snapshot.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief Snapshot module source file.
+ *
+ *  This file contains the SnapshotWriter & SnapshotReader class source code.
+ */
+
+#include "snapshot.h"
+#include "recordformat.h"
+
+#include <string.h>
+
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+/* Snapshot header magic & format version */
+static const char snapshot_magic[4] = { 'T', 'D', 'S', 'S' };
+static const quint32 snapshot_version = 1;
+
+/* The longest varint of a 64 bit number */
+static const int varint_max_size = 10;
+
+/* Mapped window size, a record longer than it gets a window of its own */
+static const qint64 snapshot_window_size = 64 * 1024 * 1024;
+
+/*!
+ * \brief appendVarint
+ * \param[out] out A buffer to append to
+ * \param[in] value A value to append
+ */
+static inline void appendVarint(QByteArray &out, quint64 value)
+{
+    char bytes[varint_max_size];
+    int size = 0;
+    while(value >= 0x80)
+    {
+        bytes[size++] = char((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    bytes[size++] = char(value);
+    out.append(bytes, size);
+}
+
+/*!
+ * \brief SnapshotWriter::SnapshotWriter
+ * \param[in] out A writer to write the snapshot to
+ *
+ * SnapshotWriter Constructor
+ */
+SnapshotWriter::SnapshotWriter(OutputWriter &out)
+{
+    _out = &out;
+    _record.reserve(4096);
+}
+
+/*!
+ * \brief SnapshotWriter::writeHeader
+ * \param[in] rootPath The listed directory, paths are relative to it
+ */
+void SnapshotWriter::writeHeader(const QByteArray &rootPath)
+{
+    _record.resize(0);
+    _record.append(snapshot_magic, sizeof(snapshot_magic));
+    appendLittleEndian(_record, snapshot_version, 4);
+    appendLittleEndian(_record, quint32(rootPath.size()), 4);
+    _record.append(rootPath);
+    _out->write(_record);
+    _previous.clear();
+}
+
+/*!
+ * \brief SnapshotWriter::add
+ * \param[in] path A raw relative path, paths must be passed in the byte order
+ * \param[in] fields File fields encoded by appendFields()
+ *
+ * Writes a record storing only the part of the path which differs from the previous one.
+ */
+void SnapshotWriter::add(const QByteArray &path, const QByteArray &fields)
+{
+    const int limit = qMin(path.size(), _previous.size());
+    int shared = 0;
+    while(shared < limit && path.at(shared) == _previous.at(shared))
+    {
+        shared++;
+    }
+
+    _record.resize(0);
+    appendVarint(_record, quint64(shared));
+    appendVarint(_record, quint64(path.size() - shared));
+    _record.append(path.constData() + shared, path.size() - shared);
+    _record.append(fields);
+    _out->write(_record);
+
+    _previous = path;
+}
+
+/*!
+ * \brief SnapshotWriter::appendFields
+ * \param[out] out A buffer to append to
+ * \param[in] entry A file
+ *
+ * Encodes the stored file fields, so they can be kept apart from the path while paths are sorted.
+ */
+void SnapshotWriter::appendFields(QByteArray &out, const DirEntry &entry)
+{
+    qint64 mtimeNsecs = entry.mtime * 1000000 + entry.mtimeNsec;
+
+    appendVarint(out, quint64(entry.size));
+    appendVarint(out, (quint64(mtimeNsecs) << 1) ^ quint64(mtimeNsecs >> 63));
+    appendVarint(out, entry.mode);
+    appendVarint(out, entry.inode);
+}
+
+/*!
+ * \brief SnapshotReader::SnapshotReader
+ * \param[in] filePath A snapshot file path
+ *
+ * SnapshotReader Constructor
+ */
+SnapshotReader::SnapshotReader(const QString &filePath) : _file(filePath)
+{
+    _fileSize = 0;
+    _window = nullptr;
+    _windowStart = 0;
+    _windowSize = 0;
+    _pos = 0;
+}
+
+/*!
+ * \brief SnapshotReader::~SnapshotReader
+ *
+ * SnapshotReader Destructor
+ */
+SnapshotReader::~SnapshotReader()
+{
+    if(_window)
+    {
+        _file.unmap(_window);
+    }
+}
+
+/*!
+ * \brief SnapshotReader::open
+ * \return "false" if the file can't be opened or it is not a snapshot
+ *
+ * Opens the file & reads the header.
+ */
+bool SnapshotReader::open()
+{
+    if(!_file.open(QIODevice::ReadOnly))
+    {
+        _errorString = "can't be opened";
+        return false;
+    }
+    _fileSize = _file.size();
+
+    const int headerSize = sizeof(snapshot_magic) + 8;
+    if(!_ensure(headerSize) ||
+       memcmp(_window + (_pos - _windowStart), snapshot_magic, sizeof(snapshot_magic)) != 0)
+    {
+        _errorString = "isn't a snapshot file";
+        return false;
+    }
+
+    const char *header = reinterpret_cast<const char *>(_window + (_pos - _windowStart));
+    quint32 version = quint32(readLittleEndian(header + 4, 4));
+    quint32 rootSize = quint32(readLittleEndian(header + 8, 4));
+    _pos += headerSize;
+
+    if(version != snapshot_version)
+    {
+        _errorString = "has an unsupported snapshot version";
+        return false;
+    }
+    if(!_readBytes(_rootPath, rootSize))
+    {
+        _errorString = "is truncated or damaged";
+        return false;
+    }
+    return true;
+}
+
+/*!
+ * \brief SnapshotReader::rootPath
+ * \return The raw path of the directory the snapshot was taken of
+ */
+const QByteArray &SnapshotReader::rootPath() const
+{
+    return _rootPath;
+}
+
+/*!
+ * \brief SnapshotReader::next
+ * \param[in,out] path The previous path, it is replaced by the next one
+ * \param[out] entry The next file fields
+ * \return "false" at the end of the snapshot or on an error
+ */
+bool SnapshotReader::next(QByteArray &path, DirEntry &entry)
+{
+    if(hasError() || _pos >= _fileSize)
+    {
+        return false;
+    }
+
+    quint64 shared = 0;
+    quint64 suffixSize = 0;
+    quint64 size = 0;
+    quint64 mtime = 0;
+    quint64 mode = 0;
+    quint64 inode = 0;
+
+    if(!_readVarint(shared) || shared > quint64(path.size()) || !_readVarint(suffixSize))
+    {
+        _errorString = "is truncated or damaged";
+        return false;
+    }
+
+    path.resize(int(shared));
+    if(!_readBytes(path, qint64(suffixSize)) ||
+       !_readVarint(size) || !_readVarint(mtime) || !_readVarint(mode) || !_readVarint(inode))
+    {
+        _errorString = "is truncated or damaged";
+        return false;
+    }
+
+    /* Milliseconds are rounded down for times before epoch too */
+    qint64 mtimeNsecs = qint64(mtime >> 1) ^ -qint64(mtime & 1);
+    qint64 mtimeMsecs = mtimeNsecs / 1000000;
+    if(mtimeNsecs % 1000000 < 0)
+    {
+        mtimeMsecs--;
+    }
+
+    entry.isDir = false;
+    entry.size = qint64(size);
+    entry.mtime = mtimeMsecs;
+    entry.mtimeNsec = int(mtimeNsecs - mtimeMsecs * 1000000);
+    entry.blocks = 0;
+    entry.mode = (unsigned int)mode;
+    entry.inode = inode;
+    entry.ctime = 0;
+    entry.uid = 0;
+    entry.links = 0;
+    entry.isLink = false;
+    return true;
+}
+
+/*!
+ * \brief SnapshotReader::hasError
+ * \return "true" if the file isn't a snapshot or it is truncated
+ */
+bool SnapshotReader::hasError() const
+{
+    return !_errorString.isEmpty();
+}
+
+/*!
+ * \brief SnapshotReader::errorString
+ * \return Why the file can't be read, like "is truncated or damaged", empty without an error
+ */
+QString SnapshotReader::errorString() const
+{
+    return _errorString;
+}
+
+/*!
+ * \brief SnapshotReader::_ensure
+ * \param[in] size Number of bytes needed from the current position
+ * \return "false" if the file is shorter or it can't be mapped
+ *
+ * Moves the window to the current position when the bytes are not in it.
+ */
+bool SnapshotReader::_ensure(qint64 size)
+{
+    if(_pos + size > _fileSize)
+    {
+        return false;
+    }
+    if(_window && _pos >= _windowStart && _pos + size <= _windowStart + _windowSize)
+    {
+        return true;
+    }
+
+    if(_window)
+    {
+        _file.unmap(_window);
+    }
+
+    _windowStart = _pos;
+    _windowSize = qMin(qMax(snapshot_window_size, size), _fileSize - _pos);
+    _window = _file.map(_windowStart, _windowSize);
+    if(_window == nullptr)
+    {
+        return false;
+    }
+
+#ifdef Q_OS_UNIX
+    /* The window is read once from the start to the end */
+    const quintptr pageMask = quintptr(sysconf(_SC_PAGESIZE)) - 1;
+    uchar *pageStart = reinterpret_cast<uchar *>(quintptr(_window) & ~pageMask);
+    posix_madvise(pageStart, size_t(_windowSize + (_window - pageStart)), POSIX_MADV_SEQUENTIAL);
+#endif
+    return true;
+}
+
+/*!
+ * \brief SnapshotReader::_readVarint
+ * \param[out] value The read value
+ * \return "false" if the varint is truncated or too long
+ */
+bool SnapshotReader::_readVarint(quint64 &value)
+{
+    if(!_ensure(qMin(qint64(varint_max_size), _fileSize - _pos)))
+    {
+        return false;
+    }
+
+    const uchar *data = _window + (_pos - _windowStart);
+    const int available = int(qMin(qint64(varint_max_size), _windowStart + _windowSize - _pos));
+
+    value = 0;
+    for(int byteNum = 0; byteNum < available; byteNum++)
+    {
+        value |= quint64(data[byteNum] & 0x7F) << (7 * byteNum);
+        if((data[byteNum] & 0x80) == 0)
+        {
+            _pos += byteNum + 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*!
+ * \brief SnapshotReader::_readBytes
+ * \param[out] out A buffer to append bytes to
+ * \param[in] size Number of bytes to read
+ * \return "false" if the file is shorter
+ */
+bool SnapshotReader::_readBytes(QByteArray &out, qint64 size)
+{
+    if(!_ensure(size))
+    {
+        return false;
+    }
+
+    out.append(reinterpret_cast<const char *>(_window + (_pos - _windowStart)), int(size));
+    _pos += size;
+    return true;
+}
@@ -0,0 +1,94 @@
+/*! \file       snapshot.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      Snapshot module header file.
+ *
+ *  This file contains the SnapshotWriter & SnapshotReader class declarations.
+ *
+ *  A snapshot is a file list sorted by raw paths relative to the listed
+ *  directory, so two snapshots are compared by one linear merge. It starts
+ *  with a header:
+ *      char[4] magic "TDSS", quint32 version, quint32 root_size, char[root_size] root
+ *  Each file record follows as:
+ *      varint  shared              (path bytes shared with the previous path)
+ *      varint  suffix_size
+ *      char[suffix_size] suffix    (the rest of the path)
+ *      varint  size                (file size in bytes)
+ *      varint  mtime_nsecs         (zigzag encoded nanoseconds since epoch)
+ *      varint  mode                (st_mode, 0 if it is not known)
+ *      varint  inode               (0 if it is not known)
+ *  Fixed size numbers are little-endian, varints are LEB128 (7 bits per byte,
+ *  the low group first). Sorted paths share long prefixes, so a record takes
+ *  a few bytes besides the file name.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <QtCore/qglobal.h>
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include "dirreader.h"
+#include "outputwriter.h"
+
+/*! \class SnapshotWriter
+ *  \brief Snapshot file writer class.
+ *
+ *  This class front codes paths passed in the byte order & writes
+ *  records through an output writer.
+ */
+class SnapshotWriter
+{
+    public:
+        explicit SnapshotWriter(OutputWriter &out);
+        void writeHeader(const QByteArray &rootPath);
+        void add(const QByteArray &path, const QByteArray &fields);
+        static void appendFields(QByteArray &out, const DirEntry &entry);
+    private:
+        OutputWriter *_out;     /*!< A writer to write records to */
+        QByteArray _previous;   /*!< The previous path */
+        QByteArray _record;     /*!< A reusable record buffer */
+
+        Q_DISABLE_COPY(SnapshotWriter)
+};
+
+/*! \class SnapshotReader
+ *  \brief Snapshot file reader class.
+ *
+ *  This class decodes records straight from a memory mapped window of
+ *  the file. The window slides along the file, so a snapshot of any size
+ *  takes a bounded address space & pages behind it can be dropped.
+ *  The path buffer of a passed record is reused, only the suffix is copied.
+ */
+class SnapshotReader
+{
+    public:
+        explicit SnapshotReader(const QString &filePath);
+        ~SnapshotReader();
+        bool open();
+        const QByteArray &rootPath() const;
+        bool next(QByteArray &path, DirEntry &entry);
+        bool hasError() const;
+        QString errorString() const;
+    private:
+        QFile _file;            /*!< The snapshot file */
+        qint64 _fileSize;       /*!< The file size */
+        uchar *_window;         /*!< The mapped window or null */
+        qint64 _windowStart;    /*!< The file offset of the window */
+        qint64 _windowSize;     /*!< The window size */
+        qint64 _pos;            /*!< The file offset of the next byte */
+        QByteArray _rootPath;   /*!< The listed directory */
+        QString _errorString;   /*!< Why the file can't be read, empty without an error */
+
+        bool _ensure(qint64 size);
+        bool _readVarint(quint64 &value);
+        bool _readBytes(QByteArray &out, qint64 size);
+
+        Q_DISABLE_COPY(SnapshotReader)
+};
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,198 @@
+/*! \file       spscring.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      SPSC Ring module header file.
+ *
+ *  This file contains the SpscRing class template.
+ */
+
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <QtCore/qglobal.h>
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+/*! \class SpscRing
+ *  \brief Bounded single producer single consumer ring class template.
+ *
+ *  Items are passed through a power of two array indexed by two counters,
+ *  each of them is changed by one side only, so pushing & popping take
+ *  no lock. A side which finds the ring full (or empty) yields for a while
+ *  & then sleeps until the other side moves, which is the backpressure.
+ *  A sleeping side is woken under a mutex only when it has announced itself,
+ *  the sleep is also limited in time so a missed wake-up costs little.
+ */
+template<typename T>
+class SpscRing
+{
+    public:
+        explicit SpscRing(int capacity);
+        bool push(const T &item);
+        bool pop(T &item);
+        void close();
+    private:
+        QVector<T> _slots;          /*!< Ring slots */
+        T *_data;                   /*!< The slot array, it is never reallocated */
+        quint32 _mask;              /*!< The slot count minus one */
+        QAtomicInt _head;           /*!< Number of popped items, changed by the consumer */
+        QAtomicInt _tail;           /*!< Number of pushed items, changed by the producer */
+        QAtomicInt _closed;         /*!< Set when the producer has finished */
+        QAtomicInt _sleepers;       /*!< Number of sides going to sleep */
+        QMutex _lock;               /*!< Guards sleeping */
+        QWaitCondition _wakeUp;     /*!< Wakes a sleeping side */
+
+        template<typename Ready>
+        void _wait(int &spins, Ready ready);
+        void _wake();
+
+        Q_DISABLE_COPY(SpscRing)
+};
+
+/* A side yields this many times before it sleeps */
+static const int spsc_ring_spins = 64;
+
+/* The longest sleep in milliseconds */
+static const unsigned long spsc_ring_sleep_ms = 1;
+
+/*!
+ * \brief SpscRing::SpscRing
+ * \param[in] capacity Minimal number of items in flight, it is rounded up to a power of two
+ *
+ * SpscRing Constructor
+ */
+template<typename T>
+SpscRing<T>::SpscRing(int capacity)
+{
+    int size = 1;
+    while(size < capacity)
+    {
+        size <<= 1;
+    }
+
+    _slots.resize(size);
+    _data = _slots.data();
+    _mask = quint32(size - 1);
+}
+
+/*!
+ * \brief SpscRing::push
+ * \param[in] item An item to pass
+ * \return "false" if the ring is closed
+ *
+ * Waits while the ring is full. It is called by the producer only.
+ */
+template<typename T>
+bool SpscRing<T>::push(const T &item)
+{
+    const quint32 tail = quint32(_tail.load());
+    int spins = 0;
+    while(tail - quint32(_head.loadAcquire()) > _mask)
+    {
+        if(_closed.loadAcquire())
+        {
+            return false;
+        }
+        _wait(spins, [this, tail]() { return tail - quint32(_head.loadAcquire()) <= _mask; });
+    }
+
+    _data[tail & _mask] = item;
+
+    /* The full barrier publishes the item before the sleepers are looked at */
+    _tail.fetchAndAddOrdered(1);
+    if(_sleepers.loadAcquire() > 0)
+    {
+        _wake();
+    }
+    return true;
+}
+
+/*!
+ * \brief SpscRing::pop
+ * \param[out] item The next item
+ * \return "false" if the ring is closed & all items have been popped
+ *
+ * Waits while the ring is empty. It is called by the consumer only.
+ */
+template<typename T>
+bool SpscRing<T>::pop(T &item)
+{
+    const quint32 head = quint32(_head.load());
+    int spins = 0;
+    while(quint32(_tail.loadAcquire()) == head)
+    {
+        if(_closed.loadAcquire() && quint32(_tail.loadAcquire()) == head)
+        {
+            return false;
+        }
+        _wait(spins, [this, head]() { return quint32(_tail.loadAcquire()) != head || _closed.loadAcquire(); });
+    }
+
+    item = _data[head & _mask];
+
+    /* The full barrier frees the slot before the sleepers are looked at */
+    _head.fetchAndAddOrdered(1);
+    if(_sleepers.loadAcquire() > 0)
+    {
+        _wake();
+    }
+    return true;
+}
+
+/*!
+ * \brief SpscRing::close
+ *
+ * Tells the consumer that no more items will be pushed. It is called by the producer.
+ */
+template<typename T>
+void SpscRing<T>::close()
+{
+    _closed.fetchAndStoreOrdered(1);
+    _wake();
+}
+
+/*!
+ * \brief SpscRing::_wait
+ * \param[in,out] spins Number of waits so far
+ * \param[in] ready A function telling if the wait is over
+ *
+ * Yields first, then sleeps until the other side wakes this one up.
+ */
+template<typename T>
+template<typename Ready>
+void SpscRing<T>::_wait(int &spins, Ready ready)
+{
+    if(++spins < spsc_ring_spins)
+    {
+        QThread::yieldCurrentThread();
+        return;
+    }
+
+    QMutexLocker locker(&_lock);
+    _sleepers.fetchAndAddOrdered(1);
+    if(!ready())
+    {
+        _wakeUp.wait(&_lock, spsc_ring_sleep_ms);
+    }
+    _sleepers.fetchAndAddOrdered(-1);
+}
+
+/*!
+ * \brief SpscRing::_wake
+ *
+ * Wakes a sleeping side up.
+ */
+template<typename T>
+void SpscRing<T>::_wake()
+{
+    QMutexLocker locker(&_lock);
+    _wakeUp.wakeAll();
+}
+
+#endif // SPSCRING_H
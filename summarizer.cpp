@@ -0,0 +1,238 @@
+/*! \file       summarizer.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief Summarizer module source file.
+ *
+ *  This file contains the Summarizer class source code.
+ */
+
+#include "summarizer.h"
+
+#include <QFile>
+#include <QMutexLocker>
+#include <QPair>
+
+/*!
+ * \brief Summarizer::Summarizer
+ * \param[in] reportDepth Maximal depth of reported directories, the root depth is 0
+ *
+ * Summarizer Constructor
+ */
+Summarizer::Summarizer(int reportDepth)
+{
+    _reportDepth = reportDepth;
+    _root = nullptr;
+}
+
+/*!
+ * \brief Summarizer::~Summarizer
+ *
+ * Summarizer Destructor
+ */
+Summarizer::~Summarizer()
+{
+    if(_root) _deleteTree(_root);
+}
+
+/*!
+ * \brief Summarizer::start
+ * \param[in] rootPath A root dir, its subtree is summed
+ */
+void Summarizer::start(const QString &rootPath)
+{
+    if(_root) _deleteTree(_root);
+
+    _root = _createNode(rootPath, 0, nullptr);
+    _pending.insert(rootPath, _root);
+}
+
+/*!
+ * \brief Summarizer::_createNode
+ * \param[in] path An absolute directory path
+ * \param[in] depth The directory depth
+ * \param[in] parent The parent directory
+ * \return A new node waiting for the directory itself
+ */
+Summarizer::Node *Summarizer::_createNode(const QString &path, int depth, Node *parent)
+{
+    Node *node = new Node;
+    node->path = path;
+    node->depth = depth;
+    node->parent = parent;
+    node->remaining.store(1);
+    node->files.store(0);
+    node->bytes.store(0);
+    node->blocks.store(0);
+    return node;
+}
+
+/*!
+ * \brief Summarizer::add
+ * \param[in] dirPath A directory scheduled by start() or a previous add()
+ * \param[in] entries Directory files & subdirectories
+ * \param[in] enterSubdirs Set to "false" not to sum subdirectories
+ * \return Absolute paths of subdirectories to add
+ *
+ * Adds directory files. It may be called from parallel traversal threads.
+ */
+QStringList Summarizer::add(const QString &dirPath, const QVector<DirEntry> &entries, bool enterSubdirs)
+{
+    QStringList subdirList;
+
+    Node *node = nullptr;
+    {
+        QMutexLocker locker(&_lock);
+        node = _pending.take(dirPath);
+    }
+    if(node == nullptr)
+    {
+        return subdirList;
+    }
+
+    QString prefix = dirPath.endsWith(QChar('/')) ? dirPath : dirPath + QChar('/');
+    qint64 files = 0;
+    qint64 bytes = 0;
+    qint64 blocks = 0;
+
+    foreach (const DirEntry &entry, entries) {
+        if(!entry.isDir)
+        {
+            files++;
+            bytes += entry.size;
+            blocks += entry.blocks;
+        }
+        else if(enterSubdirs)
+        {
+            subdirList.append(prefix + QFile::decodeName(entry.name));
+        }
+    }
+
+    node->files.fetchAndAddOrdered(files);
+    node->bytes.fetchAndAddOrdered(bytes);
+    node->blocks.fetchAndAddOrdered(blocks);
+
+    /* Subdirectories are scheduled before they can be scanned */
+    if(!subdirList.isEmpty())
+    {
+        node->remaining.fetchAndAddOrdered(subdirList.count());
+
+        QMutexLocker locker(&_lock);
+        foreach (const QString &subdir, subdirList) {
+            Node *child = _createNode(subdir, node->depth + 1, node);
+            if(child->depth <= _reportDepth)
+            {
+                node->children.append(child);
+            }
+            _pending.insert(subdir, child);
+        }
+    }
+
+    if(!node->remaining.deref())
+    {
+        _complete(node);
+    }
+
+    return subdirList;
+}
+
+/*!
+ * \brief Summarizer::_complete
+ * \param[in] node A directory summed together with all its subdirectories
+ *
+ * Adds the directory totals to its parent going up while parents get complete.
+ * Directories deeper than the report depth are freed at once.
+ */
+void Summarizer::_complete(Node *node)
+{
+    while(node)
+    {
+        Node *parent = node->parent;
+
+        if(parent)
+        {
+            parent->files.fetchAndAddOrdered(node->files.load());
+            parent->bytes.fetchAndAddOrdered(node->bytes.load());
+            parent->blocks.fetchAndAddOrdered(node->blocks.load());
+        }
+
+        if(node->depth > _reportDepth)
+        {
+            delete node;
+        }
+
+        if(parent == nullptr || parent->remaining.deref())
+        {
+            break;
+        }
+        node = parent;
+    }
+}
+
+/*!
+ * \brief Summarizer::report
+ * \param[in] report A function to pass reported directories to
+ *
+ * Reports directories up to the report depth in the post-order after
+ * all directories have been added, subdirectories in the scan order.
+ */
+void Summarizer::report(const ReportFunction &report) const
+{
+    if(_root == nullptr)
+    {
+        return;
+    }
+
+    /* Nodes with the next child index */
+    QVector<QPair<Node *, int> > stack;
+    stack.append(qMakePair(_root, 0));
+
+    while(!stack.isEmpty())
+    {
+        QPair<Node *, int> &top = stack.last();
+        Node *node = top.first;
+
+        if(top.second < node->children.count())
+        {
+            Node *child = node->children.at(top.second++);
+            stack.append(qMakePair(child, 0));
+            continue;
+        }
+
+        Totals totals;
+        totals.files = node->files.load();
+        totals.bytes = node->bytes.load();
+        totals.blocks = node->blocks.load();
+        report(node->path, node->depth, totals);
+
+        stack.removeLast();
+    }
+}
+
+/*!
+ * \brief Summarizer::_deleteTree
+ * \param[in] node A directory to free with its kept subdirectories
+ */
+void Summarizer::_deleteTree(Node *node)
+{
+    QVector<Node *> stack;
+    stack.append(node);
+
+    while(!stack.isEmpty())
+    {
+        Node *current = stack.takeLast();
+        foreach (Node *child, current->children) {
+            stack.append(child);
+        }
+        delete current;
+    }
+
+    /* Deeper directories are only in the map if the traversal was not finished */
+    foreach (Node *pendingNode, _pending) {
+        if(pendingNode->depth > _reportDepth)
+        {
+            delete pendingNode;
+        }
+    }
+    _pending.clear();
+}
@@ -0,0 +1,83 @@
+/*! \file       summarizer.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      Summarizer module header file.
+ *
+ *  This file contains the Summarizer class declaration.
+ */
+
+#ifndef SUMMARIZER_H
+#define SUMMARIZER_H
+
+#include <QtCore/qglobal.h>
+
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <functional>
+
+#include "dirreader.h"
+
+/*! \class Summarizer
+ *  \brief Directory tree size aggregation class.
+ *
+ *  This class sums file counts, apparent sizes & allocated blocks of
+ *  directory trees. Directories may be added from parallel traversal threads,
+ *  a directory total is added to its parent as soon as the directory & all its
+ *  subdirectories are added, so only directories up to the report depth are
+ *  kept until the end.
+ */
+class Summarizer
+{
+    public:
+        /*! \struct Totals
+         *  \brief Directory tree totals.
+         */
+        struct Totals
+        {
+            qint64 files;   /*!< Number of files */
+            qint64 bytes;   /*!< Apparent size in bytes */
+            qint64 blocks;  /*!< Allocated 512 byte blocks */
+        };
+
+        /*! A report function getting directories with their depths in the post-order */
+        typedef std::function<void (const QString &dirPath, int depth, const Totals &totals)> ReportFunction;
+
+        explicit Summarizer(int reportDepth);
+        ~Summarizer();
+        void start(const QString &rootPath);
+        QStringList add(const QString &dirPath, const QVector<DirEntry> &entries, bool enterSubdirs);
+        void report(const ReportFunction &report) const;
+    private:
+        /*! \struct Node
+         *  \brief A directory being summed.
+         */
+        struct Node
+        {
+            QString path;                   /*!< An absolute directory path */
+            int depth;                      /*!< The directory depth, the root depth is 0 */
+            Node *parent;                   /*!< The parent directory or nullptr for the root */
+            QAtomicInt remaining;           /*!< The directory itself & subdirectories not summed yet */
+            QAtomicInteger<qint64> files;   /*!< Number of files */
+            QAtomicInteger<qint64> bytes;   /*!< Apparent size in bytes */
+            QAtomicInteger<qint64> blocks;  /*!< Allocated 512 byte blocks */
+            QVector<Node *> children;       /*!< Subdirectories kept for the report */
+        };
+
+        int _reportDepth;                   /*!< Maximal depth of reported directories */
+        Node *_root;                        /*!< The root directory */
+        QMutex _lock;                       /*!< Guards the pending directory map */
+        QHash<QString, Node *> _pending;    /*!< Directories scheduled for adding */
+
+        Node *_createNode(const QString &path, int depth, Node *parent);
+        void _complete(Node *node);
+        void _deleteTree(Node *node);
+};
+
+#endif // SUMMARIZER_H
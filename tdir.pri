@@ -0,0 +1,25 @@
+#-------------------------------------------------
+#
+# Command line front end shared by tdir & tdir_bench,
+# it is linked with the tdirengine library
+#
+#-------------------------------------------------
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/fileenumerator.cpp
+
+HEADERS += \
+    $$PWD/fileenumerator.h \
+    $$PWD/exitcodes.h \
+    $$PWD/options.h
+
+CONFIG(debug, debug|release):TDIR_ENGINE_DIR = $$OUT_PWD/lib/debug
+CONFIG(release, debug|release):TDIR_ENGINE_DIR = $$OUT_PWD/lib
+
+LIBS += -L$$TDIR_ENGINE_DIR -ltdirengine
+
+# Relinking when the engine changes
+win32-msvc*:PRE_TARGETDEPS += $$TDIR_ENGINE_DIR/tdirengine.lib
+else:PRE_TARGETDEPS += $$TDIR_ENGINE_DIR/libtdirengine.a
@@ -0,0 +1,23 @@
+#-------------------------------------------------
+#
+# Builds the engine library, then tdir, tdir_bench & tdirrecords
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    engine \
+    app \
+    bench \
+    records
+
+engine.file = tdirengine.pro
+
+app.file = tdir.pro
+app.depends = engine
+
+bench.file = tdir_bench.pro
+bench.depends = engine
+
+records.file = tdirrecords.pro
@@ -0,0 +1,44 @@
+#-------------------------------------------------
+#
+# FileEnumerator benchmark on synthetic trees
+#
+#-------------------------------------------------
+
+VERSION = 1.0.0.1
+
+QT       += core
+
+QT       -= gui
+
+TARGET = tdir_bench
+CONFIG   += console c++11
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+DEFINES += APP_VERSION=\\\"$$VERSION\\\"
+
+include(tdir.pri)
+
+INCLUDEPATH += bench
+
+SOURCES += \
+    bench/benchmain.cpp \
+    bench/benchrunner.cpp \
+    bench/treegenerator.cpp
+
+HEADERS += \
+    bench/benchrunner.h \
+    bench/treegenerator.h
+
+CONFIG -= debug_and_release debug_and_release_target
+
+# Setting paths for compiled binaries
+CONFIG(debug, debug|release):DESTDIR = bin/debug
+CONFIG(release, debug|release):DESTDIR = bin
+
+# Temporary moc files destination
+MOC_DIR = moc/tdir_bench
+
+# Object files destination
+OBJECTS_DIR = obj/tdir_bench
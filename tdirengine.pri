@@ -0,0 +1,57 @@
+#-------------------------------------------------
+#
+# Enumeration engine sources
+#
+#-------------------------------------------------
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/treeenumerator.cpp \
+    $$PWD/patharena.cpp \
+    $$PWD/treeguard.cpp \
+    $$PWD/traversalpool.cpp \
+    $$PWD/dirreader.cpp \
+    $$PWD/outputwriter.cpp \
+    $$PWD/timeformatter.cpp \
+    $$PWD/treeindex.cpp \
+    $$PWD/dirwatcher.cpp \
+    $$PWD/uringstat.cpp \
+    $$PWD/globmatcher.cpp \
+    $$PWD/filepredicate.cpp \
+    $$PWD/summarizer.cpp \
+    $$PWD/topcollector.cpp \
+    $$PWD/externalsorter.cpp \
+    $$PWD/snapshot.cpp \
+    $$PWD/nameindex.cpp \
+    $$PWD/contenthash.cpp \
+    $$PWD/dupefinder.cpp \
+    $$PWD/recordsink.cpp \
+    $$PWD/recordpipeline.cpp \
+    $$PWD/scanstats.cpp
+
+HEADERS += \
+    $$PWD/treeenumerator.h \
+    $$PWD/patharena.h \
+    $$PWD/treeguard.h \
+    $$PWD/traversalpool.h \
+    $$PWD/dirreader.h \
+    $$PWD/outputwriter.h \
+    $$PWD/timeformatter.h \
+    $$PWD/treeindex.h \
+    $$PWD/dirwatcher.h \
+    $$PWD/uringstat.h \
+    $$PWD/globmatcher.h \
+    $$PWD/filepredicate.h \
+    $$PWD/summarizer.h \
+    $$PWD/topcollector.h \
+    $$PWD/externalsorter.h \
+    $$PWD/snapshot.h \
+    $$PWD/nameindex.h \
+    $$PWD/contenthash.h \
+    $$PWD/dupefinder.h \
+    $$PWD/recordsink.h \
+    $$PWD/recordpipeline.h \
+    $$PWD/spscring.h \
+    $$PWD/recordformat.h \
+    $$PWD/scanstats.h
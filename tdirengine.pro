@@ -0,0 +1,30 @@
+#-------------------------------------------------
+#
+# Enumeration engine library, tdir is a command line front end to it
+#
+#-------------------------------------------------
+
+VERSION = 1.0.0.1
+
+QT       += core
+
+QT       -= gui
+
+TARGET = tdirengine
+CONFIG   += staticlib c++11
+
+TEMPLATE = lib
+
+include(tdirengine.pri)
+
+CONFIG -= debug_and_release debug_and_release_target
+
+# Setting paths for compiled libraries
+CONFIG(debug, debug|release):DESTDIR = lib/debug
+CONFIG(release, debug|release):DESTDIR = lib
+
+# Temporary moc files destination
+MOC_DIR = moc/tdirengine
+
+# Object files destination
+OBJECTS_DIR = obj/tdirengine
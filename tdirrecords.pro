@@ -0,0 +1,31 @@
+#-------------------------------------------------
+#
+# Binary record reader library for "tdir --format binary" consumers
+#
+#-------------------------------------------------
+
+VERSION = 1.0.0.1
+
+QT       += core
+
+QT       -= gui
+
+TARGET = tdirrecords
+CONFIG   += staticlib c++11
+
+TEMPLATE = lib
+
+SOURCES += recordreader.cpp
+
+HEADERS += \
+    recordreader.h \
+    recordformat.h
+
+CONFIG -= debug_and_release debug_and_release_target
+
+# Setting paths for compiled libraries
+CONFIG(debug, debug|release):DESTDIR = lib/debug
+CONFIG(release, debug|release):DESTDIR = lib
+
+# Object files destination
+OBJECTS_DIR = obj/tdirrecords
@@ -0,0 +1,389 @@
+/*! \file       timeformatter.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief Time Formatter module source file.
+ *
+ *  This file contains the TimeFormatter class source code.
+ */
+
+#include "timeformatter.h"
+
+#include <QDateTime>
+
+static const qint64 msecs_per_second = 1000;
+static const qint64 secs_per_hour = 3600;
+static const qint64 secs_per_day = 86400;
+
+/*! \struct LocalTimeCache
+ *  \brief Per thread cache of the UTC offset for an hour & the date for a day.
+ */
+struct LocalTimeCache
+{
+    qint64 hour;        /*!< Cached UTC hour since epoch */
+    int offset;         /*!< UTC offset in seconds for the whole cached hour */
+    bool hourValid;     /*!< Set if the hour is cached */
+    qint64 day;         /*!< Cached local day since epoch */
+    int year;           /*!< The cached day year */
+    int month;          /*!< The cached day month */
+    int dayOfMonth;     /*!< The cached day of month */
+    bool dayValid;      /*!< Set if the day is cached */
+};
+
+static thread_local LocalTimeCache local_time_cache = { 0, 0, false, 0, 0, 0, 0, false };
+
+/*!
+ * \brief floorDiv
+ * \return Quotient rounded down for negative times
+ */
+static inline qint64 floorDiv(qint64 value, qint64 divisor)
+{
+    return (value >= 0) ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+/*!
+ * \brief utcOffset
+ * \param[in] secs Seconds since epoch
+ * \return Local time UTC offset in seconds the same as QDateTime uses
+ */
+static inline int utcOffset(qint64 secs)
+{
+    return QDateTime::fromMSecsSinceEpoch(secs * msecs_per_second).offsetFromUtc();
+}
+
+/*!
+ * \brief civilFromDays
+ * \param[in] days Days since epoch
+ *
+ * Converts days since epoch to a proleptic Gregorian date.
+ */
+static void civilFromDays(qint64 days, int &year, int &month, int &day)
+{
+    days += 719468;
+    const qint64 era = floorDiv(days, 146097);
+    const qint64 dayOfEra = days - era * 146097;
+    const qint64 yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    const qint64 dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    const qint64 shiftedMonth = (5 * dayOfYear + 2) / 153;
+
+    day = int(dayOfYear - (153 * shiftedMonth + 2) / 5 + 1);
+    month = int(shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9);
+    year = int(yearOfEra + era * 400 + (month <= 2 ? 1 : 0));
+}
+
+/*!
+ * \brief appendNumber
+ * \param[out] out A buffer to append to
+ * \param[in] value A non negative number
+ * \param[in] width Minimal width padded with zeros
+ */
+static inline void appendNumber(QByteArray &out, int value, int width)
+{
+    char digits[12];
+    int length = 0;
+
+    do
+    {
+        digits[length++] = char('0' + value % 10);
+        value /= 10;
+    }
+    while(value > 0);
+
+    while(length < width)
+    {
+        digits[length++] = '0';
+    }
+
+    while(length > 0)
+    {
+        out.append(digits[--length]);
+    }
+}
+
+/*!
+ * \brief TimeFormatter::TimeFormatter
+ * \param[in] format A QDateTime::toString format
+ * \param[in] codec Output codec to encode literals with
+ *
+ * TimeFormatter Constructor
+ */
+TimeFormatter::TimeFormatter(const QString &format, QTextCodec *codec)
+{
+    _format = format;
+    _codec = codec;
+    _compile();
+}
+
+/*!
+ * \brief TimeFormatter::isCompiled
+ * \return "true" if the format is formatted by compiled fields
+ */
+bool TimeFormatter::isCompiled() const
+{
+    return _compiled;
+}
+
+/*!
+ * \brief TimeFormatter::_addField
+ * \param[in] type A field type
+ * \param[in] literal A literal text for literal fields
+ *
+ * Adds a field, merging adjacent literals.
+ */
+void TimeFormatter::_addField(FieldType type, const QString &literal)
+{
+    if(type == FIELD_LITERAL)
+    {
+        QByteArray encoded = _codec->fromUnicode(literal);
+        if(!_fields.isEmpty() && _fields.last().type == FIELD_LITERAL)
+        {
+            _fields.last().literal.append(encoded);
+            return;
+        }
+
+        Field field;
+        field.type = FIELD_LITERAL;
+        field.literal = encoded;
+        _fields.append(field);
+        return;
+    }
+
+    Field field;
+    field.type = type;
+    _fields.append(field);
+}
+
+/*!
+ * \brief TimeFormatter::_compile
+ *
+ * Parses the format the same way as QDateTime::toString does.
+ */
+void TimeFormatter::_compile()
+{
+    _compiled = true;
+    _fields.clear();
+
+    int pos = 0;
+    while(pos < _format.size())
+    {
+        const QChar c = _format.at(pos);
+
+        /* Quoted text, "''" is a quote itself */
+        if(c == QChar('\''))
+        {
+            pos++;
+            if(pos < _format.size() && _format.at(pos) == QChar('\''))
+            {
+                _addField(FIELD_LITERAL, QString(QChar('\'')));
+                pos++;
+                continue;
+            }
+
+            QString text;
+            while(pos < _format.size())
+            {
+                if(_format.at(pos) == QChar('\''))
+                {
+                    if(pos + 1 < _format.size() && _format.at(pos + 1) == QChar('\''))
+                    {
+                        text.append(QChar('\''));
+                        pos += 2;
+                        continue;
+                    }
+                    break;
+                }
+                text.append(_format.at(pos++));
+            }
+            if(pos < _format.size())
+            {
+                pos++;
+            }
+            _addField(FIELD_LITERAL, text);
+            continue;
+        }
+
+        int repeat = 1;
+        while(pos + repeat < _format.size() && _format.at(pos + repeat) == c)
+        {
+            repeat++;
+        }
+
+        switch(c.toLatin1())
+        {
+            case 'd':
+            case 'M':
+                /* Day & month names are left to QDateTime */
+                if(repeat >= 3)
+                {
+                    _compiled = false;
+                    return;
+                }
+                if(c == QChar('d'))
+                {
+                    _addField(repeat == 2 ? FIELD_DAY2 : FIELD_DAY);
+                }
+                else
+                {
+                    _addField(repeat == 2 ? FIELD_MONTH2 : FIELD_MONTH);
+                }
+                break;
+            case 'y':
+                if(repeat >= 4)
+                {
+                    repeat = 4;
+                    _addField(FIELD_YEAR4);
+                }
+                else if(repeat >= 2)
+                {
+                    repeat = 2;
+                    _addField(FIELD_YEAR2);
+                }
+                else
+                {
+                    _addField(FIELD_LITERAL, QString(c));
+                }
+                break;
+            case 'h':
+            case 'H':
+                repeat = qMin(repeat, 2);
+                _addField(repeat == 2 ? FIELD_HOUR2 : FIELD_HOUR);
+                break;
+            case 'm':
+                repeat = qMin(repeat, 2);
+                _addField(repeat == 2 ? FIELD_MINUTE2 : FIELD_MINUTE);
+                break;
+            case 's':
+                repeat = qMin(repeat, 2);
+                _addField(repeat == 2 ? FIELD_SECOND2 : FIELD_SECOND);
+                break;
+            case 'z':
+                repeat = (repeat >= 3) ? 3 : 1;
+                _addField(repeat == 3 ? FIELD_MSEC3 : FIELD_MSEC);
+                break;
+            case 'a':
+            case 'A':
+            case 't':
+                /* AM/PM markers & time zone names are left to QDateTime */
+                _compiled = false;
+                return;
+            default:
+                _addField(FIELD_LITERAL, QString(repeat, c));
+                break;
+        }
+
+        pos += repeat;
+    }
+}
+
+/*!
+ * \brief TimeFormatter::append
+ * \param[out] out A buffer to append encoded local time to
+ * \param[in] msecs Milliseconds since epoch
+ */
+void TimeFormatter::append(QByteArray &out, qint64 msecs) const
+{
+    if(!_compiled)
+    {
+        out.append(_codec->fromUnicode(QDateTime::fromMSecsSinceEpoch(msecs).toString(_format)));
+        return;
+    }
+
+    LocalTimeCache &cache = local_time_cache;
+
+    const qint64 secs = floorDiv(msecs, msecs_per_second);
+    const int msec = int(msecs - secs * msecs_per_second);
+
+    /* The offset is cached only if it is the same for the whole hour */
+    const qint64 hour = floorDiv(secs, secs_per_hour);
+    int offset;
+    if(cache.hourValid && cache.hour == hour)
+    {
+        offset = cache.offset;
+    }
+    else
+    {
+        offset = utcOffset(hour * secs_per_hour);
+        if(offset == utcOffset(hour * secs_per_hour + secs_per_hour - 1))
+        {
+            cache.hour = hour;
+            cache.offset = offset;
+            cache.hourValid = true;
+        }
+        else
+        {
+            cache.hourValid = false;
+            offset = utcOffset(secs);
+        }
+    }
+
+    const qint64 localSecs = secs + offset;
+    const qint64 day = floorDiv(localSecs, secs_per_day);
+    const int secOfDay = int(localSecs - day * secs_per_day);
+
+    if(!cache.dayValid || cache.day != day)
+    {
+        civilFromDays(day, cache.year, cache.month, cache.dayOfMonth);
+        cache.day = day;
+        cache.dayValid = true;
+    }
+
+    /* Years out of four digits range are left to QDateTime */
+    if(cache.year < 1 || cache.year > 9999)
+    {
+        out.append(_codec->fromUnicode(QDateTime::fromMSecsSinceEpoch(msecs).toString(_format)));
+        return;
+    }
+
+    for(int fieldNum = 0; fieldNum < _fields.count(); fieldNum++)
+    {
+        const Field &field = _fields.at(fieldNum);
+        switch(field.type)
+        {
+            case FIELD_LITERAL:
+                out.append(field.literal);
+                break;
+            case FIELD_DAY:
+                appendNumber(out, cache.dayOfMonth, 1);
+                break;
+            case FIELD_DAY2:
+                appendNumber(out, cache.dayOfMonth, 2);
+                break;
+            case FIELD_MONTH:
+                appendNumber(out, cache.month, 1);
+                break;
+            case FIELD_MONTH2:
+                appendNumber(out, cache.month, 2);
+                break;
+            case FIELD_YEAR2:
+                appendNumber(out, cache.year % 100, 2);
+                break;
+            case FIELD_YEAR4:
+                appendNumber(out, cache.year, 4);
+                break;
+            case FIELD_HOUR:
+                appendNumber(out, secOfDay / 3600, 1);
+                break;
+            case FIELD_HOUR2:
+                appendNumber(out, secOfDay / 3600, 2);
+                break;
+            case FIELD_MINUTE:
+                appendNumber(out, secOfDay / 60 % 60, 1);
+                break;
+            case FIELD_MINUTE2:
+                appendNumber(out, secOfDay / 60 % 60, 2);
+                break;
+            case FIELD_SECOND:
+                appendNumber(out, secOfDay % 60, 1);
+                break;
+            case FIELD_SECOND2:
+                appendNumber(out, secOfDay % 60, 2);
+                break;
+            case FIELD_MSEC:
+                appendNumber(out, msec, 1);
+                break;
+            case FIELD_MSEC3:
+                appendNumber(out, msec, 3);
+                break;
+        }
+    }
+}
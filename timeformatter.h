@@ -0,0 +1,76 @@
+/*! \file       timeformatter.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      Time Formatter module header file.
+ *
+ *  This file contains the TimeFormatter class declaration.
+ */
+
+#ifndef TIMEFORMATTER_H
+#define TIMEFORMATTER_H
+
+#include <QtCore/qglobal.h>
+
+#include <QByteArray>
+#include <QString>
+#include <QTextCodec>
+#include <QVector>
+
+/*! \class TimeFormatter
+ *  \brief Compiled local time formatter class.
+ *
+ *  This class compiles a QDateTime::toString format once into a sequence
+ *  of numeric fields & encoded literals. Local time is computed from epoch
+ *  milliseconds with the UTC offset & the date cached per thread for the
+ *  current hour & day. The output is the same as QDateTime::toString gives.
+ *  Formats with names (ddd, MMM, AP, t) are formatted by QDateTime.
+ */
+class TimeFormatter
+{
+    public:
+        TimeFormatter(const QString &format, QTextCodec *codec);
+        bool isCompiled() const;
+        void append(QByteArray &out, qint64 msecs) const;
+    private:
+        /*! \enum FieldType
+         *  \brief Compiled format field types.
+         */
+        enum FieldType
+        {
+            FIELD_LITERAL,      /*!< Encoded literal text */
+            FIELD_DAY,          /*!< d */
+            FIELD_DAY2,         /*!< dd */
+            FIELD_MONTH,        /*!< M */
+            FIELD_MONTH2,       /*!< MM */
+            FIELD_YEAR2,        /*!< yy */
+            FIELD_YEAR4,        /*!< yyyy */
+            FIELD_HOUR,         /*!< h, H */
+            FIELD_HOUR2,        /*!< hh, HH */
+            FIELD_MINUTE,       /*!< m */
+            FIELD_MINUTE2,      /*!< mm */
+            FIELD_SECOND,       /*!< s */
+            FIELD_SECOND2,      /*!< ss */
+            FIELD_MSEC,         /*!< z */
+            FIELD_MSEC3         /*!< zzz */
+        };
+
+        /*! \struct Field
+         *  \brief A compiled format field.
+         */
+        struct Field
+        {
+            FieldType type;     /*!< A field type */
+            QByteArray literal; /*!< Encoded text of a literal field */
+        };
+
+        QString _format;        /*!< A source format */
+        QTextCodec *_codec;     /*!< Output codec */
+        QVector<Field> _fields; /*!< Compiled fields */
+        bool _compiled;         /*!< Set if the format can be formatted by fields */
+
+        void _compile();
+        void _addField(FieldType type, const QString &literal = QString());
+};
+
+#endif // TIMEFORMATTER_H
@@ -0,0 +1,80 @@
+/*! \file       topcollector.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief Top Collector module source file.
+ *
+ *  This file contains the TopCollector class source code.
+ */
+
+#include "topcollector.h"
+
+#include <algorithm>
+
+/*!
+ * \brief TopCollector::TopCollector
+ * \param[in] count Number of lines to keep
+ *
+ * TopCollector Constructor
+ */
+TopCollector::TopCollector(int count)
+{
+    _count = (count > 0) ? count : 1;
+}
+
+/*!
+ * \brief TopCollector::accepts
+ * \param[in] key A sort key
+ * \return "true" if a line with the key would be kept now
+ *
+ * Lets a caller skip formatting lines which can't get to the top.
+ */
+bool TopCollector::accepts(const QByteArray &key) const
+{
+    return int(_heap.size()) < _count || key < _heap.front().key;
+}
+
+/*!
+ * \brief TopCollector::add
+ * \param[in] key A sort key
+ * \param[in] line An encoded output line
+ *
+ * Adds a line replacing the kept line with the largest key if there are enough lines.
+ */
+void TopCollector::add(const QByteArray &key, const QByteArray &line)
+{
+    if(!accepts(key))
+    {
+        return;
+    }
+
+    if(int(_heap.size()) == _count)
+    {
+        std::pop_heap(_heap.begin(), _heap.end());
+        _heap.pop_back();
+    }
+
+    Record record;
+    record.key = key;
+    record.line = line;
+    _heap.push_back(record);
+    std::push_heap(_heap.begin(), _heap.end());
+}
+
+/*!
+ * \brief TopCollector::write
+ * \param[in] out A writer to write kept lines to
+ *
+ * Writes kept lines with the smallest key first & forgets them.
+ */
+void TopCollector::write(OutputWriter &out)
+{
+    std::sort_heap(_heap.begin(), _heap.end());
+
+    for(size_t recordNum = 0; recordNum < _heap.size(); recordNum++)
+    {
+        out.write(_heap[recordNum].line);
+    }
+
+    _heap.clear();
+}
@@ -0,0 +1,51 @@
+/*! \file       topcollector.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      Top Collector module header file.
+ *
+ *  This file contains the TopCollector class declaration.
+ */
+
+#ifndef TOPCOLLECTOR_H
+#define TOPCOLLECTOR_H
+
+#include <QtCore/qglobal.h>
+
+#include <QByteArray>
+
+#include <vector>
+
+#include "outputwriter.h"
+
+/*! \class TopCollector
+ *  \brief Bounded top lines collector class.
+ *
+ *  This class keeps the given number of lines with the smallest sort keys
+ *  in a heap, so memory doesn't depend on the number of added lines.
+ *  Keys are compared as bytes.
+ */
+class TopCollector
+{
+    public:
+        explicit TopCollector(int count);
+        bool accepts(const QByteArray &key) const;
+        void add(const QByteArray &key, const QByteArray &line);
+        void write(OutputWriter &out);
+    private:
+        /*! \struct Record
+         *  \brief A kept line.
+         */
+        struct Record
+        {
+            QByteArray key;     /*!< A sort key */
+            QByteArray line;    /*!< An encoded output line */
+
+            bool operator<(const Record &other) const { return key < other.key; }
+        };
+
+        int _count;                 /*!< Number of lines to keep */
+        std::vector<Record> _heap;  /*!< Kept lines, the largest key is on the top */
+};
+
+#endif // TOPCOLLECTOR_H
@@ -0,0 +1,463 @@
+/*! \file       traversalpool.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief Traversal Pool module source file.
+ *
+ *  This file contains the TraversalPool class source code.
+ */
+
+#include "traversalpool.h"
+
+#include <QMutexLocker>
+
+/* Memory for scanned directories waiting for the ordered writer */
+static const qint64 ordered_buffer_limit = 64 * 1024 * 1024;
+
+/* Approximate memory taken by a node besides its output */
+static const int node_overhead = 256;
+
+/*!
+ * \brief TraversalPool::TraversalPool
+ * \param[in] jobs Number of worker threads
+ * \param[in] scan Directory scan function, it is called from the workers concurrently
+ * \param[in] ordered Set to "true" to write results in the sequential order
+ *
+ * TraversalPool Constructor
+ */
+TraversalPool::TraversalPool(int jobs, const ScanFunction &scan, bool ordered)
+{
+    _jobs = (jobs > 0) ? jobs : 1;
+    _scan = scan;
+    _ordered = ordered;
+    _deviceLimit = 0;
+    _wakeups = 0;
+    _awaited = nullptr;
+    _buffered = 0;
+    _out = nullptr;
+
+    for(int index = 0; index < _jobs; index++)
+    {
+        _queues.append(new WorkQueue);
+        _workers.append(new Worker(this, index));
+    }
+}
+
+/*!
+ * \brief TraversalPool::~TraversalPool
+ *
+ * TraversalPool Destructor
+ */
+TraversalPool::~TraversalPool()
+{
+    foreach (Worker *worker, _workers) {
+        worker->wait();
+        delete worker;
+    }
+
+    foreach (WorkQueue *queue, _queues) {
+        qDeleteAll(queue->nodes);
+        delete queue;
+    }
+}
+
+/*!
+ * \brief TraversalPool::setDeviceLimit
+ * \param[in] limit Maximal number of directories scanned at once on one device, 0 for no limit
+ * \param[in] device Device function
+ *
+ * It must be called before run(). Workers wait rather than scan
+ * a directory of a device which is busy with the limit.
+ */
+void TraversalPool::setDeviceLimit(int limit, const DeviceFunction &device)
+{
+    _deviceLimit = (limit > 0 && device) ? limit : 0;
+    _device = device;
+}
+
+/*!
+ * \brief TraversalPool::run
+ * \param[in] rootPath A root dir to start traversal from
+ * \param[in] out A writer to write results to
+ *
+ * Scans the directory tree & returns when all directories are written.
+ */
+void TraversalPool::run(const QString &rootPath, OutputWriter &out)
+{
+    run(QStringList() << rootPath, out);
+}
+
+/*!
+ * \brief TraversalPool::run
+ * \param[in] rootPaths Root dirs to start traversal from
+ * \param[in] out A writer to write results to
+ *
+ * Scans all directory trees on the same workers & returns when all
+ * directories are written. In the sequential order the trees are written
+ * in the root order, otherwise directories of all trees are mixed.
+ */
+void TraversalPool::run(const QStringList &rootPaths, OutputWriter &out)
+{
+    _out = &out;
+
+    if(rootPaths.isEmpty())
+    {
+        return;
+    }
+
+    QVector<TraversalNode *> roots;
+    foreach (const QString &rootPath, rootPaths) {
+        TraversalNode *root = new TraversalNode;
+        root->path = rootPath;
+        root->depth = 0;
+        root->device = (_deviceLimit > 0) ? _device(rootPath) : 0;
+        root->done = false;
+        roots.append(root);
+    }
+
+    _pending.store(roots.count());
+    _queued.store(roots.count());
+
+    /* Roots are dealt to the deques, the first ones are taken first */
+    for(int rootNum = roots.count() - 1; rootNum >= 0; rootNum--)
+    {
+        _queues[rootNum % _jobs]->nodes.append(roots.at(rootNum));
+    }
+
+    foreach (Worker *worker, _workers) {
+        worker->start();
+    }
+
+    /* The calling thread writes results while workers are scanning */
+    if(_ordered)
+    {
+        _writeOrdered(roots);
+    }
+
+    foreach (Worker *worker, _workers) {
+        worker->wait();
+    }
+
+    _out->flush();
+}
+
+/*!
+ * \brief TraversalPool::_take
+ * \param[in] index A worker index
+ * \return A directory to scan or nullptr if there is no work
+ *
+ * Takes the most recent directory from the own deque or
+ * steals the oldest one from the other workers.
+ */
+TraversalNode *TraversalPool::_take(int index)
+{
+    for(int shift = 0; shift < _jobs; shift++)
+    {
+        WorkQueue *queue = _queues[(index + shift) % _jobs];
+        QMutexLocker locker(&queue->lock);
+
+        if(queue->nodes.isEmpty())
+        {
+            continue;
+        }
+
+        if(_deviceLimit > 0)
+        {
+            TraversalNode *node = _takeAllowed(queue->nodes, shift == 0);
+            if(node)
+            {
+                _queued.deref();
+                return node;
+            }
+            continue;
+        }
+
+        _queued.deref();
+        return (shift == 0) ? queue->nodes.takeLast() : queue->nodes.takeFirst();
+    }
+
+    return nullptr;
+}
+
+/*!
+ * \brief TraversalPool::_takeNode
+ * \param[in] node A directory to take out of the deques
+ * \return "false" if a worker has taken the directory already
+ *
+ * The ordered writer takes the directory it waits for when workers are
+ * stopped by the buffer limit. Its device is counted busy over the limit.
+ */
+bool TraversalPool::_takeNode(TraversalNode *node)
+{
+    for(int index = 0; index < _jobs; index++)
+    {
+        WorkQueue *queue = _queues[index];
+        QMutexLocker locker(&queue->lock);
+
+        /* The awaited directory is usually the next one at the back */
+        int nodeNum = queue->nodes.lastIndexOf(node);
+        if(nodeNum < 0)
+        {
+            continue;
+        }
+
+        queue->nodes.removeAt(nodeNum);
+        _queued.deref();
+        if(_deviceLimit > 0)
+        {
+            QMutexLocker deviceLocker(&_deviceLock);
+            _busyDevices[node->device]++;
+        }
+        return true;
+    }
+    return false;
+}
+
+/*!
+ * \brief TraversalPool::_takeAllowed
+ * \param[in,out] nodes A deque locked by the caller
+ * \param[in] fromBack Set to "true" to look from the back, from the front otherwise
+ * \return The nearest directory on a device below the limit or nullptr
+ *
+ * The device of a returned directory is counted as busy. Only a few nodes at
+ * the end are looked through, a worker finding none waits for a freed device.
+ */
+TraversalNode *TraversalPool::_takeAllowed(QList<TraversalNode *> &nodes, bool fromBack)
+{
+    int count = nodes.count();
+    int steps = qMin(count, int(device_scan_limit));
+    for(int step = 0; step < steps; step++)
+    {
+        int nodeNum = fromBack ? count - 1 - step : step;
+        if(_acquireDevice(nodes.at(nodeNum)->device))
+        {
+            return nodes.takeAt(nodeNum);
+        }
+    }
+    return nullptr;
+}
+
+/*!
+ * \brief TraversalPool::_acquireDevice
+ * \param[in] device A device number
+ * \return "true" if the device was below the limit & it is counted busy once more
+ */
+bool TraversalPool::_acquireDevice(quint64 device)
+{
+    QMutexLocker locker(&_deviceLock);
+    int &busy = _busyDevices[device];
+    if(busy >= _deviceLimit)
+    {
+        return false;
+    }
+    busy++;
+    return true;
+}
+
+/*!
+ * \brief TraversalPool::_releaseDevice
+ * \param[in] device A device number
+ *
+ * Counts a scan on the device finished & wakes workers waiting for it.
+ */
+void TraversalPool::_releaseDevice(quint64 device)
+{
+    {
+        QMutexLocker locker(&_deviceLock);
+        _busyDevices[device]--;
+    }
+    _wakeAll();
+}
+
+/*!
+ * \brief TraversalPool::_wakeAll
+ *
+ * Wakes all idle workers to look for work again.
+ */
+void TraversalPool::_wakeAll()
+{
+    QMutexLocker locker(&_idleLock);
+    _wakeups++;
+    _idleCondition.wakeAll();
+}
+
+/*!
+ * \brief TraversalPool::_process
+ * \param[in] index A worker index
+ * \param[in] node A directory to scan
+ *
+ * Scans a directory & schedules its subdirectories on the own deque.
+ */
+void TraversalPool::_process(int index, TraversalNode *node)
+{
+    QStringList subdirs = _scan(node->path, node->depth, node->output);
+
+    QVector<TraversalNode *> children;
+    children.reserve(subdirs.count());
+    foreach (const QString &subdir, subdirs) {
+        TraversalNode *child = new TraversalNode;
+        child->path = subdir;
+        child->depth = node->depth + 1;
+        child->device = (_deviceLimit > 0) ? _device(subdir) : 0;
+        child->done = false;
+        children.append(child);
+    }
+
+    if(!children.isEmpty())
+    {
+        _pending.fetchAndAddOrdered(children.count());
+
+        /* Pushing in reverse order to scan the first subdirectory next */
+        {
+            WorkQueue *queue = _queues[index];
+            QMutexLocker locker(&queue->lock);
+            for(int childNum = children.count() - 1; childNum >= 0; childNum--)
+            {
+                queue->nodes.append(children.at(childNum));
+            }
+        }
+
+        _queued.fetchAndAddOrdered(children.count());
+        _wakeAll();
+    }
+
+    /* The device is freed before the node may be handed to the writer */
+    if(_deviceLimit > 0)
+    {
+        _releaseDevice(node->device);
+    }
+
+    if(_ordered)
+    {
+        /* The writer owns the node after it is published */
+        QMutexLocker locker(&_doneLock);
+        node->children = children;
+        node->done = true;
+        _buffered += node->output.size() + node_overhead;
+        if(node == _awaited || _buffered >= ordered_buffer_limit)
+        {
+            _doneCondition.wakeOne();
+        }
+    }
+    else
+    {
+        QMutexLocker locker(&_outLock);
+        _out->write(node->output);
+        _out->endDirectory();
+        delete node;
+    }
+
+    /* The last scanned directory wakes everybody up to finish */
+    if(_pending.fetchAndAddOrdered(-1) == 1)
+    {
+        _wakeAll();
+    }
+}
+
+/*!
+ * \brief TraversalPool::_work
+ * \param[in] index A worker index
+ *
+ * Worker thread main loop.
+ */
+void TraversalPool::_work(int index)
+{
+    forever
+    {
+        /* Ordered results are buffered within the limit, the writer drains them */
+        if(_ordered)
+        {
+            QMutexLocker locker(&_doneLock);
+            while(_buffered >= ordered_buffer_limit)
+            {
+                _spaceCondition.wait(&_doneLock);
+            }
+        }
+
+        /* With a device limit queued work may be not allowed, so waking up is counted */
+        int wakeups = 0;
+        if(_deviceLimit > 0)
+        {
+            QMutexLocker locker(&_idleLock);
+            wakeups = _wakeups;
+        }
+
+        TraversalNode *node = _take(index);
+        if(node)
+        {
+            _process(index, node);
+            continue;
+        }
+
+        QMutexLocker locker(&_idleLock);
+        if(_pending.load() == 0)
+        {
+            break;
+        }
+        if(_queued.load() == 0 || (_deviceLimit > 0 && _wakeups == wakeups))
+        {
+            _idleCondition.wait(&_idleLock);
+        }
+    }
+}
+
+/*!
+ * \brief TraversalPool::_writeOrdered
+ * \param[in] roots Root directory nodes
+ *
+ * Writes scanned directories depth-first tree by tree, waiting for the ones
+ * which are not scanned yet. Written nodes are freed at once. Over the buffer
+ * limit the writer scans the awaited directory itself if it is still queued.
+ */
+void TraversalPool::_writeOrdered(const QVector<TraversalNode *> &roots)
+{
+    QVector<TraversalNode *> stack;
+    for(int rootNum = roots.count() - 1; rootNum >= 0; rootNum--)
+    {
+        stack.append(roots.at(rootNum));
+    }
+
+    while(!stack.isEmpty())
+    {
+        TraversalNode *node = stack.takeLast();
+
+        {
+            QMutexLocker locker(&_doneLock);
+            _awaited = node;
+            bool queued = true;
+            while(!node->done)
+            {
+                if(queued && _buffered >= ordered_buffer_limit)
+                {
+                    locker.unlock();
+                    queued = _takeNode(node);
+                    if(queued)
+                    {
+                        _process(0, node);
+                    }
+                    locker.relock();
+                    continue;
+                }
+                _doneCondition.wait(&_doneLock);
+            }
+            _awaited = nullptr;
+
+            qint64 size = node->output.size() + node_overhead;
+            if(_buffered >= ordered_buffer_limit && _buffered - size < ordered_buffer_limit)
+            {
+                _spaceCondition.wakeAll();
+            }
+            _buffered -= size;
+        }
+
+        _out->write(node->output);
+        _out->endDirectory();
+
+        for(int childNum = node->children.count() - 1; childNum >= 0; childNum--)
+        {
+            stack.append(node->children.at(childNum));
+        }
+
+        delete node;
+    }
+}
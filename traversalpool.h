@@ -0,0 +1,143 @@
+/*! \file       traversalpool.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      Traversal Pool module header file.
+ *
+ *  This file contains the TraversalPool class declaration.
+ */
+
+#ifndef TRAVERSALPOOL_H
+#define TRAVERSALPOOL_H
+
+#include <QtCore/qglobal.h>
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+#include <QAtomicInt>
+
+#include <functional>
+
+#include "outputwriter.h"
+
+/*! \struct TraversalNode
+ *  \brief A directory scheduled for a scan.
+ *
+ *  Nodes form a tree mirroring the directory tree so the
+ *  results can be written in the sequential (depth-first) order.
+ */
+struct TraversalNode
+{
+    QString path;                       /*!< An absolute directory path */
+    int depth;                          /*!< The directory depth, the root depth is 0 */
+    quint64 device;                     /*!< The directory device, 0 without a device limit */
+    QByteArray output;                  /*!< Formatted file lines of the directory */
+    QVector<TraversalNode *> children;  /*!< Subdirectory nodes in scan order */
+    bool done;                          /*!< Set when the directory has been scanned */
+};
+
+/*! \class TraversalPool
+ *  \brief Parallel directory tree traversal class.
+ *
+ *  This class scans a directory tree on a pool of worker threads.
+ *  Every worker owns a deque of pending directories: it takes work
+ *  from the back of its own deque and steals from the front of the
+ *  other workers' deques when its own one is empty. Several trees may be
+ *  scanned by one pool, they are written one after another. The number of
+ *  directories scanned at once on one device may be limited, so a slow
+ *  device (like a network mount) doesn't take all workers from the others:
+ *  a worker passes over directories of busy devices near the deque ends.
+ *  In the sequential order scanned directories wait for the writer within
+ *  a memory limit, workers stop taking work over it & the writer scans
+ *  the directory it waits for itself if no worker has taken it.
+ */
+class TraversalPool
+{
+    public:
+        /*! A directory scan function: formats the files of a directory at a depth
+         *  into the output and returns absolute paths of its subdirectories to scan */
+        typedef std::function<QStringList (const QString &dirPath, int depth, QByteArray &output)> ScanFunction;
+
+        /*! A device function: returns a number of the device a directory is on,
+         *  it is called from the workers concurrently */
+        typedef std::function<quint64 (const QString &dirPath)> DeviceFunction;
+
+        /*! Number of nodes at each end of a deque to look through for an allowed device */
+        static const int device_scan_limit = 256;
+
+        TraversalPool(int jobs, const ScanFunction &scan, bool ordered);
+        ~TraversalPool();
+        void setDeviceLimit(int limit, const DeviceFunction &device);
+        void run(const QString &rootPath, OutputWriter &out);
+        void run(const QStringList &rootPaths, OutputWriter &out);
+    private:
+        /*! \class Worker
+         *  \brief A pool worker thread.
+         */
+        class Worker : public QThread
+        {
+            public:
+                Worker(TraversalPool *pool, int index) : _pool(pool), _index(index) {}
+            protected:
+                void run() Q_DECL_OVERRIDE { _pool->_work(_index); }
+            private:
+                TraversalPool *_pool;   /*!< The pool owning the worker */
+                int _index;             /*!< The worker deque index */
+        };
+
+        /*! \struct WorkQueue
+         *  \brief A worker deque of pending directories.
+         */
+        struct WorkQueue
+        {
+            QMutex lock;                    /*!< Guards the deque */
+            QList<TraversalNode *> nodes;   /*!< Pending directories */
+        };
+
+        int _jobs;                          /*!< Number of worker threads */
+        ScanFunction _scan;                 /*!< Directory scan function */
+        bool _ordered;                      /*!< Write results in the sequential order */
+        int _deviceLimit;                   /*!< Maximal directories scanned at once per device, 0 for no limit */
+        DeviceFunction _device;             /*!< Device function */
+
+        QVector<WorkQueue *> _queues;       /*!< Per-worker deques */
+        QVector<Worker *> _workers;         /*!< Worker threads */
+
+        QAtomicInt _queued;                 /*!< Number of directories waiting in deques */
+        QAtomicInt _pending;                /*!< Number of directories not scanned yet */
+
+        QMutex _idleLock;                   /*!< Guards idle workers sleeping */
+        QWaitCondition _idleCondition;      /*!< Wakes idle workers on new work, a freed device or finish */
+        int _wakeups;                       /*!< Number of wake ups, it is changed under the idle lock */
+
+        QMutex _deviceLock;                 /*!< Guards busy device counters */
+        QHash<quint64, int> _busyDevices;   /*!< Directories being scanned per device */
+
+        QMutex _doneLock;                   /*!< Guards scanned node publishing */
+        QWaitCondition _doneCondition;      /*!< Wakes the ordered writer */
+        TraversalNode *_awaited;            /*!< A node the ordered writer is waiting for */
+        qint64 _buffered;                   /*!< Memory taken by scanned nodes waiting for the ordered writer */
+        QWaitCondition _spaceCondition;     /*!< Wakes workers when buffered nodes fall below the limit */
+
+        QMutex _outLock;                    /*!< Guards unordered output */
+        OutputWriter *_out;                 /*!< Output writer */
+
+        TraversalNode *_take(int index);
+        TraversalNode *_takeAllowed(QList<TraversalNode *> &nodes, bool fromBack);
+        bool _acquireDevice(quint64 device);
+        void _releaseDevice(quint64 device);
+        void _wakeAll();
+        bool _takeNode(TraversalNode *node);
+        void _process(int index, TraversalNode *node);
+        void _work(int index);
+        void _writeOrdered(const QVector<TraversalNode *> &roots);
+};
+
+#endif // TRAVERSALPOOL_H
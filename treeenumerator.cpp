@@ -0,0 +1,398 @@
+/*! \file       treeenumerator.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief Tree Enumerator module source file.
+ *
+ *  This file contains the TreeEnumerator class source code.
+ */
+
+#include "treeenumerator.h"
+
+/* Maximal number of directories kept open on the stack */
+static const int open_dir_limit = 16;
+
+/*!
+ * \brief TreeEnumerator::TreeEnumerator
+ *
+ * TreeEnumerator Constructor, all files of the root directory are listed by default
+ */
+TreeEnumerator::TreeEnumerator()
+{
+    _recursive = false;
+    _maxDepth = -1;
+    _sorted = false;
+    _inodeOrder = false;
+    _statBatchDepth = 0;
+    _guard = nullptr;
+    _depth = 0;
+    _visitor = nullptr;
+    _stopped = false;
+}
+
+/*!
+ * \brief TreeEnumerator::~TreeEnumerator
+ *
+ * TreeEnumerator Destructor
+ */
+TreeEnumerator::~TreeEnumerator()
+{
+    qDeleteAll(_frames);
+}
+
+/*!
+ * \brief TreeEnumerator::setMatcher
+ * \param[in] matcher File name patterns, files are not filtered if it is empty
+ */
+void TreeEnumerator::setMatcher(const GlobMatcher &matcher)
+{
+    _matcher = matcher;
+}
+
+/*!
+ * \brief TreeEnumerator::setRecursive
+ * \param[in] recursive Set to "true" to enter subdirectories
+ */
+void TreeEnumerator::setRecursive(bool recursive)
+{
+    _recursive = recursive;
+}
+
+/*!
+ * \brief TreeEnumerator::setMaxDepth
+ * \param[in] maxDepth Maximal depth to enter, unlimited if it is negative
+ */
+void TreeEnumerator::setMaxDepth(int maxDepth)
+{
+    _maxDepth = maxDepth;
+}
+
+/*!
+ * \brief TreeEnumerator::setSorted
+ * \param[in] sorted Set to "true" to visit directories which fit in one chunk
+ *                   in the QDir name order, the file system order is used otherwise
+ *
+ * Sorting decodes names, so it allocates memory per entry.
+ */
+void TreeEnumerator::setSorted(bool sorted)
+{
+    _sorted = sorted;
+}
+
+/*!
+ * \brief TreeEnumerator::setInodeOrder
+ * \param[in] inodeOrder Set to "true" to enter subdirectories of every chunk
+ *                       in inode order instead of the name or file system order
+ *
+ * Neighbouring inodes are usually stored in the same disk blocks, so
+ * directories are opened with fewer seeks. Files of a chunk are stated
+ * in inode order too, they are visited in the same order.
+ */
+void TreeEnumerator::setInodeOrder(bool inodeOrder)
+{
+    _inodeOrder = inodeOrder;
+}
+
+/*!
+ * \brief TreeEnumerator::setStatBatchDepth
+ * \param[in] depth io_uring queue depth to stat files with, 0 to stat them one by one
+ */
+void TreeEnumerator::setStatBatchDepth(int depth)
+{
+    _statBatchDepth = depth;
+}
+
+/*!
+ * \brief TreeEnumerator::setGuard
+ * \param[in] guard A guard to ask before directories are entered or null,
+ *                  it may be shared with other enumerators
+ */
+void TreeEnumerator::setGuard(TreeGuard *guard)
+{
+    _guard = guard;
+}
+
+/*!
+ * \brief TreeEnumerator::enumerate
+ * \param[in] rootPath A root dir to start enumeration from
+ * \param[in] visitor A visitor to pass directories & files to
+ * \return "false" if the root directory can't be read or it is pruned
+ *
+ * Walks the tree passing files of every directory before its subdirectories.
+ * Directories which can't be read are skipped.
+ */
+bool TreeEnumerator::enumerate(const QString &rootPath, EntryVisitor &visitor)
+{
+    _visitor = &visitor;
+    _stopped = false;
+
+    _arena.addRoot(rootPath);
+    if(!_enter(rootPath))
+    {
+        _visitor = nullptr;
+        return false;
+    }
+
+    while(_depth > 0 && !_stopped)
+    {
+        Frame *frame = _frames.at(_depth - 1);
+
+        if(frame->nextSubdir >= frame->subdirs.count())
+        {
+            if(frame->stream->atEnd())
+            {
+                _leave();
+            }
+            else
+            {
+                _readSubdirs(frame);
+            }
+            continue;
+        }
+
+        const EntryRecord &subdir = frame->subdirs.at(frame->nextSubdir++);
+        _arena.addDir(_depth - 1, subdir.name, subdir.nameSize);
+        _enter(_arena.path(_depth));
+    }
+
+    while(_depth > 0)
+    {
+        _leave();
+    }
+
+    _visitor = nullptr;
+    return true;
+}
+
+/*!
+ * \brief TreeEnumerator::dirPath
+ * \param[in] dir A handle of a directory on the stack
+ * \return The directory path
+ */
+const QString &TreeEnumerator::dirPath(int dir) const
+{
+    return _frames.at(dir)->path;
+}
+
+/*!
+ * \brief TreeEnumerator::appendPrefix
+ * \param[out] out A buffer to append to
+ * \param[in] dir A handle of a directory on the stack
+ *
+ * Appends the raw directory path ending with a separator.
+ */
+void TreeEnumerator::appendPrefix(QByteArray &out, int dir) const
+{
+    _arena.appendPrefix(out, dir);
+}
+
+/*!
+ * \brief TreeEnumerator::appendPath
+ * \param[out] out A buffer to append to
+ * \param[in] entry A visited entry
+ *
+ * Appends the raw entry path without building it as a string.
+ */
+void TreeEnumerator::appendPath(QByteArray &out, const EntryRecord &entry) const
+{
+    _arena.appendPath(out, entry.parent, entry.name, entry.nameSize);
+}
+
+/*!
+ * \brief TreeEnumerator::_enter
+ * \param[in] dirPath A directory path, its arena node is added already
+ * \return "false" if the directory can't be opened or it is pruned
+ *
+ * Visits directory files & keeps the directory on the stack if it has subdirectories to enter.
+ */
+bool TreeEnumerator::_enter(const QString &dirPath)
+{
+    /* Pruned directories are not opened */
+    quint64 device = 0;
+    if(_guard && !_guard->enter(dirPath, device))
+    {
+        _arena.truncate(_depth);
+        return false;
+    }
+
+    DirStream *stream = new DirStream(dirPath);
+    stream->setInodeOrder(_inodeOrder);
+    stream->setStatBatchDepth(_statBatchDepth);
+    if(!stream->open())
+    {
+        delete stream;
+        _arena.truncate(_depth);
+        return false;
+    }
+
+    if(_depth == _frames.count())
+    {
+        _frames.append(new Frame);
+    }
+
+    int dir = _depth++;
+    Frame *frame = _frames.at(dir);
+    frame->stream = stream;
+    frame->path = dirPath;
+    frame->subdirs.resize(0);
+    frame->nextSubdir = 0;
+    _limitOpenDirs();
+
+    if(!_visitor->enterDir(dir, dirPath))
+    {
+        _leave();
+        return true;
+    }
+
+    /* Subdirectories are collected by the file pass, the directory is read again only if they overflow the chunk */
+    bool subdirs = _recursive && (_maxDepth < 0 || dir < _maxDepth);
+    bool collect = subdirs;
+    bool overflow = false;
+    frame->subdirNames.resize(0);
+
+    bool first = true;
+    do
+    {
+        stream->read(_matcher, true, collect, DirStream::file_chunk_size, _files, _fileNames);
+
+        /* Subdirectories filling the first chunk hide whether files fit in it, so files are read again alone */
+        if(first && collect && !stream->atEnd() && _countDirs() >= DirStream::file_chunk_size)
+        {
+            stream->rewind();
+            collect = false;
+            overflow = true;
+            continue;
+        }
+
+        /* Files which fit in one chunk are sorted on request */
+        if(first && _sorted && stream->atEnd())
+        {
+            DirReader::sort(_files);
+        }
+        first = false;
+
+        for(int fileNum = 0; fileNum < _files.count(); fileNum++)
+        {
+            EntryRecord &file = _files[fileNum];
+            if(file.isDir)
+            {
+                if(frame->subdirs.count() < DirStream::subdir_chunk_size)
+                {
+                    frame->subdirs.append(file);
+                    frame->subdirNames.append(file.name, file.nameSize + 1);
+                }
+                continue;
+            }
+
+            file.parent = dir;
+            if(_guard && !_guard->acceptFile(device, file.inode, file.links))
+            {
+                continue;
+            }
+            if(!_visitor->visitFile(file))
+            {
+                _stopped = true;
+                return true;
+            }
+        }
+    }
+    while(!stream->atEnd());
+
+    _visitor->leaveFiles(dir);
+
+    if(!subdirs)
+    {
+        _leave();
+        return true;
+    }
+
+    /* A full chunk is read again in chunks, which keeps the file system order as _readSubdirs() does */
+    if(overflow || frame->subdirs.count() >= DirStream::subdir_chunk_size)
+    {
+        frame->subdirs.resize(0);
+        stream->rewind();
+        _readSubdirs(frame);
+        return true;
+    }
+
+    /* Collected names are copied, so records are pointed to the copies */
+    const char *name = frame->subdirNames.constData();
+    for(int subdirNum = 0; subdirNum < frame->subdirs.count(); subdirNum++)
+    {
+        frame->subdirs[subdirNum].name = name;
+        name += frame->subdirs.at(subdirNum).nameSize + 1;
+    }
+
+    if(_inodeOrder)
+    {
+        DirReader::sortByInode(frame->subdirs);
+    }
+    else if(_sorted)
+    {
+        DirReader::sort(frame->subdirs);
+    }
+    return true;
+}
+
+/*!
+ * \brief TreeEnumerator::_leave
+ *
+ * Closes the stack top directory, its frame & path memory are kept for the next directory at this depth.
+ */
+void TreeEnumerator::_leave()
+{
+    Frame *frame = _frames.at(--_depth);
+    delete frame->stream;
+    frame->stream = nullptr;
+    _arena.truncate(_depth);
+}
+
+/*!
+ * \brief TreeEnumerator::_readSubdirs
+ * \param[in] frame A directory to read the next subdirectory chunk of
+ */
+void TreeEnumerator::_readSubdirs(Frame *frame)
+{
+    bool first = (frame->nextSubdir == 0 && frame->subdirs.isEmpty());
+
+    frame->nextSubdir = 0;
+    frame->stream->read(_matcher, false, true, DirStream::subdir_chunk_size, frame->subdirs, frame->subdirNames);
+
+    if(_inodeOrder)
+    {
+        DirReader::sortByInode(frame->subdirs);
+    }
+    else if(first && _sorted && frame->stream->atEnd())
+    {
+        DirReader::sort(frame->subdirs);
+    }
+}
+
+/*!
+ * \brief TreeEnumerator::_countDirs
+ * \return Number of subdirectories in the file chunk
+ */
+int TreeEnumerator::_countDirs() const
+{
+    int count = 0;
+    for(int fileNum = 0; fileNum < _files.count(); fileNum++)
+    {
+        count += _files.at(fileNum).isDir ? 1 : 0;
+    }
+    return count;
+}
+
+/*!
+ * \brief TreeEnumerator::_limitOpenDirs
+ *
+ * Closes the directory which has just fallen out of the open directory limit,
+ * it is opened again when it is back on the stack top.
+ */
+void TreeEnumerator::_limitOpenDirs()
+{
+    int closed = _depth - open_dir_limit - 1;
+    if(closed >= 0)
+    {
+        _frames.at(closed)->stream->close();
+    }
+}
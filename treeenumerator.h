@@ -0,0 +1,117 @@
+/*! \file       treeenumerator.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      Tree Enumerator module header file.
+ *
+ *  This file contains the EntryVisitor & TreeEnumerator class declarations.
+ */
+
+#ifndef TREEENUMERATOR_H
+#define TREEENUMERATOR_H
+
+#include <QtCore/qglobal.h>
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#include "dirreader.h"
+#include "globmatcher.h"
+#include "patharena.h"
+#include "treeguard.h"
+
+/*! \class EntryVisitor
+ *  \brief Directory tree visitor interface.
+ *
+ *  A visitor gets directories & their files from TreeEnumerator.
+ *  Directory handles & records are valid during the call only,
+ *  a visitor copies what it keeps.
+ */
+class EntryVisitor
+{
+    public:
+        virtual ~EntryVisitor() {}
+
+        /*! A directory is entered, it is skipped with its subtree if it returns "false" */
+        virtual bool enterDir(int dir, const QString &dirPath) { Q_UNUSED(dir); Q_UNUSED(dirPath); return true; }
+
+        /*! A file of the current directory, the enumeration stops if it returns "false" */
+        virtual bool visitFile(const EntryRecord &file) = 0;
+
+        /*! All files of the directory have been visited, its subdirectories are entered next */
+        virtual void leaveFiles(int dir) { Q_UNUSED(dir); }
+};
+
+/*! \class TreeEnumerator
+ *  \brief Directory tree enumeration engine class.
+ *
+ *  This class walks a directory tree depth-first with an explicit stack &
+ *  passes every directory & its matching files to a visitor. Files of
+ *  a directory are visited before its subdirectories are entered. Records are
+ *  read in chunks into buffers reused for the whole tree, so visiting
+ *  a file allocates nothing. A directory handle is its depth on the stack,
+ *  directory paths are interned in a path arena until they are left, so
+ *  a raw file path can be rendered straight to an output buffer. Only the
+ *  deepest directories of the stack are kept open, the others are closed
+ *  & opened again at the same position. A tree guard may prune directories
+ *  before they are opened & hard links to visited files. An enumerator doesn't use
+ *  the application object & keeps its settings to itself, only scan statistics
+ *  are shared by the process, so several trees can be enumerated by separate
+ *  enumerators at the same time.
+ */
+class TreeEnumerator
+{
+    public:
+        TreeEnumerator();
+        ~TreeEnumerator();
+        void setMatcher(const GlobMatcher &matcher);
+        void setRecursive(bool recursive);
+        void setMaxDepth(int maxDepth);
+        void setSorted(bool sorted);
+        void setInodeOrder(bool inodeOrder);
+        void setStatBatchDepth(int depth);
+        void setGuard(TreeGuard *guard);
+        bool enumerate(const QString &rootPath, EntryVisitor &visitor);
+        const QString &dirPath(int dir) const;
+        void appendPrefix(QByteArray &out, int dir) const;
+        void appendPath(QByteArray &out, const EntryRecord &entry) const;
+    private:
+        /*! \struct Frame
+         *  \brief A directory on the traversal stack.
+         */
+        struct Frame
+        {
+            DirStream *stream;              /*!< The directory stream positioned after read subdirectories */
+            QString path;                   /*!< The directory path */
+            QVector<EntryRecord> subdirs;   /*!< A chunk of subdirectories to enter */
+            QByteArray subdirNames;         /*!< Names of the subdirectory chunk */
+            int nextSubdir;                 /*!< The next subdirectory index in the chunk */
+        };
+
+        GlobMatcher _matcher;               /*!< File name patterns */
+        bool _recursive;                    /*!< Enter subdirectories */
+        int _maxDepth;                      /*!< Maximal depth to enter, unlimited if it is negative */
+        bool _sorted;                       /*!< Sort directories which fit in one chunk by name */
+        bool _inodeOrder;                   /*!< Stat files & enter subdirectories of a chunk in inode order */
+        int _statBatchDepth;                /*!< io_uring queue depth, 0 to stat files one by one */
+        TreeGuard *_guard;                  /*!< A guard deciding which directories & files to visit or null */
+
+        QVector<Frame *> _frames;           /*!< Stack frames, they are kept for reuse */
+        PathArena _arena;                   /*!< Interned paths of the stack directories */
+        int _depth;                         /*!< Number of frames on the stack */
+        QVector<EntryRecord> _files;        /*!< A reusable file chunk */
+        QByteArray _fileNames;              /*!< Names of the file chunk */
+        EntryVisitor *_visitor;             /*!< The visitor of the current enumeration */
+        bool _stopped;                      /*!< Set when the visitor stops the enumeration */
+
+        bool _enter(const QString &dirPath);
+        void _leave();
+        void _readSubdirs(Frame *frame);
+        int _countDirs() const;
+        void _limitOpenDirs();
+
+        Q_DISABLE_COPY(TreeEnumerator)
+};
+
+#endif // TREEENUMERATOR_H
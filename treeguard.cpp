@@ -0,0 +1,417 @@
+/*! \file       treeguard.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief Tree Guard module source file.
+ *
+ *  This file contains the TreeGuard class source code.
+ */
+
+#include "treeguard.h"
+#include "scanstats.h"
+
+#include <QFile>
+#include <QMutexLocker>
+
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+#ifdef Q_OS_LINUX
+#include <sys/sysmacros.h>
+#elif defined(Q_OS_DARWIN) || defined(Q_OS_FREEBSD) || defined(Q_OS_OPENBSD) || defined(Q_OS_NETBSD)
+#include <sys/param.h>
+#include <sys/mount.h>
+#define TDIR_HAS_FSTYPENAME
+#endif
+
+/*!
+ * \brief TreeGuard::TreeGuard
+ *
+ * TreeGuard Constructor, only revisited directories are skipped by default
+ */
+TreeGuard::TreeGuard()
+{
+    _oneFileSystem = false;
+    _skipTypes = false;
+    _linksOnce = false;
+    _mountReads = 0;
+}
+
+/*!
+ * \brief TreeGuard::setOneFileSystem
+ * \param[in] oneFileSystem Set to "true" not to enter directories on other devices than the roots
+ */
+void TreeGuard::setOneFileSystem(bool oneFileSystem)
+{
+    _oneFileSystem = oneFileSystem;
+}
+
+/*!
+ * \brief TreeGuard::setSkippedTypes
+ * \param[in] types File system type wildcard patterns (like "proc" or "nfs*") not to enter
+ */
+void TreeGuard::setSkippedTypes(const QStringList &types)
+{
+    _skippedTypes = GlobMatcher(types, QStringList());
+    _skipTypes = !types.isEmpty();
+}
+
+/*!
+ * \brief TreeGuard::setLinksOnce
+ * \param[in] linksOnce Set to "true" to let a file with several hard links through once
+ */
+void TreeGuard::setLinksOnce(bool linksOnce)
+{
+    _linksOnce = linksOnce;
+}
+
+/*!
+ * \brief TreeGuard::addRoot
+ * \param[in] rootPath A root directory path
+ *
+ * Adds the root device to the allowed ones, it must be called before the root is entered.
+ */
+void TreeGuard::addRoot(const QString &rootPath)
+{
+#ifdef Q_OS_UNIX
+    struct stat st;
+    if(stat(QFile::encodeName(rootPath).constData(), &st) == 0)
+    {
+        QMutexLocker locker(&_lock);
+        _rootDevices.insert(quint64(st.st_dev));
+    }
+#else
+    Q_UNUSED(rootPath)
+#endif
+}
+
+/*!
+ * \brief TreeGuard::enter
+ * \param[in] dirPath A directory path
+ * \param[out] device The directory device, 0 if it is not known
+ * \return "false" if the directory must not be read
+ *
+ * Marks the directory entered. A directory met again is pruned only if it is
+ * one of its path ancestors (a link or bind mount cycle), so the decision
+ * doesn't depend on the traversal order. Directories which can't be stated
+ * are entered, so their readers report them the same way as without the guard.
+ */
+bool TreeGuard::enter(const QString &dirPath, quint64 &device)
+{
+    device = 0;
+
+#ifdef Q_OS_UNIX
+    struct stat st;
+    if(stat(QFile::encodeName(dirPath).constData(), &st) != 0)
+    {
+        return true;
+    }
+    device = quint64(st.st_dev);
+
+    QMutexLocker locker(&_lock);
+
+    /* Devices of the roots are always allowed */
+    bool allowed = _rootDevices.contains(device) ||
+                   (!_oneFileSystem && !(_skipTypes && _isSkippedDevice(device, dirPath)));
+
+    Identity identity(device, quint64(st.st_ino));
+    bool seen = _dirs.contains(identity);
+    _dirs.insert(identity);
+    locker.unlock();
+
+    /* Ancestors are stated only for directories met before, which is rare */
+    if(!allowed || (seen && _isAncestor(identity, dirPath)))
+    {
+        ScanStats::add(ScanStats::DIRS_PRUNED, 1);
+        return false;
+    }
+    return true;
+#else
+    Q_UNUSED(dirPath)
+    return true;
+#endif
+}
+
+/*!
+ * \brief TreeGuard::isOwnAncestor
+ * \param[in] dirPath A directory path built by appending names
+ * \return "true" if a parent path of "dirPath" is the same directory
+ *
+ * Tells a link or bind mount cycle the same way enter() does,
+ * for walks which don't keep a guard.
+ */
+bool TreeGuard::isOwnAncestor(const QString &dirPath)
+{
+#ifdef Q_OS_UNIX
+    struct stat st;
+    if(stat(QFile::encodeName(dirPath).constData(), &st) == 0)
+    {
+        return _isAncestor(Identity(quint64(st.st_dev), quint64(st.st_ino)), dirPath);
+    }
+#else
+    Q_UNUSED(dirPath)
+#endif
+    return false;
+}
+
+/*!
+ * \brief TreeGuard::_isAncestor
+ * \param[in] identity A directory device & inode
+ * \param[in] dirPath A path of the directory
+ * \return "true" if a parent path of "dirPath" is the same directory
+ *
+ * Traversal paths are built by appending names, so parent paths are the
+ * directories the traversal came through.
+ */
+bool TreeGuard::_isAncestor(const Identity &identity, const QString &dirPath)
+{
+#ifdef Q_OS_UNIX
+    QByteArray path = QFile::encodeName(dirPath);
+    while(path.size() > 1 && path.endsWith('/'))
+    {
+        path.chop(1);
+    }
+
+    int separator = path.lastIndexOf('/');
+    while(separator >= 0)
+    {
+        path.truncate(separator > 0 ? separator : 1);
+
+        struct stat st;
+        if(stat(path.constData(), &st) == 0 && Identity(quint64(st.st_dev), quint64(st.st_ino)) == identity)
+        {
+            return true;
+        }
+        separator = (separator > 0) ? path.lastIndexOf('/') : -1;
+    }
+#else
+    Q_UNUSED(identity)
+    Q_UNUSED(dirPath)
+#endif
+    return false;
+}
+
+/*!
+ * \brief TreeGuard::filterFiles
+ * \param[in] device The device of the directory
+ * \param[in,out] entries Directory entries to drop files let through already from
+ */
+void TreeGuard::filterFiles(quint64 device, QVector<DirEntry> &entries)
+{
+    if(!_linksOnce)
+    {
+        return;
+    }
+
+    int count = 0;
+    for(int entryNum = 0; entryNum < entries.count(); entryNum++)
+    {
+        const DirEntry &entry = entries.at(entryNum);
+        if(entry.isDir || acceptFile(device, entry.inode, entry.links))
+        {
+            if(count != entryNum)
+            {
+                entries[count] = entry;
+            }
+            count++;
+        }
+    }
+    entries.resize(count);
+}
+
+/*!
+ * \brief TreeGuard::_acceptLink
+ * \param[in] device The file device
+ * \param[in] inode The file inode
+ * \return "true" if no other hard link to the file has been let through
+ */
+bool TreeGuard::_acceptLink(quint64 device, quint64 inode)
+{
+    QMutexLocker locker(&_lock);
+
+    int size = _links.size();
+    _links.insert(Identity(device, inode));
+    if(_links.size() != size)
+    {
+        return true;
+    }
+
+    locker.unlock();
+    ScanStats::add(ScanStats::LINKS_SKIPPED, 1);
+    return false;
+}
+
+/*!
+ * \brief TreeGuard::deviceOf
+ * \param[in] dirPath An absolute directory path
+ * \return The device of the nearest mount point above the path, 0 if it is not known
+ *
+ * The device is told by the path only, so it costs no system call. Mount
+ * points are read once, paths leading to other file systems through
+ * symbolic links are counted on the device of the link. On other platforms
+ * every path is on the device 0.
+ */
+quint64 TreeGuard::deviceOf(const QString &dirPath)
+{
+#ifdef Q_OS_LINUX
+    QByteArray path = QFile::encodeName(dirPath);
+
+    QMutexLocker locker(&_lock);
+    if(_mountReads == 0)
+    {
+        _loadMounts();
+    }
+
+    for(int mountNum = 0; mountNum < _mountPoints.count(); mountNum++)
+    {
+        const QByteArray &mountPoint = _mountPoints.at(mountNum).first;
+        if(path.startsWith(mountPoint) &&
+           (path.size() == mountPoint.size() || mountPoint.endsWith('/') || path.at(mountPoint.size()) == '/'))
+        {
+            return _mountPoints.at(mountNum).second;
+        }
+    }
+#else
+    Q_UNUSED(dirPath)
+#endif
+    return 0;
+}
+
+/*!
+ * \brief TreeGuard::_isSkippedDevice
+ * \param[in] device A device number
+ * \param[in] dirPath A directory on the device
+ * \return "true" if the device file system type is skipped
+ *
+ * The decision is kept for the device, so a type is looked up once per device.
+ * It is called under the lock.
+ */
+bool TreeGuard::_isSkippedDevice(quint64 device, const QString &dirPath)
+{
+    QHash<quint64, bool>::const_iterator decision = _skippedDevices.constFind(device);
+    if(decision != _skippedDevices.constEnd())
+    {
+        return decision.value();
+    }
+
+    QByteArray type = _fileSystemType(device, dirPath);
+    bool skipped = !type.isEmpty() && _skippedTypes.matches(type);
+    _skippedDevices.insert(device, skipped);
+    return skipped;
+}
+
+/*!
+ * \brief TreeGuard::_fileSystemType
+ * \param[in] device A device number
+ * \param[in] dirPath A directory on the device
+ * \return The file system type name as the mount table shows it, empty if it is not known
+ */
+QByteArray TreeGuard::_fileSystemType(quint64 device, const QString &dirPath)
+{
+#ifdef Q_OS_LINUX
+    Q_UNUSED(dirPath)
+
+    /* The table is read again once for file systems mounted after it was read */
+    if(_mountReads < 2 && !_mountTypes.contains(device))
+    {
+        _loadMounts();
+    }
+    return _mountTypes.value(device);
+#elif defined(TDIR_HAS_FSTYPENAME)
+    Q_UNUSED(device)
+
+    struct statfs fs;
+    if(statfs(QFile::encodeName(dirPath).constData(), &fs) != 0)
+    {
+        return QByteArray();
+    }
+    return QByteArray(fs.f_fstypename);
+#else
+    Q_UNUSED(device)
+    Q_UNUSED(dirPath)
+    return QByteArray();
+#endif
+}
+
+/*!
+ * \brief TreeGuard::_loadMounts
+ *
+ * Reads device numbers, file system types & mount points of mounted
+ * file systems from the mount table.
+ */
+void TreeGuard::_loadMounts()
+{
+#ifdef Q_OS_LINUX
+    _mountReads++;
+
+    QVector<QPair<QByteArray, quint64> > mountPoints;
+    QFile mountInfo("/proc/self/mountinfo");
+    if(mountInfo.open(QIODevice::ReadOnly))
+    {
+        /* "id parent major:minor root mount_point options [optional fields] - type source options" */
+        foreach (const QByteArray &line, mountInfo.readAll().split('\n')) {
+            QList<QByteArray> fields = line.split(' ');
+            int separator = fields.indexOf("-");
+            if(fields.count() < 3 || separator < 0 || separator + 1 >= fields.count())
+            {
+                continue;
+            }
+
+            QList<QByteArray> numbers = fields.at(2).split(':');
+            if(numbers.count() != 2)
+            {
+                continue;
+            }
+
+            quint64 device = quint64(makedev(numbers.at(0).toUInt(), numbers.at(1).toUInt()));
+            _mountTypes.insert(device, fields.at(separator + 1));
+            if(fields.count() > 4)
+            {
+                mountPoints.append(qMakePair(_unescapeMountPoint(fields.at(4)), device));
+            }
+        }
+    }
+
+    /* The last mount over the same point hides the earlier ones */
+    std::stable_sort(mountPoints.begin(), mountPoints.end(),
+                     [](const QPair<QByteArray, quint64> &left, const QPair<QByteArray, quint64> &right) {
+        return left.first.size() > right.first.size();
+    });
+    for(int mountNum = mountPoints.count() - 1; mountNum > 0; mountNum--)
+    {
+        if(mountPoints.at(mountNum).first == mountPoints.at(mountNum - 1).first)
+        {
+            mountPoints.remove(mountNum - 1);
+        }
+    }
+    _mountPoints = mountPoints;
+#endif
+}
+
+/*!
+ * \brief TreeGuard::_unescapeMountPoint
+ * \param[in] field A mount point field of the mount table
+ * \return The mount point with octal escapes (like "\\040" for a space) decoded
+ */
+QByteArray TreeGuard::_unescapeMountPoint(const QByteArray &field)
+{
+    QByteArray mountPoint;
+    mountPoint.reserve(field.size());
+    for(int pos = 0; pos < field.size(); pos++)
+    {
+        char c = field.at(pos);
+        if(c == '\\' && pos + 3 < field.size() &&
+           field.at(pos + 1) >= '0' && field.at(pos + 1) <= '3' &&
+           field.at(pos + 2) >= '0' && field.at(pos + 2) <= '7' &&
+           field.at(pos + 3) >= '0' && field.at(pos + 3) <= '7')
+        {
+            c = char(((field.at(pos + 1) - '0') << 6) | ((field.at(pos + 2) - '0') << 3) | (field.at(pos + 3) - '0'));
+            pos += 3;
+        }
+        mountPoint.append(c);
+    }
+    return mountPoint;
+}
@@ -0,0 +1,88 @@
+/*! \file       treeguard.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      Tree Guard module header file.
+ *
+ *  This file contains the TreeGuard class declaration.
+ */
+
+#ifndef TREEGUARD_H
+#define TREEGUARD_H
+
+#include <QtCore/qglobal.h>
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "dirreader.h"
+#include "globmatcher.h"
+
+/*! \class TreeGuard
+ *  \brief Directory tree boundary & revisit guard class.
+ *
+ *  This class decides if a directory is entered before it is read. Every
+ *  directory is identified by its device & inode, a directory which is one
+ *  of its own path ancestors (a link or bind mount cycle) is not entered.
+ *  A second path to the same directory out of a cycle is entered again.
+ *  Directories may be kept on the devices of the root directories &
+ *  directories of skipped file system types may be pruned, the type of
+ *  a device is looked up once when the device is met first. Files with
+ *  several hard links may be let through once. The device of a path can
+ *  be told by the mount table without a system call to limit parallel
+ *  reads per device. Directories may be entered from parallel traversal
+ *  threads. On platforms without device & inode numbers every directory
+ *  is entered.
+ */
+class TreeGuard
+{
+    public:
+        TreeGuard();
+        void setOneFileSystem(bool oneFileSystem);
+        void setSkippedTypes(const QStringList &types);
+        void setLinksOnce(bool linksOnce);
+        void addRoot(const QString &rootPath);
+        bool enter(const QString &dirPath, quint64 &device);
+        void filterFiles(quint64 device, QVector<DirEntry> &entries);
+        quint64 deviceOf(const QString &dirPath);
+        static bool isOwnAncestor(const QString &dirPath);
+
+        /*! Returns "false" for a file whose other hard link has been let through already */
+        bool acceptFile(quint64 device, quint64 inode, unsigned int links)
+        {
+            return !_linksOnce || links < 2 || _acceptLink(device, inode);
+        }
+    private:
+        typedef QPair<quint64, quint64> Identity;
+
+        bool _oneFileSystem;                /*!< Keep directories on the root devices */
+        GlobMatcher _skippedTypes;          /*!< File system type patterns to prune */
+        bool _skipTypes;                    /*!< Set if there are skipped types */
+        bool _linksOnce;                    /*!< Let files with several hard links through once */
+
+        QMutex _lock;                       /*!< Guards the sets below */
+        QSet<quint64> _rootDevices;         /*!< Devices of the root directories */
+        QHash<quint64, bool> _skippedDevices; /*!< Skipped type decisions of met devices */
+        QHash<quint64, QByteArray> _mountTypes; /*!< File system types of mounted devices */
+        QVector<QPair<QByteArray, quint64> > _mountPoints; /*!< Mount points & their devices, the longest first */
+        int _mountReads;                    /*!< Number of times the mount table has been read */
+        QSet<Identity> _dirs;               /*!< Met directories, only these are checked for cycles */
+        QSet<Identity> _links;              /*!< Let through files with several hard links */
+
+        bool _acceptLink(quint64 device, quint64 inode);
+        static bool _isAncestor(const Identity &identity, const QString &dirPath);
+        bool _isSkippedDevice(quint64 device, const QString &dirPath);
+        QByteArray _fileSystemType(quint64 device, const QString &dirPath);
+        void _loadMounts();
+        static QByteArray _unescapeMountPoint(const QByteArray &field);
+
+        Q_DISABLE_COPY(TreeGuard)
+};
+
+#endif // TREEGUARD_H
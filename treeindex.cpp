@@ -0,0 +1,197 @@
+/*! \file       treeindex.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief Tree Index module source file.
+ *
+ *  This file contains the TreeIndex class source code.
+ */
+
+#include "treeindex.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QMutexLocker>
+#include <QSaveFile>
+
+#ifdef __TDIR_DEBUG__
+#include <QDebug>
+#endif
+
+/* Index file header magic ("TDIX") & format version */
+static const quint32 index_magic = 0x54444958;
+static const quint32 index_version = 5;
+
+/* Least stream sizes of a directory record & an entry, counts read from the file are capped by them */
+static const qint64 min_dir_size = 24;
+static const qint64 min_entry_size = 62;
+
+/*!
+ * \brief TreeIndex::TreeIndex
+ * \param[in] indexPath An index file path
+ * \param[in] signature Options the index entries depend on (a mask, recursion),
+ *            an index built with other options is not used
+ *
+ * TreeIndex Constructor
+ */
+TreeIndex::TreeIndex(const QString &indexPath, const QString &signature)
+{
+    _indexPath = indexPath;
+    _signature = signature;
+    _scanStarted = QDateTime::currentMSecsSinceEpoch() * 1000000;
+    _indexedAt = 0;
+}
+
+/*!
+ * \brief TreeIndex::load
+ * \return "false" if there is no usable index, all directories are read then
+ *
+ * Loads the index file stored on a previous run.
+ */
+bool TreeIndex::load()
+{
+    QFile file(_indexPath);
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    QString signature;
+    quint32 dirCount = 0;
+    stream >> magic >> version >> signature >> _indexedAt >> dirCount;
+
+    if(stream.status() != QDataStream::Ok || magic != index_magic ||
+       version != index_version || signature != _signature)
+    {
+#ifdef __TDIR_DEBUG__
+        qWarning() << "Index file is not compatible, rebuilding it!";
+#endif
+        return false;
+    }
+
+    /* A damaged count can't reserve more than the rest of the file holds */
+    _loaded.reserve(int(qMin<qint64>(dirCount, file.bytesAvailable() / min_dir_size)));
+    for(quint32 dirNum = 0; dirNum < dirCount && stream.status() == QDataStream::Ok; dirNum++)
+    {
+        QString dirPath;
+        DirRecord record;
+        quint32 entryCount = 0;
+        stream >> dirPath >> record.mtime >> record.ctime >> entryCount;
+
+        record.entries.reserve(int(qMin<qint64>(entryCount, file.bytesAvailable() / min_entry_size)));
+        for(quint32 entryNum = 0; entryNum < entryCount && stream.status() == QDataStream::Ok; entryNum++)
+        {
+            DirEntry entry;
+            stream >> entry.name >> entry.isDir >> entry.size >> entry.mtime >> entry.blocks
+                   >> entry.mtimeNsec >> entry.mode >> entry.inode >> entry.ctime >> entry.uid >> entry.links >> entry.isLink;
+            record.entries.append(entry);
+        }
+
+        _loaded.insert(dirPath, record);
+    }
+
+    if(stream.status() != QDataStream::Ok)
+    {
+#ifdef __TDIR_DEBUG__
+        qWarning() << "Index file is corrupted, rebuilding it!";
+#endif
+        _loaded.clear();
+        return false;
+    }
+
+    return true;
+}
+
+/*!
+ * \brief TreeIndex::lookup
+ * \param[in] dirPath An absolute directory path
+ * \param[in] mtime The directory modification time in nanoseconds
+ * \param[in] ctime The directory status change time in nanoseconds
+ * \param[out] entries Indexed entries
+ * \return "true" if the directory hasn't changed since it was indexed
+ *
+ * A directory changed within the indexing run time can be changed again
+ * with the same times later, so such directories are always read.
+ * The method is thread-safe.
+ */
+bool TreeIndex::lookup(const QString &dirPath, qint64 mtime, qint64 ctime, QVector<DirEntry> &entries)
+{
+    QHash<QString, DirRecord>::const_iterator found = _loaded.constFind(dirPath);
+    if(found == _loaded.constEnd() || found.value().mtime != mtime || found.value().ctime != ctime ||
+       mtime >= _indexedAt || ctime >= _indexedAt)
+    {
+        return false;
+    }
+
+    entries = found.value().entries;
+    store(dirPath, mtime, ctime, entries);
+    return true;
+}
+
+/*!
+ * \brief TreeIndex::store
+ * \param[in] dirPath An absolute directory path
+ * \param[in] mtime The directory modification time in nanoseconds taken before reading it
+ * \param[in] ctime The directory status change time in nanoseconds taken before reading it
+ * \param[in] entries The directory entries
+ *
+ * Adds a directory visited on this run to the index to save.
+ * The method is thread-safe.
+ */
+void TreeIndex::store(const QString &dirPath, qint64 mtime, qint64 ctime, const QVector<DirEntry> &entries)
+{
+    DirRecord record;
+    record.mtime = mtime;
+    record.ctime = ctime;
+    record.entries = entries;
+
+    QMutexLocker locker(&_lock);
+    _scanned.insert(dirPath, record);
+}
+
+/*!
+ * \brief TreeIndex::save
+ * \return "false" if the index file can't be written
+ *
+ * Replaces the index file with directories visited on this run,
+ * so removed directories are dropped from it.
+ */
+bool TreeIndex::save()
+{
+    QSaveFile file(_indexPath);
+    if(!file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    stream << index_magic << index_version << _signature << _scanStarted << quint32(_scanned.count());
+
+    for(QHash<QString, DirRecord>::const_iterator record = _scanned.constBegin();
+        record != _scanned.constEnd(); ++record)
+    {
+        const QVector<DirEntry> &entries = record.value().entries;
+        stream << record.key() << record.value().mtime << record.value().ctime << quint32(entries.count());
+
+        foreach (const DirEntry &entry, entries) {
+            stream << entry.name << entry.isDir << entry.size << entry.mtime << entry.blocks
+                   << entry.mtimeNsec << entry.mode << entry.inode << entry.ctime << entry.uid << entry.links << entry.isLink;
+        }
+    }
+
+    if(stream.status() != QDataStream::Ok)
+    {
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
@@ -0,0 +1,59 @@
+/*! \file       treeindex.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      Tree Index module header file.
+ *
+ *  This file contains the TreeIndex class declaration.
+ */
+
+#ifndef TREEINDEX_H
+#define TREEINDEX_H
+
+#include <QtCore/qglobal.h>
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include "dirreader.h"
+
+/*! \class TreeIndex
+ *  \brief Persistent directory tree index class.
+ *
+ *  This class stores directory entries read on a previous run together
+ *  with the directory modification & status change times. A directory
+ *  whose times haven't changed is served from the index without reading it.
+ *  Note that a file changed in place doesn't change its directory times,
+ *  so its size & modification time are shown as they were indexed.
+ */
+class TreeIndex
+{
+    public:
+        TreeIndex(const QString &indexPath, const QString &signature);
+        bool load();
+        bool lookup(const QString &dirPath, qint64 mtime, qint64 ctime, QVector<DirEntry> &entries);
+        void store(const QString &dirPath, qint64 mtime, qint64 ctime, const QVector<DirEntry> &entries);
+        bool save();
+    private:
+        /*! \struct DirRecord
+         *  \brief An indexed directory.
+         */
+        struct DirRecord
+        {
+            qint64 mtime;               /*!< The directory modification time in nanoseconds */
+            qint64 ctime;               /*!< The directory status change time in nanoseconds */
+            QVector<DirEntry> entries;  /*!< The directory entries */
+        };
+
+        QString _indexPath;                     /*!< An index file path */
+        QString _signature;                     /*!< Options the index entries depend on */
+        qint64 _scanStarted;                    /*!< This run start time in nanoseconds since epoch */
+        qint64 _indexedAt;                      /*!< The loaded index run start time in nanoseconds since epoch */
+        QHash<QString, DirRecord> _loaded;      /*!< Directories loaded from the index file */
+        QHash<QString, DirRecord> _scanned;     /*!< Directories visited on this run */
+        QMutex _lock;                           /*!< Guards visited directories */
+};
+
+#endif // TREEINDEX_H
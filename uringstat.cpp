@@ -0,0 +1,325 @@
+/*! \file       uringstat.cpp
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief io_uring Stat module source file.
+ *
+ *  This file contains the UringStat class source code.
+ */
+
+#include "uringstat.h"
+
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+#endif
+
+/* The statx opcode & the probe are available since Linux 5.6 headers */
+#if defined(IORING_FEAT_FAST_POLL) && defined(__NR_io_uring_setup) && defined(STATX_SIZE)
+#define TDIR_HAS_IO_URING
+#endif
+#endif
+
+/*!
+ * \brief UringStat::UringStat
+ * \param[in] depth Maximal number of requests in flight
+ *
+ * UringStat Constructor, the ring is not valid if io_uring is not available
+ */
+UringStat::UringStat(int depth)
+{
+    _fd = -1;
+    _depth = (depth > 0) ? depth : 1;
+    _broken = false;
+    _sqRing = nullptr;
+    _cqRing = nullptr;
+    _sqes = nullptr;
+    _sqRingSize = 0;
+    _cqRingSize = 0;
+    _sqesSize = 0;
+    _sqHead = _sqTail = _sqArray = nullptr;
+    _cqHead = _cqTail = nullptr;
+    _sqMask = _cqMask = 0;
+    _cqes = nullptr;
+
+#ifdef TDIR_HAS_IO_URING
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    int fd = syscall(__NR_io_uring_setup, _depth, &params);
+    if(fd < 0)
+    {
+        return;
+    }
+
+    _sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    _cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    _sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    /* Both rings share one mapping on newer kernels */
+    bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP);
+    if(singleMap)
+    {
+        _sqRingSize = _cqRingSize = qMax(_sqRingSize, _cqRingSize);
+    }
+
+    void *sqRing = mmap(nullptr, _sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    void *cqRing = singleMap ? sqRing :
+                   mmap(nullptr, _cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    void *sqes = mmap(nullptr, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+
+    if(sqRing == MAP_FAILED || cqRing == MAP_FAILED || sqes == MAP_FAILED)
+    {
+        if(sqes != MAP_FAILED) munmap(sqes, _sqesSize);
+        if(cqRing != MAP_FAILED && !singleMap) munmap(cqRing, _cqRingSize);
+        if(sqRing != MAP_FAILED) munmap(sqRing, _sqRingSize);
+        close(fd);
+        return;
+    }
+
+    char *sq = static_cast<char *>(sqRing);
+    char *cq = static_cast<char *>(cqRing);
+
+    _sqHead = reinterpret_cast<unsigned int *>(sq + params.sq_off.head);
+    _sqTail = reinterpret_cast<unsigned int *>(sq + params.sq_off.tail);
+    _sqMask = *reinterpret_cast<unsigned int *>(sq + params.sq_off.ring_mask);
+    _sqArray = reinterpret_cast<unsigned int *>(sq + params.sq_off.array);
+    _cqHead = reinterpret_cast<unsigned int *>(cq + params.cq_off.head);
+    _cqTail = reinterpret_cast<unsigned int *>(cq + params.cq_off.tail);
+    _cqMask = *reinterpret_cast<unsigned int *>(cq + params.cq_off.ring_mask);
+    _cqes = cq + params.cq_off.cqes;
+
+    _sqRing = sqRing;
+    _cqRing = cqRing;
+    _sqes = sqes;
+    _depth = qMin(_depth, int(params.sq_entries));
+    _fd = fd;
+#endif
+}
+
+/*!
+ * \brief UringStat::~UringStat
+ *
+ * UringStat Destructor
+ */
+UringStat::~UringStat()
+{
+#ifdef TDIR_HAS_IO_URING
+    if(_fd >= 0)
+    {
+        munmap(_sqes, _sqesSize);
+        if(_cqRing != _sqRing)
+        {
+            munmap(_cqRing, _cqRingSize);
+        }
+        munmap(_sqRing, _sqRingSize);
+
+        /* Requests left in flight after a failure have been waited for */
+        close(_fd);
+    }
+#endif
+}
+
+/*!
+ * \brief UringStat::isSupported
+ * \return "true" if the kernel supports io_uring statx requests
+ *
+ * Probes the kernel once, the first call must be made before threads are started.
+ */
+bool UringStat::isSupported()
+{
+    static int supported = -1;
+
+    if(supported < 0)
+    {
+        supported = 0;
+
+#ifdef TDIR_HAS_IO_URING
+        UringStat ring(2);
+        if(ring.isValid())
+        {
+            const int opCount = 256;
+            std::vector<char> buffer(sizeof(struct io_uring_probe) + opCount * sizeof(struct io_uring_probe_op), 0);
+            struct io_uring_probe *probe = reinterpret_cast<struct io_uring_probe *>(buffer.data());
+
+            if(syscall(__NR_io_uring_register, ring._fd, IORING_REGISTER_PROBE, probe, opCount) == 0 &&
+               probe->last_op >= IORING_OP_STATX &&
+               (probe->ops[IORING_OP_STATX].flags & IO_URING_OP_SUPPORTED))
+            {
+                supported = 1;
+            }
+        }
+#endif
+    }
+
+    return supported == 1;
+}
+
+/*!
+ * \brief UringStat::isValid
+ * \return "true" if the ring can be used
+ */
+bool UringStat::isValid() const
+{
+    return _fd >= 0 && !_broken;
+}
+
+/*!
+ * \brief UringStat::stat
+ * \param[in] dirFd An open directory descriptor names are relative to
+ * \param[in,out] requests Entries to stat following symbolic links
+ * \return "false" if the ring has failed, not done requests must be stated synchronously then
+ *
+ * Stats entries asking for the type, mode, owner, links, inode, size, times & blocks only.
+ */
+bool UringStat::stat(int dirFd, QVector<Request> &requests)
+{
+#ifdef TDIR_HAS_IO_URING
+    if(!isValid())
+    {
+        return false;
+    }
+
+    const int count = requests.count();
+    if(_buffers.size() < count * sizeof(struct statx))
+    {
+        _buffers.resize(count * sizeof(struct statx));
+    }
+    struct statx *buffers = reinterpret_cast<struct statx *>(_buffers.data());
+    struct io_uring_sqe *sqes = static_cast<struct io_uring_sqe *>(_sqes);
+
+    int submitted = 0;
+    int completed = 0;
+
+    while(completed < count)
+    {
+        /* Filling the submission ring up to the queue depth */
+        unsigned int tail = *_sqTail;
+        while(submitted < count && submitted - completed < _depth)
+        {
+            unsigned int index = tail & _sqMask;
+            struct io_uring_sqe *sqe = &sqes[index];
+
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_STATX;
+            sqe->fd = dirFd;
+            sqe->addr = reinterpret_cast<quintptr>(requests[submitted].name);
+            sqe->len = STATX_TYPE | STATX_MODE | STATX_UID | STATX_NLINK | STATX_INO | STATX_SIZE | STATX_MTIME | STATX_CTIME | STATX_BLOCKS;
+            sqe->off = reinterpret_cast<quintptr>(&buffers[submitted]);
+            sqe->statx_flags = 0;
+            sqe->user_data = submitted;
+
+            _sqArray[index] = index;
+            tail++;
+            submitted++;
+        }
+        __atomic_store_n(_sqTail, tail, __ATOMIC_RELEASE);
+
+        unsigned int toSubmit = tail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+        if(syscall(__NR_io_uring_enter, _fd, toSubmit, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR)
+        {
+            /* Requests taken by the kernel still read names & write buffers, they are waited for */
+            _broken = true;
+            _wait(requests, submitted - int(tail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE)) - completed);
+            return false;
+        }
+
+        completed += _reap(requests);
+    }
+
+    return true;
+#else
+    Q_UNUSED(dirFd)
+    Q_UNUSED(requests)
+    return false;
+#endif
+}
+
+/*!
+ * \brief UringStat::_reap
+ * \param[in,out] requests Requests of the current stat() call
+ * \return Number of completed requests
+ *
+ * Stores results of all completed requests.
+ */
+int UringStat::_reap(QVector<Request> &requests)
+{
+    int completed = 0;
+
+#ifdef TDIR_HAS_IO_URING
+    const struct statx *buffers = reinterpret_cast<const struct statx *>(_buffers.data());
+    const struct io_uring_cqe *cqes = static_cast<const struct io_uring_cqe *>(_cqes);
+
+    unsigned int head = *_cqHead;
+    while(head != __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE))
+    {
+        const struct io_uring_cqe *cqe = &cqes[head & _cqMask];
+        Request &request = requests[int(cqe->user_data)];
+        const struct statx &stx = buffers[int(cqe->user_data)];
+
+        request.done = true;
+        if(cqe->res == 0)
+        {
+            request.mode = stx.stx_mode;
+            request.size = stx.stx_size;
+            request.mtime = qint64(stx.stx_mtime.tv_sec) * 1000 + stx.stx_mtime.tv_nsec / 1000000;
+            request.blocks = stx.stx_blocks;
+            request.mtimeNsec = int(stx.stx_mtime.tv_nsec % 1000000);
+            request.inode = stx.stx_ino;
+            request.ctime = qint64(stx.stx_ctime.tv_sec) * 1000 + stx.stx_ctime.tv_nsec / 1000000;
+            request.uid = stx.stx_uid;
+            request.links = stx.stx_nlink;
+        }
+        else
+        {
+            request.mode = 0;
+        }
+
+        head++;
+        completed++;
+    }
+    __atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+#else
+    Q_UNUSED(requests)
+#endif
+
+    return completed;
+}
+
+/*!
+ * \brief UringStat::_wait
+ * \param[in,out] requests Requests of the current stat() call
+ * \param[in] inFlight Number of requests taken by the kernel & not completed
+ *
+ * Waits for requests in flight after a failure, so names & buffers they use
+ * outlive them. If the ring can't be waited on, the buffers are never freed,
+ * a late request writes to them only. Names may be read after they are reused
+ * then, which gives a wrong result to a request nobody reads.
+ */
+void UringStat::_wait(QVector<Request> &requests, int inFlight)
+{
+#ifdef TDIR_HAS_IO_URING
+    while(inFlight > 0)
+    {
+        if(syscall(__NR_io_uring_enter, _fd, 0, inFlight, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR)
+        {
+            new std::vector<char>(std::move(_buffers));
+            return;
+        }
+        inFlight -= _reap(requests);
+    }
+#else
+    Q_UNUSED(requests)
+    Q_UNUSED(inFlight)
+#endif
+}
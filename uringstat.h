@@ -0,0 +1,82 @@
+/*! \file       uringstat.h
+ *  \author     Yury Osipov (yusosipov@ya.ru)
+ *  \version    1.0.0.1
+ *  \date       August, 2018
+ *  \brief      io_uring Stat module header file.
+ *
+ *  This file contains the UringStat class declaration.
+ */
+
+#ifndef URINGSTAT_H
+#define URINGSTAT_H
+
+#include <QtCore/qglobal.h>
+
+#include <QVector>
+
+#include <vector>
+
+/*! \class UringStat
+ *  \brief Batched statx class using io_uring.
+ *
+ *  This class stats many entries of a directory with asynchronous statx
+ *  requests keeping up to the queue depth requests in flight, so network
+ *  & cold cache file systems are not waited for one entry after another.
+ *  A ring is not thread-safe, every thread must use its own one.
+ */
+class UringStat
+{
+    public:
+        /*! \struct Request
+         *  \brief A stat request & its result.
+         */
+        struct Request
+        {
+            const char *name;   /*!< A null terminated entry name relative to the directory */
+            bool done;          /*!< Set when the request is completed */
+            unsigned int mode;  /*!< An entry type & mode, 0 if the entry can't be stated */
+            qint64 size;        /*!< A file size in bytes */
+            qint64 mtime;       /*!< A file modification time in milliseconds since epoch */
+            qint64 blocks;      /*!< Allocated 512 byte blocks */
+            int mtimeNsec;      /*!< Nanoseconds of the modification time within the millisecond */
+            quint64 inode;      /*!< An inode number */
+            qint64 ctime;       /*!< A status change time in milliseconds since epoch */
+            unsigned int uid;   /*!< An owner id */
+            unsigned int links; /*!< Number of hard links */
+        };
+
+        explicit UringStat(int depth);
+        ~UringStat();
+        static bool isSupported();
+        bool isValid() const;
+        bool stat(int dirFd, QVector<Request> &requests);
+    private:
+        int _fd;                        /*!< A ring descriptor */
+        int _depth;                     /*!< Maximal number of requests in flight */
+        bool _broken;                   /*!< Set if the ring has failed */
+
+        void *_sqRing;                  /*!< Mapped submission ring */
+        void *_cqRing;                  /*!< Mapped completion ring, it can be the same mapping */
+        void *_sqes;                    /*!< Mapped submission entries */
+        size_t _sqRingSize;             /*!< Submission ring mapping size */
+        size_t _cqRingSize;             /*!< Completion ring mapping size */
+        size_t _sqesSize;               /*!< Submission entries mapping size */
+
+        unsigned int *_sqHead;          /*!< Submission ring head, moved by the kernel */
+        unsigned int *_sqTail;          /*!< Submission ring tail */
+        unsigned int _sqMask;           /*!< Submission ring index mask */
+        unsigned int *_sqArray;         /*!< Submission ring index array */
+        unsigned int *_cqHead;          /*!< Completion ring head */
+        unsigned int *_cqTail;          /*!< Completion ring tail, moved by the kernel */
+        unsigned int _cqMask;           /*!< Completion ring index mask */
+        void *_cqes;                    /*!< Completion entries */
+
+        std::vector<char> _buffers;     /*!< statx result buffers, kept while the ring lives */
+
+        int _reap(QVector<Request> &requests);
+        void _wait(QVector<Request> &requests, int inFlight);
+
+        Q_DISABLE_COPY(UringStat)
+};
+
+#endif // URINGSTAT_H